@@ -40,6 +40,7 @@
 #include "internal/opensubdiv_topology_refiner_internal.h"
 #include "internal/opensubdiv_util.h"
 #include "internal/opensubdiv_util.h"
+#include "opensubdiv_evaluator_capi.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
 using OpenSubdiv::Far::PatchMap;
@@ -159,6 +160,23 @@ template<int element_size, int num_vertices> class StackAllocatedBuffer {
   float data_[element_size * num_vertices];
 };
 
+// Helper class which wraps externally owned memory into a buffer, so data can
+// be passed to and from the CPU evaluator without extra copies.
+template<typename T> class RawDataWrapperBuffer {
+ public:
+  explicit RawDataWrapperBuffer(T *data) : data_(data)
+  {
+  }
+
+  T *BindCpuBuffer()
+  {
+    return data_;
+  }
+
+ protected:
+  T *data_;
+};
+
 template<typename EVAL_VERTEX_BUFFER,
          typename STENCIL_TABLE,
          typename PATCH_TABLE,
@@ -461,6 +479,53 @@ class VolatileEvalOutput {
     }
   }
 
+  // Evaluate all given patch coordinates with a single evaluator call.
+  // Derivatives are written when both of the derivative arrays are given.
+  void evalPatches(const PatchCoord *patch_coords,
+                   const int num_patch_coords,
+                   float *P,
+                   float *dPdu,
+                   float *dPdv)
+  {
+    // TODO(sergey): Varying data is interleaved in vertex array, so need to
+    // adjust stride if there is a varying data.
+    BufferDescriptor vertex_desc(0, 3, 3);
+    RawDataWrapperBuffer<float> vertex_data(P);
+    RawDataWrapperBuffer<PatchCoord> patch_coord_buffer(const_cast<PatchCoord *>(patch_coords));
+    if (dPdu != NULL && dPdv != NULL) {
+      BufferDescriptor du_desc(0, 3, 3), dv_desc(0, 3, 3);
+      RawDataWrapperBuffer<float> du_data(dPdu), dv_data(dPdv);
+      const EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
+          evaluator_cache_, src_desc_, vertex_desc, du_desc, dv_desc, device_context_);
+      EVALUATOR::EvalPatches(src_data_,
+                             src_desc_,
+                             &vertex_data,
+                             vertex_desc,
+                             &du_data,
+                             du_desc,
+                             &dv_data,
+                             dv_desc,
+                             num_patch_coords,
+                             &patch_coord_buffer,
+                             patch_table_,
+                             eval_instance,
+                             device_context_);
+    }
+    else {
+      const EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
+          evaluator_cache_, src_desc_, vertex_desc, device_context_);
+      EVALUATOR::EvalPatches(src_data_,
+                             src_desc_,
+                             &vertex_data,
+                             vertex_desc,
+                             num_patch_coords,
+                             &patch_coord_buffer,
+                             patch_table_,
+                             eval_instance,
+                             device_context_);
+    }
+  }
+
   void evalPatchVarying(const PatchCoord &patch_coord, float varying[3])
   {
     StackAllocatedBuffer<6, 1> varying_data;
@@ -660,6 +725,46 @@ void CpuEvalOutputAPI::evaluateLimit(const int ptex_face_index,
   }
 }
 
+void CpuEvalOutputAPI::evaluatePatchesLimit(const OpenSubdiv_PatchCoord *patch_coords,
+                                            const int num_patch_coords,
+                                            float *P,
+                                            float *dPdu,
+                                            float *dPdv)
+{
+  if (num_patch_coords == 0) {
+    return;
+  }
+  // Patch lookup is cheap compared to the evaluation itself, resolve all of
+  // the handles first so the evaluator gets the whole batch in one go.
+  vector<PatchCoord> osd_patch_coords(num_patch_coords);
+  for (int i = 0; i < num_patch_coords; ++i) {
+    const OpenSubdiv_PatchCoord &patch_coord = patch_coords[i];
+    assert(patch_coord.u >= 0.0f);
+    assert(patch_coord.u <= 1.0f);
+    assert(patch_coord.v >= 0.0f);
+    assert(patch_coord.v <= 1.0f);
+    const PatchTable::PatchHandle *handle = patch_map_->FindPatch(
+        patch_coord.ptex_face, patch_coord.u, patch_coord.v);
+    osd_patch_coords[i] = PatchCoord(*handle, patch_coord.u, patch_coord.v);
+  }
+  if (dPdu != NULL || dPdv != NULL) {
+    // Evaluator writes both derivatives, provide storage for the one which
+    // caller is not interested in.
+    vector<float> derivatives_storage;
+    if (dPdu == NULL || dPdv == NULL) {
+      derivatives_storage.resize(num_patch_coords * 3);
+    }
+    implementation_->evalPatches(&osd_patch_coords[0],
+                                 num_patch_coords,
+                                 P,
+                                 dPdu != NULL ? dPdu : &derivatives_storage[0],
+                                 dPdv != NULL ? dPdv : &derivatives_storage[0]);
+  }
+  else {
+    implementation_->evalPatches(&osd_patch_coords[0], num_patch_coords, P, NULL, NULL);
+  }
+}
+
 void CpuEvalOutputAPI::evaluateVarying(const int ptex_face_index,
                                        float face_u,
                                        float face_v,
@@ -26,6 +26,7 @@
 #include <opensubdiv/far/patchMap.h>
 #include <opensubdiv/far/patchTable.h>
 
+struct OpenSubdiv_PatchCoord;
 struct OpenSubdiv_TopologyRefiner;
 
 namespace opensubdiv_capi {
@@ -103,6 +104,15 @@ class CpuEvalOutputAPI {
                      float dPdu[3],
                      float dPdv[3]);
 
+  // Evaluate limit positions at all given patch coordinates at once.
+  // Arrays are expected to have room for 3 floats per patch coordinate.
+  // If derivatives are NULL, they will not be evaluated.
+  void evaluatePatchesLimit(const OpenSubdiv_PatchCoord *patch_coords,
+                            const int num_patch_coords,
+                            float *P,
+                            float *dPdu,
+                            float *dPdv);
+
   // Evaluate varying data at a given bilinear coordinate of given ptex face.
   void evaluateVarying(const int ptes_face_index, float face_u, float face_v, float varying[3]);
 
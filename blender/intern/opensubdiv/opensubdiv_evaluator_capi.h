@@ -26,6 +26,12 @@ extern "C" {
 struct OpenSubdiv_EvaluatorInternal;
 struct OpenSubdiv_TopologyRefiner;
 
+// Location on the limit surface: bilinear coordinate within a ptex face.
+typedef struct OpenSubdiv_PatchCoord {
+  int ptex_face;
+  float u, v;
+} OpenSubdiv_PatchCoord;
+
 typedef struct OpenSubdiv_Evaluator {
   // Set coarse positions from a continuous array of coordinates.
   void (*setCoarsePositions)(struct OpenSubdiv_Evaluator *evaluator,
@@ -92,6 +98,19 @@ typedef struct OpenSubdiv_Evaluator {
                         float dPdu[3],
                         float dPdv[3]);
 
+  // Evaluate limit positions at all given patch coordinates at once.
+  // Output arrays are expected to have room for 3 floats per coordinate.
+  // If derivatives are NULL, they will not be evaluated.
+  //
+  // This is much cheaper than calling evaluateLimit() for every coordinate
+  // since the evaluator is only set up once for the whole batch.
+  void (*evaluatePatchesLimit)(struct OpenSubdiv_Evaluator *evaluator,
+                               const OpenSubdiv_PatchCoord *patch_coords,
+                               const int num_patch_coords,
+                               float *P,
+                               float *dPdu,
+                               float *dPdv);
+
   // Evaluate varying data at a given bilinear coordinate of given ptex face.
   void (*evaluateVarying)(struct OpenSubdiv_Evaluator *evaluator,
                           const int ptex_face_index,
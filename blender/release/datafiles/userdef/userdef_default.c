@@ -131,6 +131,8 @@ const UserDef U_default = {
     .memcachelimit = 4096,
 
     .prefetchframes = 0,
+    .sequencer_disk_cache_size_limit = 100,
+    .compositor_cache_limit = 1024,
     .pad_rot_angle = 15,
     .rvisize = 25,
     .rvibright = 8,
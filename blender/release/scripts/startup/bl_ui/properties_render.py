@@ -89,6 +89,7 @@ class RENDER_PT_color_management(RenderButtonsPanel, Panel):
         col = flow.column()
         col.prop(view, "exposure")
         col.prop(view, "gamma")
+        col.prop(view, "use_baked_lut")
 
         col.separator()
 
@@ -1920,6 +1920,7 @@ class SEQUENCER_PT_view(SequencerButtonsPanel_Output, Panel):
 
         col.prop(st, "proxy_render_size")
         col.prop(ed, "use_prefetch")
+        col.prop(ed, "use_disk_cache")
 
 
 class SEQUENCER_PT_frame_overlay(SequencerButtonsPanel_Output, Panel):
@@ -742,6 +742,8 @@ class USERPREF_PT_system_memory(PreferencePanel, Panel):
         flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=False)
 
         flow.prop(system, "memory_cache_limit", text="Sequencer Cache Limit")
+        flow.prop(system, "sequencer_disk_cache_size_limit", text="Sequencer Disk Cache Limit")
+        flow.prop(system, "compositor_cache_limit", text="Compositor Cache Limit")
         flow.prop(system, "scrollback", text="Console Scrollback Lines")
 
         layout.separator()
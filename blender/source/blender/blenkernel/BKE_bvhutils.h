@@ -244,4 +244,24 @@ bool bvhcache_has_tree(const BVHCache *cache, const BVHTree *tree);
 void bvhcache_insert(BVHCache **cache_p, BVHTree *tree, int type);
 void bvhcache_free(BVHCache **cache_p);
 
+/**
+ * Shared BVHCache, trees of meshes with the same content are shared (see bvhutils.c).
+ */
+typedef struct BVHCacheStats {
+  /** Trees reused as-is. */
+  unsigned int hits;
+  /** Trees refitted because only positions changed. */
+  unsigned int refits;
+  /** Trees built. */
+  unsigned int misses;
+  /** Unused trees freed to stay within the cache size. */
+  unsigned int frees;
+  int trees_len;
+  int trees_unused_len;
+} BVHCacheStats;
+
+void BKE_bvhcache_shared_free(void);
+void BKE_bvhcache_shared_stats_get(BVHCacheStats *r_stats);
+void BKE_bvhcache_shared_stats_print(void);
+
 #endif
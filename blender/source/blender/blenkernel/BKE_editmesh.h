@@ -94,6 +94,13 @@ typedef struct BMEditMesh {
    */
   char needs_flush_to_id;
 
+  /**
+   * The last update only moved vertices (no topology, selection or custom-data changes).
+   * Set by tools such as transform, consumed by the draw cache so it can update
+   * vertex buffers in place instead of extracting them again.
+   */
+  char is_deform_only;
+
 } BMEditMesh;
 
 /* editmesh.c */
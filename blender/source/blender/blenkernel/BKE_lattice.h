@@ -26,6 +26,7 @@
 
 #include "BLI_compiler_attrs.h"
 
+struct ArmatureDeformCache;
 struct BPoint;
 struct Depsgraph;
 struct Lattice;
@@ -86,7 +87,9 @@ void armature_deform_verts(struct Object *armOb,
                            int deformflag,
                            float (*prevCos)[3],
                            const char *defgrp_name,
-                           struct bGPDstroke *gps);
+                           struct bGPDstroke *gps,
+                           struct ArmatureDeformCache **cache_p);
+void armature_deform_cache_free(struct ArmatureDeformCache *cache);
 
 float (*BKE_lattice_vert_coords_alloc(const struct Lattice *lt, int *r_vert_len))[3];
 void BKE_lattice_vert_coords_get(const struct Lattice *lt, float (*vert_coords)[3]);
@@ -459,6 +459,46 @@ void BKE_mesh_normals_loop_to_vertex(const int numVerts,
                                      const float (*clnors)[3],
                                      float (*r_vert_clnors)[3]);
 
+/* Normals topology cache, for meshes only deformed from their original (see mesh_evaluate.c). */
+struct MeshNormalsTopology;
+
+typedef struct MeshNormalsTopologyStats {
+  /** Topologies found in the cache. */
+  unsigned int hits;
+  /** Topologies built. */
+  unsigned int misses;
+  /** Unused topologies freed to stay within the cache size. */
+  unsigned int frees;
+  /** Smooth fans reused as-is, or built (first use or auto-smooth sharp edges changed). */
+  unsigned int fans_hits;
+  unsigned int fans_builds;
+  int topologies_len;
+  int topologies_unused_len;
+
+  /** Accumulated time (in seconds) of each stage. */
+  double time_lookup;
+  double time_build;
+  double time_poly_normals;
+  double time_vert_normals;
+  double time_fans;
+  double time_loop_normals;
+} MeshNormalsTopologyStats;
+
+struct MeshNormalsTopology *BKE_mesh_normals_topology_acquire(const struct Mesh *mesh);
+void BKE_mesh_normals_topology_release(struct MeshNormalsTopology *topology);
+void BKE_mesh_calc_normals_poly_topology(struct Mesh *mesh,
+                                         const struct MeshNormalsTopology *topology,
+                                         float (*r_polynors)[3]);
+void BKE_mesh_normals_loop_split_topology(const struct Mesh *mesh,
+                                          struct MeshNormalsTopology *topology,
+                                          const float (*polynors)[3],
+                                          const float split_angle,
+                                          float (*r_loopnors)[3]);
+
+void BKE_mesh_normals_topology_cache_free(void);
+void BKE_mesh_normals_topology_stats_get(MeshNormalsTopologyStats *r_stats);
+void BKE_mesh_normals_topology_stats_print(void);
+
 /* High-level custom normals functions. */
 bool BKE_mesh_has_custom_loop_normals(struct Mesh *me);
 
@@ -90,9 +90,14 @@ void BKE_sequence_iterator_end(SeqIterator *iter);
   } \
   ((void)0)
 
+/* Maximum number of prefetch workers, each of them renders different frames. */
+#define SEQ_PREFETCH_WORKERS_MAX 8
+
 typedef enum eSeqTaskId {
   SEQ_TASK_MAIN_RENDER,
+  /* Prefetch workers use consecutive IDs starting with this one. */
   SEQ_TASK_PREFETCH_RENDER,
+  SEQ_TASK_MAX = SEQ_TASK_PREFETCH_RENDER + SEQ_PREFETCH_WORKERS_MAX,
 } eSeqTaskId;
 
 typedef struct SeqRenderData {
@@ -310,6 +315,12 @@ void BKE_sequencer_proxy_rebuild(struct SeqIndexBuildContext *context,
 void BKE_sequencer_proxy_rebuild_finish(struct SeqIndexBuildContext *context, bool stop);
 
 void BKE_sequencer_proxy_set(struct Sequence *seq, bool value);
+bool BKE_sequencer_source_filepath_get(struct Sequence *seq, int cfra, char *r_path);
+bool BKE_sequencer_proxy_filepath_get(struct Scene *scene,
+                                      struct Sequence *seq,
+                                      int cfra,
+                                      int render_size,
+                                      char *r_path);
 /* **********************************************************************
  * seqcache.c
  *
@@ -360,6 +371,8 @@ void BKE_sequencer_prefetch_stop(struct Scene *scene);
 void BKE_sequencer_prefetch_free(struct Scene *scene);
 bool BKE_sequencer_prefetch_need_redraw(struct Main *bmain, struct Scene *scene);
 bool BKE_sequencer_prefetch_job_is_running(struct Scene *scene);
+bool BKE_sequencer_prefetch_is_concurrent_render(const SeqRenderData *context);
+int BKE_sequencer_prefetch_num_render_threads(const SeqRenderData *context);
 void BKE_sequencer_prefetch_get_time_range(struct Scene *scene, int *start, int *end);
 SeqRenderData *BKE_sequencer_prefetch_get_original_context(const SeqRenderData *context);
 struct Sequence *BKE_sequencer_prefetch_get_original_sequence(struct Sequence *seq,
@@ -27,6 +27,7 @@
 #include "BLI_sys_types.h"
 
 struct Mesh;
+struct OpenSubdiv_PatchCoord;
 struct Subdiv;
 
 /* Returns true if evaluator is ready for use. */
@@ -92,6 +93,23 @@ void BKE_subdiv_eval_displacement(struct Subdiv *subdiv,
 void BKE_subdiv_eval_final_point(
     struct Subdiv *subdiv, const int ptex_face_index, const float u, const float v, float r_P[3]);
 
+/* Multiple points queries.
+ *
+ * Evaluate all the given points with a single call to the evaluator, which
+ * avoids the per-point overhead of the single point queries. Output arrays
+ * are to have num_points elements, derivatives are optional. */
+
+void BKE_subdiv_eval_limit_points(struct Subdiv *subdiv,
+                                  const struct OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_points,
+                                  float (*r_P)[3]);
+void BKE_subdiv_eval_limit_points_and_derivatives(struct Subdiv *subdiv,
+                                                  const struct OpenSubdiv_PatchCoord *patch_coords,
+                                                  const int num_points,
+                                                  float (*r_P)[3],
+                                                  float (*r_dPdu)[3],
+                                                  float (*r_dPdv)[3]);
+
 /* Patch queries at given resolution.
  *
  * Will evaluate patch at uniformly distributed (u, v) coordinates on a grid
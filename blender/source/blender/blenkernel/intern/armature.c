@@ -34,6 +34,7 @@
 #include "BLI_listbase.h"
 #include "BLI_string.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_alloca.h"
@@ -72,6 +73,10 @@
 
 #include "CLG_log.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static CLG_LogRef LOG = {"bke.armature"};
 
 /* **************** Generic Functions, data level *************** */
@@ -1459,6 +1464,11 @@ typedef struct ArmatureUserdata {
 
   float premat[4][4];
   float postmat[4][4];
+
+  /* Precompiled vertex group skinning, see #armature_vert_task_packed. */
+  const struct ArmatureDeformCache *cache;
+  float (*group_mats)[4][4];
+  DualQuat *group_dqs;
 } ArmatureUserdata;
 
 static void armature_vert_task(void *__restrict userdata,
@@ -1646,6 +1656,345 @@ static void armature_vert_task(void *__restrict userdata,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Precompiled Vertex Group Skinning
+ *
+ * Meshes deformed only by vertex groups (the common case for character rigs) don't need
+ * to look up the bone of every weight of every vertex. The weights are packed once into a
+ * flat table of (group, weight) pairs which is kept between evaluations, the bone matrices
+ * (or dual quaternions) are copied into arrays indexed by group for every evaluation.
+ *
+ * Results match #armature_vert_task exactly, vertices which need envelopes use it directly.
+ * \{ */
+
+typedef struct ArmatureDeformInfluence {
+  int group;
+  float weight;
+} ArmatureDeformInfluence;
+
+typedef struct ArmatureDeformCache {
+  int verts_num;
+  int defbase_tot;
+  /** Hash of all vertex weights, to detect changes. */
+  uint weights_hash;
+
+  /** Influences of vertex `i` are `influences[offsets[i]]` up to `influences[offsets[i + 1]]`,
+   * weights of groups outside the #ArmatureDeformCache.defbase_tot range are skipped. */
+  int *offsets;
+  ArmatureDeformInfluence *influences;
+} ArmatureDeformCache;
+
+static const MDeformVert *armature_deform_dvert_get(const ArmatureUserdata *data, const int i)
+{
+  if (data->mesh) {
+    return data->mesh->dvert ? &data->mesh->dvert[i] : NULL;
+  }
+  if (data->dverts && i < data->target_totvert) {
+    return &data->dverts[i];
+  }
+  return NULL;
+}
+
+static uint armature_deform_weights_hash(const ArmatureUserdata *data, const int verts_num)
+{
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, (uint)data->defbase_tot);
+  for (int i = 0; i < verts_num; i++) {
+    const MDeformVert *dvert = armature_deform_dvert_get(data, i);
+    const int totweight = dvert ? dvert->totweight : 0;
+    BLI_hash_mm2a_add_int(&mm2, totweight);
+    if (totweight) {
+      BLI_hash_mm2a_add(&mm2, (const uchar *)dvert->dw, sizeof(*dvert->dw) * (size_t)totweight);
+    }
+  }
+  return BLI_hash_mm2a_end(&mm2);
+}
+
+static ArmatureDeformCache *armature_deform_cache_ensure(ArmatureDeformCache **cache_p,
+                                                         const ArmatureUserdata *data,
+                                                         const int verts_num)
+{
+  ArmatureDeformCache *cache = *cache_p;
+  const uint weights_hash = armature_deform_weights_hash(data, verts_num);
+
+  if (cache) {
+    if ((cache->verts_num == verts_num) && (cache->defbase_tot == data->defbase_tot) &&
+        (cache->weights_hash == weights_hash)) {
+      return cache;
+    }
+    armature_deform_cache_free(cache);
+  }
+
+  cache = MEM_mallocN(sizeof(*cache), __func__);
+  cache->verts_num = verts_num;
+  cache->defbase_tot = data->defbase_tot;
+  cache->weights_hash = weights_hash;
+  cache->offsets = MEM_malloc_arrayN((size_t)verts_num + 1, sizeof(*cache->offsets), __func__);
+
+  int influences_num = 0;
+  for (int i = 0; i < verts_num; i++) {
+    const MDeformVert *dvert = armature_deform_dvert_get(data, i);
+    cache->offsets[i] = influences_num;
+    influences_num += dvert ? dvert->totweight : 0;
+  }
+  cache->influences = MEM_malloc_arrayN(
+      (size_t)max_ii(influences_num, 1), sizeof(*cache->influences), __func__);
+
+  influences_num = 0;
+  for (int i = 0; i < verts_num; i++) {
+    const MDeformVert *dvert = armature_deform_dvert_get(data, i);
+    cache->offsets[i] = influences_num;
+    if (dvert) {
+      const MDeformWeight *dw = dvert->dw;
+      for (int j = 0; j < dvert->totweight; j++, dw++) {
+        if (dw->def_nr >= 0 && dw->def_nr < data->defbase_tot) {
+          cache->influences[influences_num].group = dw->def_nr;
+          cache->influences[influences_num].weight = dw->weight;
+          influences_num++;
+        }
+      }
+    }
+  }
+  cache->offsets[verts_num] = influences_num;
+
+  *cache_p = cache;
+  return cache;
+}
+
+void armature_deform_cache_free(ArmatureDeformCache *cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+  MEM_freeN(cache->offsets);
+  MEM_freeN(cache->influences);
+  MEM_freeN(cache);
+}
+
+/**
+ * Copy the deformation of the bone of each vertex group.
+ *
+ * \return false when a bone needs per vertex evaluation
+ * (B-Bone segments or weights multiplied by envelopes).
+ */
+static bool armature_deform_groups_init(ArmatureUserdata *data)
+{
+  for (int i = 0; i < data->defbase_tot; i++) {
+    const bPoseChannel *pchan = data->defnrToPC[i];
+    if (pchan == NULL) {
+      continue;
+    }
+    const Bone *bone = pchan->bone;
+    if ((bone == NULL) || (bone->flag & BONE_MULT_VG_ENV) ||
+        (bone->segments > 1 && pchan->runtime.bbone_segments == bone->segments)) {
+      return false;
+    }
+  }
+
+  const size_t groups_num = (size_t)max_ii(data->defbase_tot, 1);
+  if (data->use_quaternion) {
+    data->group_dqs = MEM_malloc_arrayN(groups_num, sizeof(*data->group_dqs), __func__);
+  }
+  else {
+    data->group_mats = MEM_mallocN_aligned(sizeof(*data->group_mats) * groups_num, 16, __func__);
+  }
+
+  for (int i = 0; i < data->defbase_tot; i++) {
+    const bPoseChannel *pchan = data->defnrToPC[i];
+    if (pchan == NULL) {
+      continue;
+    }
+    if (data->use_quaternion) {
+      data->group_dqs[i] = pchan->runtime.deform_dual_quat;
+    }
+    else {
+      copy_m4_m4(data->group_mats[i], (float(*)[4])pchan->chan_mat);
+    }
+  }
+  return true;
+}
+
+/* Same as: #add_weighted_dq_dq */
+static void armature_deform_accumulate_dq(const ArmatureUserdata *data,
+                                          const ArmatureDeformInfluence *influences,
+                                          const int influences_num,
+                                          DualQuat *dq_accum,
+                                          float *r_contrib,
+                                          bool *r_deformed)
+{
+#ifdef __SSE2__
+  __m128 quat = _mm_setzero_ps();
+  __m128 trans = _mm_setzero_ps();
+  __m128 scale[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+  float scale_weight = 0.0f;
+
+  for (int k = 0; k < influences_num; k++) {
+    const int group = influences[k].group;
+    float weight = influences[k].weight;
+    if (data->defnrToPC[group] == NULL) {
+      continue;
+    }
+    *r_deformed = true;
+    if (weight == 0.0f) {
+      continue;
+    }
+    *r_contrib += weight;
+
+    const DualQuat *dq = &data->group_dqs[group];
+    const __m128 dq_quat = _mm_loadu_ps(dq->quat);
+    float dot[4];
+    _mm_storeu_ps(dot, _mm_mul_ps(dq_quat, quat));
+
+    /* make sure we interpolate quats in the right direction */
+    const bool flipped = (dot[0] + dot[1] + dot[2] + dot[3]) < 0;
+    const __m128 weight_v = _mm_set1_ps(flipped ? -weight : weight);
+    quat = _mm_add_ps(quat, _mm_mul_ps(weight_v, dq_quat));
+    trans = _mm_add_ps(trans, _mm_mul_ps(weight_v, _mm_loadu_ps(dq->trans)));
+
+    if (dq->scale_weight) {
+      /* we don't want negative weights for scaling */
+      const __m128 scale_weight_v = _mm_set1_ps(weight);
+      for (int j = 0; j < 4; j++) {
+        scale[j] = _mm_add_ps(scale[j], _mm_mul_ps(_mm_loadu_ps(dq->scale[j]), scale_weight_v));
+      }
+      scale_weight += weight;
+    }
+  }
+
+  _mm_storeu_ps(dq_accum->quat, quat);
+  _mm_storeu_ps(dq_accum->trans, trans);
+  for (int j = 0; j < 4; j++) {
+    _mm_storeu_ps(dq_accum->scale[j], scale[j]);
+  }
+  dq_accum->scale_weight = scale_weight;
+#else
+  memset(dq_accum, 0, sizeof(*dq_accum));
+  for (int k = 0; k < influences_num; k++) {
+    const int group = influences[k].group;
+    const float weight = influences[k].weight;
+    if (data->defnrToPC[group] == NULL) {
+      continue;
+    }
+    *r_deformed = true;
+    if (weight == 0.0f) {
+      continue;
+    }
+    *r_contrib += weight;
+    add_weighted_dq_dq(dq_accum, &data->group_dqs[group], weight);
+  }
+#endif
+}
+
+/* Same as: #pchan_deform_accumulate (for matrices). */
+static void armature_deform_accumulate_mat(const ArmatureUserdata *data,
+                                           const ArmatureDeformInfluence *influences,
+                                           const int influences_num,
+                                           const float co[3],
+                                           float r_vec[3],
+                                           float *r_contrib,
+                                           bool *r_deformed)
+{
+#ifdef __SSE2__
+  const __m128 co_v = _mm_setr_ps(co[0], co[1], co[2], 0.0f);
+  const __m128 x = _mm_set1_ps(co[0]), y = _mm_set1_ps(co[1]), z = _mm_set1_ps(co[2]);
+  __m128 vec = _mm_setzero_ps();
+
+  for (int k = 0; k < influences_num; k++) {
+    const int group = influences[k].group;
+    const float weight = influences[k].weight;
+    if (data->defnrToPC[group] == NULL) {
+      continue;
+    }
+    *r_deformed = true;
+    if (weight == 0.0f) {
+      continue;
+    }
+    *r_contrib += weight;
+
+    const float(*mat)[4] = data->group_mats[group];
+    __m128 tmp = _mm_add_ps(_mm_mul_ps(x, _mm_load_ps(mat[0])), _mm_mul_ps(y, _mm_load_ps(mat[1])));
+    tmp = _mm_add_ps(_mm_add_ps(tmp, _mm_mul_ps(_mm_load_ps(mat[2]), z)), _mm_load_ps(mat[3]));
+    tmp = _mm_sub_ps(tmp, co_v);
+    vec = _mm_add_ps(vec, _mm_mul_ps(tmp, _mm_set1_ps(weight)));
+  }
+
+  float vec_store[4];
+  _mm_storeu_ps(vec_store, vec);
+  copy_v3_v3(r_vec, vec_store);
+#else
+  zero_v3(r_vec);
+  for (int k = 0; k < influences_num; k++) {
+    const int group = influences[k].group;
+    const float weight = influences[k].weight;
+    if (data->defnrToPC[group] == NULL) {
+      continue;
+    }
+    *r_deformed = true;
+    if (weight == 0.0f) {
+      continue;
+    }
+    *r_contrib += weight;
+
+    float tmp[3];
+    mul_v3_m4v3(tmp, data->group_mats[group], co);
+    sub_v3_v3(tmp, co);
+    madd_v3_v3fl(r_vec, tmp, weight);
+  }
+#endif
+}
+
+static void armature_vert_task_packed(void *__restrict userdata,
+                                      const int i,
+                                      const TaskParallelTLS *__restrict tls)
+{
+  const ArmatureUserdata *data = userdata;
+  const ArmatureDeformCache *cache = data->cache;
+  const ArmatureDeformInfluence *influences = &cache->influences[cache->offsets[i]];
+  const int influences_num = cache->offsets[i + 1] - cache->offsets[i];
+  float co[3];
+  float contrib = 0.0f;
+  bool deformed = false;
+
+  copy_v3_v3(co, data->vertexCos[i]);
+
+  /* Apply the object's matrix */
+  mul_m4_v3(data->premat, co);
+
+  if (data->use_quaternion) {
+    DualQuat dq;
+    armature_deform_accumulate_dq(data, influences, influences_num, &dq, &contrib, &deformed);
+
+    if (!deformed && data->use_envelope) {
+      armature_vert_task(userdata, i, tls);
+      return;
+    }
+
+    if (contrib > 0.0001f) {
+      normalize_dq(&dq, contrib);
+      mul_v3m3_dq(co, NULL, &dq);
+    }
+  }
+  else {
+    float vec[3];
+    armature_deform_accumulate_mat(data, influences, influences_num, co, vec, &contrib, &deformed);
+
+    if (!deformed && data->use_envelope) {
+      armature_vert_task(userdata, i, tls);
+      return;
+    }
+
+    if (contrib > 0.0001f) {
+      mul_v3_fl(vec, 1.0f / contrib);
+      add_v3_v3v3(co, vec, co);
+    }
+  }
+
+  mul_m4_v3(data->postmat, co);
+  copy_v3_v3(data->vertexCos[i], co);
+}
+
+/** \} */
+
 void armature_deform_verts(Object *armOb,
                            Object *target,
                            const Mesh *mesh,
@@ -1655,7 +2004,8 @@ void armature_deform_verts(Object *armOb,
                            int deformflag,
                            float (*prevCos)[3],
                            const char *defgrp_name,
-                           bGPDstroke *gps)
+                           bGPDstroke *gps,
+                           struct ArmatureDeformCache **cache_p)
 {
   bArmature *arm = armOb->data;
   bPoseChannel **defnrToPC = NULL;
@@ -1761,11 +2111,29 @@ void armature_deform_verts(Object *armOb,
   mul_m4_m4m4(data.postmat, obinv, armOb->obmat);
   invert_m4_m4(data.premat, data.postmat);
 
+  /* Use the precompiled weights when only vertex groups are needed. */
+  const bool use_packed = (cache_p != NULL) && use_dverts && (defnrToPC != NULL) &&
+                          (target->type == OB_MESH) && (defMats == NULL) && (prevCos == NULL) &&
+                          (armature_def_nr == -1) && armature_deform_groups_init(&data);
+
   TaskParallelSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.min_iter_per_thread = 32;
-  BLI_task_parallel_range(0, numVerts, &data, armature_vert_task, &settings);
 
+  if (use_packed) {
+    data.cache = armature_deform_cache_ensure(cache_p, &data, numVerts);
+    BLI_task_parallel_range(0, numVerts, &data, armature_vert_task_packed, &settings);
+  }
+  else {
+    BLI_task_parallel_range(0, numVerts, &data, armature_vert_task, &settings);
+  }
+
+  if (data.group_mats) {
+    MEM_freeN(data.group_mats);
+  }
+  if (data.group_dqs) {
+    MEM_freeN(data.group_dqs);
+  }
   if (defnrToPC) {
     MEM_freeN(defnrToPC);
   }
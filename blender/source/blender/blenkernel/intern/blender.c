@@ -42,6 +42,7 @@
 #include "BKE_blender_user_menu.h"
 #include "BKE_blendfile.h"
 #include "BKE_brush.h"
+#include "BKE_bvhutils.h"
 #include "BKE_cachefile.h"
 #include "BKE_callbacks.h"
 #include "BKE_global.h"
@@ -49,6 +50,7 @@
 #include "BKE_image.h"
 #include "BKE_layer.h"
 #include "BKE_main.h"
+#include "BKE_mesh.h"
 #include "BKE_node.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
@@ -81,6 +83,9 @@ void BKE_blender_free(void)
   BKE_main_free(G_MAIN);
   G_MAIN = NULL;
 
+  BKE_bvhcache_shared_free(); /* after free main, meshes release their trees */
+  BKE_mesh_normals_topology_cache_free();
+
   if (G.log.file != NULL) {
     fclose(G.log.file);
   }
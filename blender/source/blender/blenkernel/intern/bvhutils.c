@@ -30,7 +30,9 @@
 #include "DNA_meshdata_types.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_linklist.h"
+#include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
 
@@ -1306,6 +1308,415 @@ static BLI_bitmap *looptri_no_hidden_map_get(const MPoly *mpoly,
   return looptri_mask;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Shared BVHCache
+ *
+ * Trees built by #BKE_bvhtree_from_mesh_get are shared between meshes with the same content,
+ * keyed by a hash of the geometry used by the tree type.
+ * Evaluated meshes are recreated by copy-on-write on every update,
+ * so without this, modifiers and tools rebuild identical trees over and over.
+ *
+ * Trees are reference counted by the #BVHCache of the meshes using them.
+ * A limited number of unused trees is kept, so they survive the evaluated mesh being freed:
+ * - When both topology and positions match, the tree is reused.
+ * - When only positions changed, an unused tree is refitted instead of being rebuilt.
+ * \{ */
+
+/** Maximum number of unused trees kept around, the least recently used are freed first. */
+#define BVHCACHE_SHARED_UNUSED_MAX 32
+
+typedef struct BVHCacheSharedKey {
+  int bvh_cache_type;
+  int tree_type;
+  /** Element counts, compared in addition to the hashes. */
+  int totvert, totedge, totface, totloop, totpoly;
+  /** Two 32 bit hashes (different seeds) of the data defining the tree elements. */
+  uint topology_hash[2];
+  /** Two 32 bit hashes (different seeds) of the vertex positions. */
+  uint positions_hash[2];
+} BVHCacheSharedKey;
+
+typedef struct BVHCacheSharedItem {
+  struct BVHCacheSharedItem *next, *prev;
+  BVHCacheSharedKey key;
+  BVHTree *tree;
+  /** Number of #BVHCache using this tree. */
+  int users;
+  /** Being refitted, not usable by others until done. */
+  bool is_updating;
+} BVHCacheSharedItem;
+
+static struct {
+  ThreadMutex mutex;
+  /** Most recently used first. */
+  ListBase items;
+  int items_unused_len;
+  BVHCacheStats stats;
+} bvhcache_shared = {
+    .mutex = BLI_MUTEX_INITIALIZER,
+};
+
+static void bvhcache_shared_hash_init(BLI_HashMurmur2A mm2[2])
+{
+  BLI_hash_mm2a_init(&mm2[0], 0);
+  BLI_hash_mm2a_init(&mm2[1], 0x9e3779b9);
+}
+
+static void bvhcache_shared_hash_add(BLI_HashMurmur2A mm2[2], const void *data, size_t len)
+{
+  BLI_hash_mm2a_add(&mm2[0], data, len);
+  BLI_hash_mm2a_add(&mm2[1], data, len);
+}
+
+static void bvhcache_shared_hash_end(BLI_HashMurmur2A mm2[2], uint r_hash[2])
+{
+  r_hash[0] = BLI_hash_mm2a_end(&mm2[0]);
+  r_hash[1] = BLI_hash_mm2a_end(&mm2[1]);
+}
+
+/**
+ * Only hash data that defines the elements of the tree of this type,
+ * so changes to selection, normals, UV's etc. don't cause the tree to be rebuilt.
+ */
+static void bvhcache_shared_key_init(BVHCacheSharedKey *key,
+                                     const Mesh *mesh,
+                                     const int bvh_cache_type,
+                                     const int tree_type)
+{
+  BLI_HashMurmur2A mm2[2];
+
+  memset(key, 0, sizeof(*key));
+  key->bvh_cache_type = bvh_cache_type;
+  key->tree_type = tree_type;
+  key->totvert = mesh->totvert;
+  key->totedge = mesh->totedge;
+  key->totface = mesh->totface;
+  key->totloop = mesh->totloop;
+  key->totpoly = mesh->totpoly;
+
+  bvhcache_shared_hash_init(mm2);
+  switch (bvh_cache_type) {
+    case BVHTREE_FROM_VERTS:
+      break;
+    case BVHTREE_FROM_LOOSEVERTS:
+    case BVHTREE_FROM_EDGES:
+    case BVHTREE_FROM_LOOSEEDGES: {
+      const MEdge *med = mesh->medge;
+      for (int i = 0; i < mesh->totedge; i++, med++) {
+        const int data[3] = {
+            (int)med->v1,
+            (int)med->v2,
+            (bvh_cache_type == BVHTREE_FROM_LOOSEEDGES) ? (med->flag & ME_LOOSEEDGE) : 0,
+        };
+        bvhcache_shared_hash_add(mm2, data, sizeof(data));
+      }
+      break;
+    }
+    case BVHTREE_FROM_FACES: {
+      const MFace *mf = mesh->mface;
+      for (int i = 0; i < mesh->totface; i++, mf++) {
+        const uint data[4] = {mf->v1, mf->v2, mf->v3, mf->v4};
+        bvhcache_shared_hash_add(mm2, data, sizeof(data));
+      }
+      break;
+    }
+    case BVHTREE_FROM_LOOPTRI:
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN: {
+      const MPoly *mp = mesh->mpoly;
+      for (int i = 0; i < mesh->totpoly; i++, mp++) {
+        const int data[3] = {
+            mp->loopstart,
+            mp->totloop,
+            (bvh_cache_type == BVHTREE_FROM_LOOPTRI_NO_HIDDEN) ? (mp->flag & ME_HIDE) : 0,
+        };
+        bvhcache_shared_hash_add(mm2, data, sizeof(data));
+      }
+      const MLoop *ml = mesh->mloop;
+      for (int i = 0; i < mesh->totloop; i++, ml++) {
+        bvhcache_shared_hash_add(mm2, &ml->v, sizeof(ml->v));
+      }
+      break;
+    }
+    default:
+      BLI_assert(0);
+      break;
+  }
+  bvhcache_shared_hash_end(mm2, key->topology_hash);
+
+  bvhcache_shared_hash_init(mm2);
+  const MVert *mv = mesh->mvert;
+  for (int i = 0; i < mesh->totvert; i++, mv++) {
+    bvhcache_shared_hash_add(mm2, mv->co, sizeof(mv->co));
+  }
+  bvhcache_shared_hash_end(mm2, key->positions_hash);
+}
+
+static bool bvhcache_shared_key_topology_eq(const BVHCacheSharedKey *a,
+                                            const BVHCacheSharedKey *b)
+{
+  return ((a->bvh_cache_type == b->bvh_cache_type) && (a->tree_type == b->tree_type) &&
+          (a->totvert == b->totvert) && (a->totedge == b->totedge) &&
+          (a->totface == b->totface) && (a->totloop == b->totloop) &&
+          (a->totpoly == b->totpoly) && (a->topology_hash[0] == b->topology_hash[0]) &&
+          (a->topology_hash[1] == b->topology_hash[1]));
+}
+
+static bool bvhcache_shared_key_positions_eq(const BVHCacheSharedKey *a,
+                                             const BVHCacheSharedKey *b)
+{
+  return ((a->positions_hash[0] == b->positions_hash[0]) &&
+          (a->positions_hash[1] == b->positions_hash[1]));
+}
+
+/**
+ * Update the bounds of \a tree from the positions of \a mesh,
+ * nodes are updated in the same order they were inserted by #BKE_bvhtree_from_mesh_get.
+ */
+static void bvhcache_shared_refit(BVHTree *tree, Mesh *mesh, const int bvh_cache_type)
+{
+  const MVert *mvert = mesh->mvert;
+  int node_index = 0;
+
+  switch (bvh_cache_type) {
+    case BVHTREE_FROM_VERTS:
+    case BVHTREE_FROM_LOOSEVERTS: {
+      BLI_bitmap *mask = NULL;
+      int mask_len;
+      if (bvh_cache_type == BVHTREE_FROM_LOOSEVERTS) {
+        mask = loose_verts_map_get(mesh->medge, mesh->totedge, mvert, mesh->totvert, &mask_len);
+      }
+      for (int i = 0; i < mesh->totvert; i++) {
+        if (mask == NULL || BLI_BITMAP_TEST_BOOL(mask, i)) {
+          BLI_bvhtree_update_node(tree, node_index++, mvert[i].co, NULL, 1);
+        }
+      }
+      MEM_SAFE_FREE(mask);
+      break;
+    }
+    case BVHTREE_FROM_EDGES:
+    case BVHTREE_FROM_LOOSEEDGES: {
+      BLI_bitmap *mask = NULL;
+      int mask_len;
+      if (bvh_cache_type == BVHTREE_FROM_LOOSEEDGES) {
+        mask = loose_edges_map_get(mesh->medge, mesh->totedge, &mask_len);
+      }
+      for (int i = 0; i < mesh->totedge; i++) {
+        if (mask == NULL || BLI_BITMAP_TEST_BOOL(mask, i)) {
+          float co[2][3];
+          copy_v3_v3(co[0], mvert[mesh->medge[i].v1].co);
+          copy_v3_v3(co[1], mvert[mesh->medge[i].v2].co);
+          BLI_bvhtree_update_node(tree, node_index++, co[0], NULL, 2);
+        }
+      }
+      MEM_SAFE_FREE(mask);
+      break;
+    }
+    case BVHTREE_FROM_FACES: {
+      for (int i = 0; i < mesh->totface; i++) {
+        const MFace *mf = &mesh->mface[i];
+        float co[4][3];
+        copy_v3_v3(co[0], mvert[mf->v1].co);
+        copy_v3_v3(co[1], mvert[mf->v2].co);
+        copy_v3_v3(co[2], mvert[mf->v3].co);
+        if (mf->v4) {
+          copy_v3_v3(co[3], mvert[mf->v4].co);
+        }
+        BLI_bvhtree_update_node(tree, node_index++, co[0], NULL, mf->v4 ? 4 : 3);
+      }
+      break;
+    }
+    case BVHTREE_FROM_LOOPTRI:
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN: {
+      const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+      const int looptri_len = BKE_mesh_runtime_looptri_len(mesh);
+      const MLoop *mloop = mesh->mloop;
+      BLI_bitmap *mask = NULL;
+      int mask_len;
+      if (bvh_cache_type == BVHTREE_FROM_LOOPTRI_NO_HIDDEN) {
+        mask = looptri_no_hidden_map_get(mesh->mpoly, looptri_len, &mask_len);
+      }
+      for (int i = 0; i < looptri_len; i++) {
+        if (mask == NULL || BLI_BITMAP_TEST_BOOL(mask, i)) {
+          float co[3][3];
+          copy_v3_v3(co[0], mvert[mloop[looptri[i].tri[0]].v].co);
+          copy_v3_v3(co[1], mvert[mloop[looptri[i].tri[1]].v].co);
+          copy_v3_v3(co[2], mvert[mloop[looptri[i].tri[2]].v].co);
+          BLI_bvhtree_update_node(tree, node_index++, co[0], NULL, 3);
+        }
+      }
+      MEM_SAFE_FREE(mask);
+      break;
+    }
+    default:
+      BLI_assert(0);
+      break;
+  }
+
+  BLI_assert(node_index == BLI_bvhtree_get_len(tree));
+  BLI_bvhtree_update_tree(tree);
+}
+
+static void bvhcache_shared_item_free(BVHCacheSharedItem *item)
+{
+  BLI_bvhtree_free(item->tree);
+  MEM_freeN(item);
+}
+
+/**
+ * Find a tree matching \a key, refitting an unused tree with the same topology if needed.
+ * The returned tree has a user added, NULL is returned when a new tree needs to be built.
+ */
+static BVHTree *bvhcache_shared_acquire(const BVHCacheSharedKey *key, Mesh *mesh)
+{
+  BVHCacheSharedItem *item_refit = NULL;
+
+  BLI_mutex_lock(&bvhcache_shared.mutex);
+  LISTBASE_FOREACH (BVHCacheSharedItem *, item, &bvhcache_shared.items) {
+    if (item->is_updating || !bvhcache_shared_key_topology_eq(&item->key, key)) {
+      continue;
+    }
+    if (bvhcache_shared_key_positions_eq(&item->key, key)) {
+      if (item->users++ == 0) {
+        bvhcache_shared.items_unused_len--;
+      }
+      BLI_remlink(&bvhcache_shared.items, item);
+      BLI_addhead(&bvhcache_shared.items, item);
+      bvhcache_shared.stats.hits++;
+      BLI_mutex_unlock(&bvhcache_shared.mutex);
+      return item->tree;
+    }
+    if ((item_refit == NULL) && (item->users == 0)) {
+      item_refit = item;
+    }
+  }
+
+  if (item_refit == NULL) {
+    bvhcache_shared.stats.misses++;
+    BLI_mutex_unlock(&bvhcache_shared.mutex);
+    return NULL;
+  }
+
+  /* Take ownership and update the key first,
+   * so the tree isn't matched with the old positions while refitting. */
+  item_refit->users = 1;
+  item_refit->is_updating = true;
+  item_refit->key = *key;
+  bvhcache_shared.items_unused_len--;
+  BLI_remlink(&bvhcache_shared.items, item_refit);
+  BLI_addhead(&bvhcache_shared.items, item_refit);
+  bvhcache_shared.stats.refits++;
+  BLI_mutex_unlock(&bvhcache_shared.mutex);
+
+  bvhcache_shared_refit(item_refit->tree, mesh, key->bvh_cache_type);
+
+  BLI_mutex_lock(&bvhcache_shared.mutex);
+  item_refit->is_updating = false;
+  BLI_mutex_unlock(&bvhcache_shared.mutex);
+
+  return item_refit->tree;
+}
+
+/**
+ * Add a newly built \a tree to the shared cache, with a single user.
+ */
+static void bvhcache_shared_add(const BVHCacheSharedKey *key, BVHTree *tree)
+{
+  BVHCacheSharedItem *item = MEM_callocN(sizeof(*item), __func__);
+  item->key = *key;
+  item->tree = tree;
+  item->users = 1;
+
+  BLI_mutex_lock(&bvhcache_shared.mutex);
+  BLI_addhead(&bvhcache_shared.items, item);
+  BLI_mutex_unlock(&bvhcache_shared.mutex);
+}
+
+/**
+ * Remove a user from a shared \a tree, keeping it for later use when it's unused.
+ */
+static void bvhcache_shared_release(BVHTree *tree)
+{
+  BVHCacheSharedItem *item_free = NULL;
+
+  BLI_mutex_lock(&bvhcache_shared.mutex);
+  LISTBASE_FOREACH (BVHCacheSharedItem *, item, &bvhcache_shared.items) {
+    if (item->tree == tree) {
+      BLI_assert(item->users > 0);
+      if (--item->users == 0) {
+        bvhcache_shared.items_unused_len++;
+        BLI_remlink(&bvhcache_shared.items, item);
+        BLI_addhead(&bvhcache_shared.items, item);
+      }
+      break;
+    }
+  }
+
+  /* Remove the least recently used tree while locked, free it after. */
+  if (bvhcache_shared.items_unused_len > BVHCACHE_SHARED_UNUSED_MAX) {
+    for (BVHCacheSharedItem *item = bvhcache_shared.items.last; item; item = item->prev) {
+      if (item->users == 0) {
+        BLI_remlink(&bvhcache_shared.items, item);
+        bvhcache_shared.items_unused_len--;
+        bvhcache_shared.stats.frees++;
+        item_free = item;
+        break;
+      }
+    }
+  }
+  BLI_mutex_unlock(&bvhcache_shared.mutex);
+
+  if (item_free) {
+    bvhcache_shared_item_free(item_free);
+  }
+}
+
+/**
+ * Free all unused shared trees, call on exit (all meshes must have been freed).
+ */
+void BKE_bvhcache_shared_free(void)
+{
+  BLI_mutex_lock(&bvhcache_shared.mutex);
+  for (BVHCacheSharedItem *item = bvhcache_shared.items.first, *item_next; item;
+       item = item_next) {
+    item_next = item->next;
+    BLI_assert(item->users == 0);
+    if (item->users == 0) {
+      BLI_remlink(&bvhcache_shared.items, item);
+      bvhcache_shared_item_free(item);
+    }
+  }
+  bvhcache_shared.items_unused_len = 0;
+  BLI_mutex_unlock(&bvhcache_shared.mutex);
+}
+
+void BKE_bvhcache_shared_stats_get(BVHCacheStats *r_stats)
+{
+  BLI_mutex_lock(&bvhcache_shared.mutex);
+  *r_stats = bvhcache_shared.stats;
+  r_stats->trees_len = BLI_listbase_count(&bvhcache_shared.items);
+  r_stats->trees_unused_len = bvhcache_shared.items_unused_len;
+  BLI_mutex_unlock(&bvhcache_shared.mutex);
+}
+
+void BKE_bvhcache_shared_stats_print(void)
+{
+  BVHCacheStats stats;
+  BKE_bvhcache_shared_stats_get(&stats);
+  printf("BVH cache: %d trees (%d unused), %u hits, %u refits, %u misses, %u freed\n",
+         stats.trees_len,
+         stats.trees_unused_len,
+         stats.hits,
+         stats.refits,
+         stats.misses,
+         stats.frees);
+}
+
+/** \} */
+
+/* Used by #BKE_bvhtree_from_mesh_get to store shared trees in the mesh cache. */
+static void bvhcache_insert_shared(BVHCache **cache_p, BVHTree *tree, int type);
+static bool bvhcache_tag_shared(BVHCache *cache, const BVHTree *tree);
+
 /**
  * Builds or queries a bvhcache for the cache bvhtree of the request type.
  */
@@ -1316,6 +1727,7 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
 {
   BVHTree *tree = NULL;
   BVHCache **bvh_cache = &mesh->runtime.bvh_cache;
+  BVHCacheSharedKey shared_key;
 
   BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_READ);
   bool is_cached = bvhcache_find(*bvh_cache, bvh_cache_type, &tree);
@@ -1326,6 +1738,32 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
     return tree;
   }
 
+  const bool use_shared = (is_cached == false);
+  if (use_shared) {
+    /* Use a tree built for another mesh with the same content (or refit one). */
+    bvhcache_shared_key_init(&shared_key, mesh, bvh_cache_type, tree_type);
+    BVHTree *tree_shared = bvhcache_shared_acquire(&shared_key, mesh);
+    if (tree_shared) {
+      BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
+      is_cached = bvhcache_find(*bvh_cache, bvh_cache_type, &tree);
+      if (is_cached == false) {
+        bvhcache_insert_shared(bvh_cache, tree_shared, bvh_cache_type);
+        tree = tree_shared;
+        is_cached = true;
+        tree_shared = NULL;
+      }
+      BLI_rw_mutex_unlock(&cache_rwlock);
+      if (tree_shared) {
+        /* Another thread added a tree in the meantime. */
+        bvhcache_shared_release(tree_shared);
+      }
+      if (tree == NULL) {
+        memset(data, 0, sizeof(*data));
+        return tree;
+      }
+    }
+  }
+
   switch (bvh_cache_type) {
     case BVHTREE_FROM_VERTS:
     case BVHTREE_FROM_LOOSEVERTS:
@@ -1477,6 +1915,15 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
     }
 #endif
     BLI_assert(data->cached);
+
+    if (use_shared && (is_cached == false)) {
+      /* Share the newly built tree (unless another thread built and shared it already). */
+      BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
+      if (bvhcache_tag_shared(*bvh_cache, data->tree)) {
+        bvhcache_shared_add(&shared_key, data->tree);
+      }
+      BLI_rw_mutex_unlock(&cache_rwlock);
+    }
   }
   else {
     free_bvhtree_from_mesh(data);
@@ -1623,7 +2070,8 @@ void free_bvhtree_from_mesh(struct BVHTreeFromMesh *data)
 typedef struct BVHCacheItem {
   int type;
   BVHTree *tree;
-
+  /** The tree is owned by the shared cache, see #bvhcache_shared_acquire. */
+  bool is_shared;
 } BVHCacheItem;
 
 /**
@@ -1672,10 +2120,39 @@ void bvhcache_insert(BVHCache **cache_p, BVHTree *tree, int type)
 
   item->type = type;
   item->tree = tree;
+  item->is_shared = false;
 
   BLI_linklist_prepend(cache_p, item);
 }
 
+static void bvhcache_insert_shared(BVHCache **cache_p, BVHTree *tree, int type)
+{
+  bvhcache_insert(cache_p, tree, type);
+  ((BVHCacheItem *)(*cache_p)->link)->is_shared = true;
+}
+
+/**
+ * Tag \a tree as owned by the shared cache.
+ *
+ * \return false when it was already tagged.
+ */
+static bool bvhcache_tag_shared(BVHCache *cache, const BVHTree *tree)
+{
+  while (cache) {
+    BVHCacheItem *item = cache->link;
+    if (item->tree == tree) {
+      if (item->is_shared) {
+        return false;
+      }
+      item->is_shared = true;
+      return true;
+    }
+    cache = cache->next;
+  }
+  BLI_assert(0);
+  return false;
+}
+
 /**
  * frees a bvhcache
  */
@@ -1683,7 +2160,12 @@ static void bvhcacheitem_free(void *_item)
 {
   BVHCacheItem *item = (BVHCacheItem *)_item;
 
-  BLI_bvhtree_free(item->tree);
+  if (item->is_shared) {
+    bvhcache_shared_release(item->tree);
+  }
+  else {
+    BLI_bvhtree_free(item->tree);
+  }
   MEM_freeN(item);
 }
 
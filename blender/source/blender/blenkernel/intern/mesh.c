@@ -1626,6 +1626,9 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   /* may be NULL */
   clnors = CustomData_get_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL);
 
+  /* Meshes only deformed reuse their topology data (NULL otherwise). */
+  struct MeshNormalsTopology *topology = BKE_mesh_normals_topology_acquire(mesh);
+
   if (CustomData_has_layer(&mesh->pdata, CD_NORMAL)) {
     /* This assume that layer is always up to date, not sure this is the case
      * (esp. in Edit mode?)... */
@@ -1634,33 +1637,48 @@ void BKE_mesh_calc_normals_split_ex(Mesh *mesh, MLoopNorSpaceArray *r_lnors_spac
   }
   else {
     polynors = MEM_malloc_arrayN(mesh->totpoly, sizeof(float[3]), __func__);
-    BKE_mesh_calc_normals_poly(mesh->mvert,
-                               NULL,
-                               mesh->totvert,
-                               mesh->mloop,
-                               mesh->mpoly,
-                               mesh->totloop,
-                               mesh->totpoly,
-                               polynors,
-                               false);
+    if (topology) {
+      BKE_mesh_calc_normals_poly_topology(mesh, topology, polynors);
+    }
+    else {
+      BKE_mesh_calc_normals_poly(mesh->mvert,
+                                 NULL,
+                                 mesh->totvert,
+                                 mesh->mloop,
+                                 mesh->mpoly,
+                                 mesh->totloop,
+                                 mesh->totpoly,
+                                 polynors,
+                                 false);
+    }
     free_polynors = true;
   }
 
-  BKE_mesh_normals_loop_split(mesh->mvert,
-                              mesh->totvert,
-                              mesh->medge,
-                              mesh->totedge,
-                              mesh->mloop,
-                              r_loopnors,
-                              mesh->totloop,
-                              mesh->mpoly,
-                              (const float(*)[3])polynors,
-                              mesh->totpoly,
-                              use_split_normals,
-                              split_angle,
-                              r_lnors_spacearr,
-                              clnors,
-                              NULL);
+  if (topology && use_split_normals && (r_lnors_spacearr == NULL) && (clnors == NULL)) {
+    BKE_mesh_normals_loop_split_topology(
+        mesh, topology, (const float(*)[3])polynors, split_angle, r_loopnors);
+  }
+  else {
+    BKE_mesh_normals_loop_split(mesh->mvert,
+                                mesh->totvert,
+                                mesh->medge,
+                                mesh->totedge,
+                                mesh->mloop,
+                                r_loopnors,
+                                mesh->totloop,
+                                mesh->mpoly,
+                                (const float(*)[3])polynors,
+                                mesh->totpoly,
+                                use_split_normals,
+                                split_angle,
+                                r_lnors_spacearr,
+                                clnors,
+                                NULL);
+  }
+
+  if (topology) {
+    BKE_mesh_normals_topology_release(topology);
+  }
 
   if (free_polynors) {
     MEM_freeN(polynors);
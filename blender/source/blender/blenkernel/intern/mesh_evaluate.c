@@ -38,12 +38,14 @@
 #include "BLI_math.h"
 #include "BLI_edgehash.h"
 #include "BLI_bitmap.h"
+#include "BLI_listbase.h"
 #include "BLI_polyfill_2d.h"
 #include "BLI_linklist.h"
 #include "BLI_linklist_stack.h"
 #include "BLI_alloca.h"
 #include "BLI_stack.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_customdata.h"
 #include "BKE_global.h"
@@ -407,15 +409,24 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
     }
 
     /* calculate poly/vert normals */
-    BKE_mesh_calc_normals_poly(mesh->mvert,
-                               NULL,
-                               mesh->totvert,
-                               mesh->mloop,
-                               mesh->mpoly,
-                               mesh->totloop,
-                               mesh->totpoly,
-                               poly_nors,
-                               !do_vert_normals);
+    struct MeshNormalsTopology *topology = do_vert_normals ?
+                                               BKE_mesh_normals_topology_acquire(mesh) :
+                                               NULL;
+    if (topology) {
+      BKE_mesh_calc_normals_poly_topology(mesh, topology, poly_nors);
+      BKE_mesh_normals_topology_release(topology);
+    }
+    else {
+      BKE_mesh_calc_normals_poly(mesh->mvert,
+                                 NULL,
+                                 mesh->totvert,
+                                 mesh->mloop,
+                                 mesh->mpoly,
+                                 mesh->totloop,
+                                 mesh->totpoly,
+                                 poly_nors,
+                                 !do_vert_normals);
+    }
 
     if (do_add_poly_nors_cddata) {
       CustomData_add_layer(&mesh->pdata, CD_NORMAL, CD_ASSIGN, poly_nors, mesh->totpoly);
@@ -433,15 +444,22 @@ void BKE_mesh_calc_normals(Mesh *mesh)
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(BKE_mesh_calc_normals);
 #endif
-  BKE_mesh_calc_normals_poly(mesh->mvert,
-                             NULL,
-                             mesh->totvert,
-                             mesh->mloop,
-                             mesh->mpoly,
-                             mesh->totloop,
-                             mesh->totpoly,
-                             NULL,
-                             false);
+  struct MeshNormalsTopology *topology = BKE_mesh_normals_topology_acquire(mesh);
+  if (topology) {
+    BKE_mesh_calc_normals_poly_topology(mesh, topology, NULL);
+    BKE_mesh_normals_topology_release(topology);
+  }
+  else {
+    BKE_mesh_calc_normals_poly(mesh->mvert,
+                               NULL,
+                               mesh->totvert,
+                               mesh->mloop,
+                               mesh->mpoly,
+                               mesh->totloop,
+                               mesh->totpoly,
+                               NULL,
+                               false);
+  }
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(BKE_mesh_calc_normals);
 #endif
@@ -1732,6 +1750,809 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
 #endif
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Mesh Normals Topology Cache
+ *
+ * Meshes only deformed from their original (armature, shape keys, mesh cache...) keep the same
+ * topology on every update, yet the vertex to loop and edge to loop mappings, and the partition
+ * of loops into smooth fans, used to be rebuilt with the normals every time.
+ *
+ * Those are kept in a shared cache keyed by a hash of the topology, since evaluated meshes are
+ * recreated on every update, they can't be stored in the mesh runtime data.
+ * Normals are then computed with gather-only passes, threaded over vertices and smooth fans,
+ * giving exactly the same results as #BKE_mesh_calc_normals_poly and
+ * #BKE_mesh_normals_loop_split.
+ *
+ * Smooth fans also depend on the auto-smooth angle, the edges it makes sharp are checked on
+ * every update and fans are only rebuilt when those change.
+ * \{ */
+
+/** Smaller meshes are not worth caching. */
+#define MESH_NORMALS_TOPOLOGY_LOOPS_MIN 4096
+/** Maximum number of unused topologies kept around, the least recently used are freed first. */
+#define MESH_NORMALS_TOPOLOGY_UNUSED_MAX 16
+
+typedef struct MeshNormalsFans {
+  /** Number of users, the #MeshNormalsTopology storing it and normal calculations using it. */
+  int users;
+
+  /** Cosine of the auto-smooth angle the fans were built for, -1 when the angle isn't used. */
+  float split_angle_cos;
+  /** Per edge, sharp because of the auto-smooth angle (NULL when the angle isn't used). */
+  uchar *edge_angle_sharp;
+
+  /** Loops using the normal of their polygon (both edges around the vertex are sharp). */
+  int *single_loops;
+  int singles_len;
+
+  /**
+   * Entries of fan `i` are `fan_offsets[i]` up to `fan_offsets[i + 1]`, in the order the fan
+   * is walked by #split_loop_nor_fan_do (the order normals are accumulated in).
+   */
+  int *fan_offsets;
+  /** Vertex fanned around, and other vertex of the edge the walk starts from. */
+  int (*fan_verts)[2];
+  int fans_len;
+  /** Per entry, the loop of the fanned vertex, its polygon and the other vertex of the edge. */
+  int *entry_loops;
+  int *entry_polys;
+  int *entry_verts;
+
+  /** Loops in no fan, which keep the vertex normal. */
+  int *other_loops;
+  int others_len;
+} MeshNormalsFans;
+
+typedef struct MeshNormalsTopologyKey {
+  int totvert, totedge, totloop, totpoly;
+  /** Hash of the loops, polygons and edges. */
+  uint64_t hash;
+} MeshNormalsTopologyKey;
+
+typedef struct MeshNormalsTopology {
+  struct MeshNormalsTopology *next, *prev;
+  MeshNormalsTopologyKey key;
+  int users;
+
+  /** Loops of vertex `i` are `vert_loops[vert_loop_offsets[i]]` up to
+   * `vert_loops[vert_loop_offsets[i + 1]]`, in ascending order. */
+  int *vert_loop_offsets;
+  int *vert_loops;
+  int *loop_to_poly;
+  /** Mapping edge -> loops as in #BKE_mesh_normals_loop_split,
+   * with only the edges sharp regardless of the auto-smooth angle tagged. */
+  int (*edge_to_loops)[2];
+
+  /** Fans built for the last auto-smooth settings used, may be NULL. */
+  MeshNormalsFans *fans;
+} MeshNormalsTopology;
+
+static struct {
+  ThreadMutex mutex;
+  /** Most recently used first. */
+  ListBase items;
+  int items_unused_len;
+  MeshNormalsTopologyStats stats;
+} normals_topology_cache = {
+    .mutex = BLI_MUTEX_INITIALIZER,
+};
+
+#define HASH_LANES 4
+#define HASH_PRIME ((uint64_t)0x9e3779b97f4a7c15)
+#define HASH_ROTL(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+/**
+ * Hash of \a data, reading 64 bit words into independent lanes.
+ * Topology arrays of large meshes are hashed on every update,
+ * this is several times faster than #BLI_hash_mm2a which is bound by its dependency chain.
+ */
+static uint64_t mesh_normals_topology_hash(const uint64_t seed, const void *data, const size_t len)
+{
+  const uchar *ptr = data;
+  const size_t words_len = len / sizeof(uint64_t);
+  uint64_t lanes[HASH_LANES];
+  size_t i = 0;
+
+  for (int lane = 0; lane < HASH_LANES; lane++) {
+    lanes[lane] = seed + (uint64_t)lane * HASH_PRIME;
+  }
+
+  for (; i + HASH_LANES <= words_len; i += HASH_LANES) {
+    for (int lane = 0; lane < HASH_LANES; lane++) {
+      uint64_t word;
+      memcpy(&word, ptr + (i + (size_t)lane) * sizeof(word), sizeof(word));
+      lanes[lane] = HASH_ROTL((lanes[lane] ^ word) * HASH_PRIME, 31);
+    }
+  }
+
+  /* Remaining words and bytes. */
+  uint64_t tail[HASH_LANES + 1] = {0};
+  memcpy(tail, ptr + i * sizeof(uint64_t), len - i * sizeof(uint64_t));
+  for (int lane = 0; lane < HASH_LANES + 1; lane++) {
+    lanes[lane % HASH_LANES] = HASH_ROTL((lanes[lane % HASH_LANES] ^ tail[lane]) * HASH_PRIME, 31);
+  }
+
+  /* Combine lanes, with the final mix of MurmurHash3. */
+  uint64_t hash = (uint64_t)len;
+  for (int lane = 0; lane < HASH_LANES; lane++) {
+    hash = HASH_ROTL(hash ^ lanes[lane], 27) * HASH_PRIME;
+  }
+  hash ^= hash >> 33;
+  hash *= (uint64_t)0xff51afd7ed558ccd;
+  hash ^= hash >> 33;
+  hash *= (uint64_t)0xc4ceb9fe1a85ec53;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+#undef HASH_LANES
+#undef HASH_PRIME
+#undef HASH_ROTL
+
+static void mesh_normals_topology_key_init(MeshNormalsTopologyKey *key, const Mesh *mesh)
+{
+  memset(key, 0, sizeof(*key));
+  key->totvert = mesh->totvert;
+  key->totedge = mesh->totedge;
+  key->totloop = mesh->totloop;
+  key->totpoly = mesh->totpoly;
+
+  /* Hashing whole arrays is much faster than picking the members used,
+   * other members (selection, material...) don't change while deforming. */
+  uint64_t hash = 0;
+  hash = mesh_normals_topology_hash(
+      hash, mesh->mloop, sizeof(*mesh->mloop) * (size_t)mesh->totloop);
+  hash = mesh_normals_topology_hash(
+      hash, mesh->mpoly, sizeof(*mesh->mpoly) * (size_t)mesh->totpoly);
+  hash = mesh_normals_topology_hash(
+      hash, mesh->medge, sizeof(*mesh->medge) * (size_t)mesh->totedge);
+  key->hash = hash;
+}
+
+static void mesh_normals_topology_stats_add(const MeshNormalsTopologyStats *stats)
+{
+  BLI_mutex_lock(&normals_topology_cache.mutex);
+  MeshNormalsTopologyStats *stats_dst = &normals_topology_cache.stats;
+  stats_dst->hits += stats->hits;
+  stats_dst->misses += stats->misses;
+  stats_dst->fans_hits += stats->fans_hits;
+  stats_dst->fans_builds += stats->fans_builds;
+  stats_dst->time_lookup += stats->time_lookup;
+  stats_dst->time_build += stats->time_build;
+  stats_dst->time_poly_normals += stats->time_poly_normals;
+  stats_dst->time_vert_normals += stats->time_vert_normals;
+  stats_dst->time_fans += stats->time_fans;
+  stats_dst->time_loop_normals += stats->time_loop_normals;
+  BLI_mutex_unlock(&normals_topology_cache.mutex);
+}
+
+static MeshNormalsTopology *mesh_normals_topology_build(const Mesh *mesh,
+                                                        const MeshNormalsTopologyKey *key)
+{
+  const int totvert = mesh->totvert;
+  const int totloop = mesh->totloop;
+  const MLoop *mloop = mesh->mloop;
+
+  MeshNormalsTopology *topology = MEM_callocN(sizeof(*topology), __func__);
+  topology->key = *key;
+  topology->users = 1;
+
+  /* Vertex to loops, loops are added in order so they are sorted. */
+  int *offsets = MEM_calloc_arrayN((size_t)totvert + 1, sizeof(*offsets), __func__);
+  int *vert_loops = MEM_malloc_arrayN((size_t)totloop, sizeof(*vert_loops), __func__);
+  for (int i = 0; i < totloop; i++) {
+    offsets[mloop[i].v + 1]++;
+  }
+  for (int i = 0; i < totvert; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  int *fill = MEM_malloc_arrayN((size_t)totvert, sizeof(*fill), __func__);
+  memcpy(fill, offsets, sizeof(*fill) * (size_t)totvert);
+  for (int i = 0; i < totloop; i++) {
+    vert_loops[fill[mloop[i].v]++] = i;
+  }
+  MEM_freeN(fill);
+  topology->vert_loop_offsets = offsets;
+  topology->vert_loops = vert_loops;
+
+  /* Loop to poly and edge to loops, without the auto-smooth angle. */
+  topology->loop_to_poly = MEM_malloc_arrayN((size_t)totloop, sizeof(int), __func__);
+  topology->edge_to_loops = MEM_calloc_arrayN((size_t)mesh->totedge, sizeof(int[2]), __func__);
+
+  LoopSplitTaskDataCommon common_data = {
+      .mverts = mesh->mvert,
+      .medges = mesh->medge,
+      .mloops = mloop,
+      .mpolys = mesh->mpoly,
+      .edge_to_loops = topology->edge_to_loops,
+      .loop_to_poly = topology->loop_to_poly,
+      .numEdges = mesh->totedge,
+      .numLoops = totloop,
+      .numPolys = mesh->totpoly,
+  };
+  mesh_edges_sharp_tag(&common_data, false, (float)M_PI, false);
+
+  return topology;
+}
+
+static void mesh_normals_fans_free(MeshNormalsFans *fans)
+{
+  MEM_SAFE_FREE(fans->edge_angle_sharp);
+  MEM_SAFE_FREE(fans->single_loops);
+  MEM_SAFE_FREE(fans->fan_offsets);
+  MEM_SAFE_FREE(fans->fan_verts);
+  MEM_SAFE_FREE(fans->entry_loops);
+  MEM_SAFE_FREE(fans->entry_polys);
+  MEM_SAFE_FREE(fans->entry_verts);
+  MEM_SAFE_FREE(fans->other_loops);
+  MEM_freeN(fans);
+}
+
+/**
+ * Remove a user from \a fans, freeing them when unused.
+ * \note Must be called with the cache locked, the caller frees the returned fans (if any).
+ */
+static MeshNormalsFans *mesh_normals_fans_release_locked(MeshNormalsFans *fans)
+{
+  BLI_assert(fans->users > 0);
+  return (--fans->users == 0) ? fans : NULL;
+}
+
+static void mesh_normals_topology_free(MeshNormalsTopology *topology)
+{
+  if (topology->fans && mesh_normals_fans_release_locked(topology->fans)) {
+    mesh_normals_fans_free(topology->fans);
+  }
+  MEM_freeN(topology->vert_loop_offsets);
+  MEM_freeN(topology->vert_loops);
+  MEM_freeN(topology->loop_to_poly);
+  MEM_freeN(topology->edge_to_loops);
+  MEM_freeN(topology);
+}
+
+/**
+ * Get the cached topology of \a mesh, building it if needed.
+ *
+ * \return NULL when \a mesh doesn't use the cache (it isn't only deformed or too small),
+ * the caller has to use the regular normal calculations then.
+ * Otherwise the topology must be released with #BKE_mesh_normals_topology_release after use.
+ */
+MeshNormalsTopology *BKE_mesh_normals_topology_acquire(const Mesh *mesh)
+{
+  if (!mesh->runtime.deformed_only || (mesh->totloop < MESH_NORMALS_TOPOLOGY_LOOPS_MIN)) {
+    return NULL;
+  }
+
+  MeshNormalsTopologyStats stats = {0};
+  MeshNormalsTopologyKey key;
+  MeshNormalsTopology *topology = NULL;
+
+  double time_start = PIL_check_seconds_timer();
+  mesh_normals_topology_key_init(&key, mesh);
+
+  BLI_mutex_lock(&normals_topology_cache.mutex);
+  LISTBASE_FOREACH (MeshNormalsTopology *, item, &normals_topology_cache.items) {
+    if (memcmp(&item->key, &key, sizeof(key)) == 0) {
+      if (item->users++ == 0) {
+        normals_topology_cache.items_unused_len--;
+      }
+      BLI_remlink(&normals_topology_cache.items, item);
+      BLI_addhead(&normals_topology_cache.items, item);
+      topology = item;
+      break;
+    }
+  }
+  BLI_mutex_unlock(&normals_topology_cache.mutex);
+
+  double time_end = PIL_check_seconds_timer();
+  stats.time_lookup = time_end - time_start;
+
+  if (topology) {
+    stats.hits = 1;
+  }
+  else {
+    /* Another thread may build the same topology meanwhile, it's only stored twice then. */
+    topology = mesh_normals_topology_build(mesh, &key);
+    stats.misses = 1;
+    stats.time_build = PIL_check_seconds_timer() - time_end;
+
+    BLI_mutex_lock(&normals_topology_cache.mutex);
+    BLI_addhead(&normals_topology_cache.items, topology);
+    BLI_mutex_unlock(&normals_topology_cache.mutex);
+  }
+
+  mesh_normals_topology_stats_add(&stats);
+  return topology;
+}
+
+/**
+ * Remove a user from \a topology, keeping it for later use when it's unused.
+ */
+void BKE_mesh_normals_topology_release(MeshNormalsTopology *topology)
+{
+  MeshNormalsTopology *item_free = NULL;
+
+  BLI_mutex_lock(&normals_topology_cache.mutex);
+  BLI_assert(topology->users > 0);
+  if (--topology->users == 0) {
+    normals_topology_cache.items_unused_len++;
+  }
+
+  /* Remove the least recently used topology while locked, free it after. */
+  if (normals_topology_cache.items_unused_len > MESH_NORMALS_TOPOLOGY_UNUSED_MAX) {
+    for (MeshNormalsTopology *item = normals_topology_cache.items.last; item; item = item->prev) {
+      if (item->users == 0) {
+        BLI_remlink(&normals_topology_cache.items, item);
+        normals_topology_cache.items_unused_len--;
+        normals_topology_cache.stats.frees++;
+        item_free = item;
+        break;
+      }
+    }
+  }
+  /* Fans are reference counted under the lock too. */
+  if (item_free) {
+    mesh_normals_topology_free(item_free);
+  }
+  BLI_mutex_unlock(&normals_topology_cache.mutex);
+}
+
+/**
+ * Free all unused topologies, call on exit (all users must have released them).
+ */
+void BKE_mesh_normals_topology_cache_free(void)
+{
+  BLI_mutex_lock(&normals_topology_cache.mutex);
+  for (MeshNormalsTopology *item = normals_topology_cache.items.first, *item_next; item;
+       item = item_next) {
+    item_next = item->next;
+    BLI_assert(item->users == 0);
+    if (item->users == 0) {
+      BLI_remlink(&normals_topology_cache.items, item);
+      mesh_normals_topology_free(item);
+    }
+  }
+  normals_topology_cache.items_unused_len = 0;
+  BLI_mutex_unlock(&normals_topology_cache.mutex);
+}
+
+void BKE_mesh_normals_topology_stats_get(MeshNormalsTopologyStats *r_stats)
+{
+  BLI_mutex_lock(&normals_topology_cache.mutex);
+  *r_stats = normals_topology_cache.stats;
+  r_stats->topologies_len = BLI_listbase_count(&normals_topology_cache.items);
+  r_stats->topologies_unused_len = normals_topology_cache.items_unused_len;
+  BLI_mutex_unlock(&normals_topology_cache.mutex);
+}
+
+void BKE_mesh_normals_topology_stats_print(void)
+{
+  MeshNormalsTopologyStats stats;
+  BKE_mesh_normals_topology_stats_get(&stats);
+  printf("Normals topology cache: %d topologies (%d unused), %u hits, %u misses, %u freed\n",
+         stats.topologies_len,
+         stats.topologies_unused_len,
+         stats.hits,
+         stats.misses,
+         stats.frees);
+  printf("  smooth fans: %u reused, %u built\n", stats.fans_hits, stats.fans_builds);
+  printf("  time (ms): lookup %.3f, build %.3f, poly normals %.3f, vertex normals %.3f, "
+         "fans %.3f, loop normals %.3f\n",
+         stats.time_lookup * 1e3,
+         stats.time_build * 1e3,
+         stats.time_poly_normals * 1e3,
+         stats.time_vert_normals * 1e3,
+         stats.time_fans * 1e3,
+         stats.time_loop_normals * 1e3);
+}
+
+typedef struct MeshNormalsTopologyData {
+  const MeshNormalsTopology *topology;
+  const MeshNormalsFans *fans;
+  MVert *mverts;
+  const MEdge *medges;
+  const MLoop *mloops;
+  const float (*polynors)[3];
+  const float (*lnors_weighted)[3];
+  float split_angle_cos;
+  uchar *edge_angle_sharp;
+  float (*loopnors)[3];
+} MeshNormalsTopologyData;
+
+static void mesh_calc_normals_vert_gather_cb(void *__restrict userdata,
+                                             const int vidx,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshNormalsTopologyData *data = userdata;
+  const MeshNormalsTopology *topology = data->topology;
+  const int *loop = &topology->vert_loops[topology->vert_loop_offsets[vidx]];
+  const int *loop_end = &topology->vert_loops[topology->vert_loop_offsets[vidx + 1]];
+
+  /* Same accumulation order as the loop in #BKE_mesh_calc_normals_poly. */
+  float no[3] = {0.0f, 0.0f, 0.0f};
+  for (; loop != loop_end; loop++) {
+    add_v3_v3(no, data->lnors_weighted[*loop]);
+  }
+
+  /* Same as #mesh_calc_normals_poly_finalize_cb. */
+  MVert *mv = &data->mverts[vidx];
+  if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+    /* following Mesh convention; we use vertex coordinate itself for normal in this case */
+    normalize_v3_v3(no, mv->co);
+  }
+
+  normal_float_to_short_v3(mv->no, no);
+}
+
+/**
+ * Same as #BKE_mesh_calc_normals_poly, using the vertex to loop mapping of \a topology to gather
+ * weighted loop normals into vertices in parallel.
+ *
+ * \param r_polynors: Optional, the polygon normals.
+ */
+void BKE_mesh_calc_normals_poly_topology(Mesh *mesh,
+                                         const MeshNormalsTopology *topology,
+                                         float (*r_polynors)[3])
+{
+  MeshNormalsTopologyStats stats = {0};
+  float(*lnors_weighted)[3] = MEM_malloc_arrayN(
+      (size_t)mesh->totloop, sizeof(*lnors_weighted), __func__);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  double time_start = PIL_check_seconds_timer();
+
+  MeshCalcNormalsData data = {
+      .mpolys = mesh->mpoly,
+      .mloop = mesh->mloop,
+      .mverts = mesh->mvert,
+      .pnors = r_polynors,
+      .lnors_weighted = lnors_weighted,
+  };
+  BLI_task_parallel_range(0, mesh->totpoly, &data, mesh_calc_normals_poly_prepare_cb, &settings);
+
+  double time_poly = PIL_check_seconds_timer();
+  stats.time_poly_normals = time_poly - time_start;
+
+  MeshNormalsTopologyData gather_data = {
+      .topology = topology,
+      .mverts = mesh->mvert,
+      .lnors_weighted = (const float(*)[3])lnors_weighted,
+  };
+  BLI_task_parallel_range(
+      0, mesh->totvert, &gather_data, mesh_calc_normals_vert_gather_cb, &settings);
+
+  stats.time_vert_normals = PIL_check_seconds_timer() - time_poly;
+  mesh_normals_topology_stats_add(&stats);
+
+  MEM_freeN(lnors_weighted);
+}
+
+static void mesh_normals_edge_angle_sharp_cb(void *__restrict userdata,
+                                             const int eidx,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshNormalsTopologyData *data = userdata;
+  const int *e2l = data->topology->edge_to_loops[eidx];
+  const int *loop_to_poly = data->topology->loop_to_poly;
+
+  /* Only smooth edges used by two polygons are checked, see #mesh_edges_sharp_tag. */
+  data->edge_angle_sharp[eidx] = (e2l[1] > 0) &&
+                                 (dot_v3v3(data->polynors[loop_to_poly[e2l[0]]],
+                                           data->polynors[loop_to_poly[e2l[1]]]) <
+                                  data->split_angle_cos);
+}
+
+/**
+ * Record the smooth fans and single loops #loop_split_generator would process,
+ * walking each fan as #split_loop_nor_fan_do does.
+ */
+static MeshNormalsFans *mesh_normals_fans_build(const Mesh *mesh,
+                                                const MeshNormalsTopology *topology,
+                                                const float split_angle_cos,
+                                                uchar *edge_angle_sharp)
+{
+  const MEdge *medges = mesh->medge;
+  const MLoop *mloops = mesh->mloop;
+  const MPoly *mpolys = mesh->mpoly;
+  const int numEdges = mesh->totedge;
+  const int numLoops = mesh->totloop;
+  const int numPolys = mesh->totpoly;
+  const int *loop_to_poly = topology->loop_to_poly;
+
+  /* Edge to loops with the sharp edges from the auto-smooth angle. */
+  int(*edge_to_loops)[2] = MEM_malloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
+  memcpy(edge_to_loops, topology->edge_to_loops, sizeof(*edge_to_loops) * (size_t)numEdges);
+  if (edge_angle_sharp) {
+    for (int i = 0; i < numEdges; i++) {
+      if (edge_angle_sharp[i]) {
+        edge_to_loops[i][1] = INDEX_INVALID;
+      }
+    }
+  }
+
+  MeshNormalsFans *fans = MEM_callocN(sizeof(*fans), __func__);
+  fans->users = 1;
+  fans->split_angle_cos = split_angle_cos;
+  fans->edge_angle_sharp = edge_angle_sharp;
+  fans->single_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(int), __func__);
+  fans->fan_offsets = MEM_malloc_arrayN((size_t)numLoops + 1, sizeof(int), __func__);
+  fans->fan_verts = MEM_malloc_arrayN((size_t)numLoops, sizeof(int[2]), __func__);
+  fans->entry_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(int), __func__);
+  fans->entry_polys = MEM_malloc_arrayN((size_t)numLoops, sizeof(int), __func__);
+  fans->entry_verts = MEM_malloc_arrayN((size_t)numLoops, sizeof(int), __func__);
+
+  BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
+  BLI_bitmap *done_loops = BLI_BITMAP_NEW(numLoops, __func__);
+  int entries_len = 0;
+
+  for (int mp_index = 0; mp_index < numPolys; mp_index++) {
+    const MPoly *mp = &mpolys[mp_index];
+    const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+    int ml_curr_index = mp->loopstart;
+    int ml_prev_index = ml_last_index;
+
+    for (; ml_curr_index <= ml_last_index; ml_curr_index++) {
+      const MLoop *ml_curr = &mloops[ml_curr_index];
+      const MLoop *ml_prev = &mloops[ml_prev_index];
+      const int *e2l_curr = edge_to_loops[ml_curr->e];
+      const int *e2l_prev = edge_to_loops[ml_prev->e];
+
+      /* Same checks as #loop_split_generator. */
+      if (!IS_EDGE_SHARP(e2l_curr) &&
+          (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
+           !loop_split_generator_check_cyclic_smooth_fan(mloops,
+                                                         mpolys,
+                                                         (const int(*)[2])edge_to_loops,
+                                                         loop_to_poly,
+                                                         e2l_prev,
+                                                         skip_loops,
+                                                         ml_curr,
+                                                         ml_prev,
+                                                         ml_curr_index,
+                                                         ml_prev_index,
+                                                         mp_index))) {
+        /* Skip. */
+      }
+      else if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+        fans->single_loops[fans->singles_len++] = ml_curr_index;
+        BLI_BITMAP_ENABLE(done_loops, ml_curr_index);
+      }
+      else {
+        /* Same walk as #split_loop_nor_fan_do. */
+        const uint mv_pivot_index = ml_curr->v;
+        const MEdge *me_org = &medges[ml_curr->e];
+        const int *e2lfan_curr = e2l_prev;
+        const MLoop *mlfan_curr = ml_prev;
+        int mlfan_curr_index = ml_prev_index;
+        int mlfan_vert_index = ml_curr_index;
+        int mpfan_curr_index = mp_index;
+
+        fans->fan_offsets[fans->fans_len] = entries_len;
+        fans->fan_verts[fans->fans_len][0] = (int)mv_pivot_index;
+        fans->fan_verts[fans->fans_len][1] = (int)((me_org->v1 == mv_pivot_index) ? me_org->v2 :
+                                                                                    me_org->v1);
+        fans->fans_len++;
+
+        while (true) {
+          const MEdge *me_curr = &medges[mlfan_curr->e];
+
+          fans->entry_loops[entries_len] = mlfan_vert_index;
+          fans->entry_polys[entries_len] = mpfan_curr_index;
+          fans->entry_verts[entries_len] = (int)((me_curr->v1 == mv_pivot_index) ? me_curr->v2 :
+                                                                                   me_curr->v1);
+          entries_len++;
+          BLI_BITMAP_ENABLE(done_loops, mlfan_vert_index);
+
+          if (IS_EDGE_SHARP(e2lfan_curr) || (me_curr == me_org)) {
+            break;
+          }
+
+          BKE_mesh_loop_manifold_fan_around_vert_next(mloops,
+                                                      mpolys,
+                                                      loop_to_poly,
+                                                      e2lfan_curr,
+                                                      mv_pivot_index,
+                                                      &mlfan_curr,
+                                                      &mlfan_curr_index,
+                                                      &mlfan_vert_index,
+                                                      &mpfan_curr_index);
+
+          e2lfan_curr = edge_to_loops[mlfan_curr->e];
+        }
+      }
+
+      ml_prev_index = ml_curr_index;
+    }
+  }
+  fans->fan_offsets[fans->fans_len] = entries_len;
+
+  /* Loops in no fan keep the vertex normal. */
+  for (int i = 0; i < numLoops; i++) {
+    if (!BLI_BITMAP_TEST(done_loops, i)) {
+      if (fans->other_loops == NULL) {
+        fans->other_loops = MEM_malloc_arrayN((size_t)numLoops, sizeof(int), __func__);
+      }
+      fans->other_loops[fans->others_len++] = i;
+    }
+  }
+
+  MEM_freeN(skip_loops);
+  MEM_freeN(done_loops);
+  MEM_freeN(edge_to_loops);
+
+  return fans;
+}
+
+static void mesh_normals_loop_single_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshNormalsTopologyData *data = userdata;
+  const int ml_index = data->fans->single_loops[i];
+  copy_v3_v3(data->loopnors[ml_index], data->polynors[data->topology->loop_to_poly[ml_index]]);
+}
+
+static void mesh_normals_loop_other_cb(void *__restrict userdata,
+                                       const int i,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshNormalsTopologyData *data = userdata;
+  const int ml_index = data->fans->other_loops[i];
+  normal_short_to_float_v3(data->loopnors[ml_index], data->mverts[data->mloops[ml_index].v].no);
+}
+
+static void mesh_normals_loop_fan_cb(void *__restrict userdata,
+                                     const int fan_index,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshNormalsTopologyData *data = userdata;
+  const MeshNormalsFans *fans = data->fans;
+  const MVert *mverts = data->mverts;
+  const int entry_start = fans->fan_offsets[fan_index];
+  const int entry_end = fans->fan_offsets[fan_index + 1];
+  const float *co_pivot = mverts[fans->fan_verts[fan_index][0]].co;
+
+  float vec_curr[3], vec_prev[3];
+  float lnor[3] = {0.0f, 0.0f, 0.0f};
+
+  sub_v3_v3v3(vec_prev, mverts[fans->fan_verts[fan_index][1]].co, co_pivot);
+  normalize_v3(vec_prev);
+
+  /* Same accumulation as #split_loop_nor_fan_do. */
+  for (int i = entry_start; i < entry_end; i++) {
+    sub_v3_v3v3(vec_curr, mverts[fans->entry_verts[i]].co, co_pivot);
+    normalize_v3(vec_curr);
+
+    const float fac = saacos(dot_v3v3(vec_curr, vec_prev));
+    madd_v3_v3fl(lnor, data->polynors[fans->entry_polys[i]], fac);
+
+    copy_v3_v3(vec_prev, vec_curr);
+  }
+
+  if (LIKELY(normalize_v3(lnor) != 0.0f)) {
+    for (int i = entry_start; i < entry_end; i++) {
+      copy_v3_v3(data->loopnors[fans->entry_loops[i]], lnor);
+    }
+  }
+  else {
+    /* Use the vertex normal, as pre-populated by #mesh_edges_sharp_tag. */
+    const MVert *mv_pivot = &mverts[fans->fan_verts[fan_index][0]];
+    for (int i = entry_start; i < entry_end; i++) {
+      normal_short_to_float_v3(data->loopnors[fans->entry_loops[i]], mv_pivot->no);
+    }
+  }
+}
+
+/**
+ * Same as #BKE_mesh_normals_loop_split (using split normals, without custom normals or loop
+ * normal spaces), using the smooth fans cached in \a topology.
+ *
+ * \note Vertex normals of \a mesh must be up to date.
+ */
+void BKE_mesh_normals_loop_split_topology(const Mesh *mesh,
+                                          MeshNormalsTopology *topology,
+                                          const float (*polynors)[3],
+                                          const float split_angle,
+                                          float (*r_loopnors)[3])
+{
+  MeshNormalsTopologyStats stats = {0};
+  const bool check_angle = (split_angle < (float)M_PI);
+  const float split_angle_cos = check_angle ? cosf(split_angle) : -1.0f;
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  double time_start = PIL_check_seconds_timer();
+
+  MeshNormalsTopologyData data = {
+      .topology = topology,
+      .mverts = mesh->mvert,
+      .medges = mesh->medge,
+      .mloops = mesh->mloop,
+      .polynors = polynors,
+      .split_angle_cos = split_angle_cos,
+      .loopnors = r_loopnors,
+  };
+
+  /* Edges made sharp by the auto-smooth angle change with the deformation. */
+  if (check_angle) {
+    data.edge_angle_sharp = MEM_malloc_arrayN((size_t)mesh->totedge, sizeof(uchar), __func__);
+    BLI_task_parallel_range(
+        0, mesh->totedge, &data, mesh_normals_edge_angle_sharp_cb, &settings);
+  }
+
+  /* Use the last fans when they were built for the same sharp edges. */
+  MeshNormalsFans *fans;
+  BLI_mutex_lock(&normals_topology_cache.mutex);
+  fans = topology->fans;
+  if (fans) {
+    fans->users++;
+  }
+  BLI_mutex_unlock(&normals_topology_cache.mutex);
+
+  if (fans && ((fans->split_angle_cos != split_angle_cos) ||
+               (check_angle && memcmp(fans->edge_angle_sharp,
+                                      data.edge_angle_sharp,
+                                      sizeof(uchar) * (size_t)mesh->totedge) != 0))) {
+    BLI_mutex_lock(&normals_topology_cache.mutex);
+    fans = mesh_normals_fans_release_locked(fans);
+    BLI_mutex_unlock(&normals_topology_cache.mutex);
+    if (fans) {
+      mesh_normals_fans_free(fans);
+    }
+    fans = NULL;
+  }
+
+  if (fans) {
+    MEM_SAFE_FREE(data.edge_angle_sharp);
+    stats.fans_hits = 1;
+  }
+  else {
+    /* The fans take ownership of the sharp edges. */
+    fans = mesh_normals_fans_build(mesh, topology, split_angle_cos, data.edge_angle_sharp);
+    data.edge_angle_sharp = NULL;
+    stats.fans_builds = 1;
+
+    /* Store them for the next update, one user for the topology and one for us. */
+    MeshNormalsFans *fans_free = NULL;
+    BLI_mutex_lock(&normals_topology_cache.mutex);
+    if (topology->fans) {
+      fans_free = mesh_normals_fans_release_locked(topology->fans);
+    }
+    topology->fans = fans;
+    fans->users++;
+    BLI_mutex_unlock(&normals_topology_cache.mutex);
+    if (fans_free) {
+      mesh_normals_fans_free(fans_free);
+    }
+  }
+
+  double time_fans = PIL_check_seconds_timer();
+  stats.time_fans = time_fans - time_start;
+
+  data.fans = fans;
+  BLI_task_parallel_range(0, fans->singles_len, &data, mesh_normals_loop_single_cb, &settings);
+  BLI_task_parallel_range(0, fans->fans_len, &data, mesh_normals_loop_fan_cb, &settings);
+  BLI_task_parallel_range(0, fans->others_len, &data, mesh_normals_loop_other_cb, &settings);
+
+  stats.time_loop_normals = PIL_check_seconds_timer() - time_fans;
+
+  BLI_mutex_lock(&normals_topology_cache.mutex);
+  fans = mesh_normals_fans_release_locked(fans);
+  BLI_mutex_unlock(&normals_topology_cache.mutex);
+  if (fans) {
+    mesh_normals_fans_free(fans);
+  }
+
+  mesh_normals_topology_stats_add(&stats);
+}
+
+/** \} */
+
 #undef INDEX_UNSET
 #undef INDEX_INVALID
 #undef IS_EDGE_SHARP
@@ -21,13 +21,19 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <memory.h>
 
+#include "zlib.h"
+
 #include "MEM_guardedalloc.h"
 
+#include "DNA_color_types.h"
 #include "DNA_sequence_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
+#include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
 
@@ -35,6 +41,14 @@
 #include "BLI_threads.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_linklist.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
 
 #include "BKE_sequencer.h"
 #include "BKE_scene.h"
@@ -63,6 +77,8 @@
  * entries one by one in reverse order to their creation.
  *
  * User can exclude caching of some images. Such entries will have is_temp_cache set.
+ *
+ * Disk cache: Optional second tier of the cache, see #SeqDiskCache.
  */
 
 typedef struct SeqCache {
@@ -70,8 +86,11 @@ typedef struct SeqCache {
   ThreadMutex iterator_mutex;
   struct BLI_mempool *keys_pool;
   struct BLI_mempool *items_pool;
-  struct SeqCacheKey *last_key;
+  /* Last key of the stack which is being rendered, used for linking. Every task has its own one,
+   * so tasks can render different frames at the same time. */
+  struct SeqCacheKey *last_key[SEQ_TASK_MAX];
   size_t memory_used;
+  struct SeqDiskCache *disk_cache;
 } SeqCache;
 
 typedef struct SeqCacheItem {
@@ -175,7 +194,16 @@ static size_t seq_cache_get_mem_total(void)
 static void seq_cache_keyfree(void *val)
 {
   SeqCacheKey *key = val;
-  BLI_mempool_free(key->cache_owner->keys_pool, key);
+  SeqCache *cache = key->cache_owner;
+
+  /* Don't leave a render task linking its next item to freed memory. */
+  for (int i = 0; i < SEQ_TASK_MAX; i++) {
+    if (cache->last_key[i] == key) {
+      cache->last_key[i] = NULL;
+    }
+  }
+
+  BLI_mempool_free(cache->keys_pool, key);
 }
 
 static void seq_cache_valfree(void *val)
@@ -200,7 +228,7 @@ static void seq_cache_put(SeqCache *cache, SeqCacheKey *key, ImBuf *ibuf)
 
   if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
     IMB_refImBuf(ibuf);
-    cache->last_key = key;
+    cache->last_key[key->task_id] = key;
     cache->memory_used += IMB_get_size_in_memory(ibuf);
   }
 }
@@ -228,6 +256,11 @@ static void seq_cache_relink_keys(SeqCacheKey *link_next, SeqCacheKey *link_prev
   }
 }
 
+static void seq_cache_last_keys_clear(SeqCache *cache)
+{
+  memset(cache->last_key, 0, sizeof(cache->last_key));
+}
+
 /* Choose a key out of 2 candidates(leftmost and rightmost items)
  * to recycle based on currently used strategy */
 static SeqCacheKey *seq_cache_choose_key(Scene *scene, SeqCacheKey *lkey, SeqCacheKey *rkey)
@@ -320,6 +353,17 @@ static void seq_cache_recycle_linked(Scene *scene, SeqCacheKey *base)
   }
 }
 
+/* Key is the end of items still being linked by a render task, see BKE_sequencer_cache_put. */
+static bool seq_cache_key_is_rendering(SeqCache *cache, SeqCacheKey *key)
+{
+  for (int i = 0; i < SEQ_TASK_MAX; i++) {
+    if (cache->last_key[i] == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
 {
   SeqCache *cache = seq_cache_get_from_scene(scene);
@@ -352,6 +396,11 @@ static SeqCacheKey *seq_cache_get_item_for_removal(Scene *scene)
       continue;
     }
 
+    /* Other tasks render concurrently, keep the frames they haven't finished. */
+    if (seq_cache_key_is_rendering(cache, key)) {
+      continue;
+    }
+
     total_count++;
 
     if (key->cost <= scene->ed->recycle_max_cost) {
@@ -432,6 +481,867 @@ static void seq_cache_set_temp_cache_linked(Scene *scene, SeqCacheKey *base)
   }
 }
 
+/* ************************** Disk cache ************************** */
+
+/**
+ * Disk cache stores images in `<blend file name>_seq_cache` directory next to the blend file,
+ * so they survive reloading the file.
+ *
+ * Images are written in background when they are put into memory cache, so entries recycled
+ * from memory are already available on disk. When an image is not found in memory cache, it is
+ * read from disk and put back to memory cache. For prefetch jobs this happens in prefetch
+ * thread, so frames are loaded from disk ahead of playhead.
+ *
+ * Files are identified by hash of render settings and hash of strip content (including strips
+ * below it for composited images) instead of pointers, so they stay valid across sessions.
+ * Modification time and size of source media and proxy files are part of the content hash, so
+ * replacing a file under the same path doesn't return old frames.
+ * Strips whose content is defined by other data-blocks are not stored on disk.
+ * Least recently used files are removed when size limit from user preferences is exceeded.
+ * The order of use is written to an index file when the cache is freed, reading a file doesn't
+ * modify it.
+ */
+
+#define SEQ_DISK_CACHE_MAGIC "BSQC"
+#define SEQ_DISK_CACHE_VERSION 1
+#define SEQ_DISK_CACHE_EXT ".bseq"
+#define SEQ_DISK_CACHE_DIR_SUFFIX "_seq_cache"
+#define SEQ_DISK_CACHE_NAME_LEN 64
+#define SEQ_DISK_CACHE_INDEX_NAME "lru_index"
+#define SEQ_DISK_CACHE_INDEX_HEADER "BSQC lru 1"
+
+/* Strip flags which don't affect rendered image. */
+#define SEQ_DISK_CACHE_FLAG_IGNORE (SEQ_ALLSEL | SEQ_OVERLAP | SEQ_LOCK | SEQ_FLAG_DELETE)
+
+enum {
+  SEQ_DISK_CACHE_RECT = (1 << 0),
+  SEQ_DISK_CACHE_RECT_FLOAT = (1 << 1),
+};
+
+typedef struct SeqDiskCacheFile {
+  struct SeqDiskCacheFile *next, *prev;
+  char name[SEQ_DISK_CACHE_NAME_LEN];
+  size_t size;
+  /* File is being written, it is not in the list of files yet. */
+  bool is_pending;
+} SeqDiskCacheFile;
+
+typedef struct SeqDiskCache {
+  char dirpath[FILE_MAX];
+  ThreadMutex mutex;
+  /* Written files, from least to most recently used. */
+  ListBase files;
+  /* Order of #files differs from the index file. */
+  bool is_index_dirty;
+  /* File name -> #SeqDiskCacheFile, including files which are being written. */
+  GHash *files_hash;
+  size_t size_total;
+  bool dir_exists;
+  TaskPool *write_pool;
+  /* Memory used by images waiting to be written. */
+  size_t write_pending_size;
+} SeqDiskCache;
+
+typedef struct SeqDiskCacheHeader {
+  char magic[4];
+  int version;
+  int x, y;
+  int planes;
+  int flag;
+  float cost;
+  int dither;
+  char rect_colorspace[64];
+  char float_colorspace[64];
+} SeqDiskCacheHeader;
+
+typedef struct SeqDiskCacheWriteTask {
+  char name[SEQ_DISK_CACHE_NAME_LEN];
+  ImBuf *ibuf;
+  size_t ibuf_size;
+  float cost;
+  bool is_written;
+} SeqDiskCacheWriteTask;
+
+static size_t seq_disk_cache_get_size_total(void)
+{
+  return ((size_t)U.sequencer_disk_cache_size_limit) * 1024 * 1024 * 1024;
+}
+
+static void seq_disk_cache_hash_string(BLI_HashMurmur2A *mm2, const char *str)
+{
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)str, strlen(str) + 1);
+}
+
+static void seq_disk_cache_hash_curve_mapping(BLI_HashMurmur2A *mm2, const CurveMapping *cumap)
+{
+  BLI_hash_mm2a_add_int(mm2, cumap->flag);
+  BLI_hash_mm2a_add_int(mm2, cumap->tone);
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)&cumap->clipr, sizeof(cumap->clipr));
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)cumap->black, sizeof(cumap->black));
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)cumap->white, sizeof(cumap->white));
+
+  for (int a = 0; a < CM_TOT; a++) {
+    const CurveMap *cuma = &cumap->cm[a];
+
+    BLI_hash_mm2a_add_int(mm2, cuma->flag);
+    BLI_hash_mm2a_add_int(mm2, cuma->totpoint);
+    for (int i = 0; cuma->curve && i < cuma->totpoint; i++) {
+      const CurveMapPoint *cmp = &cuma->curve[i];
+
+      BLI_hash_mm2a_add(mm2, (const unsigned char *)&cmp->x, sizeof(float[2]));
+      BLI_hash_mm2a_add_int(mm2, cmp->flag & ~CUMA_SELECT);
+    }
+  }
+}
+
+static bool seq_disk_cache_hash_strip(BLI_HashMurmur2A *mm2,
+                                      const SeqRenderData *context,
+                                      Sequence *seq,
+                                      float cfra);
+
+static bool seq_disk_cache_hash_modifiers(BLI_HashMurmur2A *mm2,
+                                          const SeqRenderData *context,
+                                          Sequence *seq,
+                                          float cfra)
+{
+  for (SequenceModifierData *smd = seq->modifiers.first; smd; smd = smd->next) {
+    const SequenceModifierTypeInfo *smti = BKE_sequence_modifier_type_info_get(smd->type);
+
+    if (smd->flag & SEQUENCE_MODIFIER_MUTE) {
+      continue;
+    }
+
+    if (smti == NULL || (smd->mask_input_type == SEQUENCE_MASK_INPUT_ID && smd->mask_id)) {
+      return false;
+    }
+
+    BLI_hash_mm2a_add_int(mm2, smd->type);
+    BLI_hash_mm2a_add_int(mm2, smd->mask_time);
+
+    if (smd->mask_input_type == SEQUENCE_MASK_INPUT_STRIP && smd->mask_sequence) {
+      if (!seq_disk_cache_hash_strip(mm2, context, smd->mask_sequence, cfra)) {
+        return false;
+      }
+    }
+
+    if (smd->type == seqModifierType_Curves) {
+      seq_disk_cache_hash_curve_mapping(mm2, &((CurvesModifierData *)smd)->curve_mapping);
+    }
+    else if (smd->type == seqModifierType_HueCorrect) {
+      seq_disk_cache_hash_curve_mapping(mm2, &((HueCorrectModifierData *)smd)->curve_mapping);
+    }
+    else {
+      /* Remaining modifier settings are plain values. */
+      BLI_hash_mm2a_add(mm2,
+                        (const unsigned char *)smd + sizeof(SequenceModifierData),
+                        smti->struct_size - sizeof(SequenceModifierData));
+    }
+  }
+
+  return true;
+}
+
+/* Source media can be replaced under the same path, so modification time and size of the files
+ * are part of the hash. Missing files hash the same as empty ones. */
+static void seq_disk_cache_hash_file_stat(BLI_HashMurmur2A *mm2, const char *path)
+{
+  BLI_stat_t st;
+  int64_t values[2] = {0, 0};
+
+  if (BLI_stat(path, &st) == 0) {
+    values[0] = (int64_t)st.st_mtime;
+    values[1] = (int64_t)st.st_size;
+  }
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)values, sizeof(values));
+}
+
+static bool seq_disk_cache_hash_strip(BLI_HashMurmur2A *mm2,
+                                      const SeqRenderData *context,
+                                      Sequence *seq,
+                                      float cfra)
+{
+  /* Content of these strips depends on other data-blocks or animation of whole frame range,
+   * changes of it can not be detected from the strip. */
+  if (ELEM(seq->type,
+           SEQ_TYPE_SCENE,
+           SEQ_TYPE_MOVIECLIP,
+           SEQ_TYPE_MASK,
+           SEQ_TYPE_TEXT,
+           SEQ_TYPE_SPEED)) {
+    return false;
+  }
+
+  /* Files of the individual views are not hashed. */
+  if ((seq->flag & SEQ_USE_VIEWS) && seq->views_format == R_IMF_VIEWS_INDIVIDUAL) {
+    return false;
+  }
+
+  const int values_int[] = {
+      seq->type,
+      seq->flag & ~SEQ_DISK_CACHE_FLAG_IGNORE,
+      seq->start,
+      seq->len,
+      seq->startofs,
+      seq->endofs,
+      seq->startstill,
+      seq->endstill,
+      seq->machine,
+      seq->anim_startofs,
+      seq->anim_endofs,
+      seq->streamindex,
+      seq->multicam_source,
+      seq->blend_mode,
+      seq->alpha_mode,
+      seq->views_format,
+  };
+  const float values_float[] = {
+      seq->sat,
+      seq->mul,
+      seq->effect_fader,
+      seq->speed_fader,
+      seq->blend_opacity,
+  };
+
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)values_int, sizeof(values_int));
+  BLI_hash_mm2a_add(mm2, (const unsigned char *)values_float, sizeof(values_float));
+
+  if (seq->stereo3d_format) {
+    BLI_hash_mm2a_add(mm2, (const unsigned char *)seq->stereo3d_format, sizeof(Stereo3dFormat));
+  }
+
+  const Strip *strip = seq->strip;
+  if (strip) {
+    seq_disk_cache_hash_string(mm2, strip->dir);
+    seq_disk_cache_hash_string(mm2, strip->colorspace_settings.name);
+
+    if (strip->stripdata) {
+      /* Original size and fps of the elements are set by rendering, only hash the names. */
+      const int elems_len = MEM_allocN_len(strip->stripdata) / sizeof(StripElem);
+      for (int i = 0; i < elems_len; i++) {
+        seq_disk_cache_hash_string(mm2, strip->stripdata[i].name);
+      }
+    }
+    if (strip->crop && (seq->flag & SEQ_USE_CROP)) {
+      BLI_hash_mm2a_add(mm2, (const unsigned char *)strip->crop, sizeof(StripCrop));
+    }
+    if (strip->transform && (seq->flag & SEQ_USE_TRANSFORM)) {
+      BLI_hash_mm2a_add(mm2, (const unsigned char *)strip->transform, sizeof(StripTransform));
+    }
+    if (strip->proxy && (seq->flag & SEQ_USE_PROXY)) {
+      seq_disk_cache_hash_string(mm2, strip->proxy->dir);
+      seq_disk_cache_hash_string(mm2, strip->proxy->file);
+      BLI_hash_mm2a_add_int(mm2, strip->proxy->tc);
+      BLI_hash_mm2a_add_int(mm2, strip->proxy->storage);
+    }
+
+    char path[FILE_MAX];
+    if (BKE_sequencer_source_filepath_get(seq, (int)cfra, path)) {
+      seq_disk_cache_hash_file_stat(mm2, path);
+    }
+    if (BKE_sequencer_proxy_filepath_get(
+            context->scene, seq, (int)cfra, context->preview_render_size, path)) {
+      seq_disk_cache_hash_file_stat(mm2, path);
+    }
+  }
+
+  if (seq->effectdata) {
+    BLI_hash_mm2a_add(
+        mm2, (const unsigned char *)seq->effectdata, MEM_allocN_len(seq->effectdata));
+  }
+
+  if (!seq_disk_cache_hash_modifiers(mm2, context, seq, cfra)) {
+    return false;
+  }
+
+  Sequence *inputs[] = {seq->seq1, seq->seq2, seq->seq3};
+  for (int i = 0; i < ARRAY_SIZE(inputs); i++) {
+    if (inputs[i] && !seq_disk_cache_hash_strip(mm2, context, inputs[i], cfra)) {
+      return false;
+    }
+  }
+
+  for (Sequence *seq_child = seq->seqbase.first; seq_child; seq_child = seq_child->next) {
+    if (!seq_disk_cache_hash_strip(mm2, context, seq_child, cfra)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Hash of everything image of given type depends on. Values of strips which are being rendered
+ * must be used, so animated properties are evaluated for the frame.
+ * Returns false if image can not be stored on disk. */
+static bool seq_disk_cache_hash_content(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, uint32_t *r_hash)
+{
+  Scene *scene = context->scene;
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, 0);
+
+  if (!seq_disk_cache_hash_strip(&mm2, context, seq, cfra)) {
+    return false;
+  }
+
+  /* Composited images, adjustment and multicam strips depend on strips below. */
+  if ((type & (SEQ_CACHE_STORE_COMPOSITE | SEQ_CACHE_STORE_FINAL_OUT)) ||
+      ELEM(seq->type, SEQ_TYPE_ADJUSTMENT, SEQ_TYPE_MULTICAM)) {
+    ListBase *seqbase = scene->ed ? BKE_sequence_seqbase(&scene->ed->seqbase, seq) : NULL;
+
+    if (seqbase == NULL) {
+      return false;
+    }
+
+    for (Sequence *seq_iter = seqbase->first; seq_iter; seq_iter = seq_iter->next) {
+      if (seq_iter->machine >= seq->machine || (seq_iter->flag & SEQ_MUTE)) {
+        continue;
+      }
+      if (cfra < seq_iter->startdisp || cfra >= seq_iter->enddisp) {
+        continue;
+      }
+      if (!seq_disk_cache_hash_strip(&mm2, context, seq_iter, cfra)) {
+        return false;
+      }
+    }
+  }
+
+  *r_hash = BLI_hash_mm2a_end(&mm2);
+  return true;
+}
+
+/* Unlike #seq_hash_render_data, this doesn't use pointers, so it is stable across sessions. */
+static uint32_t seq_disk_cache_hash_render_data(const SeqRenderData *context)
+{
+  const Scene *scene = context->scene;
+  const int values_int[] = {
+      context->rectx,
+      context->recty,
+      context->preview_render_size,
+      context->for_render,
+      context->motion_blur_samples,
+      context->view_id,
+      scene->r.views_format,
+      scene->r.frs_sec,
+      scene->ed->proxy_storage,
+  };
+  const float values_float[] = {
+      context->motion_blur_shutter,
+      scene->r.frs_sec_base,
+  };
+  BLI_HashMurmur2A mm2;
+
+  BLI_hash_mm2a_init(&mm2, 0);
+  BLI_hash_mm2a_add(&mm2, (const unsigned char *)values_int, sizeof(values_int));
+  BLI_hash_mm2a_add(&mm2, (const unsigned char *)values_float, sizeof(values_float));
+  seq_disk_cache_hash_string(&mm2, scene->sequencer_colorspace_settings.name);
+  seq_disk_cache_hash_string(&mm2, scene->ed->proxy_dir);
+
+  return BLI_hash_mm2a_end(&mm2);
+}
+
+/* Get name of file for image rendered with given context and strip.
+ * Returns false if image can not be stored on disk. */
+static bool seq_disk_cache_file_name(
+    const SeqRenderData *context, Sequence *seq, float cfra, int type, char *r_name)
+{
+  uint32_t content_hash;
+
+  if (context->skip_cache || context->is_proxy_render || seq == NULL) {
+    return false;
+  }
+
+  /* Image files are read from disk anyway. */
+  if (type == SEQ_CACHE_STORE_RAW && seq->type == SEQ_TYPE_IMAGE) {
+    return false;
+  }
+
+  if (!seq_disk_cache_hash_content(context, seq, cfra, type, &content_hash)) {
+    return false;
+  }
+
+  union {
+    float f;
+    uint32_t i;
+  } frame = {cfra};
+
+  BLI_snprintf(r_name,
+               SEQ_DISK_CACHE_NAME_LEN,
+               "%08x%08x-%08x-%d" SEQ_DISK_CACHE_EXT,
+               seq_disk_cache_hash_render_data(context),
+               content_hash,
+               frame.i,
+               type);
+  return true;
+}
+
+static void seq_disk_cache_file_path(const SeqDiskCache *disk_cache,
+                                     const char *name,
+                                     char *r_path)
+{
+  BLI_join_dirfile(r_path, FILE_MAX, disk_cache->dirpath, name);
+}
+
+static SeqDiskCacheFile *seq_disk_cache_file_add(SeqDiskCache *disk_cache, const char *name)
+{
+  SeqDiskCacheFile *file = MEM_callocN(sizeof(SeqDiskCacheFile), "SeqDiskCacheFile");
+
+  STRNCPY(file->name, name);
+  BLI_ghash_insert(disk_cache->files_hash, file->name, file);
+  return file;
+}
+
+static void seq_disk_cache_file_remove(SeqDiskCache *disk_cache, SeqDiskCacheFile *file)
+{
+  if (!file->is_pending) {
+    BLI_remlink(&disk_cache->files, file);
+    disk_cache->size_total -= file->size;
+  }
+  BLI_ghash_remove(disk_cache->files_hash, file->name, NULL, NULL);
+  MEM_freeN(file);
+}
+
+/* Remove least recently used files until cache fits into size limit. Mutex must be locked.
+ * Paths of the removed files are added to r_paths, delete them with
+ * seq_disk_cache_delete_files() after unlocking. */
+static void seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache, LinkNode **r_paths)
+{
+  const size_t size_max = seq_disk_cache_get_size_total();
+
+  while (disk_cache->size_total > size_max && disk_cache->files.first) {
+    SeqDiskCacheFile *file = disk_cache->files.first;
+    char path[FILE_MAX];
+
+    seq_disk_cache_file_path(disk_cache, file->name, path);
+    BLI_linklist_prepend(r_paths, BLI_strdup(path));
+    seq_disk_cache_file_remove(disk_cache, file);
+  }
+}
+
+static void seq_disk_cache_delete_files(LinkNode *paths)
+{
+  for (LinkNode *link = paths; link; link = link->next) {
+    BLI_delete(link->link, false, false);
+  }
+  BLI_linklist_freeN(paths);
+}
+
+static int seq_disk_cache_direntry_cmp(const void *a_, const void *b_)
+{
+  const struct direntry *a = a_;
+  const struct direntry *b = b_;
+
+  if (a->s.st_mtime < b->s.st_mtime) {
+    return -1;
+  }
+  if (a->s.st_mtime > b->s.st_mtime) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Move files listed in the index file to the start of the list of files, in order of the index.
+ * Files which are not listed were written after the index, they stay most recently used. */
+static void seq_disk_cache_index_read(SeqDiskCache *disk_cache)
+{
+  char path[FILE_MAX];
+  LinkNode *lines;
+
+  seq_disk_cache_file_path(disk_cache, SEQ_DISK_CACHE_INDEX_NAME, path);
+  lines = BLI_file_read_as_lines(path);
+  if (lines == NULL) {
+    return;
+  }
+
+  if (STREQ(lines->link, SEQ_DISK_CACHE_INDEX_HEADER)) {
+    ListBase files_indexed = {NULL, NULL};
+    GSet *names_indexed = BLI_gset_str_new(__func__);
+
+    for (LinkNode *link = lines->next; link; link = link->next) {
+      SeqDiskCacheFile *file = BLI_ghash_lookup(disk_cache->files_hash, link->link);
+      if (file && BLI_gset_add(names_indexed, file->name)) {
+        BLI_remlink(&disk_cache->files, file);
+        BLI_addtail(&files_indexed, file);
+      }
+    }
+
+    BLI_movelisttolist(&files_indexed, &disk_cache->files);
+    disk_cache->files = files_indexed;
+    BLI_gset_free(names_indexed, NULL);
+  }
+
+  BLI_file_free_lines(lines);
+}
+
+/* Write order of the files, so least recently used files can be removed in next sessions. */
+static void seq_disk_cache_index_write(SeqDiskCache *disk_cache)
+{
+  char path[FILE_MAX], path_temp[FILE_MAX];
+  FILE *fp;
+
+  if (!disk_cache->is_index_dirty || !disk_cache->dir_exists) {
+    return;
+  }
+
+  seq_disk_cache_file_path(disk_cache, SEQ_DISK_CACHE_INDEX_NAME, path);
+  BLI_snprintf(path_temp, sizeof(path_temp), "%s@", path);
+
+  fp = BLI_fopen(path_temp, "w");
+  if (fp == NULL) {
+    return;
+  }
+
+  bool ok = fprintf(fp, "%s\n", SEQ_DISK_CACHE_INDEX_HEADER) > 0;
+  for (SeqDiskCacheFile *file = disk_cache->files.first; file && ok; file = file->next) {
+    ok = fprintf(fp, "%s\n", file->name) > 0;
+  }
+
+  if (fclose(fp) == 0 && ok) {
+    BLI_rename(path_temp, path);
+    disk_cache->is_index_dirty = false;
+  }
+  else {
+    BLI_delete(path_temp, false, false);
+  }
+}
+
+/* Add files stored by previous sessions, ordered by the index file and modification time. */
+static void seq_disk_cache_scan_dir(SeqDiskCache *disk_cache)
+{
+  struct direntry *filelist;
+  unsigned int totfile;
+
+  if (!BLI_is_dir(disk_cache->dirpath)) {
+    return;
+  }
+
+  disk_cache->dir_exists = true;
+  totfile = BLI_filelist_dir_contents(disk_cache->dirpath, &filelist);
+  qsort(filelist, totfile, sizeof(*filelist), seq_disk_cache_direntry_cmp);
+
+  for (unsigned int i = 0; i < totfile; i++) {
+    const struct direntry *entry = &filelist[i];
+
+    if (!BLI_path_extension_check(entry->relname, SEQ_DISK_CACHE_EXT) ||
+        strlen(entry->relname) >= SEQ_DISK_CACHE_NAME_LEN) {
+      continue;
+    }
+
+    SeqDiskCacheFile *file = seq_disk_cache_file_add(disk_cache, entry->relname);
+    file->size = (size_t)entry->s.st_size;
+    BLI_addtail(&disk_cache->files, file);
+    disk_cache->size_total += file->size;
+  }
+
+  BLI_filelist_free(filelist, totfile);
+
+  seq_disk_cache_index_read(disk_cache);
+
+  LinkNode *paths_removed = NULL;
+  seq_disk_cache_enforce_limits(disk_cache, &paths_removed);
+  seq_disk_cache_delete_files(paths_removed);
+}
+
+static SeqDiskCache *seq_disk_cache_create(const char *dirpath)
+{
+  SeqDiskCache *disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
+
+  STRNCPY(disk_cache->dirpath, dirpath);
+  BLI_mutex_init(&disk_cache->mutex);
+  disk_cache->files_hash = BLI_ghash_str_new("SeqDiskCache files");
+  disk_cache->write_pool = BLI_task_pool_create_background(BLI_task_scheduler_get(), disk_cache);
+  seq_disk_cache_scan_dir(disk_cache);
+
+  return disk_cache;
+}
+
+static void seq_disk_cache_free(SeqDiskCache *disk_cache)
+{
+  /* Pending writes are discarded, running ones are finished. */
+  BLI_task_pool_free(disk_cache->write_pool);
+  seq_disk_cache_index_write(disk_cache);
+  BLI_ghash_free(disk_cache->files_hash, NULL, NULL);
+  BLI_freelistN(&disk_cache->files);
+  BLI_mutex_end(&disk_cache->mutex);
+  MEM_freeN(disk_cache);
+}
+
+/* Disk cache is available only for saved files. Its directory is determined when it is created,
+ * so after saving file under different name, previous directory is used until file is reloaded.
+ */
+static SeqDiskCache *seq_disk_cache_ensure(Main *bmain, Scene *scene)
+{
+  SeqCache *cache = seq_cache_get_from_scene(scene);
+
+  if (cache == NULL || (scene->ed->cache_flag & SEQ_CACHE_DISK_CACHE_ENABLE) == 0) {
+    return NULL;
+  }
+
+  if (cache->disk_cache == NULL) {
+    const char *blendfile_path = BKE_main_blendfile_path(bmain);
+    char dirpath[FILE_MAX];
+
+    if (blendfile_path[0] == '\0') {
+      return NULL;
+    }
+
+    BLI_strncpy(dirpath, blendfile_path, sizeof(dirpath));
+    BLI_path_extension_replace(dirpath, sizeof(dirpath), SEQ_DISK_CACHE_DIR_SUFFIX);
+
+    BLI_mutex_lock(&cache_create_lock);
+    if (cache->disk_cache == NULL) {
+      cache->disk_cache = seq_disk_cache_create(dirpath);
+    }
+    BLI_mutex_unlock(&cache_create_lock);
+  }
+
+  return cache->disk_cache;
+}
+
+static bool seq_disk_cache_write_file(const char *path, ImBuf *ibuf, float cost)
+{
+  SeqDiskCacheHeader header = {{0}};
+  const size_t num_pixels = (size_t)ibuf->x * (size_t)ibuf->y;
+  gzFile file;
+  bool ok;
+
+  memcpy(header.magic, SEQ_DISK_CACHE_MAGIC, sizeof(header.magic));
+  header.version = SEQ_DISK_CACHE_VERSION;
+  header.x = ibuf->x;
+  header.y = ibuf->y;
+  header.planes = ibuf->planes;
+  header.cost = cost;
+  header.dither = ibuf->dither;
+  if (ibuf->rect) {
+    header.flag |= SEQ_DISK_CACHE_RECT;
+    STRNCPY(header.rect_colorspace, IMB_colormanagement_get_rect_colorspace(ibuf));
+  }
+  if (ibuf->rect_float) {
+    header.flag |= SEQ_DISK_CACHE_RECT_FLOAT;
+    STRNCPY(header.float_colorspace, IMB_colormanagement_get_float_colorspace(ibuf));
+  }
+
+  /* Fastest compression level, writing must keep up with rendering. */
+  file = BLI_gzopen(path, "wb1");
+  if (file == NULL) {
+    return false;
+  }
+
+  ok = gzwrite(file, &header, sizeof(header)) == sizeof(header);
+  if (ok && ibuf->rect) {
+    const size_t size = sizeof(uint) * num_pixels;
+    ok = gzwrite(file, ibuf->rect, size) == (int)size;
+  }
+  if (ok && ibuf->rect_float) {
+    const size_t size = sizeof(float[4]) * num_pixels;
+    ok = gzwrite(file, ibuf->rect_float, size) == (int)size;
+  }
+
+  return (gzclose(file) == Z_OK) && ok;
+}
+
+static ImBuf *seq_disk_cache_read_file(const char *path, float *r_cost)
+{
+  SeqDiskCacheHeader header;
+  ImBuf *ibuf = NULL;
+  gzFile file;
+
+  file = BLI_gzopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+
+  if (gzread(file, &header, sizeof(header)) == sizeof(header) &&
+      memcmp(header.magic, SEQ_DISK_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+      header.version == SEQ_DISK_CACHE_VERSION && header.x > 0 && header.y > 0 &&
+      header.flag != 0) {
+    const size_t num_pixels = (size_t)header.x * (size_t)header.y;
+    int flags = 0;
+    bool ok = true;
+
+    if (header.flag & SEQ_DISK_CACHE_RECT) {
+      flags |= IB_rect;
+    }
+    if (header.flag & SEQ_DISK_CACHE_RECT_FLOAT) {
+      flags |= IB_rectfloat;
+    }
+
+    ibuf = IMB_allocImBuf(header.x, header.y, header.planes, flags);
+    if (ibuf && ibuf->rect) {
+      const size_t size = sizeof(uint) * num_pixels;
+      ok = gzread(file, ibuf->rect, size) == (int)size;
+    }
+    if (ibuf && ok && ibuf->rect_float) {
+      const size_t size = sizeof(float[4]) * num_pixels;
+      ok = gzread(file, ibuf->rect_float, size) == (int)size;
+    }
+
+    if (ibuf && ok) {
+      header.rect_colorspace[sizeof(header.rect_colorspace) - 1] = '\0';
+      header.float_colorspace[sizeof(header.float_colorspace) - 1] = '\0';
+      if (ibuf->rect) {
+        IMB_colormanagement_assign_rect_colorspace(ibuf, header.rect_colorspace);
+      }
+      if (ibuf->rect_float) {
+        IMB_colormanagement_assign_float_colorspace(ibuf, header.float_colorspace);
+      }
+      ibuf->dither = header.dither;
+      *r_cost = header.cost;
+    }
+    else if (ibuf) {
+      IMB_freeImBuf(ibuf);
+      ibuf = NULL;
+    }
+  }
+
+  gzclose(file);
+  return ibuf;
+}
+
+static void seq_disk_cache_write_task(TaskPool *__restrict pool,
+                                      void *taskdata,
+                                      int UNUSED(threadid))
+{
+  SeqDiskCache *disk_cache = BLI_task_pool_userdata(pool);
+  SeqDiskCacheWriteTask *task = taskdata;
+  char path[FILE_MAX], path_temp[FILE_MAX];
+  bool dir_exists;
+
+  BLI_mutex_lock(&disk_cache->mutex);
+  if (!disk_cache->dir_exists) {
+    disk_cache->dir_exists = BLI_dir_create_recursive(disk_cache->dirpath);
+  }
+  dir_exists = disk_cache->dir_exists;
+  BLI_mutex_unlock(&disk_cache->mutex);
+
+  if (!dir_exists) {
+    return;
+  }
+
+  /* Write to temporary file first, so incomplete files are never read. */
+  seq_disk_cache_file_path(disk_cache, task->name, path);
+  BLI_snprintf(path_temp, sizeof(path_temp), "%s.tmp", path);
+
+  if (!seq_disk_cache_write_file(path_temp, task->ibuf, task->cost) ||
+      BLI_rename(path_temp, path) != 0) {
+    BLI_delete(path_temp, false, false);
+    return;
+  }
+
+  const size_t size = BLI_file_size(path);
+  LinkNode *paths_removed = NULL;
+
+  BLI_mutex_lock(&disk_cache->mutex);
+  SeqDiskCacheFile *file = BLI_ghash_lookup(disk_cache->files_hash, task->name);
+  if (file) {
+    file->size = size;
+    file->is_pending = false;
+    BLI_addtail(&disk_cache->files, file);
+    disk_cache->size_total += size;
+    disk_cache->is_index_dirty = true;
+    task->is_written = true;
+    seq_disk_cache_enforce_limits(disk_cache, &paths_removed);
+  }
+  BLI_mutex_unlock(&disk_cache->mutex);
+
+  seq_disk_cache_delete_files(paths_removed);
+}
+
+static void seq_disk_cache_write_task_free(TaskPool *__restrict pool,
+                                           void *taskdata,
+                                           int UNUSED(threadid))
+{
+  SeqDiskCache *disk_cache = BLI_task_pool_userdata(pool);
+  SeqDiskCacheWriteTask *task = taskdata;
+
+  BLI_mutex_lock(&disk_cache->mutex);
+  if (!task->is_written) {
+    SeqDiskCacheFile *file = BLI_ghash_lookup(disk_cache->files_hash, task->name);
+    if (file && file->is_pending) {
+      seq_disk_cache_file_remove(disk_cache, file);
+    }
+  }
+  disk_cache->write_pending_size -= task->ibuf_size;
+  BLI_mutex_unlock(&disk_cache->mutex);
+
+  IMB_freeImBuf(task->ibuf);
+  MEM_freeN(task);
+}
+
+/* Store image on disk in background, unless it is there already. */
+static void seq_disk_cache_write_async(SeqDiskCache *disk_cache,
+                                       const char *name,
+                                       ImBuf *ibuf,
+                                       float cost)
+{
+  /* Only RGBA float buffers can be stored. */
+  if (ibuf->rect_float && ibuf->channels != 4) {
+    return;
+  }
+
+  const size_t ibuf_size = IMB_get_size_in_memory(ibuf);
+
+  BLI_mutex_lock(&disk_cache->mutex);
+  /* Images waiting to be written are referenced, limit memory they can hold. Images which don't
+   * fit are not stored on disk. */
+  if (BLI_ghash_haskey(disk_cache->files_hash, name) ||
+      disk_cache->write_pending_size + ibuf_size > seq_cache_get_mem_total() / 4) {
+    BLI_mutex_unlock(&disk_cache->mutex);
+    return;
+  }
+  SeqDiskCacheFile *file = seq_disk_cache_file_add(disk_cache, name);
+  file->is_pending = true;
+  disk_cache->write_pending_size += ibuf_size;
+  BLI_mutex_unlock(&disk_cache->mutex);
+
+  SeqDiskCacheWriteTask *task = MEM_callocN(sizeof(SeqDiskCacheWriteTask), __func__);
+  STRNCPY(task->name, name);
+  task->ibuf = ibuf;
+  task->ibuf_size = ibuf_size;
+  task->cost = cost;
+  IMB_refImBuf(ibuf);
+
+  BLI_task_pool_push_ex(disk_cache->write_pool,
+                        seq_disk_cache_write_task,
+                        task,
+                        true,
+                        seq_disk_cache_write_task_free,
+                        TASK_PRIORITY_LOW);
+}
+
+static ImBuf *seq_disk_cache_read(SeqDiskCache *disk_cache, const char *name, float *r_cost)
+{
+  char path[FILE_MAX];
+  SeqDiskCacheFile *file;
+  ImBuf *ibuf;
+
+  BLI_mutex_lock(&disk_cache->mutex);
+  file = BLI_ghash_lookup(disk_cache->files_hash, name);
+  if (file == NULL || file->is_pending) {
+    BLI_mutex_unlock(&disk_cache->mutex);
+    return NULL;
+  }
+  /* Mark as most recently used. */
+  BLI_remlink(&disk_cache->files, file);
+  BLI_addtail(&disk_cache->files, file);
+  disk_cache->is_index_dirty = true;
+  BLI_mutex_unlock(&disk_cache->mutex);
+
+  seq_disk_cache_file_path(disk_cache, name, path);
+  ibuf = seq_disk_cache_read_file(path, r_cost);
+
+  if (ibuf == NULL) {
+    BLI_mutex_lock(&disk_cache->mutex);
+    file = BLI_ghash_lookup(disk_cache->files_hash, name);
+    if (file && !file->is_pending) {
+      BLI_delete(path, false, false);
+      seq_disk_cache_file_remove(disk_cache, file);
+    }
+    BLI_mutex_unlock(&disk_cache->mutex);
+  }
+
+  return ibuf;
+}
+
 static void BKE_sequencer_cache_create(Scene *scene)
 {
   BLI_mutex_lock(&cache_create_lock);
@@ -440,7 +1350,6 @@ static void BKE_sequencer_cache_create(Scene *scene)
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
     cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
-    cache->last_key = NULL;
     BLI_mutex_init(&cache->iterator_mutex);
     scene->ed->cache = cache;
   }
@@ -478,6 +1387,10 @@ void BKE_sequencer_cache_destruct(Scene *scene)
     return;
   }
 
+  if (cache->disk_cache) {
+    seq_disk_cache_free(cache->disk_cache);
+  }
+
   BLI_ghash_free(cache->hash, seq_cache_keyfree, seq_cache_valfree);
   BLI_mempool_destroy(cache->keys_pool);
   BLI_mempool_destroy(cache->items_pool);
@@ -511,7 +1424,7 @@ void BKE_sequencer_cache_cleanup(Scene *scene)
     BLI_ghashIterator_step(&gh_iter);
     BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
   }
-  cache->last_key = NULL;
+  seq_cache_last_keys_clear(cache);
   seq_cache_unlock(scene);
 }
 
@@ -568,7 +1481,7 @@ void BKE_sequencer_cache_cleanup_sequence(Scene *scene,
       BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
     }
   }
-  cache->last_key = NULL;
+  seq_cache_last_keys_clear(cache);
   seq_cache_unlock(scene);
 }
 
@@ -578,6 +1491,9 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
                                       int type)
 {
   Scene *scene = context->scene;
+  /* Disk cache keys are computed from strips which are being rendered. */
+  const SeqRenderData *context_render = context;
+  Sequence *seq_render = seq;
 
   if (context->is_prefetch_render) {
     context = BKE_sequencer_prefetch_get_original_context(context);
@@ -606,6 +1522,23 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context,
   }
   seq_cache_unlock(scene);
 
+  if (ibuf == NULL && seq) {
+    SeqDiskCache *disk_cache = seq_disk_cache_ensure(context->bmain, scene);
+    char name[SEQ_DISK_CACHE_NAME_LEN];
+    float cost;
+
+    if (disk_cache &&
+        seq_disk_cache_file_name(context_render, seq_render, cfra, type, name) &&
+        (ibuf = seq_disk_cache_read(disk_cache, name, &cost))) {
+      if (type == SEQ_CACHE_STORE_FINAL_OUT && !context_render->is_prefetch_render) {
+        BKE_sequencer_cache_put_if_possible(context_render, seq_render, cfra, type, ibuf, cost);
+      }
+      else {
+        BKE_sequencer_cache_put(context_render, seq_render, cfra, type, ibuf, cost);
+      }
+    }
+  }
+
   return ibuf;
 }
 
@@ -625,8 +1558,11 @@ bool BKE_sequencer_cache_put_if_possible(
     return true;
   }
   else {
-    seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
-    scene->ed->cache->last_key = NULL;
+    SeqCache *cache = seq_cache_get_from_scene(scene);
+    seq_cache_lock(scene);
+    seq_cache_set_temp_cache_linked(scene, cache->last_key[context->task_id]);
+    cache->last_key[context->task_id] = NULL;
+    seq_cache_unlock(scene);
     return false;
   }
 }
@@ -635,6 +1571,8 @@ void BKE_sequencer_cache_put(
     const SeqRenderData *context, Sequence *seq, float cfra, int type, ImBuf *i, float cost)
 {
   Scene *scene = context->scene;
+  const SeqRenderData *context_render = context;
+  Sequence *seq_render = seq;
 
   if (context->is_prefetch_render) {
     context = BKE_sequencer_prefetch_get_original_context(context);
@@ -646,13 +1584,6 @@ void BKE_sequencer_cache_put(
     return;
   }
 
-  /* Prevent reinserting, it breaks cache key linking */
-  ImBuf *test = BKE_sequencer_cache_get(context, seq, cfra, type);
-  if (test) {
-    IMB_freeImBuf(test);
-    return;
-  }
-
   if (!scene->ed->cache) {
     BKE_sequencer_cache_create(scene);
   }
@@ -660,6 +1591,19 @@ void BKE_sequencer_cache_put(
   seq_cache_lock(scene);
 
   SeqCache *cache = seq_cache_get_from_scene(scene);
+
+  /* Prevent reinserting, it breaks cache key linking.
+   * Test while locked, same frame can be rendered by multiple tasks. */
+  SeqCacheKey test_key;
+  test_key.seq = seq;
+  test_key.context = *context;
+  test_key.nfra = cfra - seq->start;
+  test_key.type = type;
+  if (BLI_ghash_haskey(cache->hash, &test_key)) {
+    seq_cache_unlock(scene);
+    return;
+  }
+
   int flag;
 
   if (seq->cache_flag & SEQ_CACHE_OVERRIDE) {
@@ -688,33 +1632,44 @@ void BKE_sequencer_cache_put(
   key->is_temp_cache = true;
   key->task_id = context->task_id;
 
+  SeqCacheKey **last_key = &cache->last_key[key->task_id];
+
   /* Item stored for later use */
   if (flag & type) {
     key->is_temp_cache = false;
-    key->link_prev = cache->last_key;
+    key->link_prev = *last_key;
   }
 
-  SeqCacheKey *temp_last_key = cache->last_key;
+  SeqCacheKey *temp_last_key = *last_key;
   seq_cache_put(cache, key, i);
 
   /* Restore pointer to previous item as this one will be freed when stack is rendered */
   if (key->is_temp_cache) {
-    cache->last_key = temp_last_key;
+    *last_key = temp_last_key;
   }
 
   /* Set last_key's reference to this key so we can look up chain backwards
-   * Item is already put in cache, so cache->last_key points to current key;
+   * Item is already put in cache, so last_key points to current key;
    */
   if (flag & type && temp_last_key) {
-    temp_last_key->link_next = cache->last_key;
+    temp_last_key->link_next = *last_key;
   }
 
   /* Reset linking */
   if (key->type == SEQ_CACHE_STORE_FINAL_OUT) {
-    cache->last_key = NULL;
+    *last_key = NULL;
   }
 
   seq_cache_unlock(scene);
+
+  if (flag & type) {
+    SeqDiskCache *disk_cache = seq_disk_cache_ensure(context->bmain, scene);
+    char name[SEQ_DISK_CACHE_NAME_LEN];
+
+    if (disk_cache && seq_disk_cache_file_name(context_render, seq_render, cfra, type, name)) {
+      seq_disk_cache_write_async(disk_cache, name, i, cost);
+    }
+  }
 }
 
 void BKE_sequencer_cache_iterate(
@@ -739,7 +1694,7 @@ void BKE_sequencer_cache_iterate(
     interrupt = callback(userdata, key->seq, key->nfra, key->type, key->cost);
   }
 
-  cache->last_key = NULL;
+  seq_cache_last_keys_clear(cache);
   seq_cache_unlock(scene);
 }
 
@@ -47,6 +47,8 @@
 #include "BKE_main.h"
 #include "BKE_sequencer.h"
 
+#include "seqeffects_kernels.h"
+
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
 #include "IMB_colormanagement.h"
@@ -191,160 +193,6 @@ static void init_alpha_over_or_under(Sequence *seq)
   seq->seq1 = seq2;
 }
 
-static void do_alphaover_effect_byte(float facf0,
-                                     float facf1,
-                                     int x,
-                                     int y,
-                                     unsigned char *rect1,
-                                     unsigned char *rect2,
-                                     unsigned char *out)
-{
-  float fac2, mfac, fac, fac4;
-  int xo;
-  unsigned char *cp1, *cp2, *rt;
-  float tempc[4], rt1[4], rt2[4];
-
-  xo = x;
-  cp1 = rect1;
-  cp2 = rect2;
-  rt = out;
-
-  fac2 = facf0;
-  fac4 = facf1;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      /* rt = rt1 over rt2  (alpha from rt1) */
-
-      straight_uchar_to_premul_float(rt1, cp1);
-      straight_uchar_to_premul_float(rt2, cp2);
-
-      fac = fac2;
-      mfac = 1.0f - fac2 * rt1[3];
-
-      if (fac <= 0.0f) {
-        *((unsigned int *)rt) = *((unsigned int *)cp2);
-      }
-      else if (mfac <= 0.0f) {
-        *((unsigned int *)rt) = *((unsigned int *)cp1);
-      }
-      else {
-        tempc[0] = fac * rt1[0] + mfac * rt2[0];
-        tempc[1] = fac * rt1[1] + mfac * rt2[1];
-        tempc[2] = fac * rt1[2] + mfac * rt2[2];
-        tempc[3] = fac * rt1[3] + mfac * rt2[3];
-
-        premul_float_to_straight_uchar(rt, tempc);
-      }
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      straight_uchar_to_premul_float(rt1, cp1);
-      straight_uchar_to_premul_float(rt2, cp2);
-
-      fac = fac4;
-      mfac = 1.0f - (fac4 * rt1[3]);
-
-      if (fac <= 0.0f) {
-        *((unsigned int *)rt) = *((unsigned int *)cp2);
-      }
-      else if (mfac <= 0.0f) {
-        *((unsigned int *)rt) = *((unsigned int *)cp1);
-      }
-      else {
-        tempc[0] = fac * rt1[0] + mfac * rt2[0];
-        tempc[1] = fac * rt1[1] + mfac * rt2[1];
-        tempc[2] = fac * rt1[2] + mfac * rt2[2];
-        tempc[3] = fac * rt1[3] + mfac * rt2[3];
-
-        premul_float_to_straight_uchar(rt, tempc);
-      }
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
-  }
-}
-
-static void do_alphaover_effect_float(
-    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
-{
-  float fac2, mfac, fac, fac4;
-  int xo;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac2 = facf0;
-  fac4 = facf1;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      /* rt = rt1 over rt2  (alpha from rt1) */
-
-      fac = fac2;
-      mfac = 1.0f - (fac2 * rt1[3]);
-
-      if (fac <= 0.0f) {
-        memcpy(rt, rt2, 4 * sizeof(float));
-      }
-      else if (mfac <= 0) {
-        memcpy(rt, rt1, 4 * sizeof(float));
-      }
-      else {
-        rt[0] = fac * rt1[0] + mfac * rt2[0];
-        rt[1] = fac * rt1[1] + mfac * rt2[1];
-        rt[2] = fac * rt1[2] + mfac * rt2[2];
-        rt[3] = fac * rt1[3] + mfac * rt2[3];
-      }
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      fac = fac4;
-      mfac = 1.0f - (fac4 * rt1[3]);
-
-      if (fac <= 0.0f) {
-        memcpy(rt, rt2, 4 * sizeof(float));
-      }
-      else if (mfac <= 0.0f) {
-        memcpy(rt, rt1, 4 * sizeof(float));
-      }
-      else {
-        rt[0] = fac * rt1[0] + mfac * rt2[0];
-        rt[1] = fac * rt1[1] + mfac * rt2[1];
-        rt[2] = fac * rt1[2] + mfac * rt2[2];
-        rt[3] = fac * rt1[3] + mfac * rt2[3];
-      }
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
-
 static void do_alphaover_effect(const SeqRenderData *context,
                                 Sequence *UNUSED(seq),
                                 float UNUSED(cfra),
@@ -363,7 +211,7 @@ static void do_alphaover_effect(const SeqRenderData *context,
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_alphaover_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_alphaover_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
   else {
     unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
@@ -371,7 +219,7 @@ static void do_alphaover_effect(const SeqRenderData *context,
     slice_get_byte_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_alphaover_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_alphaover_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
 }
 
@@ -584,109 +432,6 @@ static void do_alphaunder_effect(const SeqRenderData *context,
 
 /*********************** Cross *************************/
 
-static void do_cross_effect_byte(float facf0,
-                                 float facf1,
-                                 int x,
-                                 int y,
-                                 unsigned char *rect1,
-                                 unsigned char *rect2,
-                                 unsigned char *out)
-{
-  int fac1, fac2, fac3, fac4;
-  int xo;
-  unsigned char *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac2 = (int)(256.0f * facf0);
-  fac1 = 256 - fac2;
-  fac4 = (int)(256.0f * facf1);
-  fac3 = 256 - fac4;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      rt[0] = (fac1 * rt1[0] + fac2 * rt2[0]) >> 8;
-      rt[1] = (fac1 * rt1[1] + fac2 * rt2[1]) >> 8;
-      rt[2] = (fac1 * rt1[2] + fac2 * rt2[2]) >> 8;
-      rt[3] = (fac1 * rt1[3] + fac2 * rt2[3]) >> 8;
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      rt[0] = (fac3 * rt1[0] + fac4 * rt2[0]) >> 8;
-      rt[1] = (fac3 * rt1[1] + fac4 * rt2[1]) >> 8;
-      rt[2] = (fac3 * rt1[2] + fac4 * rt2[2]) >> 8;
-      rt[3] = (fac3 * rt1[3] + fac4 * rt2[3]) >> 8;
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
-
-static void do_cross_effect_float(
-    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
-{
-  float fac1, fac2, fac3, fac4;
-  int xo;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac2 = facf0;
-  fac1 = 1.0f - fac2;
-  fac4 = facf1;
-  fac3 = 1.0f - fac4;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      rt[0] = fac1 * rt1[0] + fac2 * rt2[0];
-      rt[1] = fac1 * rt1[1] + fac2 * rt2[1];
-      rt[2] = fac1 * rt1[2] + fac2 * rt2[2];
-      rt[3] = fac1 * rt1[3] + fac2 * rt2[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      rt[0] = fac3 * rt1[0] + fac4 * rt2[0];
-      rt[1] = fac3 * rt1[1] + fac4 * rt2[1];
-      rt[2] = fac3 * rt1[2] + fac4 * rt2[2];
-      rt[3] = fac3 * rt1[3] + fac4 * rt2[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
-
 static void do_cross_effect(const SeqRenderData *context,
                             Sequence *UNUSED(seq),
                             float UNUSED(cfra),
@@ -705,7 +450,7 @@ static void do_cross_effect(const SeqRenderData *context,
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_cross_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_cross_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
   else {
     unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
@@ -713,7 +458,7 @@ static void do_cross_effect(const SeqRenderData *context,
     slice_get_byte_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_cross_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_cross_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
 }
 
@@ -1017,109 +762,6 @@ static void do_gammacross_effect(const SeqRenderData *context,
 
 /*********************** Add *************************/
 
-static void do_add_effect_byte(float facf0,
-                               float facf1,
-                               int x,
-                               int y,
-                               unsigned char *rect1,
-                               unsigned char *rect2,
-                               unsigned char *out)
-{
-  int xo, fac1, fac3;
-  unsigned char *cp1, *cp2, *rt;
-
-  xo = x;
-  cp1 = rect1;
-  cp2 = rect2;
-  rt = out;
-
-  fac1 = (int)(256.0f * facf0);
-  fac3 = (int)(256.0f * facf1);
-
-  while (y--) {
-    x = xo;
-
-    while (x--) {
-      const int m = fac1 * (int)cp2[3];
-      rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
-      rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
-      rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      const int m = fac3 * (int)cp2[3];
-      rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
-      rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
-      rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
-      rt[3] = cp1[3];
-
-      cp1 += 4;
-      cp2 += 4;
-      rt += 4;
-    }
-  }
-}
-
-static void do_add_effect_float(
-    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
-{
-  int xo;
-  float fac1, fac3;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac1 = facf0;
-  fac3 = facf1;
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      const float m = (1.0f - (rt1[3] * (1.0f - fac1))) * rt2[3];
-      rt[0] = rt1[0] + m * rt2[0];
-      rt[1] = rt1[1] + m * rt2[1];
-      rt[2] = rt1[2] + m * rt2[2];
-      rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      const float m = (1.0f - (rt1[3] * (1.0f - fac3))) * rt2[3];
-      rt[0] = rt1[0] + m * rt2[0];
-      rt[1] = rt1[1] + m * rt2[1];
-      rt[2] = rt1[2] + m * rt2[2];
-      rt[3] = rt1[3];
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
-
 static void do_add_effect(const SeqRenderData *context,
                           Sequence *UNUSED(seq),
                           float UNUSED(cfra),
@@ -1138,7 +780,7 @@ static void do_add_effect(const SeqRenderData *context,
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_add_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_add_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
   else {
     unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
@@ -1146,7 +788,7 @@ static void do_add_effect(const SeqRenderData *context,
     slice_get_byte_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_add_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_add_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
 }
 
@@ -1396,116 +1038,6 @@ static void do_drop_effect_float(
 
 /*********************** Mul *************************/
 
-static void do_mul_effect_byte(float facf0,
-                               float facf1,
-                               int x,
-                               int y,
-                               unsigned char *rect1,
-                               unsigned char *rect2,
-                               unsigned char *out)
-{
-  int xo, fac1, fac3;
-  unsigned char *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac1 = (int)(256.0f * facf0);
-  fac3 = (int)(256.0f * facf1);
-
-  /* formula:
-   * fac * (a * b) + (1 - fac) * a  => fac * a * (b - 1) + axaux = c * px + py * s; //+centx
-   * yaux = -s * px + c * py; //+centy
-   */
-
-  while (y--) {
-
-    x = xo;
-    while (x--) {
-
-      rt[0] = rt1[0] + ((fac1 * rt1[0] * (rt2[0] - 255)) >> 16);
-      rt[1] = rt1[1] + ((fac1 * rt1[1] * (rt2[1] - 255)) >> 16);
-      rt[2] = rt1[2] + ((fac1 * rt1[2] * (rt2[2] - 255)) >> 16);
-      rt[3] = rt1[3] + ((fac1 * rt1[3] * (rt2[3] - 255)) >> 16);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-
-      rt[0] = rt1[0] + ((fac3 * rt1[0] * (rt2[0] - 255)) >> 16);
-      rt[1] = rt1[1] + ((fac3 * rt1[1] * (rt2[1] - 255)) >> 16);
-      rt[2] = rt1[2] + ((fac3 * rt1[2] * (rt2[2] - 255)) >> 16);
-      rt[3] = rt1[3] + ((fac3 * rt1[3] * (rt2[3] - 255)) >> 16);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
-
-static void do_mul_effect_float(
-    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
-{
-  int xo;
-  float fac1, fac3;
-  float *rt1, *rt2, *rt;
-
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-
-  fac1 = facf0;
-  fac3 = facf1;
-
-  /* formula:
-   * fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a
-   */
-
-  while (y--) {
-    x = xo;
-    while (x--) {
-      rt[0] = rt1[0] + fac1 * rt1[0] * (rt2[0] - 1.0f);
-      rt[1] = rt1[1] + fac1 * rt1[1] * (rt2[1] - 1.0f);
-      rt[2] = rt1[2] + fac1 * rt1[2] * (rt2[2] - 1.0f);
-      rt[3] = rt1[3] + fac1 * rt1[3] * (rt2[3] - 1.0f);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-
-    if (y == 0) {
-      break;
-    }
-    y--;
-
-    x = xo;
-    while (x--) {
-      rt[0] = rt1[0] + fac3 * rt1[0] * (rt2[0] - 1.0f);
-      rt[1] = rt1[1] + fac3 * rt1[1] * (rt2[1] - 1.0f);
-      rt[2] = rt1[2] + fac3 * rt1[2] * (rt2[2] - 1.0f);
-      rt[3] = rt1[3] + fac3 * rt1[3] * (rt2[3] - 1.0f);
-
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
-
 static void do_mul_effect(const SeqRenderData *context,
                           Sequence *UNUSED(seq),
                           float UNUSED(cfra),
@@ -1524,7 +1056,7 @@ static void do_mul_effect(const SeqRenderData *context,
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_mul_effect_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_mul_float(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
   else {
     unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
@@ -1532,7 +1064,7 @@ static void do_mul_effect(const SeqRenderData *context,
     slice_get_byte_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
-    do_mul_effect_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
+    seq_effect_mul_byte(facf0, facf1, context->rectx, total_lines, rect1, rect2, rect_out);
   }
 }
 
@@ -1540,7 +1072,6 @@ static void do_mul_effect(const SeqRenderData *context,
 typedef void (*IMB_blend_func_byte)(unsigned char *dst,
                                     const unsigned char *src1,
                                     const unsigned char *src2);
-typedef void (*IMB_blend_func_float)(float *dst, const float *src1, const float *src2);
 
 BLI_INLINE void apply_blend_function_byte(float facf0,
                                           float facf1,
@@ -1586,132 +1117,6 @@ BLI_INLINE void apply_blend_function_byte(float facf0,
   }
 }
 
-BLI_INLINE void apply_blend_function_float(float facf0,
-                                           float facf1,
-                                           int x,
-                                           int y,
-                                           float *rect1,
-                                           float *rect2,
-                                           float *out,
-                                           IMB_blend_func_float blend_function)
-{
-  int xo;
-  float *rt1, *rt2, *rt;
-  float achannel;
-  xo = x;
-  rt1 = rect1;
-  rt2 = rect2;
-  rt = out;
-  while (y--) {
-    for (x = xo; x > 0; x--) {
-      achannel = rt1[3];
-      rt1[3] = achannel * facf0;
-      blend_function(rt, rt1, rt2);
-      rt1[3] = achannel;
-      rt[3] = rt1[3];
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-    if (y == 0) {
-      break;
-    }
-    y--;
-    for (x = xo; x > 0; x--) {
-      achannel = rt1[3];
-      rt1[3] = achannel * facf1;
-      blend_function(rt, rt1, rt2);
-      rt1[3] = achannel;
-      rt[3] = rt1[3];
-      rt1 += 4;
-      rt2 += 4;
-      rt += 4;
-    }
-  }
-}
-
-static void do_blend_effect_float(
-    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out)
-{
-  switch (btype) {
-    case SEQ_TYPE_ADD:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_add_float);
-      break;
-    case SEQ_TYPE_SUB:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_sub_float);
-      break;
-    case SEQ_TYPE_MUL:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_mul_float);
-      break;
-    case SEQ_TYPE_DARKEN:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_darken_float);
-      break;
-    case SEQ_TYPE_COLOR_BURN:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_burn_float);
-      break;
-    case SEQ_TYPE_LINEAR_BURN:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_linearburn_float);
-      break;
-    case SEQ_TYPE_SCREEN:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_screen_float);
-      break;
-    case SEQ_TYPE_LIGHTEN:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_lighten_float);
-      break;
-    case SEQ_TYPE_DODGE:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_dodge_float);
-      break;
-    case SEQ_TYPE_OVERLAY:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_overlay_float);
-      break;
-    case SEQ_TYPE_SOFT_LIGHT:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_softlight_float);
-      break;
-    case SEQ_TYPE_HARD_LIGHT:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_hardlight_float);
-      break;
-    case SEQ_TYPE_PIN_LIGHT:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_pinlight_float);
-      break;
-    case SEQ_TYPE_LIN_LIGHT:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_linearlight_float);
-      break;
-    case SEQ_TYPE_VIVID_LIGHT:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_vividlight_float);
-      break;
-    case SEQ_TYPE_BLEND_COLOR:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_color_float);
-      break;
-    case SEQ_TYPE_HUE:
-      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_hue_float);
-      break;
-    case SEQ_TYPE_SATURATION:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_saturation_float);
-      break;
-    case SEQ_TYPE_VALUE:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_luminosity_float);
-      break;
-    case SEQ_TYPE_DIFFERENCE:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_difference_float);
-      break;
-    case SEQ_TYPE_EXCLUSION:
-      apply_blend_function_float(
-          facf0, facf1, x, y, rect1, rect2, out, blend_color_exclusion_float);
-      break;
-    default:
-      break;
-  }
-}
-
 static void do_blend_effect_byte(float facf0,
                                  float facf1,
                                  int x,
@@ -1812,7 +1217,7 @@ static void do_blend_mode_effect(const SeqRenderData *context,
     float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-    do_blend_effect_float(
+    seq_effect_blend_float(
         facf0, facf1, context->rectx, total_lines, rect1, rect2, seq->blend_mode, rect_out);
   }
   else {
@@ -1858,7 +1263,7 @@ static void do_colormix_effect(const SeqRenderData *context,
     float *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
     slice_get_float_buffers(
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
-    do_blend_effect_float(
+    seq_effect_blend_float(
         facf, facf, context->rectx, total_lines, rect1, rect2, data->blend_effect, rect_out);
   }
   else {
@@ -3285,22 +2690,22 @@ static ImBuf *do_speed_effect(const SeqRenderData *context,
   ImBuf *out = prepare_effect_imbufs(context, ibuf1, ibuf2, ibuf3);
 
   if (out->rect_float) {
-    do_cross_effect_float(facf0,
+    seq_effect_cross_float(facf0,
+                           facf1,
+                           context->rectx,
+                           context->recty,
+                           ibuf1->rect_float,
+                           ibuf2->rect_float,
+                           out->rect_float);
+  }
+  else {
+    seq_effect_cross_byte(facf0,
                           facf1,
                           context->rectx,
                           context->recty,
-                          ibuf1->rect_float,
-                          ibuf2->rect_float,
-                          out->rect_float);
-  }
-  else {
-    do_cross_effect_byte(facf0,
-                         facf1,
-                         context->rectx,
-                         context->recty,
-                         (unsigned char *)ibuf1->rect,
-                         (unsigned char *)ibuf2->rect,
-                         (unsigned char *)out->rect);
+                          (unsigned char *)ibuf1->rect,
+                          (unsigned char *)ibuf2->rect,
+                          (unsigned char *)out->rect);
   }
   return out;
 }
@@ -3329,7 +2734,7 @@ static void do_overdrop_effect(const SeqRenderData *context,
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
     do_drop_effect_float(facf0, facf1, x, y, rect1, rect2, rect_out);
-    do_alphaover_effect_float(facf0, facf1, x, y, rect1, rect2, rect_out);
+    seq_effect_alphaover_float(facf0, facf1, x, y, rect1, rect2, rect_out);
   }
   else {
     unsigned char *rect1 = NULL, *rect2 = NULL, *rect_out = NULL;
@@ -3338,7 +2743,7 @@ static void do_overdrop_effect(const SeqRenderData *context,
         context, ibuf1, ibuf2, NULL, out, start_line, &rect1, &rect2, NULL, &rect_out);
 
     do_drop_effect_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
-    do_alphaover_effect_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
+    seq_effect_alphaover_byte(facf0, facf1, x, y, rect1, rect2, rect_out);
   }
 }
 
@@ -0,0 +1,1208 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2001-2002 by NaN Holding BV.
+ * All rights reserved.
+ *
+ * - Blender Foundation, 2003-2009
+ * - Peter Schlaile <peter [at] schlaile [dot] de> 2005/2006
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Per-pixel kernels of the sequencer effects.
+ *
+ * The scalar versions are always compiled, so they can be compared against the SSE2 versions
+ * in tests. Functions without suffix pick the fastest version available.
+ */
+
+#include <string.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#include "BLI_math.h"
+#include "BLI_math_color_blend.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_sequence_types.h"
+
+#include "seqeffects_kernels.h"
+
+#ifdef __SSE2__
+
+/* SSE2 helpers for effects processing one RGBA pixel per vector.
+ * Operations are done in the same order as in scalar code, so results are identical. */
+
+BLI_INLINE __m128 load_uchar4_sse2(const unsigned char *p)
+{
+  int color;
+  memcpy(&color, p, sizeof(color));
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i color_16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(color), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(color_16, zero));
+}
+
+/* Same as #unit_float_to_uchar_clamp for all 4 channels. */
+BLI_INLINE void store_unit_float4_to_uchar4_sse2(unsigned char *p, const __m128 color)
+{
+  const __m128 scaled = _mm_add_ps(_mm_mul_ps(_mm_min_ps(color, _mm_set1_ps(1.0f)),
+                                              _mm_set1_ps(255.0f)),
+                                   _mm_set1_ps(0.5f));
+  /* Negative values are saturated to 0 by packing. */
+  const __m128i color_32 = _mm_cvttps_epi32(scaled);
+  const __m128i color_16 = _mm_packs_epi32(color_32, color_32);
+  const int color_8 = _mm_cvtsi128_si32(_mm_packus_epi16(color_16, color_16));
+  memcpy(p, &color_8, sizeof(color_8));
+}
+
+BLI_INLINE float get_alpha_sse2(const __m128 color)
+{
+  return _mm_cvtss_f32(_mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+/* RGB channels from color, alpha from alpha_src. */
+BLI_INLINE __m128 replace_alpha_sse2(const __m128 color, const __m128 alpha_src)
+{
+  const __m128 mask_rgb = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  return _mm_or_ps(_mm_and_ps(mask_rgb, color), _mm_andnot_ps(mask_rgb, alpha_src));
+}
+
+/* Same as #straight_uchar_to_premul_float. */
+BLI_INLINE __m128 straight_uchar_to_premul_float_sse2(const unsigned char color[4])
+{
+  const float alpha = color[3] * (1.0f / 255.0f);
+  const float fac = alpha * (1.0f / 255.0f);
+
+  return _mm_mul_ps(load_uchar4_sse2(color), _mm_setr_ps(fac, fac, fac, 1.0f / 255.0f));
+}
+
+/* Same as #premul_float_to_straight_uchar. */
+BLI_INLINE void premul_float_to_straight_uchar_sse2(unsigned char *result, const __m128 color)
+{
+  const float alpha = get_alpha_sse2(color);
+
+  if (alpha == 0.0f || alpha == 1.0f) {
+    store_unit_float4_to_uchar4_sse2(result, color);
+  }
+  else {
+    const float alpha_inv = 1.0f / alpha;
+    store_unit_float4_to_uchar4_sse2(
+        result, _mm_mul_ps(color, _mm_setr_ps(alpha_inv, alpha_inv, alpha_inv, 1.0f)));
+  }
+}
+
+#endif /* __SSE2__ */
+
+/*********************** Alpha Over *************************/
+
+void seq_effect_alphaover_byte_scalar(float facf0,
+                                      float facf1,
+                                      int x,
+                                      int y,
+                                      unsigned char *rect1,
+                                      unsigned char *rect2,
+                                      unsigned char *out)
+{
+  float fac2, mfac, fac, fac4;
+  int xo;
+  unsigned char *cp1, *cp2, *rt;
+  float tempc[4], rt1[4], rt2[4];
+
+  xo = x;
+  cp1 = rect1;
+  cp2 = rect2;
+  rt = out;
+
+  fac2 = facf0;
+  fac4 = facf1;
+
+  while (y--) {
+    x = xo;
+    while (x--) {
+      /* rt = rt1 over rt2  (alpha from rt1) */
+
+      straight_uchar_to_premul_float(rt1, cp1);
+      straight_uchar_to_premul_float(rt2, cp2);
+
+      fac = fac2;
+      mfac = 1.0f - fac2 * rt1[3];
+
+      if (fac <= 0.0f) {
+        *((unsigned int *)rt) = *((unsigned int *)cp2);
+      }
+      else if (mfac <= 0.0f) {
+        *((unsigned int *)rt) = *((unsigned int *)cp1);
+      }
+      else {
+        tempc[0] = fac * rt1[0] + mfac * rt2[0];
+        tempc[1] = fac * rt1[1] + mfac * rt2[1];
+        tempc[2] = fac * rt1[2] + mfac * rt2[2];
+        tempc[3] = fac * rt1[3] + mfac * rt2[3];
+
+        premul_float_to_straight_uchar(rt, tempc);
+      }
+      cp1 += 4;
+      cp2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+      straight_uchar_to_premul_float(rt1, cp1);
+      straight_uchar_to_premul_float(rt2, cp2);
+
+      fac = fac4;
+      mfac = 1.0f - (fac4 * rt1[3]);
+
+      if (fac <= 0.0f) {
+        *((unsigned int *)rt) = *((unsigned int *)cp2);
+      }
+      else if (mfac <= 0.0f) {
+        *((unsigned int *)rt) = *((unsigned int *)cp1);
+      }
+      else {
+        tempc[0] = fac * rt1[0] + mfac * rt2[0];
+        tempc[1] = fac * rt1[1] + mfac * rt2[1];
+        tempc[2] = fac * rt1[2] + mfac * rt2[2];
+        tempc[3] = fac * rt1[3] + mfac * rt2[3];
+
+        premul_float_to_straight_uchar(rt, tempc);
+      }
+      cp1 += 4;
+      cp2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_alphaover_byte_sse2(float facf0,
+                                    float facf1,
+                                    int x,
+                                    int y,
+                                    unsigned char *rect1,
+                                    unsigned char *rect2,
+                                    unsigned char *out)
+{
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const float fac = (i & 1) ? facf1 : facf0;
+
+    for (int j = 0; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      /* rt = rt1 over rt2  (alpha from rt1) */
+      const __m128 rt1 = straight_uchar_to_premul_float_sse2(rect1);
+      const float mfac = 1.0f - fac * get_alpha_sse2(rt1);
+
+      if (fac <= 0.0f) {
+        memcpy(out, rect2, 4);
+      }
+      else if (mfac <= 0.0f) {
+        memcpy(out, rect1, 4);
+      }
+      else {
+        const __m128 rt2 = straight_uchar_to_premul_float_sse2(rect2);
+        const __m128 tempc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), rt1),
+                                        _mm_mul_ps(_mm_set1_ps(mfac), rt2));
+        premul_float_to_straight_uchar_sse2(out, tempc);
+      }
+    }
+  }
+}
+#endif
+
+void seq_effect_alphaover_byte(float facf0,
+                               float facf1,
+                               int x,
+                               int y,
+                               unsigned char *rect1,
+                               unsigned char *rect2,
+                               unsigned char *out)
+{
+#ifdef __SSE2__
+  seq_effect_alphaover_byte_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_alphaover_byte_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+void seq_effect_alphaover_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  float fac2, mfac, fac, fac4;
+  int xo;
+  float *rt1, *rt2, *rt;
+
+  xo = x;
+  rt1 = rect1;
+  rt2 = rect2;
+  rt = out;
+
+  fac2 = facf0;
+  fac4 = facf1;
+
+  while (y--) {
+    x = xo;
+    while (x--) {
+      /* rt = rt1 over rt2  (alpha from rt1) */
+
+      fac = fac2;
+      mfac = 1.0f - (fac2 * rt1[3]);
+
+      if (fac <= 0.0f) {
+        memcpy(rt, rt2, 4 * sizeof(float));
+      }
+      else if (mfac <= 0) {
+        memcpy(rt, rt1, 4 * sizeof(float));
+      }
+      else {
+        rt[0] = fac * rt1[0] + mfac * rt2[0];
+        rt[1] = fac * rt1[1] + mfac * rt2[1];
+        rt[2] = fac * rt1[2] + mfac * rt2[2];
+        rt[3] = fac * rt1[3] + mfac * rt2[3];
+      }
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+      fac = fac4;
+      mfac = 1.0f - (fac4 * rt1[3]);
+
+      if (fac <= 0.0f) {
+        memcpy(rt, rt2, 4 * sizeof(float));
+      }
+      else if (mfac <= 0.0f) {
+        memcpy(rt, rt1, 4 * sizeof(float));
+      }
+      else {
+        rt[0] = fac * rt1[0] + mfac * rt2[0];
+        rt[1] = fac * rt1[1] + mfac * rt2[1];
+        rt[2] = fac * rt1[2] + mfac * rt2[2];
+        rt[3] = fac * rt1[3] + mfac * rt2[3];
+      }
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_alphaover_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const float fac = (i & 1) ? facf1 : facf0;
+
+    if (fac <= 0.0f) {
+      memcpy(out, rect2, sizeof(float[4]) * x);
+      rect1 += 4 * x;
+      rect2 += 4 * x;
+      out += 4 * x;
+      continue;
+    }
+
+    for (int j = 0; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      /* rt = rt1 over rt2  (alpha from rt1) */
+      const float mfac = 1.0f - (fac * rect1[3]);
+
+      if (mfac <= 0.0f) {
+        _mm_storeu_ps(out, _mm_loadu_ps(rect1));
+      }
+      else {
+        _mm_storeu_ps(out,
+                      _mm_add_ps(_mm_mul_ps(_mm_set1_ps(fac), _mm_loadu_ps(rect1)),
+                                 _mm_mul_ps(_mm_set1_ps(mfac), _mm_loadu_ps(rect2))));
+      }
+    }
+  }
+}
+#endif
+
+void seq_effect_alphaover_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+#ifdef __SSE2__
+  seq_effect_alphaover_float_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_alphaover_float_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+/*********************** Cross *************************/
+
+void seq_effect_cross_byte_scalar(float facf0,
+                                  float facf1,
+                                  int x,
+                                  int y,
+                                  unsigned char *rect1,
+                                  unsigned char *rect2,
+                                  unsigned char *out)
+{
+  int fac1, fac2, fac3, fac4;
+  int xo;
+  unsigned char *rt1, *rt2, *rt;
+
+  xo = x;
+  rt1 = rect1;
+  rt2 = rect2;
+  rt = out;
+
+  fac2 = (int)(256.0f * facf0);
+  fac1 = 256 - fac2;
+  fac4 = (int)(256.0f * facf1);
+  fac3 = 256 - fac4;
+
+  while (y--) {
+    x = xo;
+    while (x--) {
+      rt[0] = (fac1 * rt1[0] + fac2 * rt2[0]) >> 8;
+      rt[1] = (fac1 * rt1[1] + fac2 * rt2[1]) >> 8;
+      rt[2] = (fac1 * rt1[2] + fac2 * rt2[2]) >> 8;
+      rt[3] = (fac1 * rt1[3] + fac2 * rt2[3]) >> 8;
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+      rt[0] = (fac3 * rt1[0] + fac4 * rt2[0]) >> 8;
+      rt[1] = (fac3 * rt1[1] + fac4 * rt2[1]) >> 8;
+      rt[2] = (fac3 * rt1[2] + fac4 * rt2[2]) >> 8;
+      rt[3] = (fac3 * rt1[3] + fac4 * rt2[3]) >> 8;
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_cross_byte_sse2(float facf0,
+                                float facf1,
+                                int x,
+                                int y,
+                                unsigned char *rect1,
+                                unsigned char *rect2,
+                                unsigned char *out)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const int fac2 = (int)(256.0f * ((i & 1) ? facf1 : facf0));
+    const int fac1 = 256 - fac2;
+    int j = 0;
+
+    /* Weighted sums fit into unsigned 16 bit lanes for factors in 0..256 range. */
+    if (fac2 >= 0 && fac2 <= 256) {
+      const __m128i fac1_v = _mm_set1_epi16((short)fac1);
+      const __m128i fac2_v = _mm_set1_epi16((short)fac2);
+
+      for (; j + 4 <= x; j += 4, rect1 += 16, rect2 += 16, out += 16) {
+        const __m128i rt1 = _mm_loadu_si128((const __m128i *)rect1);
+        const __m128i rt2 = _mm_loadu_si128((const __m128i *)rect2);
+        const __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(rt1, zero), fac1_v),
+                                         _mm_mullo_epi16(_mm_unpacklo_epi8(rt2, zero), fac2_v));
+        const __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(rt1, zero), fac1_v),
+                                         _mm_mullo_epi16(_mm_unpackhi_epi8(rt2, zero), fac2_v));
+
+        _mm_storeu_si128((__m128i *)out,
+                         _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+      }
+    }
+
+    for (; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      out[0] = (fac1 * rect1[0] + fac2 * rect2[0]) >> 8;
+      out[1] = (fac1 * rect1[1] + fac2 * rect2[1]) >> 8;
+      out[2] = (fac1 * rect1[2] + fac2 * rect2[2]) >> 8;
+      out[3] = (fac1 * rect1[3] + fac2 * rect2[3]) >> 8;
+    }
+  }
+}
+#endif
+
+void seq_effect_cross_byte(float facf0,
+                           float facf1,
+                           int x,
+                           int y,
+                           unsigned char *rect1,
+                           unsigned char *rect2,
+                           unsigned char *out)
+{
+#ifdef __SSE2__
+  seq_effect_cross_byte_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_cross_byte_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+void seq_effect_cross_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  float fac1, fac2, fac3, fac4;
+  int xo;
+  float *rt1, *rt2, *rt;
+
+  xo = x;
+  rt1 = rect1;
+  rt2 = rect2;
+  rt = out;
+
+  fac2 = facf0;
+  fac1 = 1.0f - fac2;
+  fac4 = facf1;
+  fac3 = 1.0f - fac4;
+
+  while (y--) {
+    x = xo;
+    while (x--) {
+      rt[0] = fac1 * rt1[0] + fac2 * rt2[0];
+      rt[1] = fac1 * rt1[1] + fac2 * rt2[1];
+      rt[2] = fac1 * rt1[2] + fac2 * rt2[2];
+      rt[3] = fac1 * rt1[3] + fac2 * rt2[3];
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+      rt[0] = fac3 * rt1[0] + fac4 * rt2[0];
+      rt[1] = fac3 * rt1[1] + fac4 * rt2[1];
+      rt[2] = fac3 * rt1[2] + fac4 * rt2[2];
+      rt[3] = fac3 * rt1[3] + fac4 * rt2[3];
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_cross_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const float fac2 = (i & 1) ? facf1 : facf0;
+    const __m128 fac1_v = _mm_set1_ps(1.0f - fac2);
+    const __m128 fac2_v = _mm_set1_ps(fac2);
+
+    for (int j = 0; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      _mm_storeu_ps(out,
+                    _mm_add_ps(_mm_mul_ps(fac1_v, _mm_loadu_ps(rect1)),
+                               _mm_mul_ps(fac2_v, _mm_loadu_ps(rect2))));
+    }
+  }
+}
+#endif
+
+void seq_effect_cross_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+#ifdef __SSE2__
+  seq_effect_cross_float_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_cross_float_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+/*********************** Add *************************/
+
+void seq_effect_add_byte_scalar(float facf0,
+                                float facf1,
+                                int x,
+                                int y,
+                                unsigned char *rect1,
+                                unsigned char *rect2,
+                                unsigned char *out)
+{
+  int xo, fac1, fac3;
+  unsigned char *cp1, *cp2, *rt;
+
+  xo = x;
+  cp1 = rect1;
+  cp2 = rect2;
+  rt = out;
+
+  fac1 = (int)(256.0f * facf0);
+  fac3 = (int)(256.0f * facf1);
+
+  while (y--) {
+    x = xo;
+
+    while (x--) {
+      const int m = fac1 * (int)cp2[3];
+      rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
+      rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
+      rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
+      rt[3] = cp1[3];
+
+      cp1 += 4;
+      cp2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+      const int m = fac3 * (int)cp2[3];
+      rt[0] = min_ii(cp1[0] + ((m * cp2[0]) >> 16), 255);
+      rt[1] = min_ii(cp1[1] + ((m * cp2[1]) >> 16), 255);
+      rt[2] = min_ii(cp1[2] + ((m * cp2[2]) >> 16), 255);
+      rt[3] = cp1[3];
+
+      cp1 += 4;
+      cp2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_add_byte_sse2(float facf0,
+                              float facf1,
+                              int x,
+                              int y,
+                              unsigned char *rect1,
+                              unsigned char *rect2,
+                              unsigned char *out)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask_alpha = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const int fac = (int)(256.0f * ((i & 1) ? facf1 : facf0));
+    int j = 0;
+
+    /* Alpha weighted factor fits into unsigned 16 bit lanes for factors in 0..256 range. */
+    if (fac >= 0 && fac <= 256) {
+      const __m128i fac_v = _mm_set1_epi16((short)fac);
+
+      for (; j + 4 <= x; j += 4, rect1 += 16, rect2 += 16, out += 16) {
+        const __m128i cp1 = _mm_loadu_si128((const __m128i *)rect1);
+        const __m128i cp2 = _mm_loadu_si128((const __m128i *)rect2);
+        __m128i result[2];
+
+        for (int half = 0; half < 2; half++) {
+          const __m128i c1 = half ? _mm_unpackhi_epi8(cp1, zero) : _mm_unpacklo_epi8(cp1, zero);
+          const __m128i c2 = half ? _mm_unpackhi_epi8(cp2, zero) : _mm_unpacklo_epi8(cp2, zero);
+          const __m128i a2 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c2, _MM_SHUFFLE(3, 3, 3, 3)),
+                                                 _MM_SHUFFLE(3, 3, 3, 3));
+          const __m128i m = _mm_mullo_epi16(fac_v, a2);
+          const __m128i sum = _mm_add_epi16(c1, _mm_mulhi_epu16(m, c2));
+
+          /* Alpha is taken from first input. */
+          result[half] = _mm_or_si128(_mm_andnot_si128(mask_alpha, sum),
+                                      _mm_and_si128(mask_alpha, c1));
+        }
+
+        /* Packing with saturation clamps to 255. */
+        _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(result[0], result[1]));
+      }
+    }
+
+    for (; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      const int m = fac * (int)rect2[3];
+      out[0] = min_ii(rect1[0] + ((m * rect2[0]) >> 16), 255);
+      out[1] = min_ii(rect1[1] + ((m * rect2[1]) >> 16), 255);
+      out[2] = min_ii(rect1[2] + ((m * rect2[2]) >> 16), 255);
+      out[3] = rect1[3];
+    }
+  }
+}
+#endif
+
+void seq_effect_add_byte(float facf0,
+                         float facf1,
+                         int x,
+                         int y,
+                         unsigned char *rect1,
+                         unsigned char *rect2,
+                         unsigned char *out)
+{
+#ifdef __SSE2__
+  seq_effect_add_byte_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_add_byte_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+void seq_effect_add_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  int xo;
+  float fac1, fac3;
+  float *rt1, *rt2, *rt;
+
+  xo = x;
+  rt1 = rect1;
+  rt2 = rect2;
+  rt = out;
+
+  fac1 = facf0;
+  fac3 = facf1;
+
+  while (y--) {
+    x = xo;
+    while (x--) {
+      const float m = (1.0f - (rt1[3] * (1.0f - fac1))) * rt2[3];
+      rt[0] = rt1[0] + m * rt2[0];
+      rt[1] = rt1[1] + m * rt2[1];
+      rt[2] = rt1[2] + m * rt2[2];
+      rt[3] = rt1[3];
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+      const float m = (1.0f - (rt1[3] * (1.0f - fac3))) * rt2[3];
+      rt[0] = rt1[0] + m * rt2[0];
+      rt[1] = rt1[1] + m * rt2[1];
+      rt[2] = rt1[2] + m * rt2[2];
+      rt[3] = rt1[3];
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_add_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const float fac = (i & 1) ? facf1 : facf0;
+
+    for (int j = 0; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      const __m128 rt1 = _mm_loadu_ps(rect1);
+      const float m = (1.0f - (rect1[3] * (1.0f - fac))) * rect2[3];
+
+      _mm_storeu_ps(
+          out,
+          replace_alpha_sse2(_mm_add_ps(rt1, _mm_mul_ps(_mm_set1_ps(m), _mm_loadu_ps(rect2))),
+                             rt1));
+    }
+  }
+}
+#endif
+
+void seq_effect_add_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+#ifdef __SSE2__
+  seq_effect_add_float_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_add_float_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+/*********************** Mul *************************/
+
+void seq_effect_mul_byte_scalar(float facf0,
+                                float facf1,
+                                int x,
+                                int y,
+                                unsigned char *rect1,
+                                unsigned char *rect2,
+                                unsigned char *out)
+{
+  int xo, fac1, fac3;
+  unsigned char *rt1, *rt2, *rt;
+
+  xo = x;
+  rt1 = rect1;
+  rt2 = rect2;
+  rt = out;
+
+  fac1 = (int)(256.0f * facf0);
+  fac3 = (int)(256.0f * facf1);
+
+  /* formula:
+   * fac * (a * b) + (1 - fac) * a  => fac * a * (b - 1) + axaux = c * px + py * s; //+centx
+   * yaux = -s * px + c * py; //+centy
+   */
+
+  while (y--) {
+
+    x = xo;
+    while (x--) {
+
+      rt[0] = rt1[0] + ((fac1 * rt1[0] * (rt2[0] - 255)) >> 16);
+      rt[1] = rt1[1] + ((fac1 * rt1[1] * (rt2[1] - 255)) >> 16);
+      rt[2] = rt1[2] + ((fac1 * rt1[2] * (rt2[2] - 255)) >> 16);
+      rt[3] = rt1[3] + ((fac1 * rt1[3] * (rt2[3] - 255)) >> 16);
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+
+      rt[0] = rt1[0] + ((fac3 * rt1[0] * (rt2[0] - 255)) >> 16);
+      rt[1] = rt1[1] + ((fac3 * rt1[1] * (rt2[1] - 255)) >> 16);
+      rt[2] = rt1[2] + ((fac3 * rt1[2] * (rt2[2] - 255)) >> 16);
+      rt[3] = rt1[3] + ((fac3 * rt1[3] * (rt2[3] - 255)) >> 16);
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_mul_byte_sse2(float facf0,
+                              float facf1,
+                              int x,
+                              int y,
+                              unsigned char *rect1,
+                              unsigned char *rect2,
+                              unsigned char *out)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i max_v = _mm_set1_epi16(255);
+
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const int fac = (int)(256.0f * ((i & 1) ? facf1 : facf0));
+    int j = 0;
+
+    /* a + ((fac * a * (b - 255)) >> 16) is computed as a - ceil(fac * a * (255 - b) / 65536),
+     * so all products are unsigned 16 bit values for factors in 0..256 range. */
+    if (fac >= 0 && fac <= 256) {
+      const __m128i fac_v = _mm_set1_epi16((short)fac);
+
+      for (; j + 4 <= x; j += 4, rect1 += 16, rect2 += 16, out += 16) {
+        const __m128i rt1 = _mm_loadu_si128((const __m128i *)rect1);
+        const __m128i rt2 = _mm_loadu_si128((const __m128i *)rect2);
+        __m128i result[2];
+
+        for (int half = 0; half < 2; half++) {
+          const __m128i a = half ? _mm_unpackhi_epi8(rt1, zero) : _mm_unpacklo_epi8(rt1, zero);
+          const __m128i b = half ? _mm_unpackhi_epi8(rt2, zero) : _mm_unpacklo_epi8(rt2, zero);
+          const __m128i p = _mm_mullo_epi16(fac_v, a);
+          const __m128i d = _mm_sub_epi16(max_v, b);
+          const __m128i prod_hi = _mm_mulhi_epu16(p, d);
+          const __m128i prod_lo = _mm_mullo_epi16(p, d);
+          const __m128i round_up = _mm_andnot_si128(_mm_cmpeq_epi16(prod_lo, zero), one);
+
+          result[half] = _mm_sub_epi16(_mm_sub_epi16(a, prod_hi), round_up);
+        }
+
+        _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(result[0], result[1]));
+      }
+    }
+
+    for (; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      out[0] = rect1[0] + ((fac * rect1[0] * (rect2[0] - 255)) >> 16);
+      out[1] = rect1[1] + ((fac * rect1[1] * (rect2[1] - 255)) >> 16);
+      out[2] = rect1[2] + ((fac * rect1[2] * (rect2[2] - 255)) >> 16);
+      out[3] = rect1[3] + ((fac * rect1[3] * (rect2[3] - 255)) >> 16);
+    }
+  }
+}
+#endif
+
+void seq_effect_mul_byte(float facf0,
+                         float facf1,
+                         int x,
+                         int y,
+                         unsigned char *rect1,
+                         unsigned char *rect2,
+                         unsigned char *out)
+{
+#ifdef __SSE2__
+  seq_effect_mul_byte_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_mul_byte_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+void seq_effect_mul_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  int xo;
+  float fac1, fac3;
+  float *rt1, *rt2, *rt;
+
+  xo = x;
+  rt1 = rect1;
+  rt2 = rect2;
+  rt = out;
+
+  fac1 = facf0;
+  fac3 = facf1;
+
+  /* formula:
+   * fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a
+   */
+
+  while (y--) {
+    x = xo;
+    while (x--) {
+      rt[0] = rt1[0] + fac1 * rt1[0] * (rt2[0] - 1.0f);
+      rt[1] = rt1[1] + fac1 * rt1[1] * (rt2[1] - 1.0f);
+      rt[2] = rt1[2] + fac1 * rt1[2] * (rt2[2] - 1.0f);
+      rt[3] = rt1[3] + fac1 * rt1[3] * (rt2[3] - 1.0f);
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+
+    if (y == 0) {
+      break;
+    }
+    y--;
+
+    x = xo;
+    while (x--) {
+      rt[0] = rt1[0] + fac3 * rt1[0] * (rt2[0] - 1.0f);
+      rt[1] = rt1[1] + fac3 * rt1[1] * (rt2[1] - 1.0f);
+      rt[2] = rt1[2] + fac3 * rt1[2] * (rt2[2] - 1.0f);
+      rt[3] = rt1[3] + fac3 * rt1[3] * (rt2[3] - 1.0f);
+
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+void seq_effect_mul_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const __m128 fac_v = _mm_set1_ps((i & 1) ? facf1 : facf0);
+
+    /* fac * (a * b) + (1 - fac) * a  =>  fac * a * (b - 1) + a */
+    for (int j = 0; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      const __m128 rt1 = _mm_loadu_ps(rect1);
+
+      _mm_storeu_ps(
+          out,
+          _mm_add_ps(rt1,
+                     _mm_mul_ps(_mm_mul_ps(fac_v, rt1), _mm_sub_ps(_mm_loadu_ps(rect2), one))));
+    }
+  }
+}
+#endif
+
+void seq_effect_mul_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out)
+{
+#ifdef __SSE2__
+  seq_effect_mul_float_sse2(facf0, facf1, x, y, rect1, rect2, out);
+#else
+  seq_effect_mul_float_scalar(facf0, facf1, x, y, rect1, rect2, out);
+#endif
+}
+
+/*********************** Blend Mode ***************************************/
+
+typedef void (*IMB_blend_func_float)(float *dst, const float *src1, const float *src2);
+
+BLI_INLINE void apply_blend_function_float(float facf0,
+                                           float facf1,
+                                           int x,
+                                           int y,
+                                           float *rect1,
+                                           float *rect2,
+                                           float *out,
+                                           IMB_blend_func_float blend_function)
+{
+  int xo;
+  float *rt1, *rt2, *rt;
+  float achannel;
+  xo = x;
+  rt1 = rect1;
+  rt2 = rect2;
+  rt = out;
+  while (y--) {
+    for (x = xo; x > 0; x--) {
+      achannel = rt1[3];
+      rt1[3] = achannel * facf0;
+      blend_function(rt, rt1, rt2);
+      rt1[3] = achannel;
+      rt[3] = rt1[3];
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+    if (y == 0) {
+      break;
+    }
+    y--;
+    for (x = xo; x > 0; x--) {
+      achannel = rt1[3];
+      rt1[3] = achannel * facf1;
+      blend_function(rt, rt1, rt2);
+      rt1[3] = achannel;
+      rt[3] = rt1[3];
+      rt1 += 4;
+      rt2 += 4;
+      rt += 4;
+    }
+  }
+}
+
+#ifdef __SSE2__
+
+/* Same as blend_color_*_float() functions for src2 alpha (t) other than zero,
+ * src1_alpha is alpha of src1 multiplied by effect factor. */
+BLI_INLINE __m128 blend_color_float_sse2(
+    const int btype, const __m128 src1, const __m128 src2, const float src1_alpha, const float t)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+
+  switch (btype) {
+    case SEQ_TYPE_ADD:
+      return _mm_add_ps(src1, _mm_mul_ps(src2, _mm_set1_ps(src1_alpha)));
+    case SEQ_TYPE_SUB:
+      return _mm_max_ps(_mm_sub_ps(src1, _mm_mul_ps(src2, _mm_set1_ps(src1_alpha))), zero);
+    case SEQ_TYPE_MUL:
+      return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f - t), src1),
+                        _mm_mul_ps(_mm_mul_ps(src1, src2), _mm_set1_ps(src1_alpha)));
+    case SEQ_TYPE_LIGHTEN:
+    case SEQ_TYPE_DARKEN: {
+      const __m128 src2_mapped = _mm_mul_ps(src2, _mm_set1_ps(src1_alpha / t));
+      const __m128 src_mix = (btype == SEQ_TYPE_LIGHTEN) ? _mm_max_ps(src1, src2_mapped) :
+                                                           _mm_min_ps(src1, src2_mapped);
+      return _mm_add_ps(_mm_mul_ps(_mm_set1_ps(1.0f - t), src1),
+                        _mm_mul_ps(_mm_set1_ps(t), src_mix));
+    }
+    case SEQ_TYPE_SCREEN: {
+      const __m128 temp = _mm_max_ps(
+          _mm_sub_ps(one, _mm_mul_ps(_mm_sub_ps(one, src1), _mm_sub_ps(one, src2))), zero);
+      return _mm_add_ps(_mm_mul_ps(temp, _mm_set1_ps(t)),
+                        _mm_mul_ps(src1, _mm_set1_ps(1.0f - t)));
+    }
+  }
+
+  BLI_assert(0);
+  return src1;
+}
+
+BLI_INLINE void apply_blend_function_float_sse2(float facf0,
+                                                float facf1,
+                                                int x,
+                                                int y,
+                                                const float *rect1,
+                                                const float *rect2,
+                                                float *out,
+                                                const int btype)
+{
+  for (int i = 0; i < y; i++) {
+    /* Odd lines use factor of second field. */
+    const float fac = (i & 1) ? facf1 : facf0;
+
+    for (int j = 0; j < x; j++, rect1 += 4, rect2 += 4, out += 4) {
+      const __m128 src1 = _mm_loadu_ps(rect1);
+      const float t = rect2[3];
+      __m128 dst = src1;
+
+      if (t != 0.0f) {
+        dst = blend_color_float_sse2(btype, src1, _mm_loadu_ps(rect2), rect1[3] * fac, t);
+      }
+      _mm_storeu_ps(out, replace_alpha_sse2(dst, src1));
+    }
+  }
+}
+
+/* Vectorized versions of the most common blend modes, returns false for other modes. */
+bool seq_effect_blend_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out)
+{
+  /* Each mode gets its own instance of the loop. */
+  switch (btype) {
+    case SEQ_TYPE_ADD:
+      apply_blend_function_float_sse2(facf0, facf1, x, y, rect1, rect2, out, SEQ_TYPE_ADD);
+      return true;
+    case SEQ_TYPE_SUB:
+      apply_blend_function_float_sse2(facf0, facf1, x, y, rect1, rect2, out, SEQ_TYPE_SUB);
+      return true;
+    case SEQ_TYPE_MUL:
+      apply_blend_function_float_sse2(facf0, facf1, x, y, rect1, rect2, out, SEQ_TYPE_MUL);
+      return true;
+    case SEQ_TYPE_DARKEN:
+      apply_blend_function_float_sse2(facf0, facf1, x, y, rect1, rect2, out, SEQ_TYPE_DARKEN);
+      return true;
+    case SEQ_TYPE_LIGHTEN:
+      apply_blend_function_float_sse2(facf0, facf1, x, y, rect1, rect2, out, SEQ_TYPE_LIGHTEN);
+      return true;
+    case SEQ_TYPE_SCREEN:
+      apply_blend_function_float_sse2(facf0, facf1, x, y, rect1, rect2, out, SEQ_TYPE_SCREEN);
+      return true;
+  }
+  return false;
+}
+
+#endif /* __SSE2__ */
+
+void seq_effect_blend_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out)
+{
+  switch (btype) {
+    case SEQ_TYPE_ADD:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_add_float);
+      break;
+    case SEQ_TYPE_SUB:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_sub_float);
+      break;
+    case SEQ_TYPE_MUL:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_mul_float);
+      break;
+    case SEQ_TYPE_DARKEN:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_darken_float);
+      break;
+    case SEQ_TYPE_COLOR_BURN:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_burn_float);
+      break;
+    case SEQ_TYPE_LINEAR_BURN:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_linearburn_float);
+      break;
+    case SEQ_TYPE_SCREEN:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_screen_float);
+      break;
+    case SEQ_TYPE_LIGHTEN:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_lighten_float);
+      break;
+    case SEQ_TYPE_DODGE:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_dodge_float);
+      break;
+    case SEQ_TYPE_OVERLAY:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_overlay_float);
+      break;
+    case SEQ_TYPE_SOFT_LIGHT:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_softlight_float);
+      break;
+    case SEQ_TYPE_HARD_LIGHT:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_hardlight_float);
+      break;
+    case SEQ_TYPE_PIN_LIGHT:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_pinlight_float);
+      break;
+    case SEQ_TYPE_LIN_LIGHT:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_linearlight_float);
+      break;
+    case SEQ_TYPE_VIVID_LIGHT:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_vividlight_float);
+      break;
+    case SEQ_TYPE_BLEND_COLOR:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_color_float);
+      break;
+    case SEQ_TYPE_HUE:
+      apply_blend_function_float(facf0, facf1, x, y, rect1, rect2, out, blend_color_hue_float);
+      break;
+    case SEQ_TYPE_SATURATION:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_saturation_float);
+      break;
+    case SEQ_TYPE_VALUE:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_luminosity_float);
+      break;
+    case SEQ_TYPE_DIFFERENCE:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_difference_float);
+      break;
+    case SEQ_TYPE_EXCLUSION:
+      apply_blend_function_float(
+          facf0, facf1, x, y, rect1, rect2, out, blend_color_exclusion_float);
+      break;
+    default:
+      break;
+  }
+}
+
+void seq_effect_blend_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out)
+{
+#ifdef __SSE2__
+  if (seq_effect_blend_float_sse2(facf0, facf1, x, y, rect1, rect2, btype, out)) {
+    return;
+  }
+#endif
+  seq_effect_blend_float_scalar(facf0, facf1, x, y, rect1, rect2, btype, out);
+}
@@ -0,0 +1,184 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2001-2002 by NaN Holding BV.
+ * All rights reserved.
+ *
+ * - Blender Foundation, 2003-2009
+ * - Peter Schlaile <peter [at] schlaile [dot] de> 2005/2006
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Per-pixel kernels of the sequencer effects, \a y lines of \a x RGBA pixels.
+ * Odd lines use \a facf1, even lines use \a facf0.
+ */
+
+#ifndef __SEQEFFECTS_KERNELS_H__
+#define __SEQEFFECTS_KERNELS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Alpha over: rect1 over rect2. */
+void seq_effect_alphaover_byte(float facf0,
+                               float facf1,
+                               int x,
+                               int y,
+                               unsigned char *rect1,
+                               unsigned char *rect2,
+                               unsigned char *out);
+void seq_effect_alphaover_byte_scalar(float facf0,
+                                      float facf1,
+                                      int x,
+                                      int y,
+                                      unsigned char *rect1,
+                                      unsigned char *rect2,
+                                      unsigned char *out);
+#ifdef __SSE2__
+void seq_effect_alphaover_byte_sse2(float facf0,
+                                    float facf1,
+                                    int x,
+                                    int y,
+                                    unsigned char *rect1,
+                                    unsigned char *rect2,
+                                    unsigned char *out);
+#endif
+void seq_effect_alphaover_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+void seq_effect_alphaover_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#ifdef __SSE2__
+void seq_effect_alphaover_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#endif
+
+/* Cross fade from rect1 to rect2. */
+void seq_effect_cross_byte(float facf0,
+                           float facf1,
+                           int x,
+                           int y,
+                           unsigned char *rect1,
+                           unsigned char *rect2,
+                           unsigned char *out);
+void seq_effect_cross_byte_scalar(float facf0,
+                                  float facf1,
+                                  int x,
+                                  int y,
+                                  unsigned char *rect1,
+                                  unsigned char *rect2,
+                                  unsigned char *out);
+#ifdef __SSE2__
+void seq_effect_cross_byte_sse2(float facf0,
+                                float facf1,
+                                int x,
+                                int y,
+                                unsigned char *rect1,
+                                unsigned char *rect2,
+                                unsigned char *out);
+#endif
+void seq_effect_cross_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+void seq_effect_cross_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#ifdef __SSE2__
+void seq_effect_cross_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#endif
+
+/* Add rect2 to rect1. */
+void seq_effect_add_byte(float facf0,
+                         float facf1,
+                         int x,
+                         int y,
+                         unsigned char *rect1,
+                         unsigned char *rect2,
+                         unsigned char *out);
+void seq_effect_add_byte_scalar(float facf0,
+                                float facf1,
+                                int x,
+                                int y,
+                                unsigned char *rect1,
+                                unsigned char *rect2,
+                                unsigned char *out);
+#ifdef __SSE2__
+void seq_effect_add_byte_sse2(float facf0,
+                              float facf1,
+                              int x,
+                              int y,
+                              unsigned char *rect1,
+                              unsigned char *rect2,
+                              unsigned char *out);
+#endif
+void seq_effect_add_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+void seq_effect_add_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#ifdef __SSE2__
+void seq_effect_add_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#endif
+
+/* Multiply rect1 by rect2. */
+void seq_effect_mul_byte(float facf0,
+                         float facf1,
+                         int x,
+                         int y,
+                         unsigned char *rect1,
+                         unsigned char *rect2,
+                         unsigned char *out);
+void seq_effect_mul_byte_scalar(float facf0,
+                                float facf1,
+                                int x,
+                                int y,
+                                unsigned char *rect1,
+                                unsigned char *rect2,
+                                unsigned char *out);
+#ifdef __SSE2__
+void seq_effect_mul_byte_sse2(float facf0,
+                              float facf1,
+                              int x,
+                              int y,
+                              unsigned char *rect1,
+                              unsigned char *rect2,
+                              unsigned char *out);
+#endif
+void seq_effect_mul_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+void seq_effect_mul_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#ifdef __SSE2__
+void seq_effect_mul_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+#endif
+
+/* Blend mode effects, btype is one of the SEQ_TYPE_* blend types. */
+void seq_effect_blend_float(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out);
+void seq_effect_blend_float_scalar(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out);
+#ifdef __SSE2__
+/* Returns false when btype has no SSE2 version, out is left untouched then. */
+bool seq_effect_blend_float_sse2(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, int btype, float *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SEQEFFECTS_KERNELS_H__ */
@@ -34,6 +34,7 @@
 #include "DNA_anim_types.h"
 
 #include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_threads.h"
 
 #include "IMB_imbuf.h"
@@ -52,30 +53,51 @@
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_query.h"
 
+#include "CLG_log.h"
+
+#include "PIL_time.h"
+
+static CLG_LogRef LOG = {"bke.sequencer.prefetch"};
+
+/* Worker renders frames using its own copy of the scene, so workers can render different frames
+ * at the same time. */
+typedef struct PrefetchWorker {
+  struct PrefetchJob *pfjob;
+
+  struct Main *bmain_eval;
+  struct Scene *scene_eval;
+  struct Depsgraph *depsgraph;
+
+  /* context */
+  struct SeqRenderData context;
+  struct SeqRenderData context_cpy;
+} PrefetchWorker;
+
 typedef struct PrefetchJob {
   struct PrefetchJob *next, *prev;
 
   struct Main *bmain;
-  struct Main *bmain_eval;
   struct Scene *scene;
-  struct Scene *scene_eval;
-  struct Depsgraph *depsgraph;
 
+  /* Guards prefetch area and worker counters, frames are taken by workers one by one. */
   ThreadMutex prefetch_suspend_mutex;
   ThreadCondition prefetch_suspend_cond;
 
   ListBase threads;
 
-  /* context */
-  struct SeqRenderData context;
-  struct SeqRenderData context_cpy;
-  struct ListBase *seqbasep;
-  struct ListBase *seqbasep_cpy;
+  PrefetchWorker workers[SEQ_PREFETCH_WORKERS_MAX];
+  int num_workers;
+  int num_workers_running;
+  int num_workers_waiting;
 
   /* prefetch area */
   float cfra;
   int num_frames_prefetched;
 
+  /* statistics */
+  double start_time;
+  int num_frames_rendered;
+
   /* control */
   bool running;
   bool waiting;
@@ -111,6 +133,17 @@ static PrefetchJob *seq_prefetch_job_get(Scene *scene)
   return NULL;
 }
 
+static PrefetchWorker *seq_prefetch_worker_get(PrefetchJob *pfjob, Scene *scene_eval)
+{
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    if (pfjob->workers[i].scene_eval == scene_eval) {
+      return &pfjob->workers[i];
+    }
+  }
+  /* Scene used by scene strip, these are always rendered by a single worker. */
+  return &pfjob->workers[0];
+}
+
 bool BKE_sequencer_prefetch_job_is_running(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
@@ -133,6 +166,26 @@ static bool seq_prefetch_job_is_waiting(Scene *scene)
   return pfjob->waiting;
 }
 
+/* Multiple workers render frames at the same time. */
+bool BKE_sequencer_prefetch_is_concurrent_render(const SeqRenderData *context)
+{
+  if (!context->is_prefetch_render) {
+    return false;
+  }
+
+  PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
+
+  return pfjob && pfjob->num_workers > 1;
+}
+
+/* Number of threads rendering frames at the same time, including the main thread. */
+int BKE_sequencer_prefetch_num_render_threads(const SeqRenderData *context)
+{
+  PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
+
+  return pfjob ? pfjob->num_workers + 1 : 1;
+}
+
 /* for cache context swapping */
 Sequence *BKE_sequencer_prefetch_get_original_sequence(Sequence *seq, Scene *scene)
 {
@@ -152,8 +205,9 @@ Sequence *BKE_sequencer_prefetch_get_original_sequence(Sequence *seq, Scene *sce
 SeqRenderData *BKE_sequencer_prefetch_get_original_context(const SeqRenderData *context)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
+  PrefetchWorker *worker = seq_prefetch_worker_get(pfjob, context->scene);
 
-  return &pfjob->context;
+  return &worker->context;
 }
 
 static bool seq_prefetch_is_cache_full(Scene *scene)
@@ -175,38 +229,66 @@ void BKE_sequencer_prefetch_get_time_range(Scene *scene, int *start, int *end)
   *end = pfjob->cfra + pfjob->num_frames_prefetched;
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+/* Strips which are rendered using data shared between threads (render pipeline of scene strips,
+ * fonts of text strips, movie clip cache) can not be rendered by multiple workers at once. */
+static bool seq_prefetch_seqbase_is_threadsafe(ListBase *seqbase)
 {
-  if (pfjob->depsgraph != NULL) {
-    DEG_graph_free(pfjob->depsgraph);
+  for (Sequence *seq = seqbase->first; seq; seq = seq->next) {
+    if (ELEM(seq->type, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP, SEQ_TYPE_TEXT)) {
+      return false;
+    }
+    if (seq->type == SEQ_TYPE_META && !seq_prefetch_seqbase_is_threadsafe(&seq->seqbase)) {
+      return false;
+    }
   }
-  pfjob->depsgraph = NULL;
-  pfjob->scene_eval = NULL;
+  return true;
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static int seq_prefetch_num_workers_get(Scene *scene)
 {
-  DEG_evaluate_on_framechange(
-      pfjob->bmain_eval, pfjob->depsgraph, pfjob->cfra + pfjob->num_frames_prefetched);
+  if (!seq_prefetch_seqbase_is_threadsafe(&scene->ed->seqbase)) {
+    return 1;
+  }
+  /* Effects and image processing are threaded on their own, don't use worker per thread. */
+  return max_ii(1, min_ii(BLI_system_thread_count() / 4, SEQ_PREFETCH_WORKERS_MAX));
+}
+
+static void seq_prefetch_free_depsgraph(PrefetchWorker *worker)
+{
+  if (worker->depsgraph != NULL) {
+    DEG_graph_free(worker->depsgraph);
+  }
+  worker->depsgraph = NULL;
+  worker->scene_eval = NULL;
+}
+
+static void seq_prefetch_update_depsgraph(PrefetchWorker *worker, int cfra)
+{
+  DEG_evaluate_on_framechange(worker->bmain_eval, worker->depsgraph, cfra);
 }
 
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_init_depsgraph(PrefetchWorker *worker)
 {
-  Main *bmain = pfjob->bmain_eval;
+  PrefetchJob *pfjob = worker->pfjob;
   Scene *scene = pfjob->scene;
   ViewLayer *view_layer = BKE_view_layer_default_render(scene);
 
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+  if (worker->bmain_eval == NULL) {
+    worker->bmain_eval = BKE_main_new();
+  }
+  Main *bmain = worker->bmain_eval;
+
+  worker->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(worker->depsgraph, "SEQUENCER PREFETCH");
 
   /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph, bmain, scene, view_layer);
+  DEG_graph_build_for_render_pipeline(worker->depsgraph, bmain, scene, view_layer);
 
   /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
+  seq_prefetch_update_depsgraph(worker, pfjob->cfra + pfjob->num_frames_prefetched);
 
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  worker->scene_eval = DEG_get_evaluated_scene(worker->depsgraph);
+  worker->scene_eval->ed->cache_flag = 0;
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -246,7 +328,7 @@ void BKE_sequencer_prefetch_stop(Scene *scene)
   pfjob->stop = true;
 
   while (pfjob->running) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -255,32 +337,36 @@ static void seq_prefetch_update_context(const SeqRenderData *context)
   PrefetchJob *pfjob;
   pfjob = seq_prefetch_job_get(context->scene);
 
-  BKE_sequencer_new_render_data(pfjob->bmain_eval,
-                                pfjob->depsgraph,
-                                pfjob->scene_eval,
-                                context->rectx,
-                                context->recty,
-                                context->preview_render_size,
-                                false,
-                                &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
-
-  BKE_sequencer_new_render_data(pfjob->bmain,
-                                pfjob->depsgraph,
-                                pfjob->scene,
-                                context->rectx,
-                                context->recty,
-                                context->preview_render_size,
-                                false,
-                                &pfjob->context);
-  pfjob->context.is_prefetch_render = false;
-
-  /* Same ID as prefetch context, because context will be swapped, but we still
-   * want to assign this ID to cache entries created in this thread.
-   * This is to allow "temp cache" work correctly for both threads.
-   */
-  pfjob->context.task_id = SEQ_TASK_PREFETCH_RENDER;
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    PrefetchWorker *worker = &pfjob->workers[i];
+
+    BKE_sequencer_new_render_data(worker->bmain_eval,
+                                  worker->depsgraph,
+                                  worker->scene_eval,
+                                  context->rectx,
+                                  context->recty,
+                                  context->preview_render_size,
+                                  false,
+                                  &worker->context_cpy);
+    worker->context_cpy.is_prefetch_render = true;
+    worker->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER + i;
+
+    BKE_sequencer_new_render_data(pfjob->bmain,
+                                  worker->depsgraph,
+                                  pfjob->scene,
+                                  context->rectx,
+                                  context->recty,
+                                  context->preview_render_size,
+                                  false,
+                                  &worker->context);
+    worker->context.is_prefetch_render = false;
+
+    /* Same ID as prefetch context, because context will be swapped, but we still
+     * want to assign this ID to cache entries created in this thread.
+     * This is to allow "temp cache" work correctly for both threads.
+     */
+    worker->context.task_id = worker->context_cpy.task_id;
+  }
 }
 
 static void seq_prefetch_update_scene(Scene *scene)
@@ -291,16 +377,20 @@ static void seq_prefetch_update_scene(Scene *scene)
     return;
   }
 
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  for (int i = 0; i < SEQ_PREFETCH_WORKERS_MAX; i++) {
+    seq_prefetch_free_depsgraph(&pfjob->workers[i]);
+  }
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    seq_prefetch_init_depsgraph(&pfjob->workers[i]);
+  }
 }
 
 static void seq_prefetch_resume(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
-  if (pfjob && pfjob->waiting) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+  if (pfjob && pfjob->num_workers_waiting > 0) {
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -313,75 +403,124 @@ void BKE_sequencer_prefetch_free(Scene *scene)
 
   BKE_sequencer_prefetch_stop(scene);
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
+  for (int i = 0; i < SEQ_PREFETCH_WORKERS_MAX; i++) {
+    BLI_threadpool_remove(&pfjob->threads, &pfjob->workers[i]);
+  }
   BLI_threadpool_end(&pfjob->threads);
   BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
   BLI_condition_end(&pfjob->prefetch_suspend_cond);
-  seq_prefetch_free_depsgraph(pfjob);
-  BKE_main_free(pfjob->bmain_eval);
+  for (int i = 0; i < SEQ_PREFETCH_WORKERS_MAX; i++) {
+    PrefetchWorker *worker = &pfjob->workers[i];
+    seq_prefetch_free_depsgraph(worker);
+    if (worker->bmain_eval != NULL) {
+      BKE_main_free(worker->bmain_eval);
+    }
+  }
   MEM_freeN(pfjob);
   scene->ed->prefetch_job = NULL;
 }
 
-static void *seq_prefetch_frames(void *job)
+static void seq_prefetch_render_frame(PrefetchWorker *worker, int cfra)
 {
-  PrefetchJob *pfjob = (PrefetchJob *)job;
-
-  while (pfjob->cfra + pfjob->num_frames_prefetched <= pfjob->scene->r.efra) {
-    pfjob->scene_eval->ed->prefetch_job = NULL;
-
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    BKE_animsys_evaluate_animdata(pfjob->context_cpy.scene,
-                                  &pfjob->context_cpy.scene->id,
-                                  adt,
-                                  pfjob->cfra + pfjob->num_frames_prefetched,
-                                  ADT_RECALC_ALL,
-                                  false);
-    seq_prefetch_update_depsgraph(pfjob);
-
-    /* This is quite hacky solution:
-     * We need cross-reference original scene with copy for cache.
-     * However depsgraph must not have this data, because it will try to kill this job.
-     * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
-     * Set to NULL before return!
-     */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
+  PrefetchJob *pfjob = worker->pfjob;
+
+  worker->scene_eval->ed->prefetch_job = NULL;
+
+  AnimData *adt = BKE_animdata_from_id(&worker->context_cpy.scene->id);
+  BKE_animsys_evaluate_animdata(worker->context_cpy.scene,
+                                &worker->context_cpy.scene->id,
+                                adt,
+                                cfra,
+                                ADT_RECALC_ALL,
+                                false);
+  seq_prefetch_update_depsgraph(worker, cfra);
+
+  /* This is quite hacky solution:
+   * We need cross-reference original scene with copy for cache.
+   * However depsgraph must not have this data, because it will try to kill this job.
+   * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
+   * Set to NULL before return!
+   */
+  worker->scene_eval->ed->prefetch_job = pfjob;
 
-    ImBuf *ibuf = BKE_sequencer_give_ibuf(
-        &pfjob->context_cpy, pfjob->cfra + pfjob->num_frames_prefetched, 0);
-    BKE_sequencer_cache_free_temp_cache(
-        pfjob->scene, pfjob->context.task_id, pfjob->cfra + pfjob->num_frames_prefetched);
-    IMB_freeImBuf(ibuf);
+  ImBuf *ibuf = BKE_sequencer_give_ibuf(&worker->context_cpy, cfra, 0);
+  BKE_sequencer_cache_free_temp_cache(pfjob->scene, worker->context.task_id, cfra);
+  IMB_freeImBuf(ibuf);
+}
 
-    /* suspend thread */
-    BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
-    while ((seq_prefetch_is_cache_full(pfjob->scene) || seq_prefetch_is_scrubbing(pfjob->bmain)) &&
-           pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && !pfjob->stop) {
-      pfjob->waiting = true;
-      BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
-      seq_prefetch_update_area(pfjob);
-    }
-    pfjob->waiting = false;
-    BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+static void seq_prefetch_report_statistics(PrefetchJob *pfjob)
+{
+  const double time = PIL_check_seconds_timer() - pfjob->start_time;
 
-    /* Avoid "collision" with main thread, but make sure to fetch at least few frames */
-    if (pfjob->num_frames_prefetched > 5 &&
-        (pfjob->cfra + pfjob->num_frames_prefetched - pfjob->scene->r.cfra) < 2) {
+  if (pfjob->num_frames_rendered == 0 || time <= 0.0) {
+    return;
+  }
+
+  CLOG_INFO(&LOG,
+            1,
+            "%d frames prefetched by %d worker(s) in %.2f s, %.2f fps",
+            pfjob->num_frames_rendered,
+            pfjob->num_workers,
+            time,
+            pfjob->num_frames_rendered / time);
+}
+
+static void *seq_prefetch_frames(void *worker_v)
+{
+  PrefetchWorker *worker = (PrefetchWorker *)worker_v;
+  PrefetchJob *pfjob = worker->pfjob;
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  while (pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && !pfjob->stop) {
+    seq_prefetch_update_area(pfjob);
+
+    /* Take next frame which is not taken by other workers yet, frames nearest to current frame
+     * are rendered first. */
+    const int cfra = pfjob->cfra + pfjob->num_frames_prefetched;
+
+    if (cfra > pfjob->scene->r.efra) {
       break;
     }
 
-    if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
+    /* Avoid "collision" with main thread, but make sure to fetch at least few frames */
+    if (pfjob->num_frames_prefetched > 5 && (cfra - pfjob->scene->r.cfra) < 2) {
       break;
     }
 
-    seq_prefetch_update_area(pfjob);
     pfjob->num_frames_prefetched++;
+    BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+    seq_prefetch_render_frame(worker, cfra);
+
+    BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+    pfjob->num_frames_rendered++;
+
+    /* suspend thread */
+    while ((seq_prefetch_is_cache_full(pfjob->scene) || seq_prefetch_is_scrubbing(pfjob->bmain)) &&
+           pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE && !pfjob->stop) {
+      pfjob->num_workers_waiting++;
+      pfjob->waiting = (pfjob->num_workers_waiting == pfjob->num_workers_running);
+      BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
+      pfjob->num_workers_waiting--;
+      pfjob->waiting = false;
+    }
   }
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 
   BKE_sequencer_cache_free_temp_cache(
-      pfjob->scene, pfjob->context.task_id, pfjob->cfra + pfjob->num_frames_prefetched);
-  pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = NULL;
+      pfjob->scene, worker->context.task_id, pfjob->cfra + pfjob->num_frames_prefetched);
+  worker->scene_eval->ed->prefetch_job = NULL;
+
+  /* Job is running until its last worker is finished. */
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  pfjob->num_workers_running--;
+  pfjob->waiting = (pfjob->num_workers_running != 0 &&
+                    pfjob->num_workers_waiting == pfjob->num_workers_running);
+  if (pfjob->num_workers_running == 0) {
+    seq_prefetch_report_statistics(pfjob);
+    pfjob->running = false;
+  }
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 
   return 0;
 }
@@ -395,31 +534,43 @@ static PrefetchJob *seq_prefetch_start(const SeqRenderData *context, float cfra)
       pfjob = (PrefetchJob *)MEM_callocN(sizeof(PrefetchJob), "PrefetchJob");
       context->scene->ed->prefetch_job = pfjob;
 
-      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, 1);
+      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, SEQ_PREFETCH_WORKERS_MAX);
       BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
       BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
       pfjob->bmain = context->bmain;
-      pfjob->bmain_eval = BKE_main_new();
-
       pfjob->scene = context->scene;
-      seq_prefetch_init_depsgraph(pfjob);
+
+      for (int i = 0; i < SEQ_PREFETCH_WORKERS_MAX; i++) {
+        pfjob->workers[i].pfjob = pfjob;
+      }
     }
   }
-  seq_prefetch_update_scene(context->scene);
-  seq_prefetch_update_context(context);
+
+  /* Threads of previous run are finished, but still need to be joined. */
+  for (int i = 0; i < SEQ_PREFETCH_WORKERS_MAX; i++) {
+    BLI_threadpool_remove(&pfjob->threads, &pfjob->workers[i]);
+  }
 
   pfjob->cfra = cfra;
   pfjob->num_frames_prefetched = 1;
+  pfjob->num_workers = seq_prefetch_num_workers_get(context->scene);
+
+  seq_prefetch_update_scene(context->scene);
+  seq_prefetch_update_context(context);
+
+  pfjob->num_workers_running = pfjob->num_workers;
+  pfjob->num_workers_waiting = 0;
+  pfjob->start_time = PIL_check_seconds_timer();
+  pfjob->num_frames_rendered = 0;
 
   pfjob->waiting = false;
   pfjob->stop = false;
   pfjob->running = true;
 
-  if (&pfjob->threads) {
-    BLI_threadpool_remove(&pfjob->threads, pfjob);
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    BLI_threadpool_insert(&pfjob->threads, &pfjob->workers[i]);
   }
-  BLI_threadpool_insert(&pfjob->threads, pfjob);
 
   return pfjob;
 }
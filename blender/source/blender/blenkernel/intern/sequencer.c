@@ -1891,6 +1891,92 @@ static bool seq_proxy_get_fname(
   return true;
 }
 
+/**
+ * Absolute path of the image or movie file an image or movie strip reads for \a cfra.
+ * \param r_path: Buffer of FILE_MAX size.
+ */
+bool BKE_sequencer_source_filepath_get(Sequence *seq, int cfra, char *r_path)
+{
+  StripElem *s_elem;
+
+  if (seq->type == SEQ_TYPE_IMAGE) {
+    s_elem = BKE_sequencer_give_stripelem(seq, cfra);
+  }
+  else if (seq->type == SEQ_TYPE_MOVIE) {
+    s_elem = seq->strip->stripdata;
+  }
+  else {
+    return false;
+  }
+
+  if (s_elem == NULL) {
+    return false;
+  }
+
+  BLI_join_dirfile(r_path, FILE_MAX, seq->strip->dir, s_elem->name);
+  BLI_path_abs(r_path, BKE_main_blendfile_path_from_global());
+  return true;
+}
+
+/**
+ * Absolute path of the proxy an image or movie strip reads for \a cfra.
+ * For movies without a custom proxy file this is the directory proxies and time codes
+ * are built in, they are renamed into place so the directory changes when they are rebuilt.
+ * Only strip and editing settings are used, the result doesn't depend on open movies.
+ *
+ * \param r_path: Buffer of FILE_MAX size.
+ */
+bool BKE_sequencer_proxy_filepath_get(
+    Scene *scene, Sequence *seq, int cfra, int render_size, char *r_path)
+{
+  Editing *ed = scene->ed;
+  StripProxy *proxy = seq->strip->proxy;
+
+  if (proxy == NULL || (seq->flag & SEQ_USE_PROXY) == 0) {
+    return false;
+  }
+
+  /* Same as #seq_proxy_fetch. */
+  if (render_size == 99) {
+    render_size = 100;
+  }
+
+  if (seq->type == SEQ_TYPE_IMAGE) {
+    char name[PROXY_MAXFILE];
+
+    if (BKE_sequencer_give_stripelem(seq, cfra) == NULL ||
+        !seq_proxy_get_fname(ed, seq, cfra, render_size, name, 0)) {
+      return false;
+    }
+    BLI_strncpy(r_path, name, FILE_MAX);
+    return true;
+  }
+  if (seq->type != SEQ_TYPE_MOVIE) {
+    return false;
+  }
+
+  if ((proxy->storage & SEQ_STORAGE_PROXY_CUSTOM_FILE) &&
+      ed->proxy_storage != SEQ_EDIT_PROXY_DIR_STORAGE) {
+    BLI_join_dirfile(r_path, FILE_MAX, proxy->dir, proxy->file);
+  }
+  else {
+    /* Same index directory as #seq_open_anim_file, or the default one of ImBuf. */
+    if (ed->proxy_storage == SEQ_EDIT_PROXY_DIR_STORAGE) {
+      BLI_strncpy(r_path, ed->proxy_dir[0] ? ed->proxy_dir : "//BL_proxy", FILE_MAX);
+    }
+    else if (proxy->storage & SEQ_STORAGE_PROXY_CUSTOM_DIR) {
+      BLI_strncpy(r_path, proxy->dir, FILE_MAX);
+    }
+    else {
+      BLI_join_dirfile(r_path, FILE_MAX, seq->strip->dir, "BL_proxy");
+    }
+    BLI_path_append(r_path, FILE_MAX, seq->strip->stripdata->name);
+  }
+
+  BLI_path_abs(r_path, BKE_main_blendfile_path_from_global());
+  return true;
+}
+
 static ImBuf *seq_proxy_fetch(const SeqRenderData *context, Sequence *seq, int cfra)
 {
   char name[PROXY_MAXFILE];
@@ -1929,6 +2015,10 @@ static ImBuf *seq_proxy_fetch(const SeqRenderData *context, Sequence *seq, int c
     if (proxy->anim == NULL) {
       return NULL;
     }
+    if (context->is_prefetch_render) {
+      IMB_anim_set_concurrent_decoding(proxy->anim,
+                                       BKE_sequencer_prefetch_num_render_threads(context));
+    }
 
     seq_open_anim_file(context->scene, seq, true);
     sanim = seq->anims.first;
@@ -2798,7 +2888,14 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
 
   if (ibuf->x != context->rectx || ibuf->y != context->recty) {
     if (context->for_render) {
-      IMB_scaleImBuf(ibuf, (short)context->rectx, (short)context->recty);
+      if (ibuf->x < context->rectx && ibuf->y < context->recty) {
+        /* Sharper than the default bilinear filter when scaling up. */
+        IMB_scaleImBuf_filter(
+            ibuf, (short)context->rectx, (short)context->recty, IMB_SCALE_FILTER_BICUBIC);
+      }
+      else {
+        IMB_scaleImBuf(ibuf, (short)context->rectx, (short)context->recty);
+      }
     }
     else {
       IMB_scalefastImBuf(ibuf, (short)context->rectx, (short)context->recty);
@@ -3140,6 +3237,21 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context,
   return ibuf;
 }
 
+/* Prefetch workers decode movies at the same time as the main thread and each other. */
+static void seq_anims_concurrent_decoding_set(const SeqRenderData *context, Sequence *seq)
+{
+  if (!context->is_prefetch_render) {
+    return;
+  }
+
+  const int num_decoders = BKE_sequencer_prefetch_num_render_threads(context);
+  for (StripAnim *sanim = seq->anims.first; sanim; sanim = sanim->next) {
+    if (sanim->anim) {
+      IMB_anim_set_concurrent_decoding(sanim->anim, num_decoders);
+    }
+  }
+}
+
 static ImBuf *seq_render_movie_strip(const SeqRenderData *context,
                                      Sequence *seq,
                                      float nr,
@@ -3159,6 +3271,7 @@ static ImBuf *seq_render_movie_strip(const SeqRenderData *context,
 
   /* load all the videos */
   seq_open_anim_file(context->scene, seq, false);
+  seq_anims_concurrent_decoding_set(context, seq);
 
   if (is_multiview) {
     ImBuf **ibuf_arr;
@@ -4108,7 +4221,12 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
   float cost = 0;
 
   if (count && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
+    /* Workers of concurrent prefetch only render strips which are safe to render from multiple
+     * threads, so they don't need to wait for each other. */
+    const bool use_render_lock = !BKE_sequencer_prefetch_is_concurrent_render(context);
+    if (use_render_lock) {
+      BLI_mutex_lock(&seq_render_mutex);
+    }
     out = seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
     cost = seq_estimate_render_cost_end(context->scene, begin);
 
@@ -4120,7 +4238,9 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
       BKE_sequencer_cache_put_if_possible(
           context, seq_arr[count - 1], cfra, SEQ_CACHE_STORE_FINAL_OUT, out, cost);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
+    if (use_render_lock) {
+      BLI_mutex_unlock(&seq_render_mutex);
+    }
   }
 
   BKE_sequencer_prefetch_start(context, cfra, cost);
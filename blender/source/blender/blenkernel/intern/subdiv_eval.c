@@ -80,8 +80,11 @@ static void set_coarse_positions(Subdiv *subdiv,
       BLI_BITMAP_ENABLE(vertex_used_map, loop->v);
     }
   }
-  for (int vertex_index = 0, manifold_veretx_index = 0; vertex_index < mesh->totvert;
-       vertex_index++) {
+  /* Gather coordinates of all used vertices into a single continuous array,
+   * so evaluator receives all of them with a single call. */
+  float(*positions)[3] = MEM_malloc_arrayN(mesh->totvert, sizeof(float[3]), "coarse positions");
+  int num_manifold_vertices = 0;
+  for (int vertex_index = 0; vertex_index < mesh->totvert; vertex_index++) {
     if (!BLI_BITMAP_TEST_BOOL(vertex_used_map, vertex_index)) {
       continue;
     }
@@ -93,9 +96,14 @@ static void set_coarse_positions(Subdiv *subdiv,
       const MVert *vertex = &mvert[vertex_index];
       vertex_co = vertex->co;
     }
-    subdiv->evaluator->setCoarsePositions(subdiv->evaluator, vertex_co, manifold_veretx_index, 1);
-    manifold_veretx_index++;
+    copy_v3_v3(positions[num_manifold_vertices], vertex_co);
+    num_manifold_vertices++;
   }
+  if (num_manifold_vertices != 0) {
+    subdiv->evaluator->setCoarsePositions(
+        subdiv->evaluator, &positions[0][0], 0, num_manifold_vertices);
+  }
+  MEM_freeN(positions);
   MEM_freeN(vertex_used_map);
 }
 
@@ -244,6 +252,35 @@ void BKE_subdiv_eval_final_point(
   }
 }
 
+/* ========================= Multiple points queries ======================== */
+
+void BKE_subdiv_eval_limit_points(Subdiv *subdiv,
+                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                  const int num_points,
+                                  float (*r_P)[3])
+{
+  BKE_subdiv_eval_limit_points_and_derivatives(
+      subdiv, patch_coords, num_points, r_P, NULL, NULL);
+}
+
+void BKE_subdiv_eval_limit_points_and_derivatives(Subdiv *subdiv,
+                                                  const OpenSubdiv_PatchCoord *patch_coords,
+                                                  const int num_points,
+                                                  float (*r_P)[3],
+                                                  float (*r_dPdu)[3],
+                                                  float (*r_dPdv)[3])
+{
+  if (num_points == 0) {
+    return;
+  }
+  subdiv->evaluator->evaluatePatchesLimit(subdiv->evaluator,
+                                          patch_coords,
+                                          num_points,
+                                          &r_P[0][0],
+                                          r_dPdu != NULL ? &r_dPdu[0][0] : NULL,
+                                          r_dPdv != NULL ? &r_dPdv[0][0] : NULL);
+}
+
 /* ===================  Patch queries at given resolution =================== */
 
 /* Move buffer forward by a given number of bytes. */
@@ -264,6 +301,42 @@ static void buffer_write_short_value(void **buffer, const short *values_buffer,
   memcpy(*buffer, values_buffer, sizeof(short) * num_values);
 }
 
+/* Allocate and fill in coordinates of all the points of a patch evaluated at
+ * the given resolution. */
+static OpenSubdiv_PatchCoord *patch_resolution_coords_new(const int ptex_face_index,
+                                                          const int resolution)
+{
+  OpenSubdiv_PatchCoord *patch_coords = MEM_malloc_arrayN(
+      resolution * resolution, sizeof(OpenSubdiv_PatchCoord), "patch coords");
+  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
+  OpenSubdiv_PatchCoord *patch_coord = patch_coords;
+  for (int y = 0; y < resolution; y++) {
+    const float v = y * inv_resolution_1;
+    for (int x = 0; x < resolution; x++, patch_coord++) {
+      const float u = x * inv_resolution_1;
+      patch_coord->ptex_face = ptex_face_index;
+      patch_coord->u = u;
+      patch_coord->v = v;
+    }
+  }
+  return patch_coords;
+}
+
+/* Evaluate all points of a patch at the given resolution with a single call to
+ * the evaluator. Derivatives are optional. */
+static void patch_resolution_evaluate(Subdiv *subdiv,
+                                      const int ptex_face_index,
+                                      const int resolution,
+                                      float (*r_P)[3],
+                                      float (*r_dPdu)[3],
+                                      float (*r_dPdv)[3])
+{
+  OpenSubdiv_PatchCoord *patch_coords = patch_resolution_coords_new(ptex_face_index, resolution);
+  BKE_subdiv_eval_limit_points_and_derivatives(
+      subdiv, patch_coords, resolution * resolution, r_P, r_dPdu, r_dPdv);
+  MEM_freeN(patch_coords);
+}
+
 void BKE_subdiv_eval_limit_patch_resolution_point(Subdiv *subdiv,
                                                   const int ptex_face_index,
                                                   const int resolution,
@@ -271,16 +344,15 @@ void BKE_subdiv_eval_limit_patch_resolution_point(Subdiv *subdiv,
                                                   const int offset,
                                                   const int stride)
 {
+  const int num_points = resolution * resolution;
+  float(*P)[3] = MEM_malloc_arrayN(num_points, sizeof(float[3]), "patch points");
+  patch_resolution_evaluate(subdiv, ptex_face_index, resolution, P, NULL, NULL);
   buffer_apply_offset(&buffer, offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      BKE_subdiv_eval_limit_point(subdiv, ptex_face_index, u, v, buffer);
-      buffer_apply_offset(&buffer, stride);
-    }
+  for (int i = 0; i < num_points; i++) {
+    buffer_write_float_value(&buffer, P[i], 3);
+    buffer_apply_offset(&buffer, stride);
   }
+  MEM_freeN(P);
 }
 
 void BKE_subdiv_eval_limit_patch_resolution_point_and_derivatives(Subdiv *subdiv,
@@ -296,21 +368,23 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_derivatives(Subdiv *subdiv
                                                                   const int dv_offset,
                                                                   const int dv_stride)
 {
+  const int num_points = resolution * resolution;
+  float(*P)[3] = MEM_malloc_arrayN(num_points, sizeof(float[3]) * 3, "patch points");
+  float(*dPdu)[3] = P + num_points;
+  float(*dPdv)[3] = dPdu + num_points;
+  patch_resolution_evaluate(subdiv, ptex_face_index, resolution, P, dPdu, dPdv);
   buffer_apply_offset(&point_buffer, point_offset);
   buffer_apply_offset(&du_buffer, du_offset);
   buffer_apply_offset(&dv_buffer, dv_offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      BKE_subdiv_eval_limit_point_and_derivatives(
-          subdiv, ptex_face_index, u, v, point_buffer, du_buffer, dv_buffer);
-      buffer_apply_offset(&point_buffer, point_stride);
-      buffer_apply_offset(&du_buffer, du_stride);
-      buffer_apply_offset(&dv_buffer, dv_stride);
-    }
+  for (int i = 0; i < num_points; i++) {
+    buffer_write_float_value(&point_buffer, P[i], 3);
+    buffer_write_float_value(&du_buffer, dPdu[i], 3);
+    buffer_write_float_value(&dv_buffer, dPdv[i], 3);
+    buffer_apply_offset(&point_buffer, point_stride);
+    buffer_apply_offset(&du_buffer, du_stride);
+    buffer_apply_offset(&dv_buffer, dv_stride);
   }
+  MEM_freeN(P);
 }
 
 void BKE_subdiv_eval_limit_patch_resolution_point_and_normal(Subdiv *subdiv,
@@ -323,20 +397,23 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_normal(Subdiv *subdiv,
                                                              const int normal_offset,
                                                              const int normal_stride)
 {
+  const int num_points = resolution * resolution;
+  float(*P)[3] = MEM_malloc_arrayN(num_points, sizeof(float[3]) * 3, "patch points");
+  float(*dPdu)[3] = P + num_points;
+  float(*dPdv)[3] = dPdu + num_points;
+  patch_resolution_evaluate(subdiv, ptex_face_index, resolution, P, dPdu, dPdv);
   buffer_apply_offset(&point_buffer, point_offset);
   buffer_apply_offset(&normal_buffer, normal_offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      float normal[3];
-      BKE_subdiv_eval_limit_point_and_normal(subdiv, ptex_face_index, u, v, point_buffer, normal);
-      buffer_write_float_value(&normal_buffer, normal, 3);
-      buffer_apply_offset(&point_buffer, point_stride);
-      buffer_apply_offset(&normal_buffer, normal_stride);
-    }
+  for (int i = 0; i < num_points; i++) {
+    float normal[3];
+    cross_v3_v3v3(normal, dPdu[i], dPdv[i]);
+    normalize_v3(normal);
+    buffer_write_float_value(&point_buffer, P[i], 3);
+    buffer_write_float_value(&normal_buffer, normal, 3);
+    buffer_apply_offset(&point_buffer, point_stride);
+    buffer_apply_offset(&normal_buffer, normal_stride);
   }
+  MEM_freeN(P);
 }
 
 void BKE_subdiv_eval_limit_patch_resolution_point_and_short_normal(Subdiv *subdiv,
@@ -349,19 +426,23 @@ void BKE_subdiv_eval_limit_patch_resolution_point_and_short_normal(Subdiv *subdi
                                                                    const int normal_offset,
                                                                    const int normal_stride)
 {
+  const int num_points = resolution * resolution;
+  float(*P)[3] = MEM_malloc_arrayN(num_points, sizeof(float[3]) * 3, "patch points");
+  float(*dPdu)[3] = P + num_points;
+  float(*dPdv)[3] = dPdu + num_points;
+  patch_resolution_evaluate(subdiv, ptex_face_index, resolution, P, dPdu, dPdv);
   buffer_apply_offset(&point_buffer, point_offset);
   buffer_apply_offset(&normal_buffer, normal_offset);
-  const float inv_resolution_1 = 1.0f / (float)(resolution - 1);
-  for (int y = 0; y < resolution; y++) {
-    const float v = y * inv_resolution_1;
-    for (int x = 0; x < resolution; x++) {
-      const float u = x * inv_resolution_1;
-      short normal[3];
-      BKE_subdiv_eval_limit_point_and_short_normal(
-          subdiv, ptex_face_index, u, v, point_buffer, normal);
-      buffer_write_short_value(&normal_buffer, normal, 3);
-      buffer_apply_offset(&point_buffer, point_stride);
-      buffer_apply_offset(&normal_buffer, normal_stride);
-    }
+  for (int i = 0; i < num_points; i++) {
+    float normal[3];
+    short short_normal[3];
+    cross_v3_v3v3(normal, dPdu[i], dPdv[i]);
+    normalize_v3(normal);
+    normal_float_to_short_v3(short_normal, normal);
+    buffer_write_float_value(&point_buffer, P[i], 3);
+    buffer_write_short_value(&normal_buffer, short_normal, 3);
+    buffer_apply_offset(&point_buffer, point_stride);
+    buffer_apply_offset(&normal_buffer, normal_stride);
   }
+  MEM_freeN(P);
 }
@@ -41,6 +41,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "opensubdiv_evaluator_capi.h"
+
 /* =============================================================================
  * Subdivision context.
  */
@@ -427,6 +429,18 @@ typedef struct SubdivMeshTLS {
   LoopsForInterpolation loop_interpolation;
   const MPoly *loop_interpolation_coarse_poly;
   int loop_interpolation_coarse_corner;
+
+  /* Limit surface at all inner vertices of a single ptex face, evaluated with
+   * a single call to the evaluator. */
+  bool inner_grid_initialized;
+  int inner_grid_ptex_face_index;
+  int inner_grid_ptex_resolution;
+  int inner_grid_num_u, inner_grid_num_v;
+  int inner_grid_num_points_allocated;
+  OpenSubdiv_PatchCoord *inner_grid_patch_coords;
+  float (*inner_grid_P)[3];
+  float (*inner_grid_dPdu)[3];
+  float (*inner_grid_dPdv)[3];
 } SubdivMeshTLS;
 
 static void subdiv_mesh_tls_free(void *tls_v)
@@ -438,6 +452,8 @@ static void subdiv_mesh_tls_free(void *tls_v)
   if (tls->loop_interpolation_initialized) {
     loop_interpolation_end(&tls->loop_interpolation);
   }
+  MEM_SAFE_FREE(tls->inner_grid_patch_coords);
+  MEM_SAFE_FREE(tls->inner_grid_P);
 }
 
 /* =============================================================================
@@ -753,6 +769,111 @@ static void subdiv_mesh_tag_center_vertex(const MPoly *coarse_poly,
   }
 }
 
+/* Make sure limit surface is evaluated for all inner vertices of the given ptex
+ * face. Points match the traversal of inner vertices done by the foreach
+ * routines: for quads those are points of the ptex grid except of its
+ * boundary, for n-gons the u = 1 column is inner as well (it is shared with
+ * the adjacent corner). */
+static void subdiv_mesh_ensure_inner_grid(SubdivMeshContext *ctx,
+                                          SubdivMeshTLS *tls,
+                                          const MPoly *coarse_poly,
+                                          const int ptex_face_index)
+{
+  if (tls->inner_grid_initialized && tls->inner_grid_ptex_face_index == ptex_face_index) {
+    return;
+  }
+  const int resolution = ctx->settings->resolution;
+  const bool is_quad = (coarse_poly->totloop == 4);
+  const int ptex_resolution = is_quad ? resolution : (resolution >> 1) + 1;
+  const int num_u = max_ii(is_quad ? ptex_resolution - 2 : ptex_resolution - 1, 0);
+  const int num_v = max_ii(ptex_resolution - 2, 0);
+  const int num_points = num_u * num_v;
+  if (num_points > tls->inner_grid_num_points_allocated) {
+    MEM_SAFE_FREE(tls->inner_grid_patch_coords);
+    MEM_SAFE_FREE(tls->inner_grid_P);
+    tls->inner_grid_patch_coords = MEM_malloc_arrayN(
+        num_points, sizeof(OpenSubdiv_PatchCoord), "inner grid patch coords");
+    /* Positions and derivatives share single allocation. */
+    tls->inner_grid_P = MEM_malloc_arrayN(num_points, sizeof(float[3]) * 3, "inner grid");
+    tls->inner_grid_num_points_allocated = num_points;
+  }
+  tls->inner_grid_dPdu = tls->inner_grid_P + num_points;
+  tls->inner_grid_dPdv = tls->inner_grid_dPdu + num_points;
+  /* NOTE: Coordinates are to be calculated exactly as in the foreach
+   * routines, so lookup can compare them bit-wise. */
+  const float inv_ptex_resolution_1 = 1.0f / (float)(ptex_resolution - 1);
+  OpenSubdiv_PatchCoord *patch_coord = tls->inner_grid_patch_coords;
+  for (int y = 1; y <= num_v; y++) {
+    const float v = y * inv_ptex_resolution_1;
+    for (int x = 1; x <= num_u; x++, patch_coord++) {
+      const float u = x * inv_ptex_resolution_1;
+      patch_coord->ptex_face = ptex_face_index;
+      patch_coord->u = u;
+      patch_coord->v = v;
+    }
+  }
+  BKE_subdiv_eval_limit_points_and_derivatives(ctx->subdiv,
+                                               tls->inner_grid_patch_coords,
+                                               num_points,
+                                               tls->inner_grid_P,
+                                               tls->inner_grid_dPdu,
+                                               tls->inner_grid_dPdv);
+  tls->inner_grid_initialized = true;
+  tls->inner_grid_ptex_face_index = ptex_face_index;
+  tls->inner_grid_ptex_resolution = ptex_resolution;
+  tls->inner_grid_num_u = num_u;
+  tls->inner_grid_num_v = num_v;
+}
+
+/* Find point of the evaluated inner grid which corresponds to the given
+ * coordinate. Returns false if the point is not a part of the grid. */
+static bool subdiv_mesh_inner_grid_lookup(const SubdivMeshTLS *tls,
+                                          const float u,
+                                          const float v,
+                                          int *r_grid_index)
+{
+  const float ptex_resolution_1 = (float)(tls->inner_grid_ptex_resolution - 1);
+  const int x = (int)(u * ptex_resolution_1 + 0.5f);
+  const int y = (int)(v * ptex_resolution_1 + 0.5f);
+  if (x < 1 || x > tls->inner_grid_num_u || y < 1 || y > tls->inner_grid_num_v) {
+    return false;
+  }
+  const int grid_index = (y - 1) * tls->inner_grid_num_u + (x - 1);
+  const OpenSubdiv_PatchCoord *patch_coord = &tls->inner_grid_patch_coords[grid_index];
+  if (patch_coord->u != u || patch_coord->v != v) {
+    return false;
+  }
+  *r_grid_index = grid_index;
+  return true;
+}
+
+/* Same as eval_final_point_and_vertex_normal(), but uses limit surface from
+ * the evaluated inner grid. */
+static void inner_grid_final_point_and_vertex_normal(SubdivMeshTLS *tls,
+                                                     Subdiv *subdiv,
+                                                     const int grid_index,
+                                                     const int ptex_face_index,
+                                                     const float u,
+                                                     const float v,
+                                                     float r_P[3],
+                                                     short r_N[3])
+{
+  const float *dPdu = tls->inner_grid_dPdu[grid_index];
+  const float *dPdv = tls->inner_grid_dPdv[grid_index];
+  copy_v3_v3(r_P, tls->inner_grid_P[grid_index]);
+  if (subdiv->displacement_evaluator == NULL) {
+    float N[3];
+    cross_v3_v3v3(N, dPdu, dPdv);
+    normalize_v3(N);
+    normal_float_to_short_v3(r_N, N);
+  }
+  else {
+    float D[3];
+    BKE_subdiv_eval_displacement(subdiv, ptex_face_index, u, v, dPdu, dPdv, D);
+    add_v3_v3(r_P, D);
+  }
+}
+
 static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context,
                                      void *tls_v,
                                      const int ptex_face_index,
@@ -773,8 +894,17 @@ static void subdiv_mesh_vertex_inner(const SubdivForeachContext *foreach_context
   MVert *subdiv_vert = &subdiv_mvert[subdiv_vertex_index];
   subdiv_mesh_ensure_vertex_interpolation(ctx, tls, coarse_poly, coarse_corner);
   subdiv_vertex_data_interpolate(ctx, subdiv_vert, &tls->vertex_interpolation, u, v);
-  eval_final_point_and_vertex_normal(
-      subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
+  subdiv_mesh_ensure_inner_grid(ctx, tls, coarse_poly, ptex_face_index);
+  int grid_index;
+  if (subdiv_mesh_inner_grid_lookup(tls, u, v, &grid_index)) {
+    inner_grid_final_point_and_vertex_normal(
+        tls, subdiv, grid_index, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
+  }
+  else {
+    /* Center vertex of n-gon. */
+    eval_final_point_and_vertex_normal(
+        subdiv, ptex_face_index, u, v, subdiv_vert->co, subdiv_vert->no);
+  }
   subdiv_mesh_tag_center_vertex(coarse_poly, subdiv_vert, u, v);
 }
 
@@ -31,9 +31,11 @@ extern "C" {
 #endif
 
 struct BVHTree;
+struct BVHTreeFlat;
 struct DistProjectedAABBPrecalc;
 
 typedef struct BVHTree BVHTree;
+typedef struct BVHTreeFlat BVHTreeFlat;
 #define USE_KDOPBVH_WATERTIGHT
 
 typedef struct BVHTreeAxisRange {
@@ -106,6 +108,9 @@ enum {
 #define BVH_RAYCAST_DEFAULT (BVH_RAYCAST_WATERTIGHT)
 #define BVH_RAYCAST_DIST_MAX (FLT_MAX / 2.0f)
 
+/** Maximum number of rays that can be traced together as a single packet. */
+#define BVH_RAYCAST_PACKET_MAX 16
+
 /* callback must update nearest in case it finds a nearest result */
 typedef void (*BVHTree_NearestPointCallback)(void *userdata,
                                              int index,
@@ -231,6 +236,42 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
                               BVHTree_RayCastCallback callback,
                               void *userdata);
 
+/* ray packets: trace up to #BVH_RAYCAST_PACKET_MAX coherent rays in a single traversal,
+ * \a hits must be initialized the same way as for #BLI_bvhtree_ray_cast (one per ray) */
+int BLI_bvhtree_ray_cast_packet_ex(BVHTree *tree,
+                                   const float (*co)[3],
+                                   const float (*dir)[3],
+                                   int rays_len,
+                                   float radius,
+                                   BVHTreeRayHit *hits,
+                                   BVHTree_RayCastCallback callback,
+                                   void *userdata,
+                                   int flag);
+int BLI_bvhtree_ray_cast_packet(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                int rays_len,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata);
+
+/* flat layout: a read-only copy of a balanced tree using wide nodes,
+ * call #BLI_bvhtree_flat_update after #BLI_bvhtree_update_tree to refit it */
+BVHTreeFlat *BLI_bvhtree_flat_new(const BVHTree *tree);
+void BLI_bvhtree_flat_update(BVHTreeFlat *flat);
+void BLI_bvhtree_flat_free(BVHTreeFlat *flat);
+
+int BLI_bvhtree_flat_ray_cast_packet_ex(const BVHTreeFlat *flat,
+                                        const float (*co)[3],
+                                        const float (*dir)[3],
+                                        int rays_len,
+                                        float radius,
+                                        BVHTreeRayHit *hits,
+                                        BVHTree_RayCastCallback callback,
+                                        void *userdata,
+                                        int flag);
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
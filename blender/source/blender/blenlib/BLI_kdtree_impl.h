@@ -66,6 +66,24 @@ void BLI_kdtree_nd_(range_search_cb)(
     bool (*search_cb)(void *user_data, int index, const float co[KD_DIMS], float dist_sq),
     void *user_data);
 
+/* Batched queries, threaded for large batches. */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest) ATTR_NONNULL(1, 2, 4);
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          const uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          const uint nearest_len_capacity,
+                                          int *r_nearest_len) ATTR_NONNULL(1, 2, 4, 6);
+int BLI_kdtree_nd_(range_search_batch)(const KDTree *tree,
+                                       const float (*co)[KD_DIMS],
+                                       const uint co_len,
+                                       const float range,
+                                       KDTreeNearest **r_nearest,
+                                       uint *r_nearest_offset) ATTR_NONNULL(1, 2, 5, 6);
+
 int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
                                          const float range,
                                          bool use_index_order,
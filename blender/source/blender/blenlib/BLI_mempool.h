@@ -58,6 +58,18 @@ void *BLI_mempool_as_arrayN(BLI_mempool *pool,
                             const char *allocstr) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
     ATTR_NONNULL(1, 2);
 
+/* threaded allocation */
+void BLI_mempool_threads_begin(BLI_mempool *pool,
+                               const unsigned int threads_len,
+                               const unsigned int totelem_reserve) ATTR_NONNULL(1);
+void BLI_mempool_threads_end(BLI_mempool *pool) ATTR_NONNULL(1);
+void *BLI_mempool_alloc_thread(BLI_mempool *pool, const unsigned int thread_index) ATTR_MALLOC
+    ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void *BLI_mempool_calloc_thread(BLI_mempool *pool, const unsigned int thread_index) ATTR_MALLOC
+    ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void BLI_mempool_free_thread(BLI_mempool *pool, const unsigned int thread_index, void *addr)
+    ATTR_NONNULL(1, 3);
+
 #ifndef NDEBUG
 void BLI_mempool_set_memory_debug(void);
 #endif
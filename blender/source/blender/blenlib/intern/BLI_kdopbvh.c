@@ -36,10 +36,16 @@
  *   #BLI_bvhtree_overlap, #BVHOverlapData_Shared, #BVHOverlapData_Thread
  * - Range Query:
  *   #BLI_bvhtree_range_query
+ * - Ray-cast packets (many coherent rays at once):
+ *   #BLI_bvhtree_ray_cast_packet, #BLI_bvhtree_flat_ray_cast_packet_ex
  */
 
 #include <assert.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
@@ -47,6 +53,7 @@
 #include "BLI_stack.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_math.h"
+#include "BLI_math_bits.h"
 #include "BLI_task.h"
 #include "BLI_heap_simple.h"
 
@@ -1973,6 +1980,690 @@ void BLI_bvhtree_ray_cast_all(BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_ray_cast_packet
+ *
+ * Traces a packet of coherent rays with a single traversal, sharing one node stack.
+ * Each stack entry stores the mask of rays that are still interested in the node,
+ * bounds are tested against all rays of the mask at once (4 rays per SIMD register).
+ *
+ * Only the first 3 k-DOP axes (the axis aligned bounds) are used for culling,
+ * the same as #fast_ray_nearest_hit.
+ *
+ * \{ */
+
+#define BVH_RAYCAST_PACKET_LANES 4
+
+typedef unsigned int raymask_t;
+
+typedef struct BVHRayPacketData {
+  const BVHTree *tree;
+
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+
+  int rays_len;
+  float radius;
+
+  /* Ray data in SOA layout, padded to a multiple of #BVH_RAYCAST_PACKET_LANES,
+   * padding rays have a negative distance so they never hit anything. */
+  float origin[3][BVH_RAYCAST_PACKET_MAX];
+  float idot_axis[3][BVH_RAYCAST_PACKET_MAX];
+  float dist[BVH_RAYCAST_PACKET_MAX];
+
+  /* Sum of all ray directions, used to pick the traversal order. */
+  float direction_sum[3];
+
+  BVHTreeRay ray[BVH_RAYCAST_PACKET_MAX];
+#ifdef USE_KDOPBVH_WATERTIGHT
+  struct IsectRayPrecalc isect_precalc[BVH_RAYCAST_PACKET_MAX];
+#endif
+
+  BVHTreeRayHit *hits;
+} BVHRayPacketData;
+
+static void bvhtree_ray_packet_data_init(BVHRayPacketData *data,
+                                         const BVHTree *tree,
+                                         const float (*co)[3],
+                                         const float (*dir)[3],
+                                         int rays_len,
+                                         float radius,
+                                         BVHTreeRayHit *hits,
+                                         BVHTree_RayCastCallback callback,
+                                         void *userdata,
+                                         int flag)
+{
+  BLI_assert(rays_len > 0 && rays_len <= BVH_RAYCAST_PACKET_MAX);
+  /* The packet tests only use the axis aligned bounds. */
+  BLI_assert(tree->start_axis == 0 && tree->stop_axis >= 3);
+
+  data->tree = tree;
+  data->callback = callback;
+  data->userdata = userdata;
+  data->rays_len = rays_len;
+  data->radius = radius;
+  data->hits = hits;
+  zero_v3(data->direction_sum);
+
+  for (int i = 0; i < BVH_RAYCAST_PACKET_MAX; i++) {
+    if (i >= rays_len) {
+      for (int axis = 0; axis < 3; axis++) {
+        data->origin[axis][i] = 0.0f;
+        data->idot_axis[axis][i] = 1.0f;
+      }
+      data->dist[i] = -1.0f;
+      continue;
+    }
+
+    BVHTreeRay *ray = &data->ray[i];
+
+    BLI_ASSERT_UNIT_V3(dir[i]);
+
+    copy_v3_v3(ray->origin, co[i]);
+    copy_v3_v3(ray->direction, dir[i]);
+    ray->radius = radius;
+    add_v3_v3(data->direction_sum, dir[i]);
+
+    for (int axis = 0; axis < 3; axis++) {
+      float dot = dir[i][axis];
+      /* Avoid infinite inverses so the slab test never multiplies zero by infinity. */
+      if (fabsf(dot) < FLT_EPSILON) {
+        dot = (dot < 0.0f) ? -1e-30f : 1e-30f;
+      }
+      data->origin[axis][i] = co[i][axis];
+      data->idot_axis[axis][i] = 1.0f / dot;
+    }
+    data->dist[i] = hits[i].dist;
+
+#ifdef USE_KDOPBVH_WATERTIGHT
+    if (flag & BVH_RAYCAST_WATERTIGHT) {
+      isect_ray_tri_watertight_v3_precalc(&data->isect_precalc[i], ray->direction);
+      ray->isect_precalc = &data->isect_precalc[i];
+    }
+    else {
+      ray->isect_precalc = NULL;
+    }
+#endif
+  }
+
+#ifndef USE_KDOPBVH_WATERTIGHT
+  UNUSED_VARS(flag);
+#endif
+}
+
+/**
+ * Slab test of the axis aligned \a bv against every ray in \a mask.
+ *
+ * \return the mask of rays entering the bounds before their current hit distance,
+ * entry distances are written into \a r_dist for those rays.
+ */
+static raymask_t bvhtree_ray_packet_test(const BVHRayPacketData *data,
+                                         const float bv[6],
+                                         raymask_t mask,
+                                         float r_dist[BVH_RAYCAST_PACKET_MAX])
+{
+  raymask_t result = 0;
+
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps();
+  __m128 bmin[3], bmax[3];
+  for (int axis = 0; axis < 3; axis++) {
+    bmin[axis] = _mm_set1_ps(bv[2 * axis] - data->radius);
+    bmax[axis] = _mm_set1_ps(bv[2 * axis + 1] + data->radius);
+  }
+
+  for (int i = 0; i < data->rays_len; i += BVH_RAYCAST_PACKET_LANES) {
+    if (((mask >> i) & 0xf) == 0) {
+      continue;
+    }
+    const __m128 dist = _mm_loadu_ps(&data->dist[i]);
+    __m128 t_near = zero;
+    __m128 t_far = dist;
+    for (int axis = 0; axis < 3; axis++) {
+      const __m128 origin = _mm_loadu_ps(&data->origin[axis][i]);
+      const __m128 idot = _mm_loadu_ps(&data->idot_axis[axis][i]);
+      const __m128 t1 = _mm_mul_ps(_mm_sub_ps(bmin[axis], origin), idot);
+      const __m128 t2 = _mm_mul_ps(_mm_sub_ps(bmax[axis], origin), idot);
+      t_near = _mm_max_ps(t_near, _mm_min_ps(t1, t2));
+      t_far = _mm_min_ps(t_far, _mm_max_ps(t1, t2));
+    }
+    const __m128 hit = _mm_and_ps(_mm_cmple_ps(t_near, t_far), _mm_cmplt_ps(t_near, dist));
+    _mm_storeu_ps(&r_dist[i], t_near);
+    result |= (raymask_t)_mm_movemask_ps(hit) << i;
+  }
+#else
+  for (int i = 0; i < data->rays_len; i++) {
+    if ((mask & (1u << i)) == 0) {
+      continue;
+    }
+    float t_near = 0.0f;
+    float t_far = data->dist[i];
+    for (int axis = 0; axis < 3; axis++) {
+      const float t1 = (bv[2 * axis] - data->radius - data->origin[axis][i]) *
+                       data->idot_axis[axis][i];
+      const float t2 = (bv[2 * axis + 1] + data->radius - data->origin[axis][i]) *
+                       data->idot_axis[axis][i];
+      t_near = max_ff(t_near, min_ff(t1, t2));
+      t_far = min_ff(t_far, max_ff(t1, t2));
+    }
+    if (t_near <= t_far && t_near < data->dist[i]) {
+      r_dist[i] = t_near;
+      result |= (1u << i);
+    }
+  }
+#endif
+
+  return result & mask;
+}
+
+/**
+ * Report a leaf to every ray in \a mask, the equivalent of the leaf case in #dfs_raycast.
+ */
+static void bvhtree_ray_packet_leaf(BVHRayPacketData *data,
+                                    int index,
+                                    raymask_t mask,
+                                    const float dist[BVH_RAYCAST_PACKET_MAX])
+{
+  while (mask) {
+    const uint i = bitscan_forward_clear_uint(&mask);
+    BVHTreeRayHit *hit = &data->hits[i];
+
+    /* Another leaf of this packet may have moved the hit closer in the meantime. */
+    if (dist[i] >= data->dist[i]) {
+      continue;
+    }
+
+    if (data->callback) {
+      data->callback(data->userdata, index, &data->ray[i], hit);
+    }
+    else {
+      hit->index = index;
+      hit->dist = dist[i];
+      madd_v3_v3v3fl(hit->co, data->ray[i].origin, data->ray[i].direction, dist[i]);
+    }
+    data->dist[i] = hit->dist;
+  }
+}
+
+static int bvhtree_ray_packet_hits_count(const BVHRayPacketData *data)
+{
+  int hits_len = 0;
+  for (int i = 0; i < data->rays_len; i++) {
+    if (data->hits[i].index != -1) {
+      hits_len++;
+    }
+  }
+  return hits_len;
+}
+
+typedef struct BVHRayPacketStackItem {
+  const BVHNode *node;
+  raymask_t mask;
+} BVHRayPacketStackItem;
+
+static int bvhtree_depth(const BVHTree *tree)
+{
+  int depth = 0;
+  for (const BVHNode *node = tree->nodes[tree->totleaf]; node->totnode != 0;
+       node = node->children[0]) {
+    depth++;
+  }
+  return depth;
+}
+
+static void bvhtree_ray_packet_traverse(BVHRayPacketData *data, const BVHNode *root)
+{
+  const BVHTree *tree = data->tree;
+  /* All children but the one traversed next are pushed for every level of the tree. */
+  const int stack_len = (bvhtree_depth(tree) + 1) * tree->tree_type + 1;
+  BVHRayPacketStackItem *stack = BLI_array_alloca(stack, (size_t)stack_len);
+  int stack_index = 0;
+  float dist[BVH_RAYCAST_PACKET_MAX];
+
+  stack[stack_index].node = root;
+  stack[stack_index].mask = (1u << data->rays_len) - 1;
+  stack_index++;
+
+  while (stack_index != 0) {
+    stack_index--;
+    const BVHNode *node = stack[stack_index].node;
+    const raymask_t mask = bvhtree_ray_packet_test(data, node->bv, stack[stack_index].mask, dist);
+    if (mask == 0) {
+      continue;
+    }
+
+    if (node->totnode == 0) {
+      bvhtree_ray_packet_leaf(data, node->index, mask, dist);
+    }
+    else {
+      BLI_assert(stack_index + node->totnode <= stack_len);
+      /* Push in reverse traversal order (based on ray direction and split axis). */
+      if (dot_v3v3(data->direction_sum, bvhtree_kdop_axes[node->main_axis]) > 0.0f) {
+        for (int i = node->totnode - 1; i >= 0; i--) {
+          stack[stack_index].node = node->children[i];
+          stack[stack_index].mask = mask;
+          stack_index++;
+        }
+      }
+      else {
+        for (int i = 0; i != node->totnode; i++) {
+          stack[stack_index].node = node->children[i];
+          stack[stack_index].mask = mask;
+          stack_index++;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Ray-cast \a rays_len rays (up to #BVH_RAYCAST_PACKET_MAX) through the tree at once.
+ *
+ * Results match calling #BLI_bvhtree_ray_cast_ex for each ray,
+ * this is faster when the rays are coherent (similar origins and directions).
+ *
+ * \param hits: One hit per ray, initialized by the caller (index & distance).
+ * \return the number of rays that hit something.
+ */
+int BLI_bvhtree_ray_cast_packet_ex(BVHTree *tree,
+                                   const float (*co)[3],
+                                   const float (*dir)[3],
+                                   int rays_len,
+                                   float radius,
+                                   BVHTreeRayHit *hits,
+                                   BVHTree_RayCastCallback callback,
+                                   void *userdata,
+                                   int flag)
+{
+  BVHRayPacketData data;
+  BVHNode *root = tree->nodes[tree->totleaf];
+
+  bvhtree_ray_packet_data_init(
+      &data, tree, co, dir, rays_len, radius, hits, callback, userdata, flag);
+
+  if (root) {
+    bvhtree_ray_packet_traverse(&data, root);
+  }
+
+  return bvhtree_ray_packet_hits_count(&data);
+}
+
+int BLI_bvhtree_ray_cast_packet(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                int rays_len,
+                                float radius,
+                                BVHTreeRayHit *hits,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata)
+{
+  return BLI_bvhtree_ray_cast_packet_ex(
+      tree, co, dir, rays_len, radius, hits, callback, userdata, BVH_RAYCAST_DEFAULT);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_flat
+ *
+ * A flattened copy of a balanced tree, stored as an array of wide nodes in depth first order.
+ * Each wide node stores the axis aligned bounds of up to #BVH_FLAT_WIDTH children
+ * next to each other, so a single ray is tested against all children at once.
+ *
+ * Binary and quad trees are collapsed into wide nodes,
+ * wider trees are split into extra levels.
+ *
+ * \{ */
+
+#define BVH_FLAT_WIDTH 4
+
+typedef struct BVHFlatNode {
+  /* Bounds of the children in SOA layout: (min, max) for the X, Y & Z axes. */
+  float bv[6][BVH_FLAT_WIDTH];
+  /* Index into #BVHTreeFlat.nodes, or into #BVHTree.nodearray for leaves. */
+  int child[BVH_FLAT_WIDTH];
+  uchar child_len;
+  uchar leaf_mask;
+} BVHFlatNode;
+
+struct BVHTreeFlat {
+  const BVHTree *tree;
+  BVHFlatNode *nodes;
+  int nodes_len, nodes_alloc;
+  /* Number of nodes on the longest path from the root, sizes the traversal stack. */
+  int depth;
+};
+
+static void bvh_flat_bv_init(BVHFlatNode *fnode, int slot)
+{
+  for (int axis = 0; axis < 3; axis++) {
+    fnode->bv[2 * axis][slot] = FLT_MAX;
+    fnode->bv[2 * axis + 1][slot] = -FLT_MAX;
+  }
+}
+
+static void bvh_flat_bv_expand(BVHFlatNode *fnode, int slot, const float bv[6])
+{
+  for (int axis = 0; axis < 3; axis++) {
+    fnode->bv[2 * axis][slot] = min_ff(fnode->bv[2 * axis][slot], bv[2 * axis]);
+    fnode->bv[2 * axis + 1][slot] = max_ff(fnode->bv[2 * axis + 1][slot], bv[2 * axis + 1]);
+  }
+}
+
+static void bvh_flat_bv_expand_node(BVHFlatNode *fnode, int slot, const BVHFlatNode *fchild)
+{
+  for (int i = 0; i < fchild->child_len; i++) {
+    const float bv[6] = {
+        fchild->bv[0][i],
+        fchild->bv[1][i],
+        fchild->bv[2][i],
+        fchild->bv[3][i],
+        fchild->bv[4][i],
+        fchild->bv[5][i],
+    };
+    bvh_flat_bv_expand(fnode, slot, bv);
+  }
+}
+
+static float bvh_flat_bv_area(const float bv[6])
+{
+  const float x = bv[1] - bv[0], y = bv[3] - bv[2], z = bv[5] - bv[4];
+  return x * y + y * z + z * x;
+}
+
+/**
+ * Create a wide node holding \a items_src, returns its index.
+ * Branches are opened (largest first) while their children still fit in the node,
+ * when there are more items than fit, they are distributed over extra wide nodes.
+ */
+static int bvh_flat_build(BVHTreeFlat *flat, const BVHNode **items_src, int items_len, int depth)
+{
+  const BVHTree *tree = flat->tree;
+  const BVHNode *items[MAX_TREETYPE + BVH_FLAT_WIDTH];
+
+  BLI_assert(items_len > 0 && items_len <= MAX_TREETYPE);
+  memcpy(items, items_src, sizeof(*items) * (size_t)items_len);
+
+  while (items_len < BVH_FLAT_WIDTH) {
+    int best = -1;
+    float best_area = -1.0f;
+    for (int i = 0; i < items_len; i++) {
+      /* A single branch is always opened, even when its children have to be split up. */
+      if (items[i]->totnode != 0 &&
+          (items_len == 1 || items_len - 1 + items[i]->totnode <= BVH_FLAT_WIDTH)) {
+        const float area = bvh_flat_bv_area(items[i]->bv);
+        if (area > best_area) {
+          best = i;
+          best_area = area;
+        }
+      }
+    }
+    if (best == -1) {
+      break;
+    }
+    const BVHNode *node = items[best];
+    items[best] = node->children[0];
+    for (int i = 1; i < node->totnode; i++) {
+      items[items_len++] = node->children[i];
+    }
+  }
+
+  if (flat->nodes_len == flat->nodes_alloc) {
+    flat->nodes_alloc *= 2;
+    flat->nodes = MEM_reallocN(flat->nodes, sizeof(*flat->nodes) * (size_t)flat->nodes_alloc);
+  }
+  const int index = flat->nodes_len++;
+  flat->depth = max_ii(flat->depth, depth);
+
+  {
+    BVHFlatNode *fnode = &flat->nodes[index];
+    memset(fnode, 0, sizeof(*fnode));
+    fnode->child_len = (uchar)min_ii(items_len, BVH_FLAT_WIDTH);
+  }
+
+  /* Split the items evenly over the slots. */
+  const int slots_len = min_ii(items_len, BVH_FLAT_WIDTH);
+  int item_index = 0;
+  for (int slot = 0; slot < slots_len; slot++) {
+    const int group_len = (items_len - item_index) / (slots_len - slot);
+    int child;
+    bool is_leaf = false;
+
+    if (group_len > 1) {
+      child = bvh_flat_build(flat, &items[item_index], group_len, depth + 1);
+    }
+    else if (items[item_index]->totnode == 0) {
+      child = (int)(items[item_index] - tree->nodearray);
+      is_leaf = true;
+    }
+    else {
+      child = bvh_flat_build(flat, &items[item_index], 1, depth + 1);
+    }
+
+    /* Building children may have re-allocated the array. */
+    BVHFlatNode *fnode = &flat->nodes[index];
+    fnode->child[slot] = child;
+    bvh_flat_bv_init(fnode, slot);
+    if (is_leaf) {
+      fnode->leaf_mask |= (uchar)(1u << slot);
+      bvh_flat_bv_expand(fnode, slot, items[item_index]->bv);
+    }
+    else {
+      bvh_flat_bv_expand_node(fnode, slot, &flat->nodes[child]);
+    }
+    item_index += group_len;
+  }
+  BLI_assert(item_index == items_len);
+
+  return index;
+}
+
+/**
+ * Create a flat copy of a balanced \a tree,
+ * the tree must use axis aligned bounds (as all trees with 6, 8, 14 or 26 axes do).
+ *
+ * \note The flat copy references \a tree, which must not be freed before it.
+ */
+BVHTreeFlat *BLI_bvhtree_flat_new(const BVHTree *tree)
+{
+  BLI_assert(tree->totbranch != 0 || tree->totleaf <= 1);
+
+  if (tree->start_axis != 0) {
+    BLI_assert(0);
+    return NULL;
+  }
+
+  BVHTreeFlat *flat = MEM_callocN(sizeof(*flat), __func__);
+  flat->tree = tree;
+  flat->nodes_alloc = max_ii(1, tree->totbranch);
+  flat->nodes = MEM_mallocN(sizeof(*flat->nodes) * (size_t)flat->nodes_alloc, __func__);
+
+  const BVHNode *root = tree->nodes[tree->totleaf];
+  if (root) {
+    bvh_flat_build(flat, &root, 1, 1);
+  }
+  return flat;
+}
+
+/**
+ * Refit the bounds after the source tree has been updated with #BLI_bvhtree_update_tree.
+ */
+void BLI_bvhtree_flat_update(BVHTreeFlat *flat)
+{
+  const BVHTree *tree = flat->tree;
+
+  /* Children always come after their parent. */
+  for (int index = flat->nodes_len - 1; index >= 0; index--) {
+    BVHFlatNode *fnode = &flat->nodes[index];
+    for (int slot = 0; slot < fnode->child_len; slot++) {
+      bvh_flat_bv_init(fnode, slot);
+      if (fnode->leaf_mask & (1u << slot)) {
+        bvh_flat_bv_expand(fnode, slot, tree->nodearray[fnode->child[slot]].bv);
+      }
+      else {
+        bvh_flat_bv_expand_node(fnode, slot, &flat->nodes[fnode->child[slot]]);
+      }
+    }
+  }
+}
+
+void BLI_bvhtree_flat_free(BVHTreeFlat *flat)
+{
+  MEM_freeN(flat->nodes);
+  MEM_freeN(flat);
+}
+
+/**
+ * Slab test of a single ray against all children of \a fnode.
+ *
+ * \return the mask of children the ray enters before its current hit distance,
+ * entry distances are written into \a r_dist for those children.
+ */
+static uint bvh_flat_ray_test(const BVHRayPacketData *data,
+                              const BVHFlatNode *fnode,
+                              const int i,
+                              float r_dist[BVH_FLAT_WIDTH])
+{
+  const uint child_mask = (1u << fnode->child_len) - 1;
+#ifdef __SSE2__
+  const __m128 radius = _mm_set1_ps(data->radius);
+  const __m128 dist = _mm_set1_ps(data->dist[i]);
+  __m128 t_near = _mm_setzero_ps();
+  __m128 t_far = dist;
+  for (int axis = 0; axis < 3; axis++) {
+    const __m128 origin = _mm_set1_ps(data->origin[axis][i]);
+    const __m128 idot = _mm_set1_ps(data->idot_axis[axis][i]);
+    const __m128 bmin = _mm_sub_ps(_mm_loadu_ps(fnode->bv[2 * axis]), radius);
+    const __m128 bmax = _mm_add_ps(_mm_loadu_ps(fnode->bv[2 * axis + 1]), radius);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(bmin, origin), idot);
+    const __m128 t2 = _mm_mul_ps(_mm_sub_ps(bmax, origin), idot);
+    t_near = _mm_max_ps(t_near, _mm_min_ps(t1, t2));
+    t_far = _mm_min_ps(t_far, _mm_max_ps(t1, t2));
+  }
+  const __m128 hit = _mm_and_ps(_mm_cmple_ps(t_near, t_far), _mm_cmplt_ps(t_near, dist));
+  _mm_storeu_ps(r_dist, t_near);
+  return (uint)_mm_movemask_ps(hit) & child_mask;
+#else
+  uint result = 0;
+  for (int slot = 0; slot < fnode->child_len; slot++) {
+    float t_near = 0.0f;
+    float t_far = data->dist[i];
+    for (int axis = 0; axis < 3; axis++) {
+      const float t1 = (fnode->bv[2 * axis][slot] - data->radius - data->origin[axis][i]) *
+                       data->idot_axis[axis][i];
+      const float t2 = (fnode->bv[2 * axis + 1][slot] + data->radius - data->origin[axis][i]) *
+                       data->idot_axis[axis][i];
+      t_near = max_ff(t_near, min_ff(t1, t2));
+      t_far = min_ff(t_far, max_ff(t1, t2));
+    }
+    if (t_near <= t_far && t_near < data->dist[i]) {
+      r_dist[slot] = t_near;
+      result |= (1u << slot);
+    }
+  }
+  return result & child_mask;
+#endif
+}
+
+typedef struct BVHFlatStackItem {
+  int index;
+  raymask_t mask;
+} BVHFlatStackItem;
+
+static void bvh_flat_ray_packet_traverse(BVHRayPacketData *data, const BVHTreeFlat *flat)
+{
+  const BVHTree *tree = data->tree;
+  const int stack_len = (flat->depth + 1) * BVH_FLAT_WIDTH;
+  BVHFlatStackItem *stack = BLI_array_alloca(stack, (size_t)stack_len);
+  int stack_index = 0;
+
+  stack[stack_index].index = 0;
+  stack[stack_index].mask = (1u << data->rays_len) - 1;
+  stack_index++;
+
+  while (stack_index != 0) {
+    stack_index--;
+    const BVHFlatNode *fnode = &flat->nodes[stack[stack_index].index];
+    raymask_t mask = stack[stack_index].mask;
+
+    raymask_t slot_mask[BVH_FLAT_WIDTH] = {0};
+    float slot_dist[BVH_FLAT_WIDTH][BVH_RAYCAST_PACKET_MAX];
+    float slot_dist_min[BVH_FLAT_WIDTH] = {FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX};
+
+    while (mask) {
+      const uint i = bitscan_forward_clear_uint(&mask);
+      float dist[BVH_FLAT_WIDTH];
+      uint hit_mask = bvh_flat_ray_test(data, fnode, (int)i, dist);
+      while (hit_mask) {
+        const uint slot = bitscan_forward_clear_uint(&hit_mask);
+        slot_mask[slot] |= (1u << i);
+        slot_dist[slot][i] = dist[slot];
+        slot_dist_min[slot] = min_ff(slot_dist_min[slot], dist[slot]);
+      }
+    }
+
+    /* Sort the children front to back. */
+    int order[BVH_FLAT_WIDTH];
+    int order_len = 0;
+    for (int slot = 0; slot < fnode->child_len; slot++) {
+      if (slot_mask[slot] == 0) {
+        continue;
+      }
+      int j = order_len++;
+      while (j > 0 && slot_dist_min[order[j - 1]] > slot_dist_min[slot]) {
+        order[j] = order[j - 1];
+        j--;
+      }
+      order[j] = slot;
+    }
+
+    /* Leaves are handled right away, nearest first, so they can shorten the rays. */
+    for (int j = 0; j < order_len; j++) {
+      const int slot = order[j];
+      if (fnode->leaf_mask & (1u << slot)) {
+        bvhtree_ray_packet_leaf(
+            data, tree->nodearray[fnode->child[slot]].index, slot_mask[slot], slot_dist[slot]);
+      }
+    }
+    for (int j = order_len - 1; j >= 0; j--) {
+      const int slot = order[j];
+      if ((fnode->leaf_mask & (1u << slot)) == 0) {
+        BLI_assert(stack_index < stack_len);
+        stack[stack_index].index = fnode->child[slot];
+        stack[stack_index].mask = slot_mask[slot];
+        stack_index++;
+      }
+    }
+  }
+}
+
+/**
+ * Same as #BLI_bvhtree_ray_cast_packet_ex using the flat layout of the tree.
+ */
+int BLI_bvhtree_flat_ray_cast_packet_ex(const BVHTreeFlat *flat,
+                                        const float (*co)[3],
+                                        const float (*dir)[3],
+                                        int rays_len,
+                                        float radius,
+                                        BVHTreeRayHit *hits,
+                                        BVHTree_RayCastCallback callback,
+                                        void *userdata,
+                                        int flag)
+{
+  BVHRayPacketData data;
+
+  bvhtree_ray_packet_data_init(
+      &data, flat->tree, co, dir, rays_len, radius, hits, callback, userdata, flag);
+
+  if (flat->nodes_len != 0) {
+    bvh_flat_ray_packet_traverse(&data, flat);
+  }
+
+  return bvhtree_ray_packet_hits_count(&data);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
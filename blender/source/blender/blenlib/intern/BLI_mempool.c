@@ -27,6 +27,8 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating and freeing from multiple threads
+ *   (between #BLI_mempool_threads_begin and #BLI_mempool_threads_end).
  */
 
 #include <string.h>
@@ -106,6 +108,21 @@ typedef struct BLI_mempool_chunk {
   struct BLI_mempool_chunk *next;
 } BLI_mempool_chunk;
 
+/**
+ * Per-thread state used while the pool is shared between threads,
+ * each thread has its own free list and chunks, so no locking is needed to allocate.
+ */
+typedef struct BLI_mempool_thread {
+  /** Free elements of this thread, may point into chunks owned by other threads. */
+  BLI_freenode *free, *free_tail;
+  /** Chunks taken by this thread, merged into the pool on #BLI_mempool_threads_end. */
+  BLI_mempool_chunk *chunks, *chunk_tail;
+  /** Number of elements allocated minus elements freed by this thread (may be negative). */
+  int totused;
+  /** Avoid false sharing between threads. */
+  char _pad[64 - (4 * sizeof(void *)) - sizeof(int)];
+} BLI_mempool_thread;
+
 /**
  * The mempool, stores and tracks memory \a chunks and elements within those chunks \a free.
  */
@@ -135,6 +152,14 @@ struct BLI_mempool {
   /** Number of elements allocated in total. */
   uint totalloc;
 #endif
+
+  /** Per-thread data, only set between #BLI_mempool_threads_begin & #BLI_mempool_threads_end. */
+  BLI_mempool_thread *threads;
+  uint threads_len;
+  /** Lock-free stack of unused chunks, threads take new chunks from here first.
+   * Chunks are only pushed when they are newly allocated and popped chunks are never
+   * pushed again, so the stack can't run into the ABA problem. */
+  BLI_mempool_chunk *chunk_exchange;
 };
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
@@ -184,6 +209,42 @@ static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
   return MEM_mallocN(sizeof(BLI_mempool_chunk) + (size_t)pool->csize, "BLI_Mempool Chunk");
 }
 
+/**
+ * Link all elements of a chunk into a free list (starting with the chunk data).
+ *
+ * \return The last element of the list,
+ * its next pointer is NULL so it can be linked to other elements.
+ */
+static BLI_freenode *mempool_chunk_free_list_init(const BLI_mempool *pool,
+                                                  BLI_mempool_chunk *mpchunk)
+{
+  const uint esize = pool->esize;
+  BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+  uint j;
+
+  /* loop through the allocated data, building the pointer structures */
+  j = pool->pchunk;
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    while (j--) {
+      curnode->next = NODE_STEP_NEXT(curnode);
+      curnode->freeword = FREEWORD;
+      curnode = curnode->next;
+    }
+  }
+  else {
+    while (j--) {
+      curnode->next = NODE_STEP_NEXT(curnode);
+      curnode = curnode->next;
+    }
+  }
+
+  /* terminate the list (rewind one) */
+  curnode = NODE_STEP_PREV(curnode);
+  curnode->next = NULL;
+
+  return curnode;
+}
+
 /**
  * Initialize a chunk and add into \a pool->chunks
  *
@@ -197,9 +258,7 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
                                        BLI_mempool_chunk *mpchunk,
                                        BLI_freenode *last_tail)
 {
-  const uint esize = pool->esize;
   BLI_freenode *curnode = CHUNK_DATA(mpchunk);
-  uint j;
 
   /* append */
   if (pool->chunk_tail) {
@@ -217,26 +276,7 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
     pool->free = curnode;
   }
 
-  /* loop through the allocated data, building the pointer structures */
-  j = pool->pchunk;
-  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-    while (j--) {
-      curnode->next = NODE_STEP_NEXT(curnode);
-      curnode->freeword = FREEWORD;
-      curnode = curnode->next;
-    }
-  }
-  else {
-    while (j--) {
-      curnode->next = NODE_STEP_NEXT(curnode);
-      curnode = curnode->next;
-    }
-  }
-
-  /* terminate the list (rewind one)
-   * will be overwritten if 'curnode' gets passed in again as 'last_tail' */
-  curnode = NODE_STEP_PREV(curnode);
-  curnode->next = NULL;
+  curnode = mempool_chunk_free_list_init(pool, mpchunk);
 
 #ifdef USE_TOTALLOC
   pool->totalloc += pool->pchunk;
@@ -315,6 +355,9 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem, uint pchunk, uint flag
   pool->totalloc = 0;
 #endif
   pool->totused = 0;
+  pool->threads = NULL;
+  pool->threads_len = 0;
+  pool->chunk_exchange = NULL;
 
   if (totelem) {
     /* Allocate the actual chunks. */
@@ -335,6 +378,8 @@ void *BLI_mempool_alloc(BLI_mempool *pool)
 {
   BLI_freenode *free_pop;
 
+  BLI_assert(pool->threads == NULL);
+
   if (UNLIKELY(pool->free == NULL)) {
     /* Need to allocate a new chunk. */
     BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
@@ -375,6 +420,8 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 {
   BLI_freenode *newhead = addr;
 
+  BLI_assert(pool->threads == NULL);
+
 #ifndef NDEBUG
   {
     BLI_mempool_chunk *chunk;
@@ -537,6 +584,7 @@ void *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr)
 void BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter)
 {
   BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_ITER);
+  BLI_assert(pool->threads == NULL);
 
   iter->pool = pool;
   iter->curchunk = pool->chunks;
@@ -700,6 +748,8 @@ void BLI_mempool_clear_ex(BLI_mempool *pool, const int totelem_reserve)
   BLI_mempool_chunk *chunks_temp;
   BLI_freenode *last_tail = NULL;
 
+  BLI_assert(pool->threads == NULL);
+
 #ifdef WITH_MEM_VALGRIND
   VALGRIND_DESTROY_MEMPOOL(pool);
   VALGRIND_CREATE_MEMPOOL(pool, 0, false);
@@ -756,6 +806,8 @@ void BLI_mempool_clear(BLI_mempool *pool)
  */
 void BLI_mempool_destroy(BLI_mempool *pool)
 {
+  BLI_assert(pool->threads == NULL);
+
   mempool_chunk_free_all(pool->chunks);
 
 #ifdef WITH_MEM_VALGRIND
@@ -765,6 +817,221 @@ void BLI_mempool_destroy(BLI_mempool *pool)
   MEM_freeN(pool);
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Threaded Allocation
+ *
+ * Between #BLI_mempool_threads_begin and #BLI_mempool_threads_end,
+ * elements can be allocated and freed from multiple threads at once,
+ * each thread using its own free list and chunks.
+ * When a thread runs out of free elements it takes a chunk from the shared (lock-free)
+ * exchange, only allocating new chunks when the exchange is empty.
+ *
+ * On #BLI_mempool_threads_end all chunks and free elements are merged back into the pool,
+ * so iteration and #BLI_mempool_findelem work as usual afterwards
+ * (new chunks are iterated after the existing ones).
+ * \{ */
+
+/** Number of chunks allocated at once when the exchange is empty. */
+#define MEMPOOL_THREAD_CHUNK_ALLOC 4
+
+static void mempool_chunk_exchange_push(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
+{
+  BLI_mempool_chunk *head;
+  do {
+    head = pool->chunk_exchange;
+    mpchunk->next = head;
+  } while (atomic_cas_ptr((void **)&pool->chunk_exchange, head, mpchunk) != head);
+}
+
+static BLI_mempool_chunk *mempool_chunk_exchange_pop(BLI_mempool *pool)
+{
+  BLI_mempool_chunk *head;
+  do {
+    head = pool->chunk_exchange;
+    if (head == NULL) {
+      return NULL;
+    }
+  } while (atomic_cas_ptr((void **)&pool->chunk_exchange, head, head->next) != head);
+  return head;
+}
+
+/**
+ * Start sharing the pool between threads.
+ *
+ * \param threads_len: Number of threads, thread indices passed to
+ * #BLI_mempool_alloc_thread & #BLI_mempool_free_thread must be lower
+ * (for task schedulers use #BLI_task_scheduler_num_threads + 1, the main thread uses 0).
+ * \param totelem_reserve: The number of elements expected to be allocated,
+ * used to fill the exchange with chunks up-front.
+ */
+void BLI_mempool_threads_begin(BLI_mempool *pool,
+                               const uint threads_len,
+                               const uint totelem_reserve)
+{
+  BLI_assert(pool->threads == NULL);
+  BLI_assert(threads_len > 0);
+
+  pool->threads = MEM_callocN(sizeof(*pool->threads) * threads_len, __func__);
+  pool->threads_len = threads_len;
+  pool->chunk_exchange = NULL;
+
+  for (uint i = (totelem_reserve + pool->pchunk - 1) / pool->pchunk; i != 0; i--) {
+    mempool_chunk_exchange_push(pool, mempool_chunk_alloc(pool));
+  }
+}
+
+/**
+ * Stop sharing the pool between threads, must not run while other threads use the pool.
+ */
+void BLI_mempool_threads_end(BLI_mempool *pool)
+{
+  BLI_mempool_chunk *mpchunk, *mpchunk_next;
+
+  BLI_assert(pool->threads != NULL);
+
+  for (uint i = 0; i < pool->threads_len; i++) {
+    BLI_mempool_thread *thread = &pool->threads[i];
+
+    if (thread->chunks) {
+      if (pool->chunk_tail) {
+        pool->chunk_tail->next = thread->chunks;
+      }
+      else {
+        pool->chunks = thread->chunks;
+      }
+      pool->chunk_tail = thread->chunk_tail;
+    }
+
+    if (thread->free) {
+      thread->free_tail->next = pool->free;
+      pool->free = thread->free;
+    }
+
+    pool->totused = (uint)((int)pool->totused + thread->totused);
+  }
+
+  /* Chunks which were never taken by a thread. */
+  for (mpchunk = pool->chunk_exchange; mpchunk; mpchunk = mpchunk_next) {
+    mpchunk_next = mpchunk->next;
+    BLI_freenode *free_head = pool->free;
+    pool->free = NULL;
+    BLI_freenode *free_tail = mempool_chunk_add(pool, mpchunk, NULL);
+    free_tail->next = free_head;
+  }
+
+  MEM_freeN(pool->threads);
+  pool->threads = NULL;
+  pool->threads_len = 0;
+  pool->chunk_exchange = NULL;
+}
+
+static void mempool_thread_chunk_add(BLI_mempool *pool, BLI_mempool_thread *thread)
+{
+  BLI_mempool_chunk *mpchunk = mempool_chunk_exchange_pop(pool);
+
+  if (mpchunk == NULL) {
+    /* Keep some spare chunks for other threads, to reduce calls to the system allocator. */
+    for (int i = 1; i < MEMPOOL_THREAD_CHUNK_ALLOC; i++) {
+      mempool_chunk_exchange_push(pool, mempool_chunk_alloc(pool));
+    }
+    mpchunk = mempool_chunk_alloc(pool);
+  }
+
+  mpchunk->next = NULL;
+  if (thread->chunk_tail) {
+    thread->chunk_tail->next = mpchunk;
+  }
+  else {
+    thread->chunks = mpchunk;
+  }
+  thread->chunk_tail = mpchunk;
+
+  BLI_assert(thread->free == NULL);
+  thread->free_tail = mempool_chunk_free_list_init(pool, mpchunk);
+  thread->free = CHUNK_DATA(mpchunk);
+}
+
+/**
+ * Thread-safe version of #BLI_mempool_alloc,
+ * \a thread_index must be unique for all threads using the pool at the same time.
+ */
+void *BLI_mempool_alloc_thread(BLI_mempool *pool, const uint thread_index)
+{
+  BLI_assert(thread_index < pool->threads_len);
+  BLI_mempool_thread *thread = &pool->threads[thread_index];
+  BLI_freenode *free_pop;
+
+  if (UNLIKELY(thread->free == NULL)) {
+    mempool_thread_chunk_add(pool, thread);
+  }
+
+  free_pop = thread->free;
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    free_pop->freeword = USEDWORD;
+  }
+
+  thread->free = free_pop->next;
+  if (thread->free == NULL) {
+    thread->free_tail = NULL;
+  }
+  thread->totused++;
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+  return (void *)free_pop;
+}
+
+void *BLI_mempool_calloc_thread(BLI_mempool *pool, const uint thread_index)
+{
+  void *retval = BLI_mempool_alloc_thread(pool, thread_index);
+  memset(retval, 0, (size_t)pool->esize);
+  return retval;
+}
+
+/**
+ * Thread-safe version of #BLI_mempool_free,
+ * elements may be freed by another thread than the one that allocated them.
+ *
+ * \note Unlike #BLI_mempool_free, chunks are never freed here.
+ */
+void BLI_mempool_free_thread(BLI_mempool *pool, const uint thread_index, void *addr)
+{
+  BLI_assert(thread_index < pool->threads_len);
+  BLI_mempool_thread *thread = &pool->threads[thread_index];
+  BLI_freenode *newhead = addr;
+
+#ifndef NDEBUG
+  /* Enable for debugging. */
+  if (UNLIKELY(mempool_debug_memset)) {
+    memset(addr, 255, pool->esize);
+  }
+#endif
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+    /* This will detect double free's. */
+    BLI_assert(newhead->freeword != FREEWORD);
+#endif
+    newhead->freeword = FREEWORD;
+  }
+
+  newhead->next = thread->free;
+  if (thread->free == NULL) {
+    thread->free_tail = newhead;
+  }
+  thread->free = newhead;
+  thread->totused--;
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+}
+
+/** \} */
+
 #ifndef NDEBUG
 void BLI_mempool_set_memory_debug(void)
 {
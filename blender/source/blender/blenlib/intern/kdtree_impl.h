@@ -22,6 +22,8 @@
 
 #include "BLI_math.h"
 #include "BLI_kdtree_impl.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 #include "BLI_strict_flags.h"
 
@@ -42,13 +44,19 @@ typedef struct KDTreeNode {
   uint d; /* range is only (0..KD_DIMS - 1) */
 } KDTreeNode;
 
+/**
+ * Once balanced, nodes are stored in depth-first (pre-order) layout:
+ * the left child of a node always directly follows it in the array
+ * and the root is the first node.
+ * This keeps most of the nodes visited by a query in the same cache lines.
+ */
 struct KDTree {
   KDTreeNode *nodes;
   uint nodes_len;
+  uint nodes_len_capacity; /* max size of the tree */
   uint root;
 #ifdef DEBUG
-  bool is_balanced;        /* ensure we call balance first */
-  uint nodes_len_capacity; /* max size of the tree */
+  bool is_balanced; /* ensure we call balance first */
 #endif
 };
 
@@ -58,9 +66,10 @@ struct KDTree {
 
 #define KD_NODE_UNSET ((uint)-1)
 
-/** When set we know all values are unbalanced,
- * otherwise clear them when re-balancing: see T62210. */
-#define KD_NODE_ROOT_IS_INIT ((uint)-2)
+/** Sub-trees with more nodes than this are balanced in their own task. */
+#define KD_BALANCE_THREAD_NODES_MIN 8192
+/** Batched queries with more coordinates than this are threaded. */
+#define KD_BATCH_THREAD_QUERY_MIN 256
 
 /* -------------------------------------------------------------------- */
 /** \name Local Math API
@@ -101,11 +110,11 @@ KDTree *BLI_kdtree_nd_(new)(uint nodes_len_capacity)
   tree = MEM_mallocN(sizeof(KDTree), "KDTree");
   tree->nodes = MEM_mallocN(sizeof(KDTreeNode) * nodes_len_capacity, "KDTreeNode");
   tree->nodes_len = 0;
-  tree->root = KD_NODE_ROOT_IS_INIT;
+  tree->nodes_len_capacity = nodes_len_capacity;
+  tree->root = KD_NODE_UNSET;
 
 #ifdef DEBUG
   tree->is_balanced = false;
-  tree->nodes_len_capacity = nodes_len_capacity;
 #endif
 
   return tree;
@@ -126,9 +135,7 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 {
   KDTreeNode *node = &tree->nodes[tree->nodes_len++];
 
-#ifdef DEBUG
   BLI_assert(tree->nodes_len <= tree->nodes_len_capacity);
-#endif
 
   /* note, array isn't calloc'd,
    * need to initialize all struct members */
@@ -143,19 +150,21 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/* -------------------------------------------------------------------- */
+/** \name BLI_kdtree_3d_balance
+ * \{ */
+
+/**
+ * Partially sort \a nodes around their median on \a axis (quick-select),
+ * nodes before the median are never greater, nodes after are never smaller.
+ *
+ * \return The index of the median.
+ */
+static uint kdtree_balance_partition(KDTreeNode *nodes, uint nodes_len, uint axis)
 {
-  KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
-  }
-
   /* quicksort style sorting around median */
   left = 0;
   right = nodes_len - 1;
@@ -188,33 +197,130 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
     }
   }
 
-  /* set node and sort subnodes */
-  node = &nodes[median];
-  node->d = axis;
-  axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
-  node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+  return median;
+}
 
-  return median + ofs;
+/**
+ * The axis along which \a nodes have the largest extent.
+ *
+ * Cycling through the axes splits flat input (a planar grid for example) along an axis
+ * where all positions are equal, where a nearest search can't skip either side.
+ */
+static uint kdtree_balance_axis(const KDTreeNode *nodes, uint nodes_len)
+{
+  float min[KD_DIMS], max[KD_DIMS];
+  uint axis = 0;
+
+  for (uint j = 0; j < KD_DIMS; j++) {
+    min[j] = max[j] = nodes[0].co[j];
+  }
+  for (uint i = 1; i < nodes_len; i++) {
+    for (uint j = 0; j < KD_DIMS; j++) {
+      const float value = nodes[i].co[j];
+      if (value < min[j]) {
+        min[j] = value;
+      }
+      else if (value > max[j]) {
+        max[j] = value;
+      }
+    }
+  }
+  for (uint j = 1; j < KD_DIMS; j++) {
+    if (max[j] - min[j] > max[axis] - min[axis]) {
+      axis = j;
+    }
+  }
+  return axis;
 }
 
-void BLI_kdtree_nd_(balance)(KDTree *tree)
+typedef struct KDTreeBalanceTask {
+  /** Unsorted nodes of the sub-tree (partitioned in-place). */
+  KDTreeNode *nodes;
+  uint nodes_len;
+  /** Position of the sub-tree root in the balanced (pre-order) array. */
+  uint ofs;
+} KDTreeBalanceTask;
+
+static void kdtree_balance_task_func(TaskPool *__restrict pool, void *taskdata, int threadid);
+
+/**
+ * Balance \a nodes, writing them into \a nodes_dst in pre-order starting at \a ofs.
+ * Since the median split fixes the size of both sub-trees,
+ * the position of every sub-tree is known before it's balanced,
+ * so large sub-trees are balanced in parallel when a \a pool is given.
+ */
+static void kdtree_balance(
+    TaskPool *pool, KDTreeNode *nodes_dst, KDTreeNode *nodes, uint nodes_len, uint ofs)
 {
-  if (tree->root != KD_NODE_ROOT_IS_INIT) {
-    for (uint i = 0; i < tree->nodes_len; i++) {
-      tree->nodes[i].left = KD_NODE_UNSET;
-      tree->nodes[i].right = KD_NODE_UNSET;
+  /* Loop over the right hand sub-tree, recurse (or spawn a task) for the left. */
+  while (nodes_len != 0) {
+    const uint axis = kdtree_balance_axis(nodes, nodes_len);
+    const uint median = kdtree_balance_partition(nodes, nodes_len, axis);
+    const uint left_len = median;
+    const uint right_len = nodes_len - (median + 1);
+    KDTreeNode *node = &nodes_dst[ofs];
+
+    *(KDTreeNode_head *)node = *(KDTreeNode_head *)&nodes[median];
+    node->d = axis;
+    node->left = left_len ? ofs + 1 : KD_NODE_UNSET;
+    node->right = right_len ? ofs + 1 + left_len : KD_NODE_UNSET;
+
+    if (pool && (left_len > KD_BALANCE_THREAD_NODES_MIN)) {
+      KDTreeBalanceTask *task = MEM_mallocN(sizeof(*task), __func__);
+      task->nodes = nodes;
+      task->nodes_len = left_len;
+      task->ofs = ofs + 1;
+      BLI_task_pool_push(pool, kdtree_balance_task_func, task, true, TASK_PRIORITY_HIGH);
     }
+    else if (left_len != 0) {
+      kdtree_balance(pool, nodes_dst, nodes, left_len, ofs + 1);
+    }
+
+    nodes += median + 1;
+    nodes_len = right_len;
+    ofs += 1 + left_len;
   }
+}
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
+static void kdtree_balance_task_func(TaskPool *__restrict pool,
+                                     void *taskdata,
+                                     int UNUSED(threadid))
+{
+  KDTreeNode *nodes_dst = BLI_task_pool_userdata(pool);
+  const KDTreeBalanceTask *task = taskdata;
+  kdtree_balance(pool, nodes_dst, task->nodes, task->nodes_len, task->ofs);
+}
+
+/**
+ * Build the tree from the inserted nodes, large trees are built in parallel.
+ * The tree may be balanced again after inserting more nodes.
+ */
+void BLI_kdtree_nd_(balance)(KDTree *tree)
+{
+  KDTreeNode *nodes_dst = MEM_mallocN(sizeof(KDTreeNode) * tree->nodes_len_capacity,
+                                      "KDTreeNode");
+
+  if (tree->nodes_len > KD_BALANCE_THREAD_NODES_MIN) {
+    TaskPool *pool = BLI_task_pool_create(BLI_task_scheduler_get(), nodes_dst);
+    kdtree_balance(pool, nodes_dst, tree->nodes, tree->nodes_len, 0);
+    BLI_task_pool_work_and_wait(pool);
+    BLI_task_pool_free(pool);
+  }
+  else {
+    kdtree_balance(NULL, nodes_dst, tree->nodes, tree->nodes_len, 0);
+  }
+
+  MEM_freeN(tree->nodes);
+  tree->nodes = nodes_dst;
+  tree->root = tree->nodes_len ? 0 : KD_NODE_UNSET;
 
 #ifdef DEBUG
   tree->is_balanced = true;
 #endif
 }
 
+/** \} */
+
 static uint *realloc_nodes(uint *stack, uint *stack_len_capacity, const bool is_alloc)
 {
   uint *stack_new = MEM_mallocN((*stack_len_capacity + KD_NEAR_ALLOC_INC) * sizeof(uint),
@@ -228,6 +334,60 @@ static uint *realloc_nodes(uint *stack, uint *stack_len_capacity, const bool is_
   return stack_new;
 }
 
+/**
+ * Visit the side of the split plane \a co is on first, then the other side only when its cell
+ * is closer than the nearest node found so far.
+ *
+ * \param cell_offset: Per axis offset of \a co to the cell of node \a i.
+ * \param cell_dist: Squared distance of \a co to the cell, the sum of the squared offsets.
+ * Only using the distance to the split plane can't skip cells that are offset along several axes,
+ * which is common when \a co is far from all nodes.
+ */
+static void kdtree_find_nearest_recursive(const KDTreeNode *nodes,
+                                          uint i,
+                                          const float co[KD_DIMS],
+                                          float cell_offset[KD_DIMS],
+                                          const float cell_dist,
+                                          float *r_min_dist,
+                                          const KDTreeNode **r_min_node)
+{
+  const KDTreeNode *node = &nodes[i];
+  const uint d = node->d;
+  const float plane_dist = co[d] - node->co[d];
+  const float cur_dist = len_squared_vnvn(node->co, co);
+  uint near, far;
+
+  if (cur_dist < *r_min_dist) {
+    *r_min_dist = cur_dist;
+    *r_min_node = node;
+  }
+
+  if (plane_dist < 0.0f) {
+    near = node->left;
+    far = node->right;
+  }
+  else {
+    near = node->right;
+    far = node->left;
+  }
+
+  if (near != KD_NODE_UNSET) {
+    kdtree_find_nearest_recursive(
+        nodes, near, co, cell_offset, cell_dist, r_min_dist, r_min_node);
+  }
+
+  if (far != KD_NODE_UNSET) {
+    /* The far cell is checked after the near one, when the nearest distance is known best. */
+    const float offset_prev = cell_offset[d];
+    const float far_dist = cell_dist - SQUARE(offset_prev) + SQUARE(plane_dist);
+    if (far_dist < *r_min_dist) {
+      cell_offset[d] = plane_dist;
+      kdtree_find_nearest_recursive(nodes, far, co, cell_offset, far_dist, r_min_dist, r_min_node);
+      cell_offset[d] = offset_prev;
+    }
+  }
+}
+
 /**
  * Find nearest returns index, and -1 if no node is found.
  */
@@ -235,11 +395,8 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
                                  const float co[KD_DIMS],
                                  KDTreeNearest *r_nearest)
 {
-  const KDTreeNode *nodes = tree->nodes;
-  const KDTreeNode *root, *min_node;
-  uint *stack, stack_default[KD_STACK_INIT];
-  float min_dist, cur_dist;
-  uint stack_len_capacity, cur = 0;
+  const KDTreeNode *min_node;
+  float min_dist, cell_offset[KD_DIMS] = {0.0f};
 
 #ifdef DEBUG
   BLI_assert(tree->is_balanced == true);
@@ -249,73 +406,12 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
     return -1;
   }
 
-  stack = stack_default;
-  stack_len_capacity = KD_STACK_INIT;
-
-  root = &nodes[tree->root];
-  min_node = root;
-  min_dist = len_squared_vnvn(root->co, co);
-
-  if (co[root->d] < root->co[root->d]) {
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-  }
-  else {
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-  }
-
-  while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
-
-    cur_dist = node->co[node->d] - co[node->d];
-
-    if (cur_dist < 0.0f) {
-      cur_dist = -cur_dist * cur_dist;
+  /* Start with the root as nearest, so a node is found even for non-finite coordinates. */
+  min_node = &tree->nodes[tree->root];
+  min_dist = len_squared_vnvn(min_node->co, co);
 
-      if (-cur_dist < min_dist) {
-        cur_dist = len_squared_vnvn(node->co, co);
-        if (cur_dist < min_dist) {
-          min_dist = cur_dist;
-          min_node = node;
-        }
-        if (node->left != KD_NODE_UNSET) {
-          stack[cur++] = node->left;
-        }
-      }
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
-      }
-    }
-    else {
-      cur_dist = cur_dist * cur_dist;
-
-      if (cur_dist < min_dist) {
-        cur_dist = len_squared_vnvn(node->co, co);
-        if (cur_dist < min_dist) {
-          min_dist = cur_dist;
-          min_node = node;
-        }
-        if (node->right != KD_NODE_UNSET) {
-          stack[cur++] = node->right;
-        }
-      }
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
-      }
-    }
-    if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
-    }
-  }
+  kdtree_find_nearest_recursive(
+      tree->nodes, tree->root, co, cell_offset, 0.0f, &min_dist, &min_node);
 
   if (r_nearest) {
     r_nearest->index = min_node->index;
@@ -323,10 +419,6 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
     copy_vn_vn(r_nearest->co, min_node->co);
   }
 
-  if (stack != stack_default) {
-    MEM_freeN(stack);
-  }
-
   return min_node->index;
 }
 
@@ -635,39 +727,30 @@ static void nearest_add_in_range(KDTreeNearest **r_nearest,
 }
 
 /**
- * Range search returns number of points nearest_len, with results in nearest
- *
- * \param r_nearest: Allocated array of nearest nearest_len (caller is responsible for freeing).
+ * Append the nodes in \a range to \a r_nearest (which grows as needed),
+ * the appended nodes are sorted by distance.
  */
-int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
-    const KDTree *tree,
-    const float co[KD_DIMS],
-    KDTreeNearest **r_nearest,
-    const float range,
-    float (*len_sq_fn)(const float co_search[KD_DIMS],
-                       const float co_test[KD_DIMS],
-                       const void *user_data),
-    const void *user_data)
+static void kdtree_range_search_append(const KDTree *tree,
+                                       const float co[KD_DIMS],
+                                       const float range,
+                                       float (*len_sq_fn)(const float co_search[KD_DIMS],
+                                                          const float co_test[KD_DIMS],
+                                                          const void *user_data),
+                                       const void *user_data,
+                                       KDTreeNearest **r_nearest,
+                                       uint *r_nearest_len,
+                                       uint *r_nearest_len_capacity)
 {
   const KDTreeNode *nodes = tree->nodes;
   uint *stack, stack_default[KD_STACK_INIT];
-  KDTreeNearest *nearest = NULL;
   const float range_sq = range * range;
+  const uint nearest_len_init = *r_nearest_len;
   float dist_sq;
   uint stack_len_capacity, cur = 0;
-  uint nearest_len = 0, nearest_len_capacity = 0;
-
-#ifdef DEBUG
-  BLI_assert(tree->is_balanced == true);
-#endif
+  uint nearest_len = nearest_len_init;
 
   if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
-    return 0;
-  }
-
-  if (len_sq_fn == NULL) {
-    len_sq_fn = len_squared_vnvn_cb;
-    BLI_assert(user_data == NULL);
+    return;
   }
 
   stack = stack_default;
@@ -692,7 +775,7 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
       dist_sq = len_sq_fn(co, node->co, user_data);
       if (dist_sq <= range_sq) {
         nearest_add_in_range(
-            &nearest, nearest_len++, &nearest_len_capacity, node->index, dist_sq, node->co);
+            r_nearest, nearest_len++, r_nearest_len_capacity, node->index, dist_sq, node->co);
       }
 
       if (node->left != KD_NODE_UNSET) {
@@ -712,10 +795,46 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
     MEM_freeN(stack);
   }
 
-  if (nearest_len) {
-    qsort(nearest, nearest_len, sizeof(KDTreeNearest), nearest_cmp_dist);
+  if (nearest_len != nearest_len_init) {
+    qsort(*r_nearest + nearest_len_init,
+          nearest_len - nearest_len_init,
+          sizeof(KDTreeNearest),
+          nearest_cmp_dist);
+  }
+
+  *r_nearest_len = nearest_len;
+}
+
+/**
+ * Range search returns number of points nearest_len, with results in nearest
+ *
+ * \param r_nearest: Allocated array of nearest nearest_len (caller is responsible for freeing).
+ */
+int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
+    const KDTree *tree,
+    const float co[KD_DIMS],
+    KDTreeNearest **r_nearest,
+    const float range,
+    float (*len_sq_fn)(const float co_search[KD_DIMS],
+                       const float co_test[KD_DIMS],
+                       const void *user_data),
+    const void *user_data)
+{
+  KDTreeNearest *nearest = NULL;
+  uint nearest_len = 0, nearest_len_capacity = 0;
+
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  if (len_sq_fn == NULL) {
+    len_sq_fn = len_squared_vnvn_cb;
+    BLI_assert(user_data == NULL);
   }
 
+  kdtree_range_search_append(
+      tree, co, range, len_sq_fn, user_data, &nearest, &nearest_len, &nearest_len_capacity);
+
   *r_nearest = nearest;
 
   return (int)nearest_len;
@@ -804,6 +923,216 @@ finally:
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Batched Queries
+ *
+ * Answer many queries in one call, large batches are threaded.
+ * Each thread reuses its own buffers between queries,
+ * avoiding an allocation for every range search.
+ * \{ */
+
+typedef struct KDTreeBatchThreadData {
+  KDTreeNearest *nearest;
+  uint nearest_len;
+  uint nearest_len_capacity;
+} KDTreeBatchThreadData;
+
+typedef struct KDTreeBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+
+  /* find_nearest_n */
+  KDTreeNearest *nearest;
+  uint nearest_len_capacity;
+  int *nearest_len;
+
+  /* range_search */
+  float range;
+  KDTreeBatchThreadData *thread_data;
+  /** Thread and offset in its buffer of the results of every query. */
+  uint *query_thread;
+  uint *query_ofs;
+  uint *nearest_offset;
+} KDTreeBatchData;
+
+static void kdtree_batch_settings(TaskParallelSettings *settings, const uint co_len)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = (co_len > KD_BATCH_THREAD_QUERY_MIN);
+  settings->scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+}
+
+static void kdtree_find_nearest_batch_cb(void *__restrict userdata,
+                                         const int iter,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  KDTreeNearest *nearest = &data->nearest[iter];
+  if (BLI_kdtree_nd_(find_nearest)(data->tree, data->co[iter], nearest) == -1) {
+    nearest->index = -1;
+    nearest->dist = FLT_MAX;
+  }
+}
+
+/**
+ * Find the nearest node for every coordinate in \a co.
+ *
+ * \param r_nearest: An array sized \a co_len,
+ * the index is set to -1 when no node was found (when the tree is empty).
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest)
+{
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .nearest = r_nearest,
+  };
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_batch_cb, &settings);
+}
+
+static void kdtree_find_nearest_n_batch_cb(void *__restrict userdata,
+                                           const int iter,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  data->nearest_len[iter] = BLI_kdtree_nd_(find_nearest_n)(
+      data->tree,
+      data->co[iter],
+      &data->nearest[(uint)iter * data->nearest_len_capacity],
+      data->nearest_len_capacity);
+}
+
+/**
+ * Find the \a nearest_len_capacity nearest nodes for every coordinate in \a co.
+ *
+ * \param r_nearest: An array sized `co_len * nearest_len_capacity`,
+ * results for `co[i]` start at `r_nearest[i * nearest_len_capacity]`.
+ * \param r_nearest_len: An array sized \a co_len, the number of nodes found for each query.
+ */
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          const uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          const uint nearest_len_capacity,
+                                          int *r_nearest_len)
+{
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .nearest = r_nearest,
+      .nearest_len_capacity = nearest_len_capacity,
+      .nearest_len = r_nearest_len,
+  };
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_n_batch_cb, &settings);
+}
+
+static void kdtree_range_search_batch_cb(void *__restrict userdata,
+                                         const int iter,
+                                         const TaskParallelTLS *__restrict tls)
+{
+  const KDTreeBatchData *data = userdata;
+  KDTreeBatchThreadData *td = &data->thread_data[tls->thread_id];
+  const uint nearest_len_prev = td->nearest_len;
+
+  kdtree_range_search_append(data->tree,
+                             data->co[iter],
+                             data->range,
+                             len_squared_vnvn_cb,
+                             NULL,
+                             &td->nearest,
+                             &td->nearest_len,
+                             &td->nearest_len_capacity);
+
+  data->query_thread[iter] = (uint)tls->thread_id;
+  data->query_ofs[iter] = nearest_len_prev;
+  data->nearest_offset[iter + 1] = td->nearest_len - nearest_len_prev;
+}
+
+static void kdtree_range_search_batch_gather_cb(void *__restrict userdata,
+                                                const int iter,
+                                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  const KDTreeBatchThreadData *td = &data->thread_data[data->query_thread[iter]];
+  const uint ofs = data->nearest_offset[iter];
+  const uint len = data->nearest_offset[iter + 1] - ofs;
+  memcpy(&data->nearest[ofs], &td->nearest[data->query_ofs[iter]], sizeof(*data->nearest) * len);
+}
+
+/**
+ * Range search for every coordinate in \a co.
+ *
+ * \param r_nearest: Allocated array of all nodes found (caller is responsible for freeing),
+ * NULL when nothing was found.
+ * \param r_nearest_offset: An array sized `co_len + 1`,
+ * results for `co[i]` are `r_nearest[r_nearest_offset[i] .. r_nearest_offset[i + 1] - 1]`,
+ * sorted by distance.
+ * \return The total number of nodes found.
+ */
+int BLI_kdtree_nd_(range_search_batch)(const KDTree *tree,
+                                       const float (*co)[KD_DIMS],
+                                       const uint co_len,
+                                       const float range,
+                                       KDTreeNearest **r_nearest,
+                                       uint *r_nearest_offset)
+{
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+
+  const uint threads_len = settings.use_threading ?
+                               (uint)BLI_task_scheduler_num_threads(BLI_task_scheduler_get()) +
+                                   1 :
+                               1;
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .range = range,
+      .thread_data = MEM_callocN(sizeof(*data.thread_data) * threads_len, __func__),
+      .query_thread = MEM_mallocN(sizeof(*data.query_thread) * co_len, __func__),
+      .query_ofs = MEM_mallocN(sizeof(*data.query_ofs) * co_len, __func__),
+      .nearest_offset = r_nearest_offset,
+  };
+
+#ifdef DEBUG
+  BLI_assert(tree->is_balanced == true);
+#endif
+
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_range_search_batch_cb, &settings);
+
+  /* Offsets from the number of nodes found for each query. */
+  r_nearest_offset[0] = 0;
+  for (uint i = 0; i < co_len; i++) {
+    r_nearest_offset[i + 1] += r_nearest_offset[i];
+  }
+
+  const uint nearest_len = r_nearest_offset[co_len];
+  if (nearest_len != 0) {
+    data.nearest = MEM_mallocN(sizeof(*data.nearest) * nearest_len, __func__);
+    BLI_task_parallel_range(
+        0, (int)co_len, &data, kdtree_range_search_batch_gather_cb, &settings);
+  }
+
+  for (uint i = 0; i < threads_len; i++) {
+    MEM_SAFE_FREE(data.thread_data[i].nearest);
+  }
+  MEM_freeN(data.thread_data);
+  MEM_freeN(data.query_thread);
+  MEM_freeN(data.query_ofs);
+
+  *r_nearest = data.nearest;
+
+  return (int)nearest_len;
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
@@ -818,6 +1147,37 @@ static uint *kdtree_order(const KDTree *tree)
   return order;
 }
 
+static void kdtree_order_split_recursive(const KDTreeNode *nodes,
+                                         uint i,
+                                         uint *order,
+                                         uint *order_len)
+{
+  const KDTreeNode *node = &nodes[i];
+  if (node->left != KD_NODE_UNSET) {
+    kdtree_order_split_recursive(nodes, node->left, order, order_len);
+  }
+  order[(*order_len)++] = i;
+  if (node->right != KD_NODE_UNSET) {
+    kdtree_order_split_recursive(nodes, node->right, order, order_len);
+  }
+}
+
+/**
+ * Use when we want to loop over nodes in the order of their split planes (in-order),
+ * this matches the order nodes were stored in before using a pre-order layout,
+ * so results that depend on the iteration order remain unchanged.
+ */
+static uint *kdtree_order_split(const KDTree *tree)
+{
+  uint *order = MEM_mallocN(sizeof(uint) * tree->nodes_len, __func__);
+  uint order_len = 0;
+  if (tree->root != KD_NODE_UNSET) {
+    kdtree_order_split_recursive(tree->nodes, tree->root, order, &order_len);
+  }
+  BLI_assert(order_len == tree->nodes_len);
+  return order;
+}
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_kdtree_3d_calc_duplicates_fast
  * \{ */
@@ -915,8 +1275,9 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
     MEM_freeN(order);
   }
   else {
+    uint *order = kdtree_order_split(tree);
     for (uint i = 0; i < tree->nodes_len; i++) {
-      const uint node_index = i;
+      const uint node_index = order[i];
       const int index = p.nodes[node_index].index;
       if (ELEM(duplicates[index], -1, index)) {
         p.search = index;
@@ -929,6 +1290,7 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
         }
       }
     }
+    MEM_freeN(order);
   }
   return found;
 }
@@ -1385,23 +1385,6 @@ FileData *blo_filedata_from_file(const char *filepath, ReportList *reports)
   return NULL;
 }
 
-/**
- * Same as blo_filedata_from_file(), but does not reads DNA data, only header.
- * Use it for light access (e.g. thumbnail reading).
- */
-static FileData *blo_filedata_from_file_minimal(const char *filepath)
-{
-  FileData *fd = blo_filedata_from_file_open(filepath, NULL);
-  if (fd != NULL) {
-    decode_blender_header(fd);
-    if (fd->flags & FD_FLAGS_FILE_OK) {
-      return fd;
-    }
-    blo_filedata_free(fd);
-  }
-  return NULL;
-}
-
 static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, uint size)
 {
   int err;
@@ -1663,6 +1646,11 @@ bool BLO_library_path_explode(const char *path, char *r_dir, char **r_group, cha
 /**
  * Does a very light reading of given .blend file to extract its stored thumbnail.
  *
+ * This doesn't use #FileData, only the file header and the headers of the blocks
+ * stored before the #TEST block are read, the data of other blocks is skipped by seeking.
+ * Since this is used for every file shown in the file browser,
+ * reading should stop as early as possible.
+ *
  * \param filepath: The path of the file to extract thumbnail from.
  * \return The raw thumbnail
  * (MEM-allocated, as stored in file, use #BKE_main_thumbnail_to_imbuf()
@@ -1670,30 +1658,83 @@ bool BLO_library_path_explode(const char *path, char *r_dir, char **r_group, cha
  */
 BlendThumbnail *BLO_thumbnail_from_file(const char *filepath)
 {
-  FileData *fd;
   BlendThumbnail *data = NULL;
-  int *fd_data;
+  char header[SIZEOFBLENDERHEADER];
+
+  /* Handles both compressed and uncompressed files (seeking directly in the latter). */
+  gzFile file = BLI_gzopen(filepath, "rb");
+  if (file == (gzFile)Z_NULL) {
+    return NULL;
+  }
+
+  if ((gzread(file, header, sizeof(header)) != sizeof(header)) ||
+      !STREQLEN(header, "BLENDER", 7) || !ELEM(header[7], '_', '-') ||
+      !ELEM(header[8], 'v', 'V')) {
+    gzclose(file);
+    return NULL;
+  }
+
+  const int bhead_size = (header[7] == '_') ? sizeof(BHead4) : sizeof(BHead8);
+  const bool do_endian_swap = ((header[8] == 'v') ? L_ENDIAN : B_ENDIAN) != ENDIAN_ORDER;
 
-  fd = blo_filedata_from_file_minimal(filepath);
-  fd_data = fd ? read_file_thumbnail(fd) : NULL;
+  while (true) {
+    /* #BHead4 and #BHead8 both start with the code and length. */
+    union {
+      BHead4 bhead4;
+      BHead8 bhead8;
+    } bhead;
+    if (gzread(file, &bhead, bhead_size) != bhead_size) {
+      break;
+    }
 
-  if (fd_data) {
-    const int width = fd_data[0];
-    const int height = fd_data[1];
-    if (BLEN_THUMB_MEMSIZE_IS_VALID(width, height)) {
+    int len = bhead.bhead4.len;
+    if (do_endian_swap) {
+      BLI_endian_switch_int32(&len);
+    }
+    if (len < 0) {
+      break;
+    }
+
+    if (bhead.bhead4.code == TEST) {
+      int size[2];
+      if ((len < (int)sizeof(size)) || (gzread(file, size, sizeof(size)) != sizeof(size))) {
+        break;
+      }
+      if (do_endian_swap) {
+        BLI_endian_switch_int32(&size[0]);
+        BLI_endian_switch_int32(&size[1]);
+      }
+
+      const int width = size[0];
+      const int height = size[1];
+      if (!BLEN_THUMB_MEMSIZE_IS_VALID(width, height) ||
+          ((size_t)len < BLEN_THUMB_MEMSIZE_FILE(width, height))) {
+        break;
+      }
+
+      /* Read the pixels directly into the thumbnail. */
       const size_t sz = BLEN_THUMB_MEMSIZE(width, height);
+      const int rect_size = (int)(sz - sizeof(*data));
       data = MEM_mallocN(sz, __func__);
-      if (data) {
-        BLI_assert((sz - sizeof(*data)) ==
-                   (BLEN_THUMB_MEMSIZE_FILE(width, height) - (sizeof(*fd_data) * 2)));
-        data->width = width;
-        data->height = height;
-        memcpy(data->rect, &fd_data[2], sz - sizeof(*data));
+      data->width = width;
+      data->height = height;
+      if (gzread(file, data->rect, (uint)rect_size) != rect_size) {
+        MEM_freeN(data);
+        data = NULL;
       }
+      break;
+    }
+    else if (bhead.bhead4.code != REND) {
+      /* Thumbnail is stored in TEST immediately after first REND... */
+      break;
+    }
+
+    if (gzseek(file, len, SEEK_CUR) == -1) {
+      break;
     }
   }
 
-  blo_filedata_free(fd);
+  gzclose(file);
 
   return data;
 }
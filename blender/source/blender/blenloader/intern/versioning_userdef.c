@@ -664,7 +664,12 @@ void BLO_version_defaults_userpref_blend(Main *bmain, UserDef *userdef)
    * Include next version bump.
    */
   {
-    /* pass */
+    if (userdef->sequencer_disk_cache_size_limit == 0) {
+      userdef->sequencer_disk_cache_size_limit = 100;
+    }
+    if (userdef->compositor_cache_limit == 0) {
+      userdef->compositor_cache_limit = 1024;
+    }
   }
 
   if (userdef->pixelsize == 0.0f) {
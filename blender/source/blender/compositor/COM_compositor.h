@@ -112,10 +112,13 @@ extern "C" {
  *  - [@ref OrderOfChunks.COM_TO_RULE_OF_THIRDS]:
  *    Experimental order based on 9 hot-spots in the image.
  *
- * When the chunk-order is determined, the first few chunks will be checked if they can be scheduled.
- * Chunks can have three states:
+ * When the chunk-order is determined, the first few chunks will be requested.
+ * Every time a chunk finishes the next chunk is requested.
+ * Chunks can have four states:
  *  - [@ref ChunkExecutionState.COM_ES_NOT_SCHEDULED]:
- *    Chunk is not yet scheduled, or dependencies are not met.
+ *    Chunk is not yet requested.
+ *  - [@ref ChunkExecutionState.COM_ES_WAITING]:
+ *    Chunk is requested, but is waiting for input chunks.
  *  - [@ref ChunkExecutionState.COM_ES_SCHEDULED]:
  *    All dependencies are met, chunk is scheduled, but not finished.
  *  - [@ref ChunkExecutionState.COM_ES_EXECUTED]:
@@ -160,6 +163,9 @@ extern "C" {
  * [@ref ExecutionGroup.scheduleAreaWhenPossible]
  * ExecutionGroup B checks what chunks the area spans, and tries to schedule these chunks.
  * If all input data is available these chunks are scheduled [@ref ExecutionGroup.scheduleChunk]
+ * Otherwise the chunk counts the input chunks it is waiting for. Every input chunk that is
+ * finalized [@ref ExecutionGroup.finalizeChunkExecution] decrements this count, when it reaches
+ * zero the waiting chunk is scheduled right away.
  *
  * <pre>
  *
@@ -360,7 +366,7 @@ void COM_deinitialize(void);
  * \brief Clear all compositor caches. (Compositor system will still remain available).
  * To deinitialize the compositor use the COM_deinitialize method.
  */
-// void COM_clearCaches(void); // NOT YET WRITTEN
+void COM_clearCaches(void);
 
 #ifdef __cplusplus
 }
@@ -21,8 +21,6 @@
 #include <sstream>
 #include <stdlib.h>
 
-#include "atomic_ops.h"
-
 #include "COM_ExecutionGroup.h"
 #include "COM_defines.h"
 #include "COM_ExecutionSystem.h"
@@ -36,16 +34,29 @@
 #include "MEM_guardedalloc.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLT_translation.h"
 #include "PIL_time.h"
 #include "WM_api.h"
 #include "WM_types.h"
 
+/* Chunk scheduling state, shared by all ExecutionGroup's. Chunks are requested from the main
+ * thread and finalized from the device threads. Only one node tree is executed at a time, see
+ * COM_execute. */
+static ThreadMutex g_chunkMutex = BLI_MUTEX_INITIALIZER;
+/* Signaled each time a chunk is finalized. */
+static ThreadCondition g_chunkCondition = PTHREAD_COND_INITIALIZER;
+/* Chunks added to the WorkScheduler that are not finalized yet. */
+static unsigned int g_chunksInFlight = 0;
+/* Execution is breaked by the user, waiting chunks will not be scheduled anymore. */
+static bool g_chunksBreaked = false;
+
 ExecutionGroup::ExecutionGroup()
 {
   this->m_isOutput = false;
   this->m_complex = false;
   this->m_chunkExecutionStates = NULL;
+  this->m_chunkWaitCounts = NULL;
   this->m_bTree = NULL;
   this->m_height = 0;
   this->m_width = 0;
@@ -56,6 +67,9 @@ ExecutionGroup::ExecutionGroup()
   this->m_initialized = false;
   this->m_openCL = false;
   this->m_singleThreaded = false;
+  this->m_rowExecution = true;
+  this->m_hasCacheKey = false;
+  this->m_restoredFromCache = false;
   this->m_chunksFinished = 0;
   BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
   this->m_executionStartTime = 0;
@@ -108,6 +122,11 @@ bool ExecutionGroup::addOperation(NodeOperation *operation)
     m_initialized = true;
   }
 
+  if (!operation->isReadBufferOperation() && !operation->isWriteBufferOperation() &&
+      !operation->isSetOperation() && !operation->isRowOperation()) {
+    m_rowExecution = false;
+  }
+
   m_operations.push_back(operation);
 
   return true;
@@ -124,17 +143,26 @@ void ExecutionGroup::initExecution()
   if (this->m_chunkExecutionStates != NULL) {
     MEM_freeN(this->m_chunkExecutionStates);
   }
+  if (this->m_chunkWaitCounts != NULL) {
+    MEM_freeN(this->m_chunkWaitCounts);
+  }
   unsigned int index;
   determineNumberOfChunks();
 
   this->m_chunkExecutionStates = NULL;
+  this->m_chunkWaitCounts = NULL;
+  this->m_chunkDependents.clear();
   if (this->m_numberOfChunks != 0) {
     this->m_chunkExecutionStates = (ChunkExecutionState *)MEM_mallocN(
         sizeof(ChunkExecutionState) * this->m_numberOfChunks, __func__);
     for (index = 0; index < this->m_numberOfChunks; index++) {
       this->m_chunkExecutionStates[index] = COM_ES_NOT_SCHEDULED;
     }
+    this->m_chunkWaitCounts = (unsigned int *)MEM_callocN(
+        sizeof(unsigned int) * this->m_numberOfChunks, __func__);
+    this->m_chunkDependents.resize(this->m_numberOfChunks);
   }
+  g_chunksBreaked = false;
 
   unsigned int maxNumber = 0;
 
@@ -150,12 +178,50 @@ void ExecutionGroup::initExecution()
   this->m_cachedMaxReadBufferOffset = maxNumber;
 }
 
+void ExecutionGroup::restoreFromCache()
+{
+  if (!this->m_hasCacheKey || this->m_numberOfChunks == 0) {
+    return;
+  }
+  WriteBufferOperation *writeOperation = (WriteBufferOperation *)this->getOutputOperation();
+  MemoryBuffer *buffer = writeOperation->getMemoryProxy()->getBuffer();
+  if (!MemoryBufferCache::restore(this->m_cacheKey, buffer)) {
+    return;
+  }
+  for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+    this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+  }
+  this->m_chunksFinished = this->m_numberOfChunks;
+  this->m_restoredFromCache = true;
+}
+
+void ExecutionGroup::storeInCache()
+{
+  if (!this->m_hasCacheKey || this->m_restoredFromCache || this->m_numberOfChunks == 0) {
+    return;
+  }
+  /* only part of the buffer is calculated when no other group needed all of it */
+  for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+    if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+      return;
+    }
+  }
+  WriteBufferOperation *writeOperation = (WriteBufferOperation *)this->getOutputOperation();
+  MemoryBufferCache::store(this->m_cacheKey, writeOperation->getMemoryProxy()->getBuffer());
+}
+
 void ExecutionGroup::deinitExecution()
 {
   if (this->m_chunkExecutionStates != NULL) {
     MEM_freeN(this->m_chunkExecutionStates);
     this->m_chunkExecutionStates = NULL;
   }
+  if (this->m_chunkWaitCounts != NULL) {
+    MEM_freeN(this->m_chunkWaitCounts);
+    this->m_chunkWaitCounts = NULL;
+  }
+  this->m_chunkDependents.clear();
+  this->m_restoredFromCache = false;
   this->m_numberOfChunks = 0;
   this->m_numberOfXChunks = 0;
   this->m_numberOfYChunks = 0;
@@ -202,6 +268,9 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
   if (bTree->test_break && bTree->test_break(bTree->tbh)) {
     return;
   }  /// \note: early break out for blur and preview nodes
+  if (g_chunksBreaked) {
+    return;
+  }  /// \note: an earlier ExecutionGroup was breaked, waiting chunks are left behind
   if (this->m_numberOfChunks == 0) {
     return;
   }  /// \note: early break out
@@ -323,48 +392,60 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
   DebugInfo::graphviz(graph);
 
   bool breaked = false;
-  bool finished = false;
-  unsigned int startIndex = 0;
-  const int maxNumberEvaluated = BLI_system_thread_count() * 2;
-
-  while (!finished && !breaked) {
-    bool startEvaluated = false;
-    finished = true;
-    int numberEvaluated = 0;
-
-    for (index = startIndex;
-         index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated;
-         index++) {
-      chunkNumber = chunkOrder[index];
+  unsigned int nextIndex = 0;
+  unsigned int lastChunksFinished = 0;
+  const unsigned int maxNumberEvaluated = BLI_system_thread_count() * 2;
+
+  /* Keep a window of requested output chunks. Input chunks are scheduled by
+   * finalizeChunkExecution as soon as their own inputs are available, so the device threads
+   * never wait for a whole batch of chunks to finish. */
+  BLI_mutex_lock(&g_chunkMutex);
+  while (this->m_chunksFinished < this->m_numberOfChunks) {
+    ChunkReferences readyChunks;
+    while (nextIndex < this->m_numberOfChunks &&
+           nextIndex - this->m_chunksFinished < maxNumberEvaluated) {
+      chunkNumber = chunkOrder[nextIndex++];
       int yChunk = chunkNumber / this->m_numberOfXChunks;
       int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-      const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-      if (state == COM_ES_NOT_SCHEDULED) {
-        scheduleChunkWhenPossible(graph, xChunk, yChunk);
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-
-        if (bTree->update_draw) {
-          bTree->update_draw(bTree->udh);
-        }
-      }
-      else if (state == COM_ES_SCHEDULED) {
-        finished = false;
-        startEvaluated = true;
-        numberEvaluated++;
-      }
-      else if (state == COM_ES_EXECUTED && !startEvaluated) {
-        startIndex = index + 1;
-      }
+      scheduleChunkWhenPossible(graph, xChunk, yChunk, NULL, &readyChunks);
     }
 
-    WorkScheduler::finish();
+    if (!readyChunks.empty()) {
+      BLI_mutex_unlock(&g_chunkMutex);
+      scheduleChunks(readyChunks);
+      BLI_mutex_lock(&g_chunkMutex);
+      continue;
+    }
 
+    if (this->m_chunksFinished == lastChunksFinished) {
+      BLI_condition_wait(&g_chunkCondition, &g_chunkMutex);
+    }
+    const bool redraw = this->m_chunksFinished != lastChunksFinished;
+    lastChunksFinished = this->m_chunksFinished;
+    BLI_mutex_unlock(&g_chunkMutex);
+
+    if (redraw && bTree->update_draw) {
+      bTree->update_draw(bTree->udh);
+    }
     if (bTree->test_break && bTree->test_break(bTree->tbh)) {
       breaked = true;
     }
+
+    BLI_mutex_lock(&g_chunkMutex);
+    if (breaked) {
+      break;
+    }
   }
+
+  if (breaked) {
+    /* Stop scheduling waiting chunks and let the chunks in flight finish. */
+    g_chunksBreaked = true;
+    while (g_chunksInFlight != 0) {
+      BLI_condition_wait(&g_chunkCondition, &g_chunkMutex);
+    }
+  }
+  BLI_mutex_unlock(&g_chunkMutex);
+
   DebugInfo::execution_group_finished(this);
   DebugInfo::graphviz(graph);
 
@@ -405,11 +486,34 @@ MemoryBuffer *ExecutionGroup::constructConsolidatedMemoryBuffer(MemoryProxy *mem
 
 void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers)
 {
+  ChunkReferences readyChunks;
+  unsigned int chunksFinished;
+
+  BLI_mutex_lock(&g_chunkMutex);
   if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
     this->m_chunkExecutionStates[chunkNumber] = COM_ES_EXECUTED;
   }
 
-  atomic_add_and_fetch_u(&this->m_chunksFinished, 1);
+  /* Schedule the chunks that were only waiting for this chunk. */
+  ChunkReferences &dependents = this->m_chunkDependents[chunkNumber];
+  for (unsigned int index = 0; index < dependents.size(); index++) {
+    ExecutionGroup *group = dependents[index].group;
+    const unsigned int dependentChunk = dependents[index].chunkNumber;
+    BLI_assert(group->m_chunkWaitCounts[dependentChunk] > 0);
+    group->m_chunkWaitCounts[dependentChunk]--;
+    if (group->m_chunkWaitCounts[dependentChunk] == 0 && !g_chunksBreaked) {
+      group->scheduleChunk(dependentChunk, &readyChunks);
+    }
+  }
+  ChunkReferences().swap(dependents);
+
+  g_chunksInFlight--;
+  chunksFinished = ++this->m_chunksFinished;
+  BLI_condition_notify_all(&g_chunkCondition);
+  BLI_mutex_unlock(&g_chunkMutex);
+
+  scheduleChunks(readyChunks);
+
   if (memoryBuffers) {
     for (unsigned int index = 0; index < this->m_cachedMaxReadBufferOffset; index++) {
       MemoryBuffer *buffer = memoryBuffers[index];
@@ -424,7 +528,7 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
   }
   if (this->m_bTree) {
     // status report is only performed for top level Execution Groups.
-    float progress = this->m_chunksFinished;
+    float progress = chunksFinished;
     progress /= this->m_numberOfChunks;
     this->m_bTree->progress(this->m_bTree->prh, progress);
 
@@ -432,7 +536,7 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
     BLI_snprintf(buf,
                  sizeof(buf),
                  TIP_("Compositing | Tile %u-%u"),
-                 this->m_chunksFinished,
+                 chunksFinished,
                  this->m_numberOfChunks);
     this->m_bTree->stats_draw(this->m_bTree->sdh, buf);
   }
@@ -481,10 +585,13 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int /*chunkNumber*/, rcti *re
   return NULL;
 }
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph,
+                                              rcti *area,
+                                              const ChunkReference *dependent,
+                                              ChunkReferences *readyChunks)
 {
   if (this->m_singleThreaded) {
-    return scheduleChunkWhenPossible(graph, 0, 0);
+    return scheduleChunkWhenPossible(graph, 0, 0, dependent, readyChunks);
   }
   // find all chunks inside the rect
   // determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
@@ -506,7 +613,7 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
   bool result = true;
   for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
     for (indexy = minychunk; indexy < maxychunk; indexy++) {
-      if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
+      if (!scheduleChunkWhenPossible(graph, indexx, indexy, dependent, readyChunks)) {
         result = false;
       }
     }
@@ -515,17 +622,26 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
   return result;
 }
 
-bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
+void ExecutionGroup::scheduleChunk(unsigned int chunkNumber, ChunkReferences *readyChunks)
 {
-  if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
-    this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
-    WorkScheduler::schedule(this, chunkNumber);
-    return true;
+  ChunkReference chunk = {this, chunkNumber};
+  this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+  g_chunksInFlight++;
+  readyChunks->push_back(chunk);
+}
+
+void ExecutionGroup::scheduleChunks(const ChunkReferences &chunks)
+{
+  for (unsigned int index = 0; index < chunks.size(); index++) {
+    WorkScheduler::schedule(chunks[index].group, chunks[index].chunkNumber);
   }
-  return false;
 }
 
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph,
+                                               int xChunk,
+                                               int yChunk,
+                                               const ChunkReference *dependent,
+                                               ChunkReferences *readyChunks)
 {
   if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
     return true;
@@ -539,20 +655,28 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
     return true;
   }
 
-  // chunk is scheduled, but not executed
-  if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
+  // the dependent chunk is notified when this chunk is finalized
+  if (dependent) {
+    dependent->group->m_chunkWaitCounts[dependent->chunkNumber]++;
+    this->m_chunkDependents[chunkNumber].push_back(*dependent);
+  }
+
+  // chunk is requested before, but not executed
+  if (this->m_chunkExecutionStates[chunkNumber] != COM_ES_NOT_SCHEDULED) {
     return false;
   }
 
-  // chunk is nor executed nor scheduled.
+  // chunk is nor executed nor requested, request its input chunks.
+  this->m_chunkExecutionStates[chunkNumber] = COM_ES_WAITING;
+
   vector<MemoryProxy *> memoryProxies;
   this->determineDependingMemoryProxies(&memoryProxies);
 
   rcti rect;
   determineChunkRect(&rect, xChunk, yChunk);
   unsigned int index;
-  bool canBeExecuted = true;
   rcti area;
+  ChunkReference chunk = {this, (unsigned int)chunkNumber};
 
   for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
     ReadBufferOperation *readOperation =
@@ -563,17 +687,15 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
     ExecutionGroup *group = memoryProxy->getExecutor();
 
     if (group != NULL) {
-      if (!group->scheduleAreaWhenPossible(graph, &area)) {
-        canBeExecuted = false;
-      }
+      group->scheduleAreaWhenPossible(graph, &area, &chunk, readyChunks);
     }
     else {
       throw "ERROR";
     }
   }
 
-  if (canBeExecuted) {
-    scheduleChunk(chunkNumber);
+  if (this->m_chunkWaitCounts[chunkNumber] == 0) {
+    scheduleChunk(chunkNumber, readyChunks);
   }
 
   return false;
@@ -26,6 +26,7 @@
 #include "COM_MemoryProxy.h"
 #include "COM_Device.h"
 #include "COM_CompositorContext.h"
+#include "COM_MemoryBufferCache.h"
 
 using std::vector;
 
@@ -33,6 +34,7 @@ class ExecutionSystem;
 class MemoryProxy;
 class ReadBufferOperation;
 class Device;
+class ExecutionGroup;
 
 /**
  * \brief the execution state of a chunk in an ExecutionGroup
@@ -51,8 +53,23 @@ typedef enum ChunkExecutionState {
    * \brief chunk is executed.
    */
   COM_ES_EXECUTED = 2,
+  /**
+   * \brief chunk is requested, but is waiting for input chunks to be executed
+   */
+  COM_ES_WAITING = 3,
 } ChunkExecutionState;
 
+/**
+ * \brief reference to a single chunk of an ExecutionGroup
+ * \ingroup Execution
+ */
+typedef struct ChunkReference {
+  ExecutionGroup *group;
+  unsigned int chunkNumber;
+} ChunkReference;
+
+typedef std::vector<ChunkReference> ChunkReferences;
+
 /**
  * \brief Class ExecutionGroup is a group of Operations that are executed as one.
  * This grouping is used to combine Operations that can be executed as one whole when
@@ -124,6 +141,25 @@ class ExecutionGroup {
    */
   bool m_singleThreaded;
 
+  /**
+   * \brief can this ExecutionGroup be calculated a row at a time.
+   * \note true when all operations are row operations, read buffer or set operations.
+   * \see NodeOperation.executeRow
+   */
+  bool m_rowExecution;
+
+  /**
+   * \brief key of the buffer of the MemoryProxy in the MemoryBufferCache.
+   * \note only valid when m_hasCacheKey is set.
+   */
+  MemoryBufferCacheKey m_cacheKey;
+  bool m_hasCacheKey;
+
+  /**
+   * \brief the buffer of the MemoryProxy was copied from the MemoryBufferCache.
+   */
+  bool m_restoredFromCache;
+
   /**
    * \brief what is the maximum number field of all ReadBufferOperation in this ExecutionGroup.
    * \note this is used to construct the MemoryBuffers that will be passed during execution.
@@ -150,11 +186,23 @@ class ExecutionGroup {
   /**
    * \brief the chunkExecutionStates holds per chunk the execution state. this state can be
    *   - COM_ES_NOT_SCHEDULED: not scheduled
+   *   - COM_ES_WAITING: waiting for input chunks
    *   - COM_ES_SCHEDULED: scheduled
    *   - COM_ES_EXECUTED: executed
    */
   ChunkExecutionState *m_chunkExecutionStates;
 
+  /**
+   * \brief number of input chunks a chunk in the COM_ES_WAITING state is still waiting for.
+   * \note when it drops to zero the chunk is scheduled.
+   */
+  unsigned int *m_chunkWaitCounts;
+
+  /**
+   * \brief per chunk the chunks of other ExecutionGroup's that are waiting for it.
+   */
+  vector<ChunkReferences> m_chunkDependents;
+
   /**
    * \brief indicator when this ExecutionGroup has valid Operations in its vector for Execution
    * \note When building the ExecutionGroup Operations are added via recursion.
@@ -207,35 +255,56 @@ class ExecutionGroup {
   void determineNumberOfChunks();
 
   /**
-   * \brief try to schedule a specific chunk.
-   * \note scheduling succeeds when all input requirements are met and the chunks hasn't been
-   * scheduled yet.
+   * \brief request a specific chunk.
+   * \note A chunk that is requested for the first time requests its input chunks. It is
+   * scheduled as soon as the last of them has been executed, see finalizeChunkExecution.
+   * \note Must be called with the chunk scheduling lock held.
    * \param graph:
    * \param xChunk:
    * \param yChunk:
+   * \param dependent: chunk waiting for this chunk, NULL when requested by execute.
+   * \param readyChunks: chunks that can be added to the WorkScheduler. Result
    * \return [true:false]
-   * true: package(s) are scheduled
-   * false: scheduling is deferred (depending workpackages are scheduled)
+   * true: chunk is already executed
+   * false: dependent has to wait for the chunk
    */
-  bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
+  bool scheduleChunkWhenPossible(ExecutionSystem *graph,
+                                 int xChunk,
+                                 int yChunk,
+                                 const ChunkReference *dependent,
+                                 ChunkReferences *readyChunks);
 
   /**
-   * \brief try to schedule a specific area.
-   * \note Check if a certain area is available, when not available this are will be checked.
+   * \brief request a specific area.
+   * \note Requests all chunks the area spans, see scheduleChunkWhenPossible.
    * \note This method is called from other ExecutionGroup's.
    * \param graph:
    * \param rect:
+   * \param dependent: chunk waiting for the area
+   * \param readyChunks: chunks that can be added to the WorkScheduler. Result
    * \return [true:false]
-   * true: package(s) are scheduled
-   * false: scheduling is deferred (depending workpackages are scheduled)
+   * true: all chunks of the area are executed
+   * false: dependent has to wait for chunks of the area
    */
-  bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+  bool scheduleAreaWhenPossible(ExecutionSystem *graph,
+                                rcti *rect,
+                                const ChunkReference *dependent,
+                                ChunkReferences *readyChunks);
 
   /**
-   * \brief add a chunk to the WorkScheduler.
-   * \param chunknumber:
+   * \brief mark a chunk as scheduled.
+   * \note Must be called with the chunk scheduling lock held, the chunk is added to
+   * readyChunks and has to be passed to scheduleChunks after releasing the lock.
+   * \param chunkNumber:
+   * \param readyChunks:
+   */
+  void scheduleChunk(unsigned int chunkNumber, ChunkReferences *readyChunks);
+
+  /**
+   * \brief add chunks to the WorkScheduler.
+   * \note Must be called without holding the chunk scheduling lock.
    */
-  bool scheduleChunk(unsigned int chunkNumber);
+  static void scheduleChunks(const ChunkReferences &chunks);
 
   /**
    * \brief determine the area of interest of a certain input area
@@ -323,6 +392,37 @@ class ExecutionGroup {
     return m_complex;
   }
 
+  /**
+   * \brief can this ExecutionGroup be calculated a row at a time
+   * \see NodeOperation.executeRow
+   */
+  bool isRowExecution() const
+  {
+    return m_rowExecution;
+  }
+
+  /**
+   * \brief set the key of the buffer this ExecutionGroup writes in the MemoryBufferCache
+   */
+  void setCacheKey(const MemoryBufferCacheKey &key)
+  {
+    this->m_cacheKey = key;
+    this->m_hasCacheKey = true;
+  }
+
+  /**
+   * \brief copy the buffer from the MemoryBufferCache when it is cached.
+   * All chunks are marked executed, so the ExecutionGroup and the groups it depends on are
+   * not scheduled.
+   * \note must be called after initExecution
+   */
+  void restoreFromCache();
+
+  /**
+   * \brief add the buffer to the MemoryBufferCache when all chunks have been executed.
+   */
+  void storeInCache();
+
   /**
    * \brief get the output operation of this ExecutionGroup
    * \return NodeOperation *output operation
@@ -389,7 +489,9 @@ class ExecutionGroup {
    *   - CenterX
    *   - CenterY
    *
-   * After determining the order of the chunks the chunks will be scheduled
+   * After determining the order of the chunks the chunks will be requested. A window of
+   * output chunks is kept in flight: a new chunk is requested as soon as one finishes, there
+   * is no barrier between batches of chunks.
    *
    * \see ViewerOperation
    * \param system:
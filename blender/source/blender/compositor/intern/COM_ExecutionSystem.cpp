@@ -30,6 +30,7 @@ extern "C" {
 #include "COM_NodeOperationBuilder.h"
 #include "COM_NodeOperation.h"
 #include "COM_ExecutionGroup.h"
+#include "COM_MemoryBufferCache.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_Debug.h"
@@ -178,6 +179,19 @@ void ExecutionSystem::execute()
     executionGroup->initExecution();
   }
 
+  /* buffers of unchanged parts of the node tree are copied from the previous executions */
+  const bool use_cache = MemoryBufferCache::isEnabled(this->m_context);
+  if (use_cache) {
+    MemoryBufferCache::startExecution();
+    for (index = 0; index < this->m_groups.size(); index++) {
+      this->m_groups[index]->restoreFromCache();
+    }
+  }
+  else {
+    /* don't keep memory allocated while rendering or after disabling the cache */
+    MemoryBufferCache::clear();
+  }
+
   WorkScheduler::start(this->m_context);
 
   executeGroups(COM_PRIORITY_HIGH);
@@ -187,6 +201,13 @@ void ExecutionSystem::execute()
   }
 
   WorkScheduler::finish();
+
+  if (use_cache && !editingtree->test_break(editingtree->tbh)) {
+    for (index = 0; index < this->m_groups.size(); index++) {
+      this->m_groups[index]->storeInCache();
+    }
+  }
+
   WorkScheduler::stop();
 
   editingtree->stats_draw(editingtree->sdh, TIP_("Compositing | De-initializing execution"));
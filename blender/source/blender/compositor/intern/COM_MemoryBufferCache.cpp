@@ -0,0 +1,406 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2019, Blender Foundation.
+ */
+
+#include <map>
+#include <string.h>
+
+#include "COM_MemoryBufferCache.h"
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_Node.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_fileops.h"
+#include "BLI_hash_md5.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_color_types.h"
+#include "DNA_image_types.h"
+#include "DNA_node_types.h"
+#include "DNA_packedFile_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BKE_image.h"
+#include "BKE_node.h"
+
+#include "RE_pipeline.h"
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Keys
+ * \{ */
+
+void MemoryBufferCacheKeyBuilder::add(const void *data, size_t size)
+{
+  const char *bytes = (const char *)data;
+  m_data.insert(m_data.end(), bytes, bytes + size);
+}
+
+void MemoryBufferCacheKeyBuilder::addString(const char *str)
+{
+  /* include the terminator, so consecutive strings can't be confused */
+  add(str, strlen(str) + 1);
+}
+
+void MemoryBufferCacheKeyBuilder::addKey(const MemoryBufferCacheKey &key)
+{
+  add(key.digest, sizeof(key.digest));
+}
+
+void MemoryBufferCacheKeyBuilder::addContext(const CompositorContext &context)
+{
+  add(context.getFramenumber());
+  add((int)context.getQuality());
+  add(context.isFastCalculation());
+  add(context.getHasActiveOpenCLDevices());
+  add(context.getScene());
+  addString(context.getViewName() ? context.getViewName() : "");
+
+  const RenderData *rd = context.getRenderData();
+  if (rd) {
+    add(rd->xsch);
+    add(rd->ysch);
+    add(rd->size);
+    add(rd->xasp);
+    add(rd->yasp);
+    add(rd->mode);
+    add(rd->scemode);
+    add(rd->border.xmin);
+    add(rd->border.xmax);
+    add(rd->border.ymin);
+    add(rd->border.ymax);
+  }
+
+  const ColorManagedViewSettings *view_settings = context.getViewSettings();
+  if (view_settings) {
+    add(view_settings->flag);
+    addString(view_settings->look);
+    addString(view_settings->view_transform);
+    add(view_settings->exposure);
+    add(view_settings->gamma);
+  }
+  const ColorManagedDisplaySettings *display_settings = context.getDisplaySettings();
+  if (display_settings) {
+    addString(display_settings->display_device);
+  }
+}
+
+/* Curve mappings contain pointers to the curve points and tables that are recalculated. */
+static void key_add_curve_mapping(MemoryBufferCacheKeyBuilder &builder,
+                                  const CurveMapping *cumap)
+{
+  builder.add(cumap->flag);
+  builder.add(cumap->preset);
+  builder.add(cumap->clipr);
+  for (int i = 0; i < 3; i++) {
+    builder.add(cumap->black[i]);
+    builder.add(cumap->white[i]);
+  }
+  builder.add(cumap->tone);
+  for (int i = 0; i < CM_TOT; i++) {
+    const CurveMap *cuma = &cumap->cm[i];
+    builder.add(cuma->totpoint);
+    builder.add(cuma->flag);
+    builder.add(cuma->ext_in);
+    builder.add(cuma->ext_out);
+    for (int a = 0; a < cuma->totpoint; a++) {
+      builder.add(cuma->curve[a].x);
+      builder.add(cuma->curve[a].y);
+      builder.add((short)(cuma->curve[a].flag & ~CUMA_SELECT));
+    }
+  }
+}
+
+static void key_add_storage(MemoryBufferCacheKeyBuilder &builder,
+                            const char *storagename,
+                            const void *storage)
+{
+  if (STREQ(storagename, "CurveMapping")) {
+    key_add_curve_mapping(builder, (const CurveMapping *)storage);
+  }
+  else if (STREQ(storagename, "NodeCryptomatte")) {
+    const NodeCryptomatte *data = (const NodeCryptomatte *)storage;
+    builder.add(data->add);
+    builder.add(data->remove);
+    builder.add(data->num_inputs);
+    builder.addString(data->matte_id ? data->matte_id : "");
+  }
+  else {
+    /* storage without pointers, or pointers that are only set when the node is created */
+    builder.add(storage, MEM_allocN_len(storage));
+  }
+}
+
+static void key_add_socket(MemoryBufferCacheKeyBuilder &builder, const bNodeSocket *b_socket)
+{
+  if (b_socket == NULL) {
+    return;
+  }
+  builder.addString(b_socket->identifier);
+  if (b_socket->default_value) {
+    builder.add(b_socket->default_value, MEM_allocN_len(b_socket->default_value));
+  }
+  if (b_socket->storage) {
+    builder.add(b_socket->storage, MEM_allocN_len(b_socket->storage));
+  }
+}
+
+/* Images which are only read from disk, so the buffers don't change when the file doesn't. */
+static bool key_add_image(MemoryBufferCacheKeyBuilder &builder, Image *ima, ImageUser *iuser)
+{
+  if (!ELEM(ima->source, IMA_SRC_FILE, IMA_SRC_SEQUENCE, IMA_SRC_MOVIE, IMA_SRC_GENERATED) ||
+      !ELEM(ima->type, IMA_TYPE_IMAGE, IMA_TYPE_MULTILAYER, IMA_TYPE_UV_TEST)) {
+    return false;
+  }
+  /* painted */
+  if (BKE_image_is_dirty(ima)) {
+    return false;
+  }
+
+  builder.add(ima->flag);
+  builder.add(ima->source);
+  builder.add(ima->type);
+  builder.add(ima->gen_x);
+  builder.add(ima->gen_y);
+  builder.add(ima->gen_type);
+  builder.add(ima->gen_flag);
+  builder.add(ima->gen_depth);
+  builder.add(ima->gen_color);
+  builder.add(ima->alpha_mode);
+  builder.add(ima->views_format);
+  builder.addString(ima->colorspace_settings.name);
+
+  if (ima->source == IMA_SRC_GENERATED) {
+    return true;
+  }
+
+  if (BKE_image_has_packedfile(ima)) {
+    LISTBASE_FOREACH (ImagePackedFile *, imapf, &ima->packedfiles) {
+      const PackedFile *pf = imapf->packedfile;
+      unsigned char digest[16];
+      BLI_hash_md5_buffer((const char *)pf->data, (size_t)pf->size, digest);
+      builder.addString(imapf->filepath);
+      builder.add(pf->size);
+      builder.add(digest);
+    }
+    return true;
+  }
+
+  /* the file of the frame and view is needed */
+  if (iuser == NULL) {
+    return false;
+  }
+
+  /* also saved after painting or changed by another program */
+  char filepath[FILE_MAX];
+  BLI_stat_t st;
+  BKE_image_user_file_path(iuser, ima, filepath);
+  builder.addString(filepath);
+  if (BLI_stat(filepath, &st) == 0) {
+    builder.add(st.st_mtime);
+    builder.add(st.st_size);
+  }
+  return true;
+}
+
+/* Render results change without the node changing, use the time of the render. */
+static void key_add_render_result(MemoryBufferCacheKeyBuilder &builder, Scene *scene)
+{
+  Render *re = RE_GetSceneRender(scene);
+  builder.add(scene);
+  builder.add(re);
+  if (re) {
+    RenderResult *rr = RE_AcquireResultRead(re);
+    RenderStats *stats = RE_GetStats(re);
+    builder.add(rr);
+    builder.add(stats->starttime);
+    builder.add(stats->lastframetime);
+    RE_ReleaseResult(re);
+  }
+}
+
+bool MemoryBufferCacheKeyBuilder::addNode(const Node *node)
+{
+  bNode *b_node = node->getbNode();
+
+  add(b_node->type);
+  add(b_node->custom1);
+  add(b_node->custom2);
+  add(b_node->custom3);
+  add(b_node->custom4);
+  if (b_node->storage) {
+    key_add_storage(*this, b_node->typeinfo->storagename, b_node->storage);
+  }
+
+  /* nodes create different operations for linked inputs */
+  for (unsigned int index = 0; index < node->getNumberOfInputSockets(); index++) {
+    NodeInput *input = node->getInputSocket(index);
+    add(input->isLinked());
+    key_add_socket(*this, input->getbNodeSocket());
+  }
+  for (unsigned int index = 0; index < node->getNumberOfOutputSockets(); index++) {
+    key_add_socket(*this, node->getOutputSocket(index)->getbNodeSocket());
+  }
+
+  switch (b_node->type) {
+    case CMP_NODE_IMAGE:
+      return (b_node->id == NULL) ||
+             key_add_image(*this, (Image *)b_node->id, (ImageUser *)b_node->storage);
+    case CMP_NODE_R_LAYERS:
+      if (b_node->id) {
+        key_add_render_result(*this, (Scene *)b_node->id);
+      }
+      return true;
+    case CMP_NODE_DEFOCUS:
+      /* reads the camera of the scene */
+      return false;
+    default:
+      /* movie clips, masks, textures, ... */
+      return b_node->id == NULL;
+  }
+}
+
+MemoryBufferCacheKey MemoryBufferCacheKeyBuilder::finish() const
+{
+  MemoryBufferCacheKey key;
+  BLI_hash_md5_buffer(m_data.data(), m_data.size(), key.digest);
+  return key;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache
+ * \{ */
+
+typedef struct MemoryBufferCacheEntry {
+  float *buffer;
+  int width;
+  int height;
+  unsigned int num_channels;
+  size_t size;
+  /** Execution in which the entry was used last. */
+  unsigned int lastused;
+} MemoryBufferCacheEntry;
+
+struct MemoryBufferCacheKeyLess {
+  bool operator()(const MemoryBufferCacheKey &a, const MemoryBufferCacheKey &b) const
+  {
+    return memcmp(a.digest, b.digest, sizeof(a.digest)) < 0;
+  }
+};
+
+typedef std::map<MemoryBufferCacheKey, MemoryBufferCacheEntry, MemoryBufferCacheKeyLess>
+    MemoryBufferCacheEntries;
+
+static MemoryBufferCacheEntries g_entries;
+static size_t g_size = 0;
+static unsigned int g_clock = 0;
+
+static size_t cache_limit()
+{
+  return (size_t)max_ii(U.compositor_cache_limit, 0) * 1024 * 1024;
+}
+
+static void cache_remove(MemoryBufferCacheEntries::iterator it)
+{
+  MEM_freeN(it->second.buffer);
+  g_size -= it->second.size;
+  g_entries.erase(it);
+}
+
+static void cache_limit_to(size_t limit)
+{
+  while (g_size > limit) {
+    MemoryBufferCacheEntries::iterator oldest = g_entries.begin();
+    for (MemoryBufferCacheEntries::iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+      if (it->second.lastused < oldest->second.lastused) {
+        oldest = it;
+      }
+    }
+    cache_remove(oldest);
+  }
+}
+
+bool MemoryBufferCache::isEnabled(const CompositorContext &context)
+{
+  return !context.isRendering() && U.compositor_cache_limit > 0;
+}
+
+bool MemoryBufferCache::restore(const MemoryBufferCacheKey &key, MemoryBuffer *buffer)
+{
+  MemoryBufferCacheEntries::iterator it = g_entries.find(key);
+  if (it == g_entries.end()) {
+    return false;
+  }
+  MemoryBufferCacheEntry &entry = it->second;
+  if (entry.width != buffer->getWidth() || entry.height != buffer->getHeight() ||
+      entry.num_channels != buffer->get_num_channels()) {
+    return false;
+  }
+  memcpy(buffer->getBuffer(), entry.buffer, entry.size);
+  buffer->setCreatedState();
+  entry.lastused = g_clock;
+  return true;
+}
+
+void MemoryBufferCache::store(const MemoryBufferCacheKey &key, MemoryBuffer *buffer)
+{
+  const size_t size = sizeof(float) * buffer->getWidth() * buffer->getHeight() *
+                      buffer->get_num_channels();
+  const size_t limit = cache_limit();
+  if (size > limit) {
+    return;
+  }
+
+  MemoryBufferCacheEntries::iterator it = g_entries.find(key);
+  if (it != g_entries.end()) {
+    cache_remove(it);
+  }
+  cache_limit_to(limit - size);
+
+  MemoryBufferCacheEntry entry;
+  entry.buffer = (float *)MEM_mallocN(size, "COM_MemoryBufferCache");
+  entry.width = buffer->getWidth();
+  entry.height = buffer->getHeight();
+  entry.num_channels = buffer->get_num_channels();
+  entry.size = size;
+  entry.lastused = g_clock;
+  memcpy(entry.buffer, buffer->getBuffer(), size);
+
+  g_entries[key] = entry;
+  g_size += size;
+}
+
+void MemoryBufferCache::startExecution()
+{
+  g_clock++;
+  cache_limit_to(cache_limit());
+}
+
+void MemoryBufferCache::clear()
+{
+  cache_limit_to(0);
+}
+
+/** \} */
@@ -0,0 +1,113 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2019, Blender Foundation.
+ */
+
+#ifndef __COM_MEMORYBUFFERCACHE_H__
+#define __COM_MEMORYBUFFERCACHE_H__
+
+#include <vector>
+
+class CompositorContext;
+class MemoryBuffer;
+class Node;
+
+/**
+ * \brief key of a MemoryBuffer in the MemoryBufferCache.
+ * MD5 digest of everything the content of the buffer depends on: the settings of the nodes and
+ * operations that calculate it, the resolutions and the CompositorContext.
+ * \ingroup Memory
+ */
+typedef struct MemoryBufferCacheKey {
+  unsigned char digest[16];
+} MemoryBufferCacheKey;
+
+/**
+ * \brief collects the data of a MemoryBufferCacheKey.
+ * \ingroup Memory
+ */
+class MemoryBufferCacheKeyBuilder {
+ private:
+  std::vector<char> m_data;
+
+ public:
+  void add(const void *data, size_t size);
+  template<typename T> void add(const T &value)
+  {
+    add(&value, sizeof(value));
+  }
+  void addString(const char *str);
+  void addKey(const MemoryBufferCacheKey &key);
+
+  /**
+   * \brief add the settings of the CompositorContext that operations can read.
+   */
+  void addContext(const CompositorContext &context);
+
+  /**
+   * \brief add the settings of a node that are used to create its operations.
+   * \return false when the node reads data that can change without the node changing
+   * (movie clips, masks, textures, ...). Buffers depending on such a node are not cached.
+   */
+  bool addNode(const Node *node);
+
+  MemoryBufferCacheKey finish() const;
+};
+
+/**
+ * \brief keeps the buffers of the memory proxies between executions of the compositor.
+ *
+ * When a node tree is edited only the buffers downstream of the changed node get a different
+ * key. The other buffers are copied from the cache and the execution groups that calculate
+ * them are not scheduled.
+ *
+ * The cache is only used for editing, the memory is limited by UserDef.compositor_cache_limit
+ * and the least recently used buffers are removed first.
+ * \note only one node tree is executed at the same time, see COM_execute.
+ * \ingroup Memory
+ */
+class MemoryBufferCache {
+ public:
+  /**
+   * \brief is the cache used for the execution of the context.
+   */
+  static bool isEnabled(const CompositorContext &context);
+
+  /**
+   * \brief copy the cached content of key into buffer.
+   * \return true when the key was found with the same size as the buffer.
+   */
+  static bool restore(const MemoryBufferCacheKey &key, MemoryBuffer *buffer);
+
+  /**
+   * \brief add a copy of buffer to the cache, removing old buffers to stay in the limit.
+   */
+  static void store(const MemoryBufferCacheKey &key, MemoryBuffer *buffer);
+
+  /**
+   * \brief called before the buffers of an execution are restored and stored.
+   * Removes the least recently used buffers until the cache is in its limit again,
+   * the limit can have been changed in the preferences.
+   */
+  static void startExecution();
+
+  /**
+   * \brief remove all buffers.
+   */
+  static void clear();
+};
+
+#endif /* __COM_MEMORYBUFFERCACHE_H__ */
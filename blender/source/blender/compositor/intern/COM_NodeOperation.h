@@ -105,6 +105,12 @@ class NodeOperation : public SocketReader {
    */
   bool m_openCL;
 
+  /**
+   * \brief can this operation calculate a whole row of pixels at once.
+   * \see NodeOperation.executeRow
+   */
+  bool m_rowOperation;
+
   /**
    * \brief mutex reference for very special node initializations
    * \note only use when you really know what you are doing.
@@ -346,6 +352,33 @@ class NodeOperation : public SocketReader {
     return this->m_openCL;
   }
 
+  /**
+   * \brief can this NodeOperation calculate a whole row of pixels at once
+   * \see NodeOperation.executeRow
+   * \see ExecutionGroup.addOperation
+   */
+  bool isRowOperation() const
+  {
+    return this->m_rowOperation;
+  }
+
+  /**
+   * \brief calculate a row of pixels at once.
+   *
+   * Used instead of the per pixel readSampled calls when every operation of an ExecutionGroup
+   * is a row operation. Row operations only read their inputs at the position of the pixel
+   * being calculated, so the position itself is not passed.
+   * Pixels are packed with the number of channels of the socket data type
+   * (1 for values, 3 for vectors and 4 for colors).
+   * \param output: the calculated row of width pixels of the output socket data type.
+   * \param inputs: per input socket a row of width pixels of the socket data type.
+   * \param width: number of pixels in the row.
+   * \see WriteBufferOperation.executeRegion
+   */
+  virtual void executeRow(float * /*output*/, float ** /*inputs*/, int /*width*/)
+  {
+  }
+
   virtual bool isViewerOperation() const
   {
     return false;
@@ -423,6 +456,14 @@ class NodeOperation : public SocketReader {
     this->m_openCL = openCL;
   }
 
+  /**
+   * \brief set if this NodeOperation implements executeRow
+   */
+  void setRowOperation(bool rowOperation)
+  {
+    this->m_rowOperation = rowOperation;
+  }
+
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
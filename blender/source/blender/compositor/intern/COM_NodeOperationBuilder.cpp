@@ -16,6 +16,8 @@
  * Copyright 2013, Blender Foundation.
  */
 
+#include <typeinfo>
+
 extern "C" {
 #include "BLI_utildefines.h"
 }
@@ -40,7 +42,10 @@ extern "C" {
 #include "COM_NodeOperationBuilder.h" /* own include */
 
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree)
-    : m_context(context), m_current_node(NULL), m_active_viewer(NULL)
+    : m_context(context),
+      m_current_node(NULL),
+      m_current_node_operations(0),
+      m_active_viewer(NULL)
 {
   m_graph.from_bNodeTree(*context, b_nodetree);
 }
@@ -58,6 +63,7 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
     Node *node = (Node *)m_graph.nodes()[index];
 
     m_current_node = node;
+    m_current_node_operations = 0;
 
     DebugInfo::node_to_operations(node);
     node->convertToOperations(converter, *m_context);
@@ -121,6 +127,11 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
   /* create execution groups */
   group_operations();
 
+  /* identify buffers that can be reused from previous executions */
+  if (MemoryBufferCache::isEnabled(*m_context)) {
+    determine_cache_keys();
+  }
+
   /* transfer resulting operations to the system */
   system->set_operations(m_operations, m_groups);
 }
@@ -128,6 +139,10 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
   m_operations.push_back(operation);
+
+  if (m_current_node) {
+    m_operation_origins[operation] = OperationOrigin(m_current_node, m_current_node_operations++);
+  }
 }
 
 void NodeOperationBuilder::mapInputSocket(NodeInput *node_socket,
@@ -644,6 +659,7 @@ void NodeOperationBuilder::prune_operations()
       reachable_ops.push_back(op);
     }
     else {
+      m_operation_origins.erase(op);
       delete op;
     }
   }
@@ -731,9 +747,106 @@ void NodeOperationBuilder::group_operations()
       MemoryProxy *memproxy = read_op->getMemoryProxy();
 
       if (memproxy->getExecutor() == NULL) {
-        ExecutionGroup *group = make_group(memproxy->getWriteBufferOperation());
+        WriteBufferOperation *write_op = memproxy->getWriteBufferOperation();
+        ExecutionGroup *group = make_group(write_op);
         memproxy->setExecutor(group);
+        /* calculate whole rows when all operations of the group support it */
+        write_op->setRowExecution(group->isRowExecution());
       }
     }
   }
 }
+
+bool NodeOperationBuilder::determine_cache_key(NodeOperation *op,
+                                               const NodeCacheKeyMap &node_keys,
+                                               OperationCacheKeyMap &keys,
+                                               OperationSet &uncached,
+                                               MemoryBufferCacheKey *r_key) const
+{
+  OperationCacheKeyMap::const_iterator it_key = keys.find(op);
+  if (it_key != keys.end()) {
+    *r_key = it_key->second;
+    return true;
+  }
+  if (uncached.find(op) != uncached.end()) {
+    return false;
+  }
+
+  MemoryBufferCacheKeyBuilder builder;
+  builder.addString(typeid(*op).name());
+  builder.add(op->getWidth());
+  builder.add(op->getHeight());
+  builder.addContext(*m_context);
+
+  /* operations added by nodes get their settings from the node,
+   * the other operations are conversions and buffers added by the builder */
+  bool valid = true;
+  OperationOriginMap::const_iterator it_origin = m_operation_origins.find(op);
+  if (it_origin != m_operation_origins.end()) {
+    NodeCacheKeyMap::const_iterator it_node = node_keys.find(it_origin->second.first);
+    if (it_node != node_keys.end()) {
+      builder.addKey(it_node->second);
+      builder.add(it_origin->second.second);
+    }
+    else {
+      valid = false;
+    }
+  }
+
+  if (op->isSetOperation()) {
+    float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    op->readSampled(value, 0.0f, 0.0f, COM_PS_NEAREST);
+    builder.add(value);
+  }
+
+  MemoryBufferCacheKey input_key;
+  if (valid && op->isReadBufferOperation()) {
+    ReadBufferOperation *read_op = (ReadBufferOperation *)op;
+    WriteBufferOperation *write_op = read_op->getMemoryProxy()->getWriteBufferOperation();
+    valid = determine_cache_key(write_op, node_keys, keys, uncached, &input_key);
+    builder.addKey(input_key);
+  }
+  for (int k = 0; valid && k < op->getNumberOfInputSockets(); ++k) {
+    NodeOperationInput *input = op->getInputSocket(k);
+    builder.add(input->isConnected());
+    if (input->isConnected()) {
+      NodeOperation *input_op = &input->getLink()->getOperation();
+      valid = determine_cache_key(input_op, node_keys, keys, uncached, &input_key);
+      builder.addKey(input_key);
+    }
+  }
+
+  if (!valid) {
+    uncached.insert(op);
+    return false;
+  }
+  *r_key = builder.finish();
+  keys[op] = *r_key;
+  return true;
+}
+
+void NodeOperationBuilder::determine_cache_keys()
+{
+  /* nodes reading data that can change without the node tree changing have no key */
+  NodeCacheKeyMap node_keys;
+  for (int index = 0; index < m_graph.nodes().size(); index++) {
+    Node *node = (Node *)m_graph.nodes()[index];
+    MemoryBufferCacheKeyBuilder builder;
+    if (builder.addNode(node)) {
+      node_keys[node] = builder.finish();
+    }
+  }
+
+  OperationCacheKeyMap keys;
+  OperationSet uncached;
+  for (Groups::const_iterator it = m_groups.begin(); it != m_groups.end(); ++it) {
+    ExecutionGroup *group = *it;
+    MemoryBufferCacheKey key;
+
+    /* only the buffers of memory proxies are kept */
+    if (!group->isOutputExecutionGroup() &&
+        determine_cache_key(group->getOutputOperation(), node_keys, keys, uncached, &key)) {
+      group->setCacheKey(key);
+    }
+  }
+}
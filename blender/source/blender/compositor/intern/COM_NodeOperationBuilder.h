@@ -23,6 +23,7 @@
 #include <set>
 #include <vector>
 
+#include "COM_MemoryBufferCache.h"
 #include "COM_NodeGraph.h"
 
 using std::vector;
@@ -75,6 +76,14 @@ class NodeOperationBuilder {
   typedef std::vector<NodeOperationInput *> OpInputs;
   typedef std::map<NodeInput *, OpInputs> OpInputInverseMap;
 
+  /** Node that added an operation and the index of the operation in the node's operations */
+  typedef std::pair<Node *, int> OperationOrigin;
+  typedef std::map<NodeOperation *, OperationOrigin> OperationOriginMap;
+
+  typedef std::map<const Node *, MemoryBufferCacheKey> NodeCacheKeyMap;
+  typedef std::map<NodeOperation *, MemoryBufferCacheKey> OperationCacheKeyMap;
+  typedef std::set<NodeOperation *> OperationSet;
+
  private:
   const CompositorContext *m_context;
   NodeGraph m_graph;
@@ -89,6 +98,11 @@ class NodeOperationBuilder {
   OutputSocketMap m_output_map;
 
   Node *m_current_node;
+  /** Number of operations added by the current node */
+  int m_current_node_operations;
+
+  /** Maps operations to the nodes that added them */
+  OperationOriginMap m_operation_origins;
 
   /** Operation that will be writing to the viewer image
    *  Only one operation can occupy this place at a time,
@@ -169,6 +183,14 @@ class NodeOperationBuilder {
   void group_operations();
   ExecutionGroup *make_group(NodeOperation *op);
 
+  /** Set the MemoryBufferCache keys of the memory proxy groups */
+  void determine_cache_keys();
+  bool determine_cache_key(NodeOperation *op,
+                           const NodeCacheKeyMap &node_keys,
+                           OperationCacheKeyMap &keys,
+                           OperationSet &uncached,
+                           MemoryBufferCacheKey *r_key) const;
+
  private:
   PreviewOperation *make_preview_operation() const;
 
@@ -0,0 +1,192 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2019, Blender Foundation.
+ */
+
+#ifndef __COM_ROWVECTOR_H__
+#define __COM_ROWVECTOR_H__
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#else
+#  include <math.h>
+#endif
+
+/**
+ * \brief four floats processed at once by the row kernels of the operations.
+ * Either a single color or four consecutive values.
+ * \see NodeOperation.executeRow
+ * \ingroup Execution
+ */
+#ifdef __SSE2__
+typedef __m128 RowVector;
+#else
+typedef struct RowVector {
+  float v[4];
+} RowVector;
+#endif
+
+/* The comparisons follow the scalar code of the operations, so NaN values give the same result
+ * in both execution modes. */
+
+#ifdef __SSE2__
+
+inline RowVector rowvector_load(const float *p)
+{
+  return _mm_loadu_ps(p);
+}
+
+inline void rowvector_store(float *p, RowVector a)
+{
+  _mm_storeu_ps(p, a);
+}
+
+inline RowVector rowvector_set1(float f)
+{
+  return _mm_set1_ps(f);
+}
+
+inline RowVector rowvector_add(RowVector a, RowVector b)
+{
+  return _mm_add_ps(a, b);
+}
+
+inline RowVector rowvector_sub(RowVector a, RowVector b)
+{
+  return _mm_sub_ps(a, b);
+}
+
+inline RowVector rowvector_mul(RowVector a, RowVector b)
+{
+  return _mm_mul_ps(a, b);
+}
+
+/* a / b, zero where b is zero. */
+inline RowVector rowvector_div_safe(RowVector a, RowVector b)
+{
+  return _mm_andnot_ps(_mm_cmpeq_ps(b, _mm_setzero_ps()), _mm_div_ps(a, b));
+}
+
+/* a < b ? a : b */
+inline RowVector rowvector_min(RowVector a, RowVector b)
+{
+  return _mm_min_ps(a, b);
+}
+
+/* a > b ? a : b */
+inline RowVector rowvector_max(RowVector a, RowVector b)
+{
+  return _mm_max_ps(a, b);
+}
+
+inline RowVector rowvector_abs(RowVector a)
+{
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+
+/* a < b ? 1.0f : 0.0f */
+inline RowVector rowvector_less(RowVector a, RowVector b)
+{
+  return _mm_and_ps(_mm_cmplt_ps(a, b), _mm_set1_ps(1.0f));
+}
+
+/* Same as CLAMP(a, 0.0f, 1.0f), NaN is passed through. */
+inline RowVector rowvector_clamp01(RowVector a)
+{
+  return _mm_max_ps(_mm_setzero_ps(), _mm_min_ps(_mm_set1_ps(1.0f), a));
+}
+
+#else /* __SSE2__ */
+
+inline RowVector rowvector_load(const float *p)
+{
+  RowVector r = {{p[0], p[1], p[2], p[3]}};
+  return r;
+}
+
+inline void rowvector_store(float *p, RowVector a)
+{
+  p[0] = a.v[0];
+  p[1] = a.v[1];
+  p[2] = a.v[2];
+  p[3] = a.v[3];
+}
+
+inline RowVector rowvector_set1(float f)
+{
+  RowVector r = {{f, f, f, f}};
+  return r;
+}
+
+#  define ROWVECTOR_OP(a, b, expr) \
+    RowVector r; \
+    for (int i = 0; i < 4; i++) { \
+      const float x = a.v[i], y = b.v[i]; \
+      (void)y; \
+      r.v[i] = (expr); \
+    } \
+    return r
+
+inline RowVector rowvector_add(RowVector a, RowVector b)
+{
+  ROWVECTOR_OP(a, b, x + y);
+}
+
+inline RowVector rowvector_sub(RowVector a, RowVector b)
+{
+  ROWVECTOR_OP(a, b, x - y);
+}
+
+inline RowVector rowvector_mul(RowVector a, RowVector b)
+{
+  ROWVECTOR_OP(a, b, x * y);
+}
+
+inline RowVector rowvector_div_safe(RowVector a, RowVector b)
+{
+  ROWVECTOR_OP(a, b, (y == 0.0f) ? 0.0f : x / y);
+}
+
+inline RowVector rowvector_min(RowVector a, RowVector b)
+{
+  ROWVECTOR_OP(a, b, (x < y) ? x : y);
+}
+
+inline RowVector rowvector_max(RowVector a, RowVector b)
+{
+  ROWVECTOR_OP(a, b, (x > y) ? x : y);
+}
+
+inline RowVector rowvector_abs(RowVector a)
+{
+  ROWVECTOR_OP(a, a, fabsf(x));
+}
+
+inline RowVector rowvector_less(RowVector a, RowVector b)
+{
+  ROWVECTOR_OP(a, b, (x < y) ? 1.0f : 0.0f);
+}
+
+inline RowVector rowvector_clamp01(RowVector a)
+{
+  ROWVECTOR_OP(a, a, (x < 0.0f) ? 0.0f : ((x > 1.0f) ? 1.0f : x));
+}
+
+#  undef ROWVECTOR_OP
+
+#endif /* __SSE2__ */
+
+#endif
@@ -43,6 +43,7 @@ ConvertValueToColorOperation::ConvertValueToColorOperation() : ConvertBaseOperat
 {
   this->addInputSocket(COM_DT_VALUE);
   this->addOutputSocket(COM_DT_COLOR);
+  this->setRowOperation(true);
 }
 
 void ConvertValueToColorOperation::executePixelSampled(float output[4],
@@ -56,12 +57,22 @@ void ConvertValueToColorOperation::executePixelSampled(float output[4],
   output[3] = 1.0f;
 }
 
+void ConvertValueToColorOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputValue = inputs[0];
+  for (int index = 0; index < width; index++, output += 4) {
+    output[0] = output[1] = output[2] = inputValue[index];
+    output[3] = 1.0f;
+  }
+}
+
 /* ******** Color to Value ******** */
 
 ConvertColorToValueOperation::ConvertColorToValueOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_VALUE);
+  this->setRowOperation(true);
 }
 
 void ConvertColorToValueOperation::executePixelSampled(float output[4],
@@ -74,12 +85,21 @@ void ConvertColorToValueOperation::executePixelSampled(float output[4],
   output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputColor = inputs[0];
+  for (int index = 0; index < width; index++, inputColor += 4) {
+    output[index] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
+  }
+}
+
 /* ******** Color to BW ******** */
 
 ConvertColorToBWOperation::ConvertColorToBWOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_VALUE);
+  this->setRowOperation(true);
 }
 
 void ConvertColorToBWOperation::executePixelSampled(float output[4],
@@ -92,12 +112,21 @@ void ConvertColorToBWOperation::executePixelSampled(float output[4],
   output[0] = IMB_colormanagement_get_luminance(inputColor);
 }
 
+void ConvertColorToBWOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputColor = inputs[0];
+  for (int index = 0; index < width; index++, inputColor += 4) {
+    output[index] = IMB_colormanagement_get_luminance(inputColor);
+  }
+}
+
 /* ******** Color to Vector ******** */
 
 ConvertColorToVectorOperation::ConvertColorToVectorOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_VECTOR);
+  this->setRowOperation(true);
 }
 
 void ConvertColorToVectorOperation::executePixelSampled(float output[4],
@@ -110,12 +139,21 @@ void ConvertColorToVectorOperation::executePixelSampled(float output[4],
   copy_v3_v3(output, color);
 }
 
+void ConvertColorToVectorOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputColor = inputs[0];
+  for (int index = 0; index < width; index++, output += 3, inputColor += 4) {
+    copy_v3_v3(output, inputColor);
+  }
+}
+
 /* ******** Value to Vector ******** */
 
 ConvertValueToVectorOperation::ConvertValueToVectorOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_VALUE);
   this->addOutputSocket(COM_DT_VECTOR);
+  this->setRowOperation(true);
 }
 
 void ConvertValueToVectorOperation::executePixelSampled(float output[4],
@@ -128,12 +166,21 @@ void ConvertValueToVectorOperation::executePixelSampled(float output[4],
   output[0] = output[1] = output[2] = value;
 }
 
+void ConvertValueToVectorOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputValue = inputs[0];
+  for (int index = 0; index < width; index++, output += 3) {
+    output[0] = output[1] = output[2] = inputValue[index];
+  }
+}
+
 /* ******** Vector to Color ******** */
 
 ConvertVectorToColorOperation::ConvertVectorToColorOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_VECTOR);
   this->addOutputSocket(COM_DT_COLOR);
+  this->setRowOperation(true);
 }
 
 void ConvertVectorToColorOperation::executePixelSampled(float output[4],
@@ -145,12 +192,22 @@ void ConvertVectorToColorOperation::executePixelSampled(float output[4],
   output[3] = 1.0f;
 }
 
+void ConvertVectorToColorOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputVector = inputs[0];
+  for (int index = 0; index < width; index++, output += 4, inputVector += 3) {
+    copy_v3_v3(output, inputVector);
+    output[3] = 1.0f;
+  }
+}
+
 /* ******** Vector to Value ******** */
 
 ConvertVectorToValueOperation::ConvertVectorToValueOperation() : ConvertBaseOperation()
 {
   this->addInputSocket(COM_DT_VECTOR);
   this->addOutputSocket(COM_DT_VALUE);
+  this->setRowOperation(true);
 }
 
 void ConvertVectorToValueOperation::executePixelSampled(float output[4],
@@ -163,6 +220,14 @@ void ConvertVectorToValueOperation::executePixelSampled(float output[4],
   output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
+void ConvertVectorToValueOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputVector = inputs[0];
+  for (int index = 0; index < width; index++, inputVector += 3) {
+    output[index] = (inputVector[0] + inputVector[1] + inputVector[2]) / 3.0f;
+  }
+}
+
 /* ******** RGB to YCC ******** */
 
 ConvertRGBToYCCOperation::ConvertRGBToYCCOperation() : ConvertBaseOperation()
@@ -37,6 +37,7 @@ class ConvertValueToColorOperation : public ConvertBaseOperation {
   ConvertValueToColorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class ConvertColorToValueOperation : public ConvertBaseOperation {
@@ -44,6 +45,7 @@ class ConvertColorToValueOperation : public ConvertBaseOperation {
   ConvertColorToValueOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class ConvertColorToBWOperation : public ConvertBaseOperation {
@@ -51,6 +53,7 @@ class ConvertColorToBWOperation : public ConvertBaseOperation {
   ConvertColorToBWOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class ConvertColorToVectorOperation : public ConvertBaseOperation {
@@ -58,6 +61,7 @@ class ConvertColorToVectorOperation : public ConvertBaseOperation {
   ConvertColorToVectorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class ConvertValueToVectorOperation : public ConvertBaseOperation {
@@ -65,6 +69,7 @@ class ConvertValueToVectorOperation : public ConvertBaseOperation {
   ConvertValueToVectorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class ConvertVectorToColorOperation : public ConvertBaseOperation {
@@ -72,6 +77,7 @@ class ConvertVectorToColorOperation : public ConvertBaseOperation {
   ConvertVectorToColorOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class ConvertVectorToValueOperation : public ConvertBaseOperation {
@@ -79,6 +85,7 @@ class ConvertVectorToValueOperation : public ConvertBaseOperation {
   ConvertVectorToValueOperation();
 
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class ConvertRGBToYCCOperation : public ConvertBaseOperation {
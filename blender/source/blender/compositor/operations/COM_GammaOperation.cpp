@@ -26,6 +26,7 @@ GammaOperation::GammaOperation() : NodeOperation()
   this->addOutputSocket(COM_DT_COLOR);
   this->m_inputProgram = NULL;
   this->m_inputGammaProgram = NULL;
+  this->setRowOperation(true);
 }
 void GammaOperation::initExecution()
 {
@@ -49,6 +50,20 @@ void GammaOperation::executePixelSampled(float output[4], float x, float y, Pixe
   output[3] = inputValue[3];
 }
 
+void GammaOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputColor = inputs[0];
+  const float *inputGamma = inputs[1];
+  for (int index = 0; index < width; index++, output += 4, inputColor += 4) {
+    const float gamma = inputGamma[index];
+    /* check for negative to avoid nan's */
+    output[0] = inputColor[0] > 0.0f ? powf(inputColor[0], gamma) : inputColor[0];
+    output[1] = inputColor[1] > 0.0f ? powf(inputColor[1], gamma) : inputColor[1];
+    output[2] = inputColor[2] > 0.0f ? powf(inputColor[2], gamma) : inputColor[2];
+    output[3] = inputColor[3];
+  }
+}
+
 void GammaOperation::deinitExecution()
 {
   this->m_inputProgram = NULL;
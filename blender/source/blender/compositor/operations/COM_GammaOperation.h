@@ -36,6 +36,11 @@ class GammaOperation : public NodeOperation {
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 
+  /**
+   * the inner loop of this program, a row at a time
+   */
+  void executeRow(float *output, float **inputs, int width);
+
   /**
    * Initialize the execution
    */
@@ -17,6 +17,7 @@
  */
 
 #include "COM_InvertOperation.h"
+#include "COM_RowVector.h"
 
 InvertOperation::InvertOperation() : NodeOperation()
 {
@@ -28,6 +29,7 @@ InvertOperation::InvertOperation() : NodeOperation()
   this->m_color = true;
   this->m_alpha = false;
   setResolutionInputSocketIndex(1);
+  this->setRowOperation(true);
 }
 void InvertOperation::initExecution()
 {
@@ -62,6 +64,35 @@ void InvertOperation::executePixelSampled(float output[4], float x, float y, Pix
   }
 }
 
+void InvertOperation::executeRow(float *output, float **inputs, int width)
+{
+  const float *inputValue = inputs[0];
+  const float *inputColor = inputs[1];
+  const RowVector one = rowvector_set1(1.0f);
+  for (int index = 0; index < width; index++, output += 4, inputColor += 4) {
+    const RowVector value = rowvector_set1(inputValue[index]);
+    const RowVector invertedValue = rowvector_set1(1.0f - inputValue[index]);
+    const RowVector color = rowvector_load(inputColor);
+    const float alpha = inputColor[3];
+
+    if (this->m_color) {
+      rowvector_store(output,
+                      rowvector_add(rowvector_mul(rowvector_sub(one, color), value),
+                                    rowvector_mul(color, invertedValue)));
+    }
+    else {
+      rowvector_store(output, color);
+    }
+
+    if (!this->m_alpha) {
+      output[3] = alpha;
+    }
+    else if (!this->m_color) {
+      output[3] = (1.0f - alpha) * inputValue[index] + alpha * (1.0f - inputValue[index]);
+    }
+  }
+}
+
 void InvertOperation::deinitExecution()
 {
   this->m_inputValueProgram = NULL;
@@ -39,6 +39,11 @@ class InvertOperation : public NodeOperation {
    */
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 
+  /**
+   * the inner loop of this program, a row at a time
+   */
+  void executeRow(float *output, float **inputs, int width);
+
   /**
    * Initialize the execution
    */
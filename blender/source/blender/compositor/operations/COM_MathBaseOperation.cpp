@@ -17,6 +17,7 @@
  */
 
 #include "COM_MathBaseOperation.h"
+#include "COM_RowVector.h"
 extern "C" {
 #include "BLI_math.h"
 }
@@ -68,6 +69,42 @@ void MathBaseOperation::clampIfNeeded(float *color)
   }
 }
 
+/* Row kernel shared by the math operations, calculates four values at a time. */
+template<typename MathFunc>
+static inline RowVector math_row_vector(const float *inputValue1,
+                                        const float *inputValue2,
+                                        bool useClamp,
+                                        MathFunc func)
+{
+  RowVector result = func(rowvector_load(inputValue1), rowvector_load(inputValue2));
+  return (useClamp) ? rowvector_clamp01(result) : result;
+}
+
+template<typename MathFunc>
+static void math_execute_row(
+    float *output, float **inputs, int width, bool useClamp, MathFunc func)
+{
+  const float *inputValue1 = inputs[0];
+  const float *inputValue2 = inputs[1];
+  int index = 0;
+  for (; index + 4 <= width; index += 4) {
+    rowvector_store(
+        &output[index],
+        math_row_vector(&inputValue1[index], &inputValue2[index], useClamp, func));
+  }
+  if (index < width) {
+    /* remaining values, padded to a whole vector */
+    const size_t remainder = sizeof(float) * (width - index);
+    float value1[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float value2[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float result[4];
+    memcpy(value1, &inputValue1[index], remainder);
+    memcpy(value2, &inputValue2[index], remainder);
+    rowvector_store(result, math_row_vector(value1, value2, useClamp, func));
+    memcpy(&output[index], result, remainder);
+  }
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
   float inputValue1[4];
@@ -81,6 +118,13 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
   clampIfNeeded(output);
 }
 
+void MathAddOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_add(a, b);
+  });
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -97,6 +141,13 @@ void MathSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathSubtractOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_sub(a, b);
+  });
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -113,6 +164,13 @@ void MathMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_mul(a, b);
+  });
+}
+
 void MathDivideOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -134,6 +192,13 @@ void MathDivideOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathDivideOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_div_safe(a, b);
+  });
+}
+
 void MathSineOperation::executePixelSampled(float output[4],
                                             float x,
                                             float y,
@@ -305,6 +370,13 @@ void MathMinimumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMinimumOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_min(b, a);
+  });
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4],
                                                float x,
                                                float y,
@@ -321,6 +393,13 @@ void MathMaximumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMaximumOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_max(b, a);
+  });
+}
+
 void MathRoundOperation::executePixelSampled(float output[4],
                                              float x,
                                              float y,
@@ -353,6 +432,13 @@ void MathLessThanOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathLessThanOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_less(a, b);
+  });
+}
+
 void MathGreaterThanOperation::executePixelSampled(float output[4],
                                                    float x,
                                                    float y,
@@ -369,6 +455,13 @@ void MathGreaterThanOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathGreaterThanOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector b) {
+    return rowvector_less(b, a);
+  });
+}
+
 void MathModuloOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -404,6 +497,13 @@ void MathAbsoluteOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathAbsoluteOperation::executeRow(float *output, float **inputs, int width)
+{
+  math_execute_row(output, inputs, width, this->m_useClamp, [](RowVector a, RowVector /*b*/) {
+    return rowvector_abs(a);
+  });
+}
+
 void MathArcTan2Operation::executePixelSampled(float output[4],
                                                float x,
                                                float y,
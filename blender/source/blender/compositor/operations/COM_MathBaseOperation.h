@@ -73,29 +73,37 @@ class MathAddOperation : public MathBaseOperation {
  public:
   MathAddOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 class MathSubtractOperation : public MathBaseOperation {
  public:
   MathSubtractOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 class MathMultiplyOperation : public MathBaseOperation {
  public:
   MathMultiplyOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 class MathDivideOperation : public MathBaseOperation {
  public:
   MathDivideOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 class MathSineOperation : public MathBaseOperation {
  public:
@@ -158,15 +166,19 @@ class MathMinimumOperation : public MathBaseOperation {
  public:
   MathMinimumOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 class MathMaximumOperation : public MathBaseOperation {
  public:
   MathMaximumOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 class MathRoundOperation : public MathBaseOperation {
  public:
@@ -179,15 +191,19 @@ class MathLessThanOperation : public MathBaseOperation {
  public:
   MathLessThanOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 class MathGreaterThanOperation : public MathBaseOperation {
  public:
   MathGreaterThanOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class MathModuloOperation : public MathBaseOperation {
@@ -202,8 +218,10 @@ class MathAbsoluteOperation : public MathBaseOperation {
  public:
   MathAbsoluteOperation() : MathBaseOperation()
   {
+    this->setRowOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeRow(float *output, float **inputs, int width);
 };
 
 class MathArcTan2Operation : public MathBaseOperation {
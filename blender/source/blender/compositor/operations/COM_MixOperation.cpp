@@ -17,6 +17,7 @@
  */
 
 #include "COM_MixOperation.h"
+#include "COM_RowVector.h"
 
 extern "C" {
 #include "BLI_math.h"
@@ -97,11 +98,44 @@ void MixBaseOperation::deinitExecution()
   this->m_inputColor2Operation = NULL;
 }
 
+/* Row kernel shared by the mix operations. blend calculates a pixel from both colors and the
+ * mix factor, the alpha of the first color is passed through. */
+template<typename BlendFunc>
+static void mix_execute_row(float *output,
+                            float **inputs,
+                            int width,
+                            bool valueAlphaMultiply,
+                            bool useClamp,
+                            BlendFunc blend)
+{
+  const float *inputValue = inputs[0];
+  const float *inputColor1 = inputs[1];
+  const float *inputColor2 = inputs[2];
+  for (int index = 0; index < width; index++) {
+    float value = inputValue[index];
+    if (valueAlphaMultiply) {
+      value *= inputColor2[3];
+    }
+    rowvector_store(output,
+                    blend(rowvector_load(inputColor1),
+                          rowvector_load(inputColor2),
+                          rowvector_set1(value),
+                          rowvector_set1(1.0f - value)));
+    output[3] = inputColor1[3];
+    if (useClamp) {
+      rowvector_store(output, rowvector_clamp01(rowvector_load(output)));
+    }
+    output += 4;
+    inputColor1 += 4;
+    inputColor2 += 4;
+  }
+}
+
 /* ******** Mix Add Operation ******** */
 
 MixAddOperation::MixAddOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setRowOperation(true);
 }
 
 void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -126,11 +160,24 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   clampIfNeeded(output);
 }
 
+void MixAddOperation::executeRow(float *output, float **inputs, int width)
+{
+  mix_execute_row(
+      output,
+      inputs,
+      width,
+      this->useValueAlphaMultiply(),
+      this->m_useClamp,
+      [](RowVector color1, RowVector color2, RowVector value, RowVector /*valuem*/) {
+        return rowvector_add(color1, rowvector_mul(value, color2));
+      });
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setRowOperation(true);
 }
 
 void MixBlendOperation::executePixelSampled(float output[4],
@@ -160,6 +207,19 @@ void MixBlendOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixBlendOperation::executeRow(float *output, float **inputs, int width)
+{
+  mix_execute_row(
+      output,
+      inputs,
+      width,
+      this->useValueAlphaMultiply(),
+      this->m_useClamp,
+      [](RowVector color1, RowVector color2, RowVector value, RowVector valuem) {
+        return rowvector_add(rowvector_mul(valuem, color1), rowvector_mul(value, color2));
+      });
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixColorBurnOperation::MixColorBurnOperation() : MixBaseOperation()
@@ -292,7 +352,7 @@ void MixColorOperation::executePixelSampled(float output[4],
 
 MixDarkenOperation::MixDarkenOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setRowOperation(true);
 }
 
 void MixDarkenOperation::executePixelSampled(float output[4],
@@ -321,11 +381,25 @@ void MixDarkenOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixDarkenOperation::executeRow(float *output, float **inputs, int width)
+{
+  mix_execute_row(
+      output,
+      inputs,
+      width,
+      this->useValueAlphaMultiply(),
+      this->m_useClamp,
+      [](RowVector color1, RowVector color2, RowVector value, RowVector valuem) {
+        return rowvector_add(rowvector_mul(rowvector_min(color1, color2), value),
+                             rowvector_mul(color1, valuem));
+      });
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDifferenceOperation::MixDifferenceOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setRowOperation(true);
 }
 
 void MixDifferenceOperation::executePixelSampled(float output[4],
@@ -354,6 +428,20 @@ void MixDifferenceOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixDifferenceOperation::executeRow(float *output, float **inputs, int width)
+{
+  mix_execute_row(
+      output,
+      inputs,
+      width,
+      this->useValueAlphaMultiply(),
+      this->m_useClamp,
+      [](RowVector color1, RowVector color2, RowVector value, RowVector valuem) {
+        return rowvector_add(rowvector_mul(valuem, color1),
+                             rowvector_mul(value, rowvector_abs(rowvector_sub(color1, color2))));
+      });
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDivideOperation::MixDivideOperation() : MixBaseOperation()
@@ -678,7 +766,7 @@ void MixLinearLightOperation::executePixelSampled(float output[4],
 
 MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setRowOperation(true);
 }
 
 void MixMultiplyOperation::executePixelSampled(float output[4],
@@ -707,6 +795,19 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRow(float *output, float **inputs, int width)
+{
+  mix_execute_row(
+      output,
+      inputs,
+      width,
+      this->useValueAlphaMultiply(),
+      this->m_useClamp,
+      [](RowVector color1, RowVector color2, RowVector value, RowVector valuem) {
+        return rowvector_mul(color1, rowvector_add(valuem, rowvector_mul(value, color2)));
+      });
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -803,7 +904,7 @@ void MixSaturationOperation::executePixelSampled(float output[4],
 
 MixScreenOperation::MixScreenOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setRowOperation(true);
 }
 
 void MixScreenOperation::executePixelSampled(float output[4],
@@ -833,6 +934,23 @@ void MixScreenOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixScreenOperation::executeRow(float *output, float **inputs, int width)
+{
+  mix_execute_row(
+      output,
+      inputs,
+      width,
+      this->useValueAlphaMultiply(),
+      this->m_useClamp,
+      [](RowVector color1, RowVector color2, RowVector value, RowVector valuem) {
+        const RowVector one = rowvector_set1(1.0f);
+        return rowvector_sub(
+            one,
+            rowvector_mul(rowvector_add(valuem, rowvector_mul(value, rowvector_sub(one, color2))),
+                          rowvector_sub(one, color1)));
+      });
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -883,7 +1001,7 @@ void MixSoftLightOperation::executePixelSampled(float output[4],
 
 MixSubtractOperation::MixSubtractOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setRowOperation(true);
 }
 
 void MixSubtractOperation::executePixelSampled(float output[4],
@@ -911,6 +1029,19 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MixSubtractOperation::executeRow(float *output, float **inputs, int width)
+{
+  mix_execute_row(
+      output,
+      inputs,
+      width,
+      this->useValueAlphaMultiply(),
+      this->m_useClamp,
+      [](RowVector color1, RowVector color2, RowVector value, RowVector /*valuem*/) {
+        return rowvector_sub(color1, rowvector_mul(value, color2));
+      });
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -107,6 +107,28 @@ void ReadBufferOperation::executePixelFiltered(
   }
 }
 
+void ReadBufferOperation::readRow(float *output, int x, int y, int width)
+{
+  const int num_channels = m_buffer->get_num_channels();
+  const rcti *rect = m_buffer->getRect();
+  if (m_single_value) {
+    /* write buffer has a single value stored at (0,0) */
+    m_buffer->read(output, 0, 0);
+    for (int i = 1; i < width; i++) {
+      memcpy(&output[i * num_channels], output, sizeof(float) * num_channels);
+    }
+  }
+  else if (y >= rect->ymin && y < rect->ymax && x >= rect->xmin && x + width <= rect->xmax) {
+    const float *buffer = m_buffer->getBuffer() + (m_buffer->getWidth() * y + x) * num_channels;
+    memcpy(output, buffer, sizeof(float) * num_channels * width);
+  }
+  else {
+    for (int i = 0; i < width; i++) {
+      m_buffer->read(&output[i * num_channels], x + i, y);
+    }
+  }
+}
+
 bool ReadBufferOperation::determineDependingAreaOfInterest(rcti *input,
                                                            ReadBufferOperation *readOperation,
                                                            rcti *output)
@@ -51,6 +51,11 @@ class ReadBufferOperation : public NodeOperation {
                           MemoryBufferExtend extend_x,
                           MemoryBufferExtend extend_y);
   void executePixelFiltered(float output[4], float x, float y, float dx[2], float dy[2]);
+  /**
+   * \brief read a row of pixels, pixels outside the buffer are zero.
+   * \see NodeOperation.executeRow
+   */
+  void readRow(float *output, int x, int y, int width);
   bool isReadBufferOperation() const
   {
     return true;
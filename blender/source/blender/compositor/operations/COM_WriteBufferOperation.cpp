@@ -20,6 +20,13 @@
 #include "COM_defines.h"
 #include <stdio.h>
 #include "COM_OpenCLDevice.h"
+#include "COM_ReadBufferOperation.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_alloca.h"
+}
 
 WriteBufferOperation::WriteBufferOperation(DataType datatype) : NodeOperation()
 {
@@ -27,6 +34,7 @@ WriteBufferOperation::WriteBufferOperation(DataType datatype) : NodeOperation()
   this->m_memoryProxy = new MemoryProxy(datatype);
   this->m_memoryProxy->setWriteBufferOperation(this);
   this->m_memoryProxy->setExecutor(NULL);
+  this->m_rowExecution = false;
 }
 WriteBufferOperation::~WriteBufferOperation()
 {
@@ -56,12 +64,107 @@ void WriteBufferOperation::deinitExecution()
   this->m_memoryProxy->free();
 }
 
+/* ******** Row execution ******** */
+
+static int row_num_channels(NodeOperation *operation)
+{
+  switch (operation->getOutputSocket()->getDataType()) {
+    case COM_DT_VALUE:
+      return COM_NUM_CHANNELS_VALUE;
+    case COM_DT_VECTOR:
+      return COM_NUM_CHANNELS_VECTOR;
+    case COM_DT_COLOR:
+    default:
+      return COM_NUM_CHANNELS_COLOR;
+  }
+}
+
+static NodeOperation *row_input_operation(NodeOperation *operation, unsigned int index)
+{
+  return &operation->getInputSocket(index)->getLink()->getOperation();
+}
+
+/* Number of floats needed to calculate a row of the operation, without its output row. */
+static size_t row_scratch_size(NodeOperation *operation, int width)
+{
+  if (operation->isReadBufferOperation() || operation->isSetOperation()) {
+    return 0;
+  }
+  size_t size = 0;
+  size_t input_size = 0;
+  for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperation *input = row_input_operation(operation, index);
+    size += (size_t)row_num_channels(input) * width;
+    input_size = max(input_size, row_scratch_size(input, width));
+  }
+  return size + input_size;
+}
+
+/* Calculate a row of the operation, the input rows are stored in scratch. */
+static void execute_row_recursive(
+    NodeOperation *operation, float *output, int x, int y, int width, float *scratch)
+{
+  const int num_channels = row_num_channels(operation);
+  if (operation->isReadBufferOperation()) {
+    ((ReadBufferOperation *)operation)->readRow(output, x, y, width);
+  }
+  else if (operation->isSetOperation()) {
+    float value[4];
+    operation->readSampled(value, x, y, COM_PS_NEAREST);
+    for (int i = 0; i < width; i++) {
+      memcpy(&output[i * num_channels], value, sizeof(float) * num_channels);
+    }
+  }
+  else {
+    const unsigned int numberOfInputs = operation->getNumberOfInputSockets();
+    float **inputs = BLI_array_alloca(inputs, numberOfInputs);
+    for (unsigned int index = 0; index < numberOfInputs; index++) {
+      inputs[index] = scratch;
+      scratch += row_num_channels(row_input_operation(operation, index)) * width;
+    }
+    for (unsigned int index = 0; index < numberOfInputs; index++) {
+      execute_row_recursive(
+          row_input_operation(operation, index), inputs[index], x, y, width, scratch);
+    }
+    operation->executeRow(output, inputs, width);
+  }
+}
+
+void WriteBufferOperation::executeRegionRows(rcti *rect)
+{
+  MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
+  float *buffer = memoryBuffer->getBuffer();
+  const int num_channels = memoryBuffer->get_num_channels();
+  const int width = BLI_rcti_size_x(rect);
+  const size_t scratch_size = row_scratch_size(this->m_input, width);
+  float *scratch = NULL;
+
+  BLI_assert(row_num_channels(this->m_input) == num_channels);
+
+  if (scratch_size) {
+    scratch = (float *)MEM_mallocN(sizeof(float) * scratch_size, __func__);
+  }
+  for (int y = rect->ymin; y < rect->ymax; y++) {
+    float *output = &buffer[(y * memoryBuffer->getWidth() + rect->xmin) * num_channels];
+    execute_row_recursive(this->m_input, output, rect->xmin, y, width, scratch);
+    if (isBraked()) {
+      break;
+    }
+  }
+  if (scratch) {
+    MEM_freeN(scratch);
+  }
+}
+
 void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 {
   MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
   float *buffer = memoryBuffer->getBuffer();
   const int num_channels = memoryBuffer->get_num_channels();
-  if (this->m_input->isComplex()) {
+  if (this->m_rowExecution) {
+    executeRegionRows(rect);
+  }
+  else if (this->m_input->isComplex()) {
     void *data = this->m_input->initializeTileData(rect);
     int x1 = rect->xmin;
     int y1 = rect->ymin;
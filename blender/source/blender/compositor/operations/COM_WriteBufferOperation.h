@@ -29,8 +29,11 @@
 class WriteBufferOperation : public NodeOperation {
   MemoryProxy *m_memoryProxy;
   bool m_single_value; /* single value stored in buffer */
+  bool m_rowExecution; /* calculate the input operations a row at a time */
   NodeOperation *m_input;
 
+  void executeRegionRows(rcti *rect);
+
  public:
   WriteBufferOperation(DataType datatype);
   ~WriteBufferOperation();
@@ -47,6 +50,15 @@ class WriteBufferOperation : public NodeOperation {
   {
     return m_single_value;
   }
+  /**
+   * \brief calculate the input operations a row at a time.
+   * \note only valid when all operations of the ExecutionGroup are row operations
+   * \see NodeOperation.executeRow
+   */
+  void setRowExecution(bool rowExecution)
+  {
+    m_rowExecution = rowExecution;
+  }
 
   void executeRegion(rcti *rect, unsigned int tileNumber);
   void initExecution();
@@ -152,6 +152,9 @@ void DRW_opengl_context_disable(void);
 /* For garbage collection */
 void DRW_cache_free_old_batches(struct Main *bmain);
 
+/* Mesh extraction statistics (printed by the memory statistics operator). */
+void DRW_mesh_batch_cache_stats_print(void);
+
 /* Never use this. Only for closing blender. */
 void DRW_opengl_context_enable_ex(bool restore);
 void DRW_opengl_context_disable_ex(bool restore);
@@ -228,6 +228,8 @@ typedef struct MeshBatchCache {
   int vert_len;
   int mat_len;
   bool is_dirty; /* Instantly invalidates cache, skipping mesh check */
+  /** Only edit-mesh vertices moved, buffers are updated in place on validation. */
+  bool is_deform_dirty;
   bool is_editmode;
   bool is_uvsyncsel;
 
@@ -247,6 +249,15 @@ typedef struct MeshBatchCache {
   float tot_area, tot_uv_area;
 
   bool no_loose_wire;
+
+  /* Edit-mesh vertex coordinates & normals the buffers were extracted from, so a deformation
+   * only re-extracts the faces it touched. Element counts are stored in `*_len` above. */
+  float (*deform_co)[3];
+  float (*deform_no)[3];
+  uint64_t deform_tess_hash;
+
+  /* Mesh analysis weights & BVH, kept across cache rebuilds while the geometry is unchanged. */
+  struct MeshStatVisCache *statvis_cache;
 } MeshBatchCache;
 
 void mesh_buffer_cache_create_requested(MeshBatchCache *cache,
@@ -259,4 +270,8 @@ void mesh_buffer_cache_create_requested(MeshBatchCache *cache,
                                         const ToolSettings *ts,
                                         const bool use_hide);
 
+bool mesh_buffer_cache_update_deformed(MeshBatchCache *cache, MeshBufferCache mbc, Mesh *me);
+void mesh_buffer_cache_stats_deform_add(const bool in_place);
+void mesh_buffer_cache_statvis_free(MeshBatchCache *cache);
+
 #endif /* __DRAW_CACHE_EXTRACT_H__ */
@@ -61,6 +61,7 @@
 #include "GPU_batch.h"
 #include "GPU_extensions.h"
 
+#include "DRW_engine.h"
 #include "DRW_render.h"
 
 #include "ED_mesh.h"
@@ -2989,9 +2990,175 @@ static const MeshExtract extract_stretch_angle = {
 /** \} */
 
 /* ---------------------------------------------------------------------- */
-/** \name Extract Edit UV angle stretch
+/** \name Extract Mesh Analysis
  * \{ */
 
+/**
+ * Thickness & intersection weights take a long time to compute (thickness casts rays for every
+ * triangle), they are kept across rebuilds of the batch cache (selection, hiding...) and only
+ * computed again when the geometry or the settings they depend on changed.
+ */
+typedef struct MeshStatVisCache {
+  /** Hash of the geometry the weights & the BVH were computed from. */
+  uint64_t geom_hash;
+  int loop_len;
+  /** Visualization type & settings the weights were computed with. */
+  char type;
+  float params[4];
+  float *loop_weights;
+  /** Edit-mesh BVH, when extracting from a mesh its own (shared) BVH cache is used instead. */
+  struct BMBVHTree *bmtree;
+} MeshStatVisCache;
+
+void mesh_buffer_cache_statvis_free(MeshBatchCache *cache)
+{
+  MeshStatVisCache *svc = cache->statvis_cache;
+  if (svc == NULL) {
+    return;
+  }
+  if (svc->bmtree) {
+    BKE_bmbvh_free(svc->bmtree);
+  }
+  MEM_SAFE_FREE(svc->loop_weights);
+  MEM_freeN(svc);
+  cache->statvis_cache = NULL;
+}
+
+/* Triangles hashed by a single task. */
+#define STATVIS_HASH_CHUNK_SIZE 4096
+
+typedef struct StatVisHashData {
+  const MeshRenderData *mr;
+  uint64_t *chunk_hash;
+} StatVisHashData;
+
+BLI_INLINE uint64_t statvis_hash_step(uint64_t hash, const uint64_t value)
+{
+  hash ^= value * 0x9e3779b97f4a7c15ull;
+  hash = (hash << 27) | (hash >> 37);
+  return hash * 0xc2b2ae3d27d4eb4full;
+}
+
+BLI_INLINE uint64_t statvis_hash_co(uint64_t hash, const float co[3])
+{
+  uint32_t co_bits[3];
+  memcpy(co_bits, co, sizeof(co_bits));
+  hash = statvis_hash_step(hash, ((uint64_t)co_bits[0] << 32) | co_bits[1]);
+  return statvis_hash_step(hash, co_bits[2]);
+}
+
+static void statvis_hash_chunk_cb(void *__restrict userdata,
+                                  const int chunk,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  StatVisHashData *data = userdata;
+  const MeshRenderData *mr = data->mr;
+  const int tri_start = chunk * STATVIS_HASH_CHUNK_SIZE;
+  const int tri_end = min_ii(tri_start + STATVIS_HASH_CHUNK_SIZE, mr->tri_len);
+  uint64_t hash = (uint64_t)chunk;
+
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    /* The edit-mesh BVH points to the loops, hash them along with the vertex and edge they use
+     * so the weights (per loop index) and the topology of the mesh are covered too. */
+    for (int i = tri_start; i < tri_end; i++) {
+      BMLoop **ltri = mr->edit_bmesh->looptris[i];
+      for (int j = 0; j < 3; j++) {
+        hash = statvis_hash_step(hash, (uint64_t)(uintptr_t)ltri[j]);
+        hash = statvis_hash_step(hash, (uint64_t)(uintptr_t)ltri[j]->v);
+        hash = statvis_hash_step(hash, (uint64_t)(uintptr_t)ltri[j]->e);
+        hash = statvis_hash_co(hash, ltri[j]->v->co);
+      }
+    }
+  }
+  else {
+    for (int i = tri_start; i < tri_end; i++) {
+      const MLoopTri *mlt = &mr->mlooptri[i];
+      for (int j = 0; j < 3; j++) {
+        const MLoop *ml = &mr->mloop[mlt->tri[j]];
+        hash = statvis_hash_step(hash, mlt->tri[j]);
+        hash = statvis_hash_step(hash, ((uint64_t)ml->v << 32) | ml->e);
+        hash = statvis_hash_co(hash, mr->mvert[ml->v].co);
+      }
+    }
+  }
+  data->chunk_hash[chunk] = hash;
+}
+
+/**
+ * Hash the geometry used by mesh analysis. Triangles are hashed in fixed size chunks
+ * in parallel so the result doesn't depend on the number of threads.
+ */
+static uint64_t statvis_geom_hash(const MeshRenderData *mr)
+{
+  const int chunk_len = (mr->tri_len + STATVIS_HASH_CHUNK_SIZE - 1) / STATVIS_HASH_CHUNK_SIZE;
+  StatVisHashData data = {
+      .mr = mr,
+      .chunk_hash = MEM_mallocN(sizeof(*data.chunk_hash) * max_ii(chunk_len, 1), __func__),
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, chunk_len, &data, statvis_hash_chunk_cb, &settings);
+
+  uint64_t hash = statvis_hash_step(mr->extract_type, mr->tri_len);
+  hash = statvis_hash_step(hash, ((uint64_t)mr->loop_len << 32) | (uint)mr->edge_len);
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    hash = statvis_hash_step(hash, (uint64_t)(uintptr_t)mr->bm);
+    hash = statvis_hash_step(hash, (uint64_t)(uintptr_t)mr->edit_bmesh->looptris);
+  }
+  for (int i = 0; i < chunk_len; i++) {
+    hash = statvis_hash_step(hash, data.chunk_hash[i]);
+  }
+
+  MEM_freeN(data.chunk_hash);
+  return hash;
+}
+
+static MeshStatVisCache *statvis_cache_validate(const MeshRenderData *mr)
+{
+  MeshBatchCache *cache = mr->cache;
+  if (cache->statvis_cache == NULL) {
+    cache->statvis_cache = MEM_callocN(sizeof(*cache->statvis_cache), __func__);
+  }
+  MeshStatVisCache *svc = cache->statvis_cache;
+
+  const uint64_t geom_hash = statvis_geom_hash(mr);
+  if ((svc->loop_len != mr->loop_len) || (svc->geom_hash != geom_hash)) {
+    if (svc->bmtree) {
+      BKE_bmbvh_free(svc->bmtree);
+      svc->bmtree = NULL;
+    }
+    MEM_SAFE_FREE(svc->loop_weights);
+    svc->geom_hash = geom_hash;
+    svc->loop_len = mr->loop_len;
+  }
+  return svc;
+}
+
+/* Only the settings used by the visualization \a type, so tweaking others keeps the cache. */
+static void statvis_params_get(const MeshRenderData *mr, const char type, float r_params[4])
+{
+  const MeshStatVis *statvis = &mr->toolsettings->statvis;
+  zero_v4(r_params);
+  switch (type) {
+    case SCE_STATVIS_THICKNESS:
+      r_params[0] = statvis->thickness_min;
+      r_params[1] = statvis->thickness_max;
+      r_params[2] = (float)statvis->thickness_samples;
+      r_params[3] = mat4_to_scale(mr->edit_bmesh->ob->obmat);
+      break;
+  }
+}
+
+static struct BMBVHTree *statvis_bmbvh_get(const MeshRenderData *mr)
+{
+  MeshStatVisCache *svc = mr->cache->statvis_cache;
+  if (svc->bmtree == NULL) {
+    svc->bmtree = BKE_bmbvh_new_from_editmesh(mr->edit_bmesh, 0, NULL, false);
+  }
+  return svc->bmtree;
+}
+
 static void *extract_mesh_analysis_init(const MeshRenderData *mr, void *buf)
 {
   static GPUVertFormat format = {0};
@@ -3106,120 +3273,162 @@ BLI_INLINE float thickness_remap(float fac, float min, float max, float minmax_i
   return fac;
 }
 
-static void statvis_calc_thickness(const MeshRenderData *mr, float *r_thickness)
+typedef struct StatVisThicknessData {
+  const MeshRenderData *mr;
+  struct BMBVHTree *bmtree;
+  BVHTreeFromMesh *treedata;
+  const float (*jit_ofs)[2];
+  int samples;
+  float min, max, minmax_irange;
+  float *r_thickness;
+} StatVisThicknessData;
+
+/* Faces are processed in parallel, each one casting rays from its own triangles. */
+static void statvis_calc_thickness_bm_cb(void *__restrict userdata,
+                                         const int f_index,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const float eps_offset = 0.00002f; /* values <= 0.00001 give errors */
+  const StatVisThicknessData *data = userdata;
+  const MeshRenderData *mr = data->mr;
+  BMFace *f = BM_face_at_index(mr->bm, f_index);
+  const int l_start = BM_elem_index_get(BM_FACE_FIRST_LOOP(f));
+  /* Each face has (len - 2) triangles, stored in face order. */
+  const int tri_start = poly_to_tri_count(f_index, l_start);
+  float face_dist = data->max;
+
+  for (int i = tri_start; i < tri_start + f->len - 2; i++) {
+    BMLoop **ltri = mr->edit_bmesh->looptris[i];
+    const float *cos[3] = {ltri[0]->v->co, ltri[1]->v->co, ltri[2]->v->co};
+    float ray_co[3];
+    float ray_no[3];
+
+    BLI_assert(ltri[0]->f == f);
+
+    normal_tri_v3(ray_no, cos[2], cos[1], cos[0]);
+
+    for (int j = 0; j < data->samples; j++) {
+      float dist = face_dist;
+      interp_v3_v3v3v3_uv(ray_co, cos[0], cos[1], cos[2], data->jit_ofs[j]);
+      madd_v3_v3fl(ray_co, ray_no, eps_offset);
+
+      BMFace *f_hit = BKE_bmbvh_ray_cast(data->bmtree, ray_co, ray_no, 0.0f, &dist, NULL, NULL);
+      if (f_hit && dist < face_dist) {
+        float angle_fac = fabsf(dot_v3v3(f->no, f_hit->no));
+        angle_fac = 1.0f - angle_fac;
+        angle_fac = angle_fac * angle_fac * angle_fac;
+        angle_fac = 1.0f - angle_fac;
+        dist /= angle_fac;
+        if (dist < face_dist) {
+          face_dist = dist;
+        }
+      }
+    }
+  }
+
+  const float fac = thickness_remap(face_dist, data->min, data->max, data->minmax_irange);
+  for (int i = 0; i < f->len; i++) {
+    data->r_thickness[l_start + i] = fac;
+  }
+}
+
+static void statvis_calc_thickness_mesh_cb(void *__restrict userdata,
+                                           const int p,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
 {
   const float eps_offset = 0.00002f; /* values <= 0.00001 give errors */
-  /* cheating to avoid another allocation */
-  float *face_dists = r_thickness + (mr->loop_len - mr->poly_len);
+  const StatVisThicknessData *data = userdata;
+  const MeshRenderData *mr = data->mr;
+  BVHTreeFromMesh *treedata = data->treedata;
+  const MPoly *mp = &mr->mpoly[p];
+  const int tri_start = poly_to_tri_count(p, mp->loopstart);
+  float face_dist = data->max;
+
+  for (int i = tri_start; i < tri_start + mp->totloop - 2; i++) {
+    const MLoopTri *mlooptri = &mr->mlooptri[i];
+    const float *cos[3] = {mr->mvert[mr->mloop[mlooptri->tri[0]].v].co,
+                           mr->mvert[mr->mloop[mlooptri->tri[1]].v].co,
+                           mr->mvert[mr->mloop[mlooptri->tri[2]].v].co};
+    float ray_co[3];
+    float ray_no[3];
+
+    BLI_assert(mlooptri->poly == p);
+
+    normal_tri_v3(ray_no, cos[2], cos[1], cos[0]);
+
+    for (int j = 0; j < data->samples; j++) {
+      interp_v3_v3v3v3_uv(ray_co, cos[0], cos[1], cos[2], data->jit_ofs[j]);
+      madd_v3_v3fl(ray_co, ray_no, eps_offset);
+
+      BVHTreeRayHit hit;
+      hit.index = -1;
+      hit.dist = face_dist;
+      if ((BLI_bvhtree_ray_cast(treedata->tree,
+                                ray_co,
+                                ray_no,
+                                0.0f,
+                                &hit,
+                                treedata->raycast_callback,
+                                treedata) != -1) &&
+          hit.dist < face_dist) {
+        float angle_fac = fabsf(dot_v3v3(mr->poly_normals[p], hit.no));
+        angle_fac = 1.0f - angle_fac;
+        angle_fac = angle_fac * angle_fac * angle_fac;
+        angle_fac = 1.0f - angle_fac;
+        hit.dist /= angle_fac;
+        if (hit.dist < face_dist) {
+          face_dist = hit.dist;
+        }
+      }
+    }
+  }
+
+  const float fac = thickness_remap(face_dist, data->min, data->max, data->minmax_irange);
+  for (int i = 0; i < mp->totloop; i++) {
+    data->r_thickness[mp->loopstart + i] = fac;
+  }
+}
+
+static void statvis_calc_thickness(const MeshRenderData *mr, float *r_thickness)
+{
   BMEditMesh *em = mr->edit_bmesh;
   const float scale = 1.0f / mat4_to_scale(em->ob->obmat);
   const MeshStatVis *statvis = &mr->toolsettings->statvis;
   const float min = statvis->thickness_min * scale;
   const float max = statvis->thickness_max * scale;
-  const float minmax_irange = 1.0f / (max - min);
   const int samples = statvis->thickness_samples;
   float jit_ofs[32][2];
   BLI_assert(samples <= 32);
   BLI_assert(min <= max);
 
-  copy_vn_fl(face_dists, mr->poly_len, max);
-
   BLI_jitter_init(jit_ofs, samples);
   for (int j = 0; j < samples; j++) {
     uv_from_jitter_v2(jit_ofs[j]);
   }
 
-  if (mr->extract_type == MR_EXTRACT_BMESH) {
-    BMesh *bm = em->bm;
-    BM_mesh_elem_index_ensure(bm, BM_FACE);
-
-    struct BMBVHTree *bmtree = BKE_bmbvh_new_from_editmesh(em, 0, NULL, false);
-    struct BMLoop *(*looptris)[3] = em->looptris;
-    for (int i = 0; i < mr->tri_len; i++) {
-      BMLoop **ltri = looptris[i];
-      const int index = BM_elem_index_get(ltri[0]->f);
-      const float *cos[3] = {ltri[0]->v->co, ltri[1]->v->co, ltri[2]->v->co};
-      float ray_co[3];
-      float ray_no[3];
-
-      normal_tri_v3(ray_no, cos[2], cos[1], cos[0]);
-
-      for (int j = 0; j < samples; j++) {
-        float dist = face_dists[index];
-        interp_v3_v3v3v3_uv(ray_co, cos[0], cos[1], cos[2], jit_ofs[j]);
-        madd_v3_v3fl(ray_co, ray_no, eps_offset);
-
-        BMFace *f_hit = BKE_bmbvh_ray_cast(bmtree, ray_co, ray_no, 0.0f, &dist, NULL, NULL);
-        if (f_hit && dist < face_dists[index]) {
-          float angle_fac = fabsf(dot_v3v3(ltri[0]->f->no, f_hit->no));
-          angle_fac = 1.0f - angle_fac;
-          angle_fac = angle_fac * angle_fac * angle_fac;
-          angle_fac = 1.0f - angle_fac;
-          dist /= angle_fac;
-          if (dist < face_dists[index]) {
-            face_dists[index] = dist;
-          }
-        }
-      }
-    }
-    BKE_bmbvh_free(bmtree);
+  StatVisThicknessData data = {
+      .mr = mr,
+      .jit_ofs = (const float(*)[2])jit_ofs,
+      .samples = samples,
+      .min = min,
+      .max = max,
+      .minmax_irange = 1.0f / (max - min),
+      .r_thickness = r_thickness,
+  };
 
-    BMIter iter;
-    BMFace *f;
-    int l = 0;
-    BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-      float fac = face_dists[BM_elem_index_get(f)];
-      fac = thickness_remap(fac, min, max, minmax_irange);
-      for (int i = 0; i < f->len; i++, l++) {
-        r_thickness[l] = fac;
-      }
-    }
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+
+  if (mr->extract_type == MR_EXTRACT_BMESH) {
+    data.bmtree = statvis_bmbvh_get(mr);
+    BLI_task_parallel_range(0, mr->poly_len, &data, statvis_calc_thickness_bm_cb, &settings);
   }
   else {
-    BVHTreeFromMesh treeData = {NULL};
-
-    BVHTree *tree = BKE_bvhtree_from_mesh_get(&treeData, mr->me, BVHTREE_FROM_LOOPTRI, 4);
-    const MLoopTri *mlooptri = mr->mlooptri;
-    for (int i = 0; i < mr->tri_len; i++, mlooptri++) {
-      const int index = mlooptri->poly;
-      const float *cos[3] = {mr->mvert[mr->mloop[mlooptri->tri[0]].v].co,
-                             mr->mvert[mr->mloop[mlooptri->tri[1]].v].co,
-                             mr->mvert[mr->mloop[mlooptri->tri[2]].v].co};
-      float ray_co[3];
-      float ray_no[3];
-
-      normal_tri_v3(ray_no, cos[2], cos[1], cos[0]);
-
-      for (int j = 0; j < samples; j++) {
-        interp_v3_v3v3v3_uv(ray_co, cos[0], cos[1], cos[2], jit_ofs[j]);
-        madd_v3_v3fl(ray_co, ray_no, eps_offset);
-
-        BVHTreeRayHit hit;
-        hit.index = -1;
-        hit.dist = face_dists[index];
-        if ((BLI_bvhtree_ray_cast(
-                 tree, ray_co, ray_no, 0.0f, &hit, treeData.raycast_callback, &treeData) != -1) &&
-            hit.dist < face_dists[index]) {
-          float angle_fac = fabsf(dot_v3v3(mr->poly_normals[index], hit.no));
-          angle_fac = 1.0f - angle_fac;
-          angle_fac = angle_fac * angle_fac * angle_fac;
-          angle_fac = 1.0f - angle_fac;
-          hit.dist /= angle_fac;
-          if (hit.dist < face_dists[index]) {
-            face_dists[index] = hit.dist;
-          }
-        }
-      }
-    }
-
-    const MPoly *mpoly = mr->mpoly;
-    for (int p = 0, l = 0; p < mr->poly_len; p++, mpoly++) {
-      float fac = face_dists[p];
-      fac = thickness_remap(fac, min, max, minmax_irange);
-      for (int i = 0; i < mpoly->totloop; i++, l++) {
-        r_thickness[l] = fac;
-      }
-    }
+    BVHTreeFromMesh treedata = {NULL};
+    BKE_bvhtree_from_mesh_get(&treedata, mr->me, BVHTREE_FROM_LOOPTRI, 4);
+    data.treedata = &treedata;
+    BLI_task_parallel_range(0, mr->poly_len, &data, statvis_calc_thickness_mesh_cb, &settings);
   }
 }
 
@@ -3264,21 +3473,16 @@ static bool bvh_overlap_cb(void *userdata, int index_a, int index_b, int UNUSED(
           ((verts_shared == 0) || (len_squared_v3v3(ix_pair[0], ix_pair[1]) > data->epsilon)));
 }
 
+/* The overlap test itself is threaded by the BVH, the cached tree avoids building it again. */
 static void statvis_calc_intersect(const MeshRenderData *mr, float *r_intersect)
 {
   BMEditMesh *em = mr->edit_bmesh;
 
-  for (int l = 0; l < mr->loop_len; l++) {
-    r_intersect[l] = -1.0f;
-  }
+  copy_vn_fl(r_intersect, mr->loop_len, -1.0f);
 
   if (mr->extract_type == MR_EXTRACT_BMESH) {
     uint overlap_len;
-    BMesh *bm = em->bm;
-
-    BM_mesh_elem_index_ensure(bm, BM_FACE);
-
-    struct BMBVHTree *bmtree = BKE_bmbvh_new_from_editmesh(em, 0, NULL, false);
+    struct BMBVHTree *bmtree = statvis_bmbvh_get(mr);
     BVHTreeOverlap *overlap = BKE_bmbvh_overlap(bmtree, bmtree, &overlap_len);
 
     if (overlap) {
@@ -3298,8 +3502,6 @@ static void statvis_calc_intersect(const MeshRenderData *mr, float *r_intersect)
       }
       MEM_freeN(overlap);
     }
-
-    BKE_bmbvh_free(bmtree);
   }
   else {
     uint overlap_len;
@@ -3343,81 +3545,105 @@ BLI_INLINE float distort_remap(float fac, float min, float UNUSED(max), float mi
   return fac;
 }
 
-static void statvis_calc_distort(const MeshRenderData *mr, float *r_distort)
-{
-  BMEditMesh *em = mr->edit_bmesh;
-  const MeshStatVis *statvis = &mr->toolsettings->statvis;
-  const float min = statvis->distort_min;
-  const float max = statvis->distort_max;
-  const float minmax_irange = 1.0f / (max - min);
-
-  if (mr->extract_type == MR_EXTRACT_BMESH) {
-    BMIter iter;
-    BMesh *bm = em->bm;
-    BMFace *f;
-
-    int l = 0;
-    BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-      float fac = -1.0f;
-
-      if (f->len > 3) {
-        BMLoop *l_iter, *l_first;
-
-        fac = 0.0f;
-        l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-        do {
-          float no_corner[3];
-          BM_loop_calc_face_normal_safe(l_iter, no_corner);
-          /* simple way to detect (what is most likely) concave */
-          if (dot_v3v3(f->no, no_corner) < 0.0f) {
-            negate_v3(no_corner);
-          }
-          fac = max_ff(fac, angle_normalized_v3v3(f->no, no_corner));
-        } while ((l_iter = l_iter->next) != l_first);
-        fac *= 2.0f;
+typedef struct StatVisRemapData {
+  const MeshRenderData *mr;
+  float min, max, minmax_irange;
+  /** Only used by sharpness. */
+  float *edge_angles, *vert_angles;
+  float *r_weight;
+} StatVisRemapData;
+
+static void statvis_calc_distort_bm_cb(void *__restrict userdata,
+                                       const int f_index,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const StatVisRemapData *data = userdata;
+  BMFace *f = BM_face_at_index(data->mr->bm, f_index);
+  BMLoop *l_iter, *l_first;
+  float fac = -1.0f;
+
+  l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+  if (f->len > 3) {
+    fac = 0.0f;
+    do {
+      float no_corner[3];
+      BM_loop_calc_face_normal_safe(l_iter, no_corner);
+      /* simple way to detect (what is most likely) concave */
+      if (dot_v3v3(f->no, no_corner) < 0.0f) {
+        negate_v3(no_corner);
       }
-
-      fac = distort_remap(fac, min, max, minmax_irange);
-      for (int i = 0; i < f->len; i++, l++) {
-        r_distort[l] = fac;
+      fac = max_ff(fac, angle_normalized_v3v3(f->no, no_corner));
+    } while ((l_iter = l_iter->next) != l_first);
+    fac *= 2.0f;
+  }
+
+  fac = distort_remap(fac, data->min, data->max, data->minmax_irange);
+  const int l_start = BM_elem_index_get(l_first);
+  for (int i = 0; i < f->len; i++) {
+    data->r_weight[l_start + i] = fac;
+  }
+}
+
+static void statvis_calc_distort_mesh_cb(void *__restrict userdata,
+                                         const int p,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const StatVisRemapData *data = userdata;
+  const MeshRenderData *mr = data->mr;
+  const MPoly *mpoly = &mr->mpoly[p];
+  float fac = -1.0f;
+
+  if (mpoly->totloop > 3) {
+    float *f_no = mr->poly_normals[p];
+    fac = 0.0f;
+
+    for (int i = 1; i <= mpoly->totloop; i++) {
+      const MLoop *l_prev = &mr->mloop[mpoly->loopstart + (i - 1) % mpoly->totloop];
+      const MLoop *l_curr = &mr->mloop[mpoly->loopstart + (i + 0) % mpoly->totloop];
+      const MLoop *l_next = &mr->mloop[mpoly->loopstart + (i + 1) % mpoly->totloop];
+      float no_corner[3];
+      normal_tri_v3(no_corner,
+                    mr->mvert[l_prev->v].co,
+                    mr->mvert[l_curr->v].co,
+                    mr->mvert[l_next->v].co);
+      /* simple way to detect (what is most likely) concave */
+      if (dot_v3v3(f_no, no_corner) < 0.0f) {
+        negate_v3(no_corner);
       }
+      fac = max_ff(fac, angle_normalized_v3v3(f_no, no_corner));
     }
+    fac *= 2.0f;
   }
-  else {
-    const MPoly *mpoly = mr->mpoly;
-    for (int p = 0, l = 0; p < mr->poly_len; p++, mpoly++) {
-      float fac = -1.0f;
-
-      if (mpoly->totloop > 3) {
-        float *f_no = mr->poly_normals[p];
-        fac = 0.0f;
-
-        for (int i = 1; i <= mpoly->totloop; i++) {
-          const MLoop *l_prev = &mr->mloop[mpoly->loopstart + (i - 1) % mpoly->totloop];
-          const MLoop *l_curr = &mr->mloop[mpoly->loopstart + (i + 0) % mpoly->totloop];
-          const MLoop *l_next = &mr->mloop[mpoly->loopstart + (i + 1) % mpoly->totloop];
-          float no_corner[3];
-          normal_tri_v3(no_corner,
-                        mr->mvert[l_prev->v].co,
-                        mr->mvert[l_curr->v].co,
-                        mr->mvert[l_next->v].co);
-          /* simple way to detect (what is most likely) concave */
-          if (dot_v3v3(f_no, no_corner) < 0.0f) {
-            negate_v3(no_corner);
-          }
-          fac = max_ff(fac, angle_normalized_v3v3(f_no, no_corner));
-        }
-        fac *= 2.0f;
-      }
 
-      fac = distort_remap(fac, min, max, minmax_irange);
-      for (int i = 0; i < mpoly->totloop; i++, l++) {
-        r_distort[l] = fac;
-      }
-    }
+  fac = distort_remap(fac, data->min, data->max, data->minmax_irange);
+  for (int i = 0; i < mpoly->totloop; i++) {
+    data->r_weight[mpoly->loopstart + i] = fac;
   }
 }
 
+static void statvis_calc_distort(const MeshRenderData *mr, float *r_distort)
+{
+  const MeshStatVis *statvis = &mr->toolsettings->statvis;
+  StatVisRemapData data = {
+      .mr = mr,
+      .min = statvis->distort_min,
+      .max = statvis->distort_max,
+      .minmax_irange = 1.0f / (statvis->distort_max - statvis->distort_min),
+      .r_weight = r_distort,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  BLI_task_parallel_range(0,
+                          mr->poly_len,
+                          &data,
+                          (mr->extract_type == MR_EXTRACT_BMESH) ? statvis_calc_distort_bm_cb :
+                                                                   statvis_calc_distort_mesh_cb,
+                          &settings);
+}
+
 BLI_INLINE float sharp_remap(float fac, float min, float UNUSED(max), float minmax_irange)
 {
   /* important not '>=' */
@@ -3432,9 +3658,48 @@ BLI_INLINE float sharp_remap(float fac, float min, float UNUSED(max), float minm
   return fac;
 }
 
+
+static void statvis_calc_sharp_edge_bm_cb(void *__restrict userdata,
+                                          const int e_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const StatVisRemapData *data = userdata;
+  BMEdge *e = BM_edge_at_index(data->mr->bm, e_index);
+  data->edge_angles[e_index] = BM_edge_calc_face_angle_signed(e);
+}
+
+static void statvis_calc_sharp_vert_bm_cb(void *__restrict userdata,
+                                          const int v_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const StatVisRemapData *data = userdata;
+  BMVert *v = BM_vert_at_index(data->mr->bm, v_index);
+  BMIter iter;
+  BMEdge *e;
+  float angle = -(float)M_PI;
+  BM_ITER_ELEM (e, &iter, v, BM_EDGES_OF_VERT) {
+    angle = max_ff(angle, data->edge_angles[BM_elem_index_get(e)]);
+  }
+  data->vert_angles[v_index] = angle;
+}
+
+static void statvis_calc_sharp_face_bm_cb(void *__restrict userdata,
+                                          const int f_index,
+                                          const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const StatVisRemapData *data = userdata;
+  BMFace *f = BM_face_at_index(data->mr->bm, f_index);
+  BMLoop *l_iter, *l_first;
+  l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+  do {
+    const float angle = data->vert_angles[BM_elem_index_get(l_iter->v)];
+    data->r_weight[BM_elem_index_get(l_iter)] = sharp_remap(
+        angle, data->min, data->max, data->minmax_irange);
+  } while ((l_iter = l_iter->next) != l_first);
+}
+
 static void statvis_calc_sharp(const MeshRenderData *mr, float *r_sharp)
 {
-  BMEditMesh *em = mr->edit_bmesh;
   const MeshStatVis *statvis = &mr->toolsettings->statvis;
   const float min = statvis->sharp_min;
   const float max = statvis->sharp_max;
@@ -3442,35 +3707,36 @@ static void statvis_calc_sharp(const MeshRenderData *mr, float *r_sharp)
 
   /* Can we avoid this extra allocation? */
   float *vert_angles = MEM_mallocN(sizeof(float) * mr->vert_len, __func__);
-  copy_vn_fl(vert_angles, mr->vert_len, -M_PI);
 
   if (mr->extract_type == MR_EXTRACT_BMESH) {
-    BMIter iter, l_iter;
-    BMesh *bm = em->bm;
-    BMFace *efa;
-    BMEdge *e;
-    BMLoop *loop;
-    /* first assign float values to verts */
-    BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
-      float angle = BM_edge_calc_face_angle_signed(e);
-      float *col1 = &vert_angles[BM_elem_index_get(e->v1)];
-      float *col2 = &vert_angles[BM_elem_index_get(e->v2)];
-      *col1 = max_ff(*col1, angle);
-      *col2 = max_ff(*col2, angle);
-    }
-    /* Copy vert value to loops. */
-    BM_ITER_MESH (efa, &iter, bm, BM_FACES_OF_MESH) {
-      BM_ITER_ELEM (loop, &l_iter, efa, BM_LOOPS_OF_FACE) {
-        int l = BM_elem_index_get(loop);
-        int v = BM_elem_index_get(loop->v);
-        r_sharp[l] = sharp_remap(vert_angles[v], min, max, minmax_irange);
-      }
-    }
+    /* Edge angles first, then the maximum around each vertex, so no two threads write the
+     * same value. */
+    StatVisRemapData data = {
+        .mr = mr,
+        .min = min,
+        .max = max,
+        .minmax_irange = minmax_irange,
+        .edge_angles = MEM_mallocN(sizeof(float) * mr->edge_len, __func__),
+        .vert_angles = vert_angles,
+        .r_weight = r_sharp,
+    };
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1024;
+
+    BLI_task_parallel_range(0, mr->edge_len, &data, statvis_calc_sharp_edge_bm_cb, &settings);
+    BLI_task_parallel_range(0, mr->vert_len, &data, statvis_calc_sharp_vert_bm_cb, &settings);
+    BLI_task_parallel_range(0, mr->poly_len, &data, statvis_calc_sharp_face_bm_cb, &settings);
+
+    MEM_freeN(data.edge_angles);
   }
   else {
     /* first assign float values to verts */
     const MPoly *mpoly = mr->mpoly;
 
+    copy_vn_fl(vert_angles, mr->vert_len, -M_PI);
+
     EdgeHash *eh = BLI_edgehash_new_ex(__func__, mr->edge_len);
 
     for (int p = 0; p < mr->poly_len; p++, mpoly++) {
@@ -3536,24 +3802,45 @@ static void extract_mesh_analysis_finish(const MeshRenderData *mr, void *buf, vo
 
   GPUVertBuf *vbo = buf;
   float *l_weight = (float *)vbo->data;
+  const char type = mr->toolsettings->statvis.type;
 
-  switch (mr->toolsettings->statvis.type) {
+  /* Cheaper to compute than to validate the cache. */
+  switch (type) {
     case SCE_STATVIS_OVERHANG:
       statvis_calc_overhang(mr, l_weight);
-      break;
+      return;
+    case SCE_STATVIS_DISTORT:
+      statvis_calc_distort(mr, l_weight);
+      return;
+    case SCE_STATVIS_SHARP:
+      statvis_calc_sharp(mr, l_weight);
+      return;
+  }
+
+  MeshStatVisCache *svc = statvis_cache_validate(mr);
+  float params[4];
+  statvis_params_get(mr, type, params);
+
+  if (svc->loop_weights && (svc->type == type) && equals_v4v4(svc->params, params)) {
+    memcpy(l_weight, svc->loop_weights, sizeof(float) * mr->loop_len);
+    return;
+  }
+
+  switch (type) {
     case SCE_STATVIS_THICKNESS:
       statvis_calc_thickness(mr, l_weight);
       break;
     case SCE_STATVIS_INTERSECT:
       statvis_calc_intersect(mr, l_weight);
       break;
-    case SCE_STATVIS_DISTORT:
-      statvis_calc_distort(mr, l_weight);
-      break;
-    case SCE_STATVIS_SHARP:
-      statvis_calc_sharp(mr, l_weight);
-      break;
   }
+
+  if (svc->loop_weights == NULL) {
+    svc->loop_weights = MEM_mallocN(sizeof(float) * mr->loop_len, __func__);
+  }
+  memcpy(svc->loop_weights, l_weight, sizeof(float) * mr->loop_len);
+  svc->type = type;
+  copy_v4_v4(svc->params, params);
 }
 
 static const MeshExtract extract_mesh_analysis = {
@@ -4147,6 +4434,100 @@ static const MeshExtract extract_fdot_idx = {
 
 /** \} */
 
+/* ---------------------------------------------------------------------- */
+/** \name Extract Statistics
+ * \{ */
+
+typedef struct MeshExtractStats {
+  /** Buffers extracted from scratch and elements (faces, loose edges & verts) iterated. */
+  uint full_buffers, full_elems;
+  /** Buffers updated in place after a deformation and elements iterated. */
+  uint deform_buffers, deform_elems;
+  /** Bytes sent to the GPU by in place updates. */
+  uint64_t deform_upload_size;
+  /** Edit-mesh deformations updated in place, or needing a full rebuild. */
+  uint deform_in_place, deform_rebuild;
+} MeshExtractStats;
+
+/* Only accessed from the main thread. */
+static struct {
+  MeshExtractStats redraw, redraw_last, total;
+} extract_stats = {{0}};
+
+static void extract_stats_add(const MeshExtractStats *stats)
+{
+  MeshExtractStats *dst_array[2] = {&extract_stats.redraw, &extract_stats.total};
+  for (int i = 0; i < ARRAY_SIZE(dst_array); i++) {
+    MeshExtractStats *dst = dst_array[i];
+    dst->full_buffers += stats->full_buffers;
+    dst->full_elems += stats->full_elems;
+    dst->deform_buffers += stats->deform_buffers;
+    dst->deform_elems += stats->deform_elems;
+    dst->deform_upload_size += stats->deform_upload_size;
+    dst->deform_in_place += stats->deform_in_place;
+    dst->deform_rebuild += stats->deform_rebuild;
+  }
+}
+
+static uint extract_stats_elem_len(const MeshRenderData *mr, const eMRIterType iter_type)
+{
+  uint len = 0;
+  if (iter_type & MR_ITER_LOOPTRI) {
+    len += mr->tri_len;
+  }
+  if (iter_type & MR_ITER_LOOP) {
+    len += mr->poly_len;
+  }
+  if (iter_type & MR_ITER_LEDGE) {
+    len += mr->edge_loose_len;
+  }
+  if (iter_type & MR_ITER_LVERT) {
+    len += mr->vert_loose_len;
+  }
+  return len;
+}
+
+void mesh_buffer_cache_stats_deform_add(const bool in_place)
+{
+  extract_stats_add(&(MeshExtractStats){
+      .deform_in_place = in_place ? 1 : 0,
+      .deform_rebuild = in_place ? 0 : 1,
+  });
+}
+
+/* Called at the start of each viewport redraw. */
+void DRW_mesh_batch_cache_stats_redraw_begin(void)
+{
+  extract_stats.redraw_last = extract_stats.redraw;
+  memset(&extract_stats.redraw, 0, sizeof(extract_stats.redraw));
+}
+
+void DRW_mesh_batch_cache_stats_print(void)
+{
+  const MeshExtractStats *last = &extract_stats.redraw_last;
+  const MeshExtractStats *total = &extract_stats.total;
+  printf("Mesh batch extraction (last redraw / total):\n");
+  printf("  full: %u / %u buffers, %u / %u elements\n",
+         last->full_buffers,
+         total->full_buffers,
+         last->full_elems,
+         total->full_elems);
+  printf("  in place: %u / %u buffers, %u / %u elements, %.1f / %.1f KiB uploaded\n",
+         last->deform_buffers,
+         total->deform_buffers,
+         last->deform_elems,
+         total->deform_elems,
+         (double)last->deform_upload_size / 1024.0,
+         (double)total->deform_upload_size / 1024.0);
+  printf("  edit-mesh deform: %u / %u updated in place, %u / %u rebuilt\n",
+         last->deform_in_place,
+         total->deform_in_place,
+         last->deform_rebuild,
+         total->deform_rebuild);
+}
+
+/** \} */
+
 /* ---------------------------------------------------------------------- */
 /** \name Extract Loop
  * \{ */
@@ -4279,6 +4660,11 @@ static void extract_task_create(TaskPool *task_pool,
   taskdata->start = 0;
   taskdata->end = INT_MAX;
 
+  extract_stats_add(&(MeshExtractStats){
+      .full_buffers = 1,
+      .full_elems = extract_stats_elem_len(mr, taskdata->iter_type),
+  });
+
   /* Simple heuristic. */
   const bool use_thread = (mr->loop_len + mr->loop_loose_len) > 8192;
   if (use_thread && extract->use_threading) {
@@ -4478,3 +4864,237 @@ void mesh_buffer_cache_create_requested(MeshBatchCache *cache,
 }
 
 /** \} */
+
+/* ---------------------------------------------------------------------- */
+/** \name Extract Deformed
+ * \{ */
+
+/* Granularity of the re-extracted face ranges. */
+#define DEFORM_CHUNK_SIZE 1024
+
+static int extract_deform_loop_start(const MeshRenderData *mr, int f)
+{
+  if (f >= mr->poly_len) {
+    return mr->loop_len;
+  }
+  return BM_elem_index_get(BM_FACE_FIRST_LOOP(BM_face_at_index(mr->bm, f)));
+}
+
+static void extract_deform_task_create(TaskPool *task_pool,
+                                       const MeshRenderData *mr,
+                                       const MeshExtract *extract,
+                                       void *buf,
+                                       int32_t *task_counter,
+                                       const int (*face_ranges)[2],
+                                       const int face_ranges_len)
+{
+  ExtractTaskData *taskdata = MEM_mallocN(sizeof(*taskdata), "ExtractTaskData");
+  taskdata->mr = mr;
+  taskdata->extract = extract;
+  taskdata->buf = buf;
+  taskdata->user_data = extract->init(mr, buf);
+  taskdata->iter_type = mesh_extract_iter_type(extract);
+  taskdata->task_counter = task_counter;
+
+  const int chunk_size = 8192;
+  if (taskdata->iter_type & MR_ITER_LOOP) {
+    for (int r = 0; r < face_ranges_len; r++) {
+      for (int i = face_ranges[r][0]; i < face_ranges[r][1]; i += chunk_size) {
+        const int len = min_ii(chunk_size, face_ranges[r][1] - i);
+        extract_range_task_create(task_pool, taskdata, MR_ITER_LOOP, i, len);
+      }
+    }
+  }
+  /* Loose elements are few, always update them. */
+  if ((taskdata->iter_type & MR_ITER_LEDGE) && mr->edge_loose_len > 0) {
+    extract_range_task_create(task_pool, taskdata, MR_ITER_LEDGE, 0, mr->edge_loose_len);
+  }
+  if ((taskdata->iter_type & MR_ITER_LVERT) && mr->vert_loose_len > 0) {
+    extract_range_task_create(task_pool, taskdata, MR_ITER_LVERT, 0, mr->vert_loose_len);
+  }
+  /* The pool is suspended, no task ran yet. */
+  if (*task_counter == 0 && extract->finish != NULL) {
+    extract->finish(mr, buf, taskdata->user_data);
+  }
+  MEM_freeN(taskdata);
+}
+
+/**
+ * Update the vertex buffers of \a mbc that only depend on coordinates and normals, after
+ * edit-mesh vertices moved. Changed vertices are found by comparing against the coordinates
+ * stored in \a cache, then only the faces using them are extracted again and uploaded as
+ * sub-ranges. The caller is responsible for discarding other coordinate dependent buffers.
+ *
+ * \return false when the buffers need to be extracted from scratch.
+ */
+bool mesh_buffer_cache_update_deformed(MeshBatchCache *cache, MeshBufferCache mbc, Mesh *me)
+{
+  const MeshExtract *extracts[] = {&extract_pos_nor, &extract_lnor, &extract_fdots_pos};
+  GPUVertBuf *vbos[] = {mbc.vbo.pos_nor, mbc.vbo.lnor, mbc.vbo.fdots_pos};
+  const bool is_per_face[] = {false, false, true};
+  BLI_STATIC_ASSERT(ARRAY_SIZE(extracts) == ARRAY_SIZE(vbos), "Size mismatch");
+
+  eMRIterType iter_flag = 0;
+  eMRDataType data_flag = 0;
+  for (int i = 0; i < ARRAY_SIZE(extracts); i++) {
+    if (vbos[i]) {
+      iter_flag |= mesh_extract_iter_type(extracts[i]);
+      data_flag |= extracts[i]->data_flag;
+    }
+  }
+
+  MeshRenderData *mr = mesh_render_data_create(me, true, false, iter_flag, data_flag, NULL, NULL);
+  mr->cache = cache; /* HACK */
+  mr->use_final_mesh = true;
+  if (mr->extract_type != MR_EXTRACT_BMESH) {
+    mesh_render_data_free(mr);
+    return false;
+  }
+  BMesh *bm = mr->bm;
+
+  /* Find vertices whose coordinates or normals changed since the last update. */
+  int *moved_verts = MEM_mallocN(sizeof(*moved_verts) * mr->vert_len, __func__);
+  int moved_len = 0;
+  {
+    BMIter iter;
+    BMVert *eve;
+    int v;
+    BM_ITER_MESH_INDEX (eve, &iter, bm, BM_VERTS_OF_MESH, v) {
+      if (!equals_v3v3(eve->co, cache->deform_co[v]) ||
+          !equals_v3v3(eve->no, cache->deform_no[v])) {
+        copy_v3_v3(cache->deform_co[v], eve->co);
+        copy_v3_v3(cache->deform_no[v], eve->no);
+        moved_verts[moved_len++] = v;
+      }
+    }
+  }
+
+  /* Tag the chunks of faces using them. */
+  const int chunk_len = (mr->poly_len + DEFORM_CHUNK_SIZE - 1) / DEFORM_CHUNK_SIZE;
+  BLI_bitmap *chunk_dirty = BLI_BITMAP_NEW(max_ii(chunk_len, 1), __func__);
+  if (moved_len > mr->vert_len / 4) {
+    BLI_bitmap_set_all(chunk_dirty, true, chunk_len);
+  }
+  else if (moved_len > 0) {
+    /* Split normals depend on all faces around a vertex, so faces around the vertices of
+     * deformed faces need to be updated too. */
+    BLI_bitmap *vert_ring = mr->loop_normals ? BLI_BITMAP_NEW(mr->vert_len, __func__) : NULL;
+    BMIter iter, l_iter;
+    BMFace *efa;
+    BMLoop *loop;
+    for (int i = 0; i < moved_len; i++) {
+      BMVert *eve = BM_vert_at_index(bm, moved_verts[i]);
+      BM_ITER_ELEM (efa, &iter, eve, BM_FACES_OF_VERT) {
+        BLI_BITMAP_ENABLE(chunk_dirty, BM_elem_index_get(efa) / DEFORM_CHUNK_SIZE);
+        if (vert_ring) {
+          BM_ITER_ELEM (loop, &l_iter, efa, BM_LOOPS_OF_FACE) {
+            BLI_BITMAP_ENABLE(vert_ring, BM_elem_index_get(loop->v));
+          }
+        }
+      }
+    }
+    if (vert_ring) {
+      for (int v = 0; v < mr->vert_len; v++) {
+        if (BLI_BITMAP_TEST(vert_ring, v)) {
+          BM_ITER_ELEM (efa, &iter, BM_vert_at_index(bm, v), BM_FACES_OF_VERT) {
+            BLI_BITMAP_ENABLE(chunk_dirty, BM_elem_index_get(efa) / DEFORM_CHUNK_SIZE);
+          }
+        }
+      }
+      MEM_freeN(vert_ring);
+    }
+  }
+  MEM_freeN(moved_verts);
+
+  /* Merge consecutive chunks into face ranges. */
+  int(*face_ranges)[2] = MEM_mallocN(sizeof(*face_ranges) * (chunk_len + 1), __func__);
+  int face_ranges_len = 0;
+  int face_dirty_len = 0;
+  for (int c = 0; c < chunk_len; c++) {
+    if (BLI_BITMAP_TEST(chunk_dirty, c)) {
+      const int start = c * DEFORM_CHUNK_SIZE;
+      const int end = min_ii(start + DEFORM_CHUNK_SIZE, mr->poly_len);
+      if (face_ranges_len > 0 && face_ranges[face_ranges_len - 1][1] == start) {
+        face_ranges[face_ranges_len - 1][1] = end;
+      }
+      else {
+        face_ranges[face_ranges_len][0] = start;
+        face_ranges[face_ranges_len][1] = end;
+        face_ranges_len++;
+      }
+      face_dirty_len += end - start;
+    }
+  }
+  MEM_freeN(chunk_dirty);
+
+  bool is_valid = true;
+  if (moved_len > 0) {
+    /* Extract to temporary buffers. */
+    GPUVertBuf vbos_update[ARRAY_SIZE(extracts)];
+    int32_t task_counters[ARRAY_SIZE(extracts)] = {0};
+
+    TaskPool *task_pool = BLI_task_pool_create_suspended(BLI_task_scheduler_get(), NULL);
+    for (int i = 0; i < ARRAY_SIZE(extracts); i++) {
+      if (vbos[i]) {
+        extract_deform_task_create(task_pool,
+                                   mr,
+                                   extracts[i],
+                                   &vbos_update[i],
+                                   &task_counters[i],
+                                   (const int(*)[2])face_ranges,
+                                   face_ranges_len);
+      }
+    }
+    BLI_task_pool_work_and_wait(task_pool);
+    BLI_task_pool_free(task_pool);
+
+    /* Upload the updated ranges. */
+    MeshExtractStats stats = {0};
+    for (int i = 0; i < ARRAY_SIZE(extracts); i++) {
+      GPUVertBuf *vbo = vbos[i];
+      GPUVertBuf *vbo_update = &vbos_update[i];
+      if (vbo == NULL) {
+        continue;
+      }
+      if (vbo->vertex_len != vbo_update->vertex_len ||
+          vbo->format.stride != vbo_update->format.stride) {
+        is_valid = false;
+      }
+      else {
+        const uint stride = vbo->format.stride;
+        for (int r = 0; r < face_ranges_len; r++) {
+          int start = face_ranges[r][0], end = face_ranges[r][1];
+          if (!is_per_face[i]) {
+            start = extract_deform_loop_start(mr, start);
+            end = extract_deform_loop_start(mr, end);
+          }
+          GPU_vertbuf_update_sub(vbo, start, end - start, vbo_update->data + start * stride);
+          stats.deform_upload_size += (uint64_t)(end - start) * stride;
+        }
+        if (!is_per_face[i] && vbo->vertex_len > mr->loop_len) {
+          /* Loose edges and vertices are stored after the loops. */
+          const uint loose_len = vbo->vertex_len - mr->loop_len;
+          GPU_vertbuf_update_sub(
+              vbo, mr->loop_len, loose_len, vbo_update->data + mr->loop_len * stride);
+          stats.deform_upload_size += (uint64_t)loose_len * stride;
+        }
+        stats.deform_buffers += 1;
+        stats.deform_elems += face_dirty_len;
+        stats.deform_elems += extract_stats_elem_len(mr,
+                                                     mesh_extract_iter_type(extracts[i]) &
+                                                         (MR_ITER_LEDGE | MR_ITER_LVERT));
+      }
+      GPU_vertbuf_clear(vbo_update);
+    }
+    extract_stats_add(&stats);
+  }
+
+  MEM_freeN(face_ranges);
+  mesh_render_data_free(mr);
+
+  return is_valid;
+}
+
+#undef DEFORM_CHUNK_SIZE
+
+/** \} */
@@ -113,6 +113,7 @@ struct GPUBatch *DRW_lattice_batch_cache_get_all_verts(struct Lattice *lt);
 struct GPUBatch *DRW_lattice_batch_cache_get_edit_verts(struct Lattice *lt);
 
 /* Mesh */
+void DRW_mesh_batch_cache_stats_redraw_begin(void);
 void DRW_mesh_batch_cache_create_requested(struct Object *ob,
                                            struct Mesh *me,
                                            const struct Scene *scene,
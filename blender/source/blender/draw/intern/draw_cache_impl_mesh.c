@@ -439,14 +439,6 @@ static void mesh_batch_cache_init(Mesh *me)
   drw_mesh_weight_state_clear(&cache->weight_state);
 }
 
-void DRW_mesh_batch_cache_validate(Mesh *me)
-{
-  if (!mesh_batch_cache_valid(me)) {
-    mesh_batch_cache_clear(me);
-    mesh_batch_cache_init(me);
-  }
-}
-
 static MeshBatchCache *mesh_batch_cache_get(Mesh *me)
 {
   return me->runtime.batch_cache;
@@ -561,6 +553,12 @@ static void mesh_batch_cache_discard_uvedit_select(MeshBatchCache *cache)
 void DRW_mesh_batch_cache_dirty_tag(Mesh *me, int mode)
 {
   MeshBatchCache *cache = me->runtime.batch_cache;
+  bool is_deform_only = false;
+  if ((mode == BKE_MESH_BATCH_DIRTY_ALL) && me->edit_mesh) {
+    /* Consume the hint, the next update may change more than coordinates. */
+    is_deform_only = me->edit_mesh->is_deform_only;
+    me->edit_mesh->is_deform_only = false;
+  }
   if (cache == NULL) {
     return;
   }
@@ -607,7 +605,12 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *me, int mode)
       cache->batch_ready &= ~(MBC_SURFACE | MBC_WIRE_EDGES | MBC_WIRE_LOOPS | MBC_SURF_PER_MAT);
       break;
     case BKE_MESH_BATCH_DIRTY_ALL:
-      cache->is_dirty = true;
+      if (is_deform_only && !cache->is_dirty) {
+        cache->is_deform_dirty = true;
+      }
+      else {
+        cache->is_dirty = true;
+      }
       break;
     case BKE_MESH_BATCH_DIRTY_SHADING:
       mesh_batch_cache_discard_shaded_tri(cache);
@@ -664,16 +667,182 @@ static void mesh_batch_cache_clear(Mesh *me)
   cache->batch_ready = 0;
 
   drw_mesh_weight_state_clear(&cache->weight_state);
+
+  MEM_SAFE_FREE(cache->deform_co);
+  MEM_SAFE_FREE(cache->deform_no);
 }
 
 void DRW_mesh_batch_cache_free(Mesh *me)
 {
+  if (me->runtime.batch_cache) {
+    mesh_buffer_cache_statvis_free(me->runtime.batch_cache);
+  }
   mesh_batch_cache_clear(me);
   MEM_SAFE_FREE(me->runtime.batch_cache);
 }
 
 /** \} */
 
+/* ---------------------------------------------------------------------- */
+/** \name Edit-Mesh Deform Update
+ *
+ * While transforming in edit-mode only the vertex coordinates change. Instead of discarding
+ * the whole cache, buffers that only depend on coordinates and normals are patched in place
+ * (see #mesh_buffer_cache_update_deformed) and the few others that depend on them are
+ * discarded. Topology, selection and custom-data buffers are kept as is.
+ * \{ */
+
+/* Buffers are extracted from the #BMesh directly (no modifiers on the cage). */
+static bool mesh_batch_cache_deform_supported(const Mesh *me)
+{
+  const BMEditMesh *em = me->edit_mesh;
+  return (em != NULL) && (em->mesh_eval_final != NULL) &&
+         (em->mesh_eval_final == em->mesh_eval_cage) && em->mesh_eval_final->runtime.is_original;
+}
+
+/* N-gon tessellation depends on the vertex coordinates. */
+static uint64_t mesh_batch_cache_tess_hash(const BMEditMesh *em)
+{
+  /* FNV-1a over the loop pointers. */
+  uint64_t hash = 14695981039346656037ULL;
+  for (int i = 0; i < em->tottri; i++) {
+    for (int j = 0; j < 3; j++) {
+      hash = (hash ^ (uint64_t)(uintptr_t)em->looptris[i][j]) * 1099511628211ULL;
+    }
+  }
+  return hash;
+}
+
+static void mesh_batch_cache_deform_snapshot(Mesh *me, MeshBatchCache *cache)
+{
+  BMEditMesh *em = me->edit_mesh;
+  BMesh *bm = em->bm;
+  BMIter iter;
+  BMVert *eve;
+  int v;
+
+  cache->deform_co = MEM_mallocN(sizeof(*cache->deform_co) * bm->totvert, __func__);
+  cache->deform_no = MEM_mallocN(sizeof(*cache->deform_no) * bm->totvert, __func__);
+  BM_ITER_MESH_INDEX (eve, &iter, bm, BM_VERTS_OF_MESH, v) {
+    copy_v3_v3(cache->deform_co[v], eve->co);
+    copy_v3_v3(cache->deform_no[v], eve->no);
+  }
+  cache->vert_len = bm->totvert;
+  cache->edge_len = bm->totedge;
+  cache->poly_len = bm->totface;
+  cache->tri_len = em->tottri;
+  cache->deform_tess_hash = mesh_batch_cache_tess_hash(em);
+}
+
+/* Discard the triangle index buffers and every batch using them. */
+static void mesh_batch_cache_discard_deformed_tess(MeshBatchCache *cache)
+{
+  MeshBufferCache *mbufcache = &cache->final;
+  GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.tris);
+  GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.edituv_tris);
+  GPU_INDEXBUF_DISCARD_SAFE(mbufcache->ibo.lines_adjacency);
+
+  GPU_BATCH_DISCARD_SAFE(cache->batch.surface);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.surface_weights);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edit_mesh_analysis);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edit_triangles);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edit_lnor);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edit_selection_faces);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edituv_faces_stretch_area);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edituv_faces_stretch_angle);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edituv_faces);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edge_detection);
+  mesh_batch_cache_discard_shaded_batches(cache);
+
+  cache->batch_ready &= ~(MBC_SURFACE | MBC_SURFACE_WEIGHTS | MBC_EDIT_MESH_ANALYSIS |
+                          MBC_EDIT_TRIANGLES | MBC_EDIT_LNOR | MBC_EDIT_SELECTION_FACES |
+                          MBC_EDITUV_FACES_STRETCH_AREA | MBC_EDITUV_FACES_STRETCH_ANGLE |
+                          MBC_EDITUV_FACES | MBC_EDGE_DETECTION);
+}
+
+/* Discard buffers depending on coordinates that cannot be updated in place. */
+static void mesh_batch_cache_discard_deformed(MeshBatchCache *cache)
+{
+  MeshBufferCache *mbufcache = &cache->final;
+  GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.edge_fac);
+  GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.mesh_analysis);
+  GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.fdots_nor);
+  GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.stretch_area);
+  GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.stretch_angle);
+  GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.skin_roots);
+
+  GPU_BATCH_DISCARD_SAFE(cache->batch.wire_edges);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edit_mesh_analysis);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edit_fdots);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edituv_faces_stretch_area);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edituv_faces_stretch_angle);
+  GPU_BATCH_DISCARD_SAFE(cache->batch.edit_skin_roots);
+
+  cache->batch_ready &= ~(MBC_WIRE_EDGES | MBC_EDIT_MESH_ANALYSIS | MBC_EDIT_FACEDOTS |
+                          MBC_EDITUV_FACES_STRETCH_AREA | MBC_EDITUV_FACES_STRETCH_ANGLE |
+                          MBC_SKIN_ROOTS);
+
+  if (mbufcache->vbo.tan) {
+    GPU_VERTBUF_DISCARD_SAFE(mbufcache->vbo.tan);
+    mesh_batch_cache_discard_shaded_batches(cache);
+  }
+}
+
+/* Return false when the whole cache needs to be rebuilt. */
+static bool mesh_batch_cache_deform_update(Mesh *me, MeshBatchCache *cache)
+{
+  if (!mesh_batch_cache_deform_supported(me) || (cache->deform_co == NULL)) {
+    return false;
+  }
+  BMEditMesh *em = me->edit_mesh;
+  BMesh *bm = em->bm;
+  if ((bm->totvert != cache->vert_len) || (bm->totedge != cache->edge_len) ||
+      (bm->totface != cache->poly_len) || (em->tottri != cache->tri_len)) {
+    return false;
+  }
+
+  const uint64_t tess_hash = mesh_batch_cache_tess_hash(em);
+  if (tess_hash != cache->deform_tess_hash) {
+    mesh_batch_cache_discard_deformed_tess(cache);
+    cache->deform_tess_hash = tess_hash;
+  }
+  mesh_batch_cache_discard_deformed(cache);
+
+  return mesh_buffer_cache_update_deformed(cache, cache->final, me);
+}
+
+void DRW_mesh_batch_cache_validate(Mesh *me)
+{
+  MeshBatchCache *cache = me->runtime.batch_cache;
+  if (cache && cache->is_deform_dirty) {
+    cache->is_deform_dirty = false;
+    const bool in_place = mesh_batch_cache_valid(me) && mesh_batch_cache_deform_update(me, cache);
+    if (!in_place) {
+      cache->is_dirty = true;
+    }
+    mesh_buffer_cache_stats_deform_add(in_place);
+  }
+
+  if (!mesh_batch_cache_valid(me)) {
+    /* Mesh analysis weights are validated against the geometry when extracted. */
+    struct MeshStatVisCache *statvis_cache = cache ? cache->statvis_cache : NULL;
+    mesh_batch_cache_clear(me);
+    mesh_batch_cache_init(me);
+    cache = me->runtime.batch_cache;
+    cache->statvis_cache = statvis_cache;
+  }
+
+  if (!cache->is_editmode) {
+    mesh_buffer_cache_statvis_free(cache);
+  }
+  if (cache->is_editmode && (cache->deform_co == NULL) && mesh_batch_cache_deform_supported(me)) {
+    /* The buffers of a valid cache always match the current coordinates. */
+    mesh_batch_cache_deform_snapshot(me, cache);
+  }
+}
+
+/** \} */
+
 /* ---------------------------------------------------------------------- */
 /** \name Public API
  * \{ */
@@ -83,6 +83,8 @@ SnapObjectContext *ED_transform_snap_object_context_create_view3d(struct Main *b
                                                                   const struct ARegion *ar,
                                                                   const struct View3D *v3d);
 void ED_transform_snap_object_context_destroy(SnapObjectContext *sctx);
+/* Invalidate the objects cached by all snap contexts, call on depsgraph updates. */
+void ED_transform_snap_object_tag_update(void);
 
 /* callbacks to filter how snap works */
 void ED_transform_snap_object_context_set_editmesh_callbacks(
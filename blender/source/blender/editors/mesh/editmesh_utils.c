@@ -1400,6 +1400,9 @@ void EDBM_update_generic(BMEditMesh *em, const bool do_tessellation, const bool
     BKE_editmesh_looptri_calc(em);
   }
 
+  /* Anything may have changed, not only coordinates. */
+  em->is_deform_only = false;
+
   if (is_destructive) {
     /* TODO. we may be able to remove this now! - Campbell */
     // BM_mesh_elem_table_free(em->bm, BM_ALL_NOLOOP);
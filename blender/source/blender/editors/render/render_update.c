@@ -57,6 +57,7 @@
 
 #include "ED_node.h"
 #include "ED_render.h"
+#include "ED_transform_snap_object_context.h"
 #include "ED_view3d.h"
 
 #include "DEG_depsgraph.h"
@@ -85,6 +86,10 @@ void ED_render_scene_update(const DEGEditorUpdateContext *update_ctx, int update
     return;
   }
 
+  if (updated) {
+    ED_transform_snap_object_tag_update();
+  }
+
   /* don't call this recursively for frame updates */
   if (recursive_check) {
     return;
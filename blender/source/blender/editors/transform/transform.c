@@ -3958,6 +3958,20 @@ static void ElementResize(TransInfo *t, TransDataContainer *tc, TransData *td, f
   constraintTransLim(t, td);
 }
 
+static void transdata_elem_resize(TransInfo *t,
+                                  TransDataContainer *tc,
+                                  TransData *td,
+                                  void *user_data)
+{
+  float(*mat)[3] = user_data;
+
+  if (td->flag & (TD_NOACTION | TD_SKIP)) {
+    return;
+  }
+
+  ElementResize(t, tc, td, mat);
+}
+
 static void applyResize(TransInfo *t, const int UNUSED(mval[2]))
 {
   float mat[3][3];
@@ -4004,19 +4018,9 @@ static void applyResize(TransInfo *t, const int UNUSED(mval[2]))
 
   copy_m3_m3(t->mat, mat);  // used in gizmo
 
+  const bool use_threading = transdata_use_threading(t);
   FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-    TransData *td = tc->data;
-    for (i = 0; i < tc->data_len; i++, td++) {
-      if (td->flag & TD_NOACTION) {
-        break;
-      }
-
-      if (td->flag & TD_SKIP) {
-        continue;
-      }
-
-      ElementResize(t, tc, td, mat);
-    }
+    transdata_foreach_parallel(t, tc, use_threading, transdata_elem_resize, mat);
   }
 
   /* evil hack - redo resize if cliping needed */
@@ -4582,14 +4586,81 @@ static float large_rotation_limit(float angle)
   return angle;
 }
 
+typedef struct RotationElemData {
+  float angle;
+  float angle_step;
+  const float *axis;
+  bool is_large_rotation;
+  /** Rotation matrix for elements using the unmodified angle & axis. */
+  float mat[3][3];
+} RotationElemData;
+
+static void transdata_elem_rotate(TransInfo *t,
+                                  TransDataContainer *tc,
+                                  TransData *td,
+                                  void *user_data)
+{
+  const RotationElemData *data = user_data;
+  const float angle = data->angle;
+  float axis[3], mat[3][3];
+  bool do_update_matrix = false;
+
+  if (td->flag & (TD_NOACTION | TD_SKIP)) {
+    return;
+  }
+
+  copy_v3_v3(axis, data->axis);
+
+  float angle_final = angle;
+  if (t->con.applyRot) {
+    t->con.applyRot(t, tc, td, axis, NULL);
+    angle_final = angle * td->factor;
+    /* Even though final angle might be identical to orig value,
+     * we have to update the rotation matrix in that case... */
+    do_update_matrix = true;
+  }
+  else if (t->flag & T_PROP_EDIT) {
+    angle_final = angle * td->factor;
+  }
+
+  /* Rotation is very likely to be above 180°, we need to do rotation by steps.
+   * Note that this is only needed when doing 'absolute' rotation
+   * (i.e. from initial rotation again, typically when using numinput).
+   * regular incremental rotation (from mouse/widget/...) will be called often enough,
+   * hence steps are small enough to be properly handled without that complicated trick.
+   * Note that we can only do that kind of stepped rotation if we have initial rotation values
+   * (and access to some actual rotation value storage).
+   * Otherwise, just assume it's useless (e.g. in case of mesh/UV/etc. editing).
+   * Also need to be in Euler rotation mode, the others never allow more than one turn anyway.
+   */
+  if (data->is_large_rotation && td->ext != NULL && td->ext->rotOrder == ROT_MODE_EUL) {
+    copy_v3_v3(td->ext->rot, td->ext->irot);
+    for (float angle_progress = data->angle_step; fabsf(angle_progress) < fabsf(angle_final);
+         angle_progress += data->angle_step) {
+      axis_angle_normalized_to_mat3(mat, axis, angle_progress);
+      ElementRotation(t, tc, td, mat, t->around);
+    }
+    do_update_matrix = true;
+  }
+  else if (angle_final != angle) {
+    do_update_matrix = true;
+  }
+
+  if (do_update_matrix) {
+    axis_angle_normalized_to_mat3(mat, axis, angle_final);
+  }
+  else {
+    copy_m3_m3(mat, (float(*)[3])data->mat);
+  }
+
+  ElementRotation(t, tc, td, mat, t->around);
+}
+
 static void applyRotationValue(TransInfo *t,
                                float angle,
                                float axis[3],
                                const bool is_large_rotation)
 {
-  float mat[3][3];
-  int i;
-
   const float angle_sign = angle < 0.0f ? -1.0f : 1.0f;
   /* We cannot use something too close to 180°, or 'continuous' rotation may fail
    * due to computing error... */
@@ -4601,65 +4672,19 @@ static void applyRotationValue(TransInfo *t,
     angle = large_rotation_limit(angle);
   }
 
-  axis_angle_normalized_to_mat3(mat, axis, angle);
-  /* Counter for needed updates (when we need to update to non-default matrix,
-   * we also need another update on next iteration to go back to default matrix,
-   * hence the '2' value used here, instead of a mere boolean). */
-  short do_update_matrix = 0;
+  /* Each element computes its own matrix when it differs from the shared one,
+   * so elements can be rotated independently. */
+  RotationElemData data = {
+      .angle = angle,
+      .angle_step = angle_step,
+      .axis = axis,
+      .is_large_rotation = is_large_rotation,
+  };
+  axis_angle_normalized_to_mat3(data.mat, axis, angle);
 
+  const bool use_threading = transdata_use_threading(t);
   FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-    TransData *td = tc->data;
-    for (i = 0; i < tc->data_len; i++, td++) {
-      if (td->flag & TD_NOACTION) {
-        break;
-      }
-
-      if (td->flag & TD_SKIP) {
-        continue;
-      }
-
-      float angle_final = angle;
-      if (t->con.applyRot) {
-        t->con.applyRot(t, tc, td, axis, NULL);
-        angle_final = angle * td->factor;
-        /* Even though final angle might be identical to orig value,
-         * we have to update the rotation matrix in that case... */
-        do_update_matrix = 2;
-      }
-      else if (t->flag & T_PROP_EDIT) {
-        angle_final = angle * td->factor;
-      }
-
-      /* Rotation is very likely to be above 180°, we need to do rotation by steps.
-       * Note that this is only needed when doing 'absolute' rotation
-       * (i.e. from initial rotation again, typically when using numinput).
-       * regular incremental rotation (from mouse/widget/...) will be called often enough,
-       * hence steps are small enough to be properly handled without that complicated trick.
-       * Note that we can only do that kind of stepped rotation if we have initial rotation values
-       * (and access to some actual rotation value storage).
-       * Otherwise, just assume it's useless (e.g. in case of mesh/UV/etc. editing).
-       * Also need to be in Euler rotation mode, the others never allow more than one turn anyway.
-       */
-      if (is_large_rotation && td->ext != NULL && td->ext->rotOrder == ROT_MODE_EUL) {
-        copy_v3_v3(td->ext->rot, td->ext->irot);
-        for (float angle_progress = angle_step; fabsf(angle_progress) < fabsf(angle_final);
-             angle_progress += angle_step) {
-          axis_angle_normalized_to_mat3(mat, axis, angle_progress);
-          ElementRotation(t, tc, td, mat, t->around);
-        }
-        do_update_matrix = 2;
-      }
-      else if (angle_final != angle) {
-        do_update_matrix = 2;
-      }
-
-      if (do_update_matrix > 0) {
-        axis_angle_normalized_to_mat3(mat, axis, angle_final);
-        do_update_matrix--;
-      }
-
-      ElementRotation(t, tc, td, mat, t->around);
-    }
+    transdata_foreach_parallel(t, tc, use_threading, transdata_elem_rotate, &data);
   }
 }
 
@@ -5191,105 +5216,118 @@ static void headerTranslation(TransInfo *t, const float vec[3], char str[UI_MAX_
   }
 }
 
-static void applyTranslationValue(TransInfo *t, const float vec[3])
+typedef struct TranslationElemData {
+  const float *vec;
+  float pivot[3];
+  bool apply_snap_align_rotation;
+} TranslationElemData;
+
+static void transdata_elem_translate(TransInfo *t,
+                                     TransDataContainer *tc,
+                                     TransData *td,
+                                     void *user_data)
 {
-  const bool apply_snap_align_rotation = usingSnappingNormal(
-      t);  // && (t->tsnap.status & POINT_INIT);
+  const TranslationElemData *data = user_data;
   float tvec[3];
 
-  /* The ideal would be "apply_snap_align_rotation" only when a snap point is found
-   * so, maybe inside this function is not the best place to apply this rotation.
-   * but you need "handle snapping rotation before doing the translation" (really?) */
-  FOREACH_TRANS_DATA_CONTAINER (t, tc) {
+  if (td->flag & (TD_NOACTION | TD_SKIP)) {
+    return;
+  }
 
-    float pivot[3];
-    if (apply_snap_align_rotation) {
-      copy_v3_v3(pivot, t->tsnap.snapTarget);
-      /* The pivot has to be in local-space (see T49494) */
-      if (tc->use_local_mat) {
-        mul_m4_v3(tc->imat, pivot);
-      }
-    }
+  float rotate_offset[3] = {0};
+  bool use_rotate_offset = false;
 
-    TransData *td = tc->data;
-    for (int i = 0; i < tc->data_len; i++, td++) {
-      if (td->flag & TD_NOACTION) {
-        break;
-      }
+  /* handle snapping rotation before doing the translation */
+  if (data->apply_snap_align_rotation) {
+    float mat[3][3];
 
-      if (td->flag & TD_SKIP) {
-        continue;
+    if (validSnappingNormal(t)) {
+      const float *original_normal;
+
+      /* In pose mode, we want to align normals with Y axis of bones... */
+      if (t->flag & T_POSE) {
+        original_normal = td->axismtx[1];
+      }
+      else {
+        original_normal = td->axismtx[2];
       }
 
-      float rotate_offset[3] = {0};
-      bool use_rotate_offset = false;
+      rotation_between_vecs_to_mat3(mat, original_normal, t->tsnap.snapNormal);
+    }
+    else {
+      unit_m3(mat);
+    }
 
-      /* handle snapping rotation before doing the translation */
-      if (apply_snap_align_rotation) {
-        float mat[3][3];
+    ElementRotation_ex(t, tc, td, mat, data->pivot);
 
-        if (validSnappingNormal(t)) {
-          const float *original_normal;
+    if (td->loc) {
+      use_rotate_offset = true;
+      sub_v3_v3v3(rotate_offset, td->loc, td->iloc);
+    }
+  }
 
-          /* In pose mode, we want to align normals with Y axis of bones... */
-          if (t->flag & T_POSE) {
-            original_normal = td->axismtx[1];
-          }
-          else {
-            original_normal = td->axismtx[2];
-          }
+  if (t->con.applyVec) {
+    float pvec[3];
+    t->con.applyVec(t, tc, td, data->vec, tvec, pvec);
+  }
+  else {
+    copy_v3_v3(tvec, data->vec);
+  }
 
-          rotation_between_vecs_to_mat3(mat, original_normal, t->tsnap.snapNormal);
-        }
-        else {
-          unit_m3(mat);
-        }
+  if (use_rotate_offset) {
+    add_v3_v3(tvec, rotate_offset);
+  }
 
-        ElementRotation_ex(t, tc, td, mat, pivot);
+  mul_m3_v3(td->smtx, tvec);
 
-        if (td->loc) {
-          use_rotate_offset = true;
-          sub_v3_v3v3(rotate_offset, td->loc, td->iloc);
-        }
-      }
+  if (t->options & CTX_GPENCIL_STROKES) {
+    /* grease pencil multiframe falloff */
+    bGPDstroke *gps = (bGPDstroke *)td->extra;
+    if (gps != NULL) {
+      mul_v3_fl(tvec, td->factor * gps->runtime.multi_frame_falloff);
+    }
+    else {
+      mul_v3_fl(tvec, td->factor);
+    }
+  }
+  else {
+    /* proportional editing falloff */
+    mul_v3_fl(tvec, td->factor);
+  }
 
-      if (t->con.applyVec) {
-        float pvec[3];
-        t->con.applyVec(t, tc, td, vec, tvec, pvec);
-      }
-      else {
-        copy_v3_v3(tvec, vec);
-      }
+  protectedTransBits(td->protectflag, tvec);
 
-      if (use_rotate_offset) {
-        add_v3_v3(tvec, rotate_offset);
-      }
+  if (td->loc) {
+    add_v3_v3v3(td->loc, td->iloc, tvec);
+  }
 
-      mul_m3_v3(td->smtx, tvec);
+  constraintTransLim(t, td);
+}
 
-      if (t->options & CTX_GPENCIL_STROKES) {
-        /* grease pencil multiframe falloff */
-        bGPDstroke *gps = (bGPDstroke *)td->extra;
-        if (gps != NULL) {
-          mul_v3_fl(tvec, td->factor * gps->runtime.multi_frame_falloff);
-        }
-        else {
-          mul_v3_fl(tvec, td->factor);
-        }
-      }
-      else {
-        /* proportional editing falloff */
-        mul_v3_fl(tvec, td->factor);
-      }
+static void applyTranslationValue(TransInfo *t, const float vec[3])
+{
+  const bool apply_snap_align_rotation = usingSnappingNormal(
+      t);  // && (t->tsnap.status & POINT_INIT);
+  const bool use_threading = transdata_use_threading(t);
 
-      protectedTransBits(td->protectflag, tvec);
+  /* The ideal would be "apply_snap_align_rotation" only when a snap point is found
+   * so, maybe inside this function is not the best place to apply this rotation.
+   * but you need "handle snapping rotation before doing the translation" (really?) */
+  FOREACH_TRANS_DATA_CONTAINER (t, tc) {
+    TranslationElemData data = {
+        .vec = vec,
+        .apply_snap_align_rotation = apply_snap_align_rotation,
+    };
 
-      if (td->loc) {
-        add_v3_v3v3(td->loc, td->iloc, tvec);
+    if (apply_snap_align_rotation) {
+      copy_v3_v3(data.pivot, t->tsnap.snapTarget);
+      /* The pivot has to be in local-space (see T49494) */
+      if (tc->use_local_mat) {
+        mul_m4_v3(tc->imat, data.pivot);
       }
-
-      constraintTransLim(t, td);
     }
+
+    transdata_foreach_parallel(t, tc, use_threading, transdata_elem_translate, &data);
   }
 }
 
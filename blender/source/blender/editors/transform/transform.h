@@ -1017,6 +1017,17 @@ bool calculateCenterActive(TransInfo *t, bool select_only, float r_center[3]);
 
 void calculatePropRatio(TransInfo *t);
 
+typedef void (*TransDataForeachFn)(TransInfo *t,
+                                   TransDataContainer *tc,
+                                   TransData *td,
+                                   void *user_data);
+bool transdata_use_threading(const TransInfo *t);
+void transdata_foreach_parallel(TransInfo *t,
+                                TransDataContainer *tc,
+                                const bool use_threading,
+                                TransDataForeachFn elem_fn,
+                                void *user_data);
+
 void getViewVector(const TransInfo *t, const float coord[3], float vec[3]);
 
 void transform_data_ext_rotate(TransData *td, float mat[3][3], bool use_drot);
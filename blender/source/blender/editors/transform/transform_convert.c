@@ -189,6 +189,71 @@ static void sort_trans_data_selected_first(TransInfo *t)
   }
 }
 
+typedef struct PropDistData {
+  KDTree_3d *td_tree;
+  /** Pointers to selected's #TransData, indexed by the kd-tree. */
+  TransData **td_table;
+  const float *proj_vec;
+  bool use_island;
+  bool with_dist;
+} PropDistData;
+
+/**
+ * Position of \a td used for proportional distance, in global or \a proj_vec space.
+ */
+static void prop_dist_co_get(const TransDataContainer *tc,
+                             const TransData *td,
+                             const float *proj_vec,
+                             const bool use_island,
+                             float r_vec[3])
+{
+  const float *co = use_island ? td->iloc : td->center;
+
+  if (tc->use_local_mat) {
+    mul_v3_m4v3(r_vec, tc->mat, co);
+  }
+  else {
+    mul_v3_m3v3(r_vec, td->mtx, co);
+  }
+
+  if (proj_vec) {
+    float vec_p[3];
+    project_v3_v3v3(vec_p, r_vec, proj_vec);
+    sub_v3_v3(r_vec, vec_p);
+  }
+}
+
+static void prop_dist_elem_nearest(TransInfo *UNUSED(t),
+                                   TransDataContainer *tc,
+                                   TransData *td,
+                                   void *user_data)
+{
+  const PropDistData *data = user_data;
+  float vec[3];
+
+  if (td->flag & TD_SELECTED) {
+    return;
+  }
+
+  prop_dist_co_get(tc, td, data->proj_vec, data->use_island, vec);
+
+  KDTreeNearest_3d nearest;
+  const int td_index = BLI_kdtree_3d_find_nearest(data->td_tree, vec, &nearest);
+
+  td->rdist = -1.0f;
+  if (td_index != -1) {
+    td->rdist = nearest.dist;
+    if (data->use_island) {
+      copy_v3_v3(td->center, data->td_table[td_index]->center);
+      copy_m3_m3(td->axismtx, data->td_table[td_index]->axismtx);
+    }
+  }
+
+  if (data->with_dist) {
+    td->dist = td->rdist;
+  }
+}
+
 /**
  * Distance calculated from not-selected vertex to nearest selected vertex.
  */
@@ -241,28 +306,7 @@ static void set_prop_dist(TransInfo *t, const bool with_dist)
         float vec[3];
         td->rdist = 0.0f;
 
-        if (use_island) {
-          if (tc->use_local_mat) {
-            mul_v3_m4v3(vec, tc->mat, td->iloc);
-          }
-          else {
-            mul_v3_m3v3(vec, td->mtx, td->iloc);
-          }
-        }
-        else {
-          if (tc->use_local_mat) {
-            mul_v3_m4v3(vec, tc->mat, td->center);
-          }
-          else {
-            mul_v3_m3v3(vec, td->mtx, td->center);
-          }
-        }
-
-        if (proj_vec) {
-          float vec_p[3];
-          project_v3_v3v3(vec_p, vec, proj_vec);
-          sub_v3_v3(vec, vec_p);
-        }
+        prop_dist_co_get(tc, td, proj_vec, use_island, vec);
 
         BLI_kdtree_3d_insert(td_tree, td_table_index, vec);
         td_table[td_table_index++] = td;
@@ -277,53 +321,17 @@ static void set_prop_dist(TransInfo *t, const bool with_dist)
 
   BLI_kdtree_3d_balance(td_tree);
 
-  /* For each non-selected vertex, find distance to the nearest selected vertex. */
+  /* For each non-selected vertex, find distance to the nearest selected vertex.
+   * Queries only read the tree & selected elements, so they run in parallel. */
+  PropDistData data = {
+      .td_tree = td_tree,
+      .td_table = td_table,
+      .proj_vec = proj_vec,
+      .use_island = use_island,
+      .with_dist = with_dist,
+  };
   FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-    TransData *td = tc->data;
-    for (a = 0; a < tc->data_len; a++, td++) {
-      if ((td->flag & TD_SELECTED) == 0) {
-        float vec[3];
-
-        if (use_island) {
-          if (tc->use_local_mat) {
-            mul_v3_m4v3(vec, tc->mat, td->iloc);
-          }
-          else {
-            mul_v3_m3v3(vec, td->mtx, td->iloc);
-          }
-        }
-        else {
-          if (tc->use_local_mat) {
-            mul_v3_m4v3(vec, tc->mat, td->center);
-          }
-          else {
-            mul_v3_m3v3(vec, td->mtx, td->center);
-          }
-        }
-
-        if (proj_vec) {
-          float vec_p[3];
-          project_v3_v3v3(vec_p, vec, proj_vec);
-          sub_v3_v3(vec, vec_p);
-        }
-
-        KDTreeNearest_3d nearest;
-        const int td_index = BLI_kdtree_3d_find_nearest(td_tree, vec, &nearest);
-
-        td->rdist = -1.0f;
-        if (td_index != -1) {
-          td->rdist = nearest.dist;
-          if (use_island) {
-            copy_v3_v3(td->center, td_table[td_index]->center);
-            copy_m3_m3(td->axismtx, td_table[td_index]->axismtx);
-          }
-        }
-
-        if (with_dist) {
-          td->dist = td->rdist;
-        }
-      }
-    }
+    transdata_foreach_parallel(t, tc, true, prop_dist_elem_nearest, &data);
   }
 
   BLI_kdtree_3d_free(td_tree);
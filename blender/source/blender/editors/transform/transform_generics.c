@@ -48,6 +48,7 @@
 #include "BLI_math.h"
 #include "BLI_blenlib.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "PIL_time.h"
@@ -902,11 +903,16 @@ static void recalcData_objects(TransInfo *t)
         projectVertSlideData(t, false);
       }
 
+      /* These modes edit custom-data instead of coordinates. */
+      const bool is_custom_data_mode = ELEM(t->mode, TFM_BWEIGHT, TFM_CREASE, TFM_SKIN_RESIZE);
+
       FOREACH_TRANS_DATA_CONTAINER (t, tc) {
         DEG_id_tag_update(tc->obedit->data, 0); /* sets recalc flags */
         BMEditMesh *em = BKE_editmesh_from_object(tc->obedit);
         EDBM_mesh_normals_update(em);
         BKE_editmesh_looptri_calc(em);
+        /* Let drawing update coordinates in place, unless UV's are corrected too. */
+        em->is_deform_only = !is_custom_data_mode && (tc->custom.type.data == NULL);
       }
     }
     else if (t->obedit_type == OB_ARMATURE) { /* no recalc flag, does pose */
@@ -2340,89 +2346,151 @@ const TransCenterData *transformCenter_from_type(TransInfo *t, int around)
   return cd;
 }
 
-void calculatePropRatio(TransInfo *t)
+/* -------------------------------------------------------------------- */
+/** \name Parallel Iteration over Transform Data
+ * \{ */
+
+typedef struct TransDataForeachData {
+  TransInfo *t;
+  TransDataContainer *tc;
+  TransDataForeachFn elem_fn;
+  void *user_data;
+} TransDataForeachData;
+
+static void transdata_foreach_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  TransDataForeachData *data = userdata;
+  data->elem_fn(data->t, data->tc, &data->tc->data[i], data->user_data);
+}
+
+/**
+ * Elements of edit-mode data are transformed independently from each other. Objects & bones
+ * may evaluate limit constraints and grease pencil strokes change the shared input values.
+ */
+bool transdata_use_threading(const TransInfo *t)
+{
+  return (t->flag & T_EDIT) && !(t->options & CTX_GPENCIL_STROKES);
+}
+
+/**
+ * Call \a elem_fn for every element of \a tc, in parallel when \a use_threading is set
+ * and there are enough elements. \a elem_fn handles #TD_SKIP & #TD_NOACTION itself.
+ */
+void transdata_foreach_parallel(TransInfo *t,
+                                TransDataContainer *tc,
+                                const bool use_threading,
+                                TransDataForeachFn elem_fn,
+                                void *user_data)
+{
+  TransDataForeachData data = {
+      .t = t,
+      .tc = tc,
+      .elem_fn = elem_fn,
+      .user_data = user_data,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = use_threading;
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, tc->data_len, &data, transdata_foreach_cb, &settings);
+}
+
+/** \} */
+
+static void transdata_elem_prop_ratio(TransInfo *t,
+                                      TransDataContainer *UNUSED(tc),
+                                      TransData *td,
+                                      void *UNUSED(user_data))
 {
-  int i;
-  float dist;
   const bool connected = (t->flag & T_PROP_CONNECTED) != 0;
+  float dist;
+
+  if (td->flag & TD_SELECTED) {
+    td->factor = 1.0f;
+  }
+  else if ((connected && (td->flag & TD_NOTCONNECTED || td->dist > t->prop_size)) ||
+           (connected == 0 && td->rdist > t->prop_size)) {
+    /*
+     * The elements are sorted according to their dist member in the array,
+     * that means we can stop when it finds one element outside of the propsize.
+     * do not set 'td->flag |= TD_NOACTION', the prop circle is being changed.
+     */
+
+    td->factor = 0.0f;
+    restoreElement(td);
+  }
+  else {
+    /* Use rdist for falloff calculations, it is the real distance */
+    td->flag &= ~TD_NOACTION;
+
+    if (connected) {
+      dist = (t->prop_size - td->dist) / t->prop_size;
+    }
+    else {
+      dist = (t->prop_size - td->rdist) / t->prop_size;
+    }
 
+    /*
+     * Clamp to positive numbers.
+     * Certain corner cases with connectivity and individual centers
+     * can give values of rdist larger than propsize.
+     */
+    if (dist < 0.0f) {
+      dist = 0.0f;
+    }
+
+    switch (t->prop_mode) {
+      case PROP_SHARP:
+        td->factor = dist * dist;
+        break;
+      case PROP_SMOOTH:
+        td->factor = 3.0f * dist * dist - 2.0f * dist * dist * dist;
+        break;
+      case PROP_ROOT:
+        td->factor = sqrtf(dist);
+        break;
+      case PROP_LIN:
+        td->factor = dist;
+        break;
+      case PROP_CONST:
+        td->factor = 1.0f;
+        break;
+      case PROP_SPHERE:
+        td->factor = sqrtf(2 * dist - dist * dist);
+        break;
+      case PROP_RANDOM:
+        td->factor = BLI_rng_get_float(t->rng) * dist;
+        break;
+      case PROP_INVSQUARE:
+        td->factor = dist * (2.0f - dist);
+        break;
+      default:
+        td->factor = 1;
+        break;
+    }
+  }
+}
+
+void calculatePropRatio(TransInfo *t)
+{
   t->proptext[0] = '\0';
 
   if (t->flag & T_PROP_EDIT) {
     const char *pet_id = NULL;
-    FOREACH_TRANS_DATA_CONTAINER (t, tc) {
-      TransData *td = tc->data;
-      for (i = 0; i < tc->data_len; i++, td++) {
-        if (td->flag & TD_SELECTED) {
-          td->factor = 1.0f;
-        }
-        else if ((connected && (td->flag & TD_NOTCONNECTED || td->dist > t->prop_size)) ||
-                 (connected == 0 && td->rdist > t->prop_size)) {
-          /*
-           * The elements are sorted according to their dist member in the array,
-           * that means we can stop when it finds one element outside of the propsize.
-           * do not set 'td->flag |= TD_NOACTION', the prop circle is being changed.
-           */
-
-          td->factor = 0.0f;
-          restoreElement(td);
-        }
-        else {
-          /* Use rdist for falloff calculations, it is the real distance */
-          td->flag &= ~TD_NOACTION;
-
-          if (connected) {
-            dist = (t->prop_size - td->dist) / t->prop_size;
-          }
-          else {
-            dist = (t->prop_size - td->rdist) / t->prop_size;
-          }
 
-          /*
-           * Clamp to positive numbers.
-           * Certain corner cases with connectivity and individual centers
-           * can give values of rdist larger than propsize.
-           */
-          if (dist < 0.0f) {
-            dist = 0.0f;
-          }
+    if (t->prop_mode == PROP_RANDOM && t->rng == NULL) {
+      /* Lazy initialization. */
+      uint rng_seed = (uint)(PIL_check_seconds_timer_i() & UINT_MAX);
+      t->rng = BLI_rng_new(rng_seed);
+    }
 
-          switch (t->prop_mode) {
-            case PROP_SHARP:
-              td->factor = dist * dist;
-              break;
-            case PROP_SMOOTH:
-              td->factor = 3.0f * dist * dist - 2.0f * dist * dist * dist;
-              break;
-            case PROP_ROOT:
-              td->factor = sqrtf(dist);
-              break;
-            case PROP_LIN:
-              td->factor = dist;
-              break;
-            case PROP_CONST:
-              td->factor = 1.0f;
-              break;
-            case PROP_SPHERE:
-              td->factor = sqrtf(2 * dist - dist * dist);
-              break;
-            case PROP_RANDOM:
-              if (t->rng == NULL) {
-                /* Lazy initialization. */
-                uint rng_seed = (uint)(PIL_check_seconds_timer_i() & UINT_MAX);
-                t->rng = BLI_rng_new(rng_seed);
-              }
-              td->factor = BLI_rng_get_float(t->rng) * dist;
-              break;
-            case PROP_INVSQUARE:
-              td->factor = dist * (2.0f - dist);
-              break;
-            default:
-              td->factor = 1;
-              break;
-          }
-        }
-      }
+    FOREACH_TRANS_DATA_CONTAINER (t, tc) {
+      /* Random values are taken from a single generator, in order. */
+      transdata_foreach_parallel(
+          t, tc, t->prop_mode != PROP_RANDOM, transdata_elem_prop_ratio, NULL);
     }
 
     switch (t->prop_mode) {
@@ -2461,7 +2529,7 @@ void calculatePropRatio(TransInfo *t)
   else {
     FOREACH_TRANS_DATA_CONTAINER (t, tc) {
       TransData *td = tc->data;
-      for (i = 0; i < tc->data_len; i++, td++) {
+      for (int i = 0; i < tc->data_len; i++, td++) {
         td->factor = 1.0;
       }
     }
@@ -26,10 +26,12 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
+#include "BLI_bitmap.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_memarena.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_armature_types.h"
@@ -112,6 +114,18 @@ typedef struct SnapObjectData_EditMesh {
 
 } SnapObjectData_EditMesh;
 
+/** An object (or dupli-instance) to snap to, see #snap_objects_cache_ensure. */
+typedef struct SnapObjectItem {
+  Object *ob;
+  float obmat[4][4];
+  bool is_obedit;
+  /**
+   * The object is in #SnapObjectContext.objects.tree, otherwise it's always tested.
+   * These objects only read snap data prepared up-front, so they can be snapped in parallel.
+   */
+  bool use_bounds;
+} SnapObjectItem;
+
 struct SnapObjectContext {
   Main *bmain;
   Scene *scene;
@@ -133,6 +147,20 @@ struct SnapObjectContext {
     MemArena *mem_arena;
   } cache;
 
+  /* Scene level BVH-tree over the bounds of the objects to snap to,
+   * so only objects near the cursor are tested. */
+  struct {
+    BVHTree *tree;
+    SnapObjectItem *items;
+    int items_len, items_alloc;
+
+    /* The cache is rebuilt after any depsgraph update or when the parameters change. */
+    bool is_valid;
+    unsigned int update_id;
+    eSnapSelect snap_select;
+    bool use_object_edit_cage;
+  } objects;
+
   /* Filter data, returns true to check this value */
   struct {
     struct {
@@ -204,6 +232,39 @@ static SnapObjectData_EditMesh *snap_object_data_editmesh_get(SnapObjectContext
 typedef void (*IterSnapObjsCallback)(
     SnapObjectContext *sctx, bool is_obedit, Object *ob, float obmat[4][4], void *data);
 
+/**
+ * \return true when objects of this base can be snapped to.
+ */
+static bool snap_object_base_test(const View3D *v3d,
+                                  const Base *base,
+                                  const Base *base_act,
+                                  const eSnapSelect snap_select)
+{
+  if (!BASE_VISIBLE(v3d, base)) {
+    return false;
+  }
+
+  if (base->flag_legacy & BA_TRANSFORM_LOCKED_IN_PLACE) {
+    /* pass */
+  }
+  else if (base->flag_legacy & BA_SNAP_FIX_DEPS_FIASCO) {
+    return false;
+  }
+
+  if (snap_select == SNAP_NOT_SELECTED) {
+    if ((base->flag & BASE_SELECTED) || (base->flag_legacy & BA_WAS_SEL)) {
+      return false;
+    }
+  }
+  else if (snap_select == SNAP_NOT_ACTIVE) {
+    if (base == base_act) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /**
  * Walks through all objects in the scene to create the list of objects to snap.
  *
@@ -222,29 +283,10 @@ static void iter_snap_objects(SnapObjectContext *sctx,
 
   Base *base_act = view_layer->basact;
   for (Base *base = view_layer->object_bases.first; base != NULL; base = base->next) {
-
-    if (!BASE_VISIBLE(v3d, base)) {
-      continue;
-    }
-
-    if (base->flag_legacy & BA_TRANSFORM_LOCKED_IN_PLACE) {
-      /* pass */
-    }
-    else if (base->flag_legacy & BA_SNAP_FIX_DEPS_FIASCO) {
+    if (!snap_object_base_test(v3d, base, base_act, snap_select)) {
       continue;
     }
 
-    if (snap_select == SNAP_NOT_SELECTED) {
-      if ((base->flag & BASE_SELECTED) || (base->flag_legacy & BA_WAS_SEL)) {
-        continue;
-      }
-    }
-    else if (snap_select == SNAP_NOT_ACTIVE) {
-      if (base == base_act) {
-        continue;
-      }
-    }
-
     Object *obj_eval = DEG_get_evaluated_object(sctx->depsgraph, base->object);
     if (obj_eval->transflag & OB_DUPLI) {
       DupliObject *dupli_ob;
@@ -1990,41 +2032,37 @@ static short snapCamera(const SnapObjectContext *sctx,
   return 0;
 }
 
-static short snapMesh(SnapObjectContext *sctx,
-                      SnapData *snapdata,
-                      Object *ob,
-                      Mesh *me,
-                      const float obmat[4][4],
-                      /* read/write args */
-                      float *dist_px,
-                      /* return args */
-                      float r_loc[3],
-                      float r_no[3],
-                      int *r_index)
+/**
+ * Test the bounds of \a me and ensure its snap data (BVH-trees & array pointers) is up to date.
+ *
+ * Nothing is written when the data is already up to date,
+ * see #snapObjectsRay which relies on this to snap to objects in parallel.
+ *
+ * \return NULL when there is nothing to snap to.
+ */
+static SnapObjectData_Mesh *snap_object_data_mesh_ensure(SnapObjectContext *sctx,
+                                                         const SnapData *snapdata,
+                                                         Object *ob,
+                                                         Mesh *me,
+                                                         const float lpmat[4][4],
+                                                         const float dist_px_sq)
 {
-  BLI_assert(snapdata->snap_to_flag != SCE_SNAP_MODE_FACE);
-
   if ((snapdata->snap_to_flag & ~SCE_SNAP_MODE_FACE) == SCE_SNAP_MODE_VERTEX) {
     if (me->totvert == 0) {
-      return 0;
+      return NULL;
     }
   }
   else {
     if (me->totedge == 0) {
-      return 0;
+      return NULL;
     }
   }
 
-  float lpmat[4][4];
-  mul_m4_m4m4(lpmat, snapdata->pmat, obmat);
-
-  float dist_px_sq = SQUARE(*dist_px);
-
   /* Test BoundBox */
   BoundBox *bb = BKE_mesh_boundbox_get(ob);
   if (bb && !snap_bound_box_check_dist(
                 bb->vec[0], bb->vec[6], lpmat, snapdata->win_size, snapdata->mval, dist_px_sq)) {
-    return 0;
+    return NULL;
   }
 
   SnapObjectData_Mesh *sod = snap_object_data_mesh_get(sctx, ob);
@@ -2084,28 +2122,62 @@ static short snapMesh(SnapObjectContext *sctx,
       }
     }
   }
-  else {
+  else if (sod->has_loose_vert) {
     /* Not necessary, just to keep the data more consistent. */
     sod->has_loose_vert = false;
   }
 
   /* Update pointers. */
-  if (treedata->vert_allocated == false) {
+  if (treedata->vert_allocated == false && treedata->vert != me->mvert) {
     treedata->vert = me->mvert; /* CustomData_get_layer(&me->vdata, CD_MVERT);? */
   }
   if (treedata->tree || bvhtree[0]) {
-    if (treedata->edge_allocated == false) {
+    if (treedata->edge_allocated == false && treedata->edge != me->medge) {
       /* If raycast has been executed before, `treedata->edge` can be NULL. */
       treedata->edge = me->medge; /* CustomData_get_layer(&me->edata, CD_MEDGE);? */
     }
-    if (treedata->loop && treedata->loop_allocated == false) {
+    if (treedata->loop && treedata->loop_allocated == false && treedata->loop != me->mloop) {
       treedata->loop = me->mloop; /* CustomData_get_layer(&me->edata, CD_MLOOP);? */
     }
     if (treedata->looptri && treedata->looptri_allocated == false) {
-      treedata->looptri = BKE_mesh_runtime_looptri_ensure(me);
+      const MLoopTri *looptri = BKE_mesh_runtime_looptri_ensure(me);
+      if (treedata->looptri != looptri) {
+        treedata->looptri = looptri;
+      }
     }
   }
 
+  return sod;
+}
+
+static short snapMesh(SnapObjectContext *sctx,
+                      SnapData *snapdata,
+                      Object *ob,
+                      Mesh *me,
+                      const float obmat[4][4],
+                      /* read/write args */
+                      float *dist_px,
+                      /* return args */
+                      float r_loc[3],
+                      float r_no[3],
+                      int *r_index)
+{
+  BLI_assert(snapdata->snap_to_flag != SCE_SNAP_MODE_FACE);
+
+  float lpmat[4][4];
+  mul_m4_m4m4(lpmat, snapdata->pmat, obmat);
+
+  float dist_px_sq = SQUARE(*dist_px);
+
+  SnapObjectData_Mesh *sod = snap_object_data_mesh_ensure(
+      sctx, snapdata, ob, me, lpmat, dist_px_sq);
+  if (sod == NULL) {
+    return 0;
+  }
+
+  BVHTreeFromMesh *treedata = &sod->treedata;
+  BVHTree **bvhtree = sod->bvhtree;
+
   Nearest2dUserData nearest2d = {
       .is_persp = snapdata->view_proj == VIEW_PROJ_PERSP,
       .userdata = treedata,
@@ -2506,40 +2578,228 @@ static short snapObject(SnapObjectContext *sctx,
   return 0;
 }
 
-struct SnapObjUserData {
-  SnapData *snapdata;
-  /* read/write args */
-  float *dist_px;
-  /* return args */
-  float *r_loc;
-  float *r_no;
-  int *r_index;
-  Object **r_ob;
-  float (*r_obmat)[4];
-  short ret;
-};
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Snap Objects Cache
+ * \{ */
 
-static void sanp_obj_cb(
-    SnapObjectContext *sctx, bool is_obedit, Object *ob, float obmat[4][4], void *data)
+/**
+ * Incremented on every depsgraph update. Any change may move or reshape instances
+ * (edits to an instanced collection for example), so the cache can't depend on bases alone.
+ */
+static unsigned int snap_objects_update_id = 0;
+
+void ED_transform_snap_object_tag_update(void)
 {
-  struct SnapObjUserData *dt = data;
+  snap_objects_update_id++;
+}
 
-  short elem = snapObject(sctx,
-                          dt->snapdata,
-                          ob,
-                          obmat,
-                          is_obedit,
-                          /* read/write args */
-                          dt->dist_px,
-                          /* return args */
-                          dt->r_loc,
-                          dt->r_no,
-                          dt->r_index,
-                          dt->r_ob,
-                          dt->r_obmat);
+static void snap_objects_cache_free(SnapObjectContext *sctx)
+{
+  if (sctx->objects.tree) {
+    BLI_bvhtree_free(sctx->objects.tree);
+    sctx->objects.tree = NULL;
+  }
+  MEM_SAFE_FREE(sctx->objects.items);
+  sctx->objects.items_len = sctx->objects.items_alloc = 0;
+  sctx->objects.is_valid = false;
+}
+
+/**
+ * Object space bounds of what #snapObject snaps to, used to skip objects far from the cursor.
+ *
+ * \return false when the object has to be tested anyway.
+ */
+static bool snap_object_bounds_get(Object *ob, float r_min[3], float r_max[3])
+{
+  switch (ob->type) {
+    case OB_MESH: {
+      if (BKE_object_is_in_editmode(ob)) {
+        return false;
+      }
+      BoundBox *bb = BKE_mesh_boundbox_get(ob);
+      copy_v3_v3(r_min, bb->vec[0]);
+      copy_v3_v3(r_max, bb->vec[6]);
+      return true;
+    }
+    case OB_SURF:
+    case OB_FONT: {
+      /* #snapMesh tests the object bounds, use them only when they don't need an update. */
+      BoundBox *bb = ob->runtime.bb;
+      if (ob->runtime.mesh_eval == NULL || bb == NULL || (bb->flag & BOUNDBOX_DIRTY)) {
+        return false;
+      }
+      copy_v3_v3(r_min, bb->vec[0]);
+      copy_v3_v3(r_max, bb->vec[6]);
+      return true;
+    }
+    case OB_EMPTY:
+    case OB_GPENCIL:
+      /* Only the origin is snapped to. */
+      zero_v3(r_min);
+      zero_v3(r_max);
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void snap_objects_cache_add_cb(SnapObjectContext *sctx,
+                                      bool is_obedit,
+                                      Object *ob,
+                                      float obmat[4][4],
+                                      void *UNUSED(data))
+{
+  if (sctx->objects.items_len == sctx->objects.items_alloc) {
+    sctx->objects.items_alloc = max_ii(32, sctx->objects.items_alloc * 2);
+    sctx->objects.items = MEM_reallocN(sctx->objects.items,
+                                       sizeof(*sctx->objects.items) * sctx->objects.items_alloc);
+  }
+
+  SnapObjectItem *item = &sctx->objects.items[sctx->objects.items_len++];
+  item->ob = ob;
+  copy_m4_m4(item->obmat, obmat);
+  item->is_obedit = is_obedit;
+  item->use_bounds = false;
+}
+
+/**
+ * Ensure the list of objects to snap to and the BVH-tree over their world space bounds.
+ * These are reused until the next depsgraph update, see #ED_transform_snap_object_tag_update.
+ */
+static void snap_objects_cache_ensure(SnapObjectContext *sctx,
+                                      const struct SnapObjectParams *params)
+{
+  if (sctx->objects.is_valid && (sctx->objects.update_id == snap_objects_update_id) &&
+      (sctx->objects.snap_select == params->snap_select) &&
+      (sctx->objects.use_object_edit_cage == params->use_object_edit_cage)) {
+    return;
+  }
+
+  snap_objects_cache_free(sctx);
+
+  sctx->objects.is_valid = true;
+  sctx->objects.update_id = snap_objects_update_id;
+  sctx->objects.snap_select = params->snap_select;
+  sctx->objects.use_object_edit_cage = params->use_object_edit_cage;
+
+  iter_snap_objects(sctx, params, snap_objects_cache_add_cb, NULL);
 
-  if (elem) {
-    dt->ret = elem;
+  float(*bounds)[2][3] = MEM_malloc_arrayN(
+      max_ii(1, sctx->objects.items_len), sizeof(*bounds), __func__);
+  int tree_len = 0;
+  for (int i = 0; i < sctx->objects.items_len; i++) {
+    SnapObjectItem *item = &sctx->objects.items[i];
+    item->use_bounds = snap_object_bounds_get(item->ob, bounds[i][0], bounds[i][1]);
+    if (item->use_bounds) {
+      tree_len++;
+    }
+  }
+
+  if (tree_len != 0) {
+    sctx->objects.tree = BLI_bvhtree_new(tree_len, 0.0f, 2, 6);
+    for (int i = 0; i < sctx->objects.items_len; i++) {
+      const SnapObjectItem *item = &sctx->objects.items[i];
+      if (item->use_bounds) {
+        BoundBox bb;
+        BKE_boundbox_init_from_minmax(&bb, bounds[i][0], bounds[i][1]);
+        for (int j = 0; j < 8; j++) {
+          mul_m4_v3(item->obmat, bb.vec[j]);
+        }
+        BLI_bvhtree_insert(sctx->objects.tree, i, &bb.vec[0][0], 8);
+      }
+    }
+    BLI_bvhtree_balance(sctx->objects.tree);
+  }
+
+  MEM_freeN(bounds);
+}
+
+static void snap_objects_near_cb(void *userdata,
+                                 int index,
+                                 const struct DistProjectedAABBPrecalc *UNUSED(precalc),
+                                 const float (*clip_plane)[4],
+                                 const int clip_plane_len,
+                                 BVHTreeNearest *UNUSED(nearest))
+{
+  UNUSED_VARS(clip_plane, clip_plane_len);
+  /* Only leaves within the distance reach here, keep the distance to collect all of them. */
+  BLI_bitmap *items_near = userdata;
+  BLI_BITMAP_ENABLE(items_near, index);
+}
+
+/**
+ * Build the snap data of objects which are snapped to in parallel,
+ * so #snapObject only reads it (see #snap_object_data_mesh_ensure).
+ */
+static void snap_object_data_prepare(SnapObjectContext *sctx,
+                                     SnapData *snapdata,
+                                     const SnapObjectItem *item,
+                                     const float dist_px)
+{
+  Object *ob = item->ob;
+  Mesh *me = NULL;
+
+  switch (ob->type) {
+    case OB_MESH:
+      if (ob->dt != OB_BOUNDBOX) {
+        me = ob->data;
+      }
+      break;
+    case OB_SURF:
+    case OB_FONT:
+      me = ob->runtime.mesh_eval;
+      break;
+  }
+
+  if (me) {
+    float lpmat[4][4];
+    mul_m4_m4m4(lpmat, snapdata->pmat, item->obmat);
+    snap_object_data_mesh_ensure(sctx, snapdata, ob, me, lpmat, SQUARE(dist_px));
+  }
+}
+
+typedef struct SnapObjectResult {
+  short elem;
+  float dist_px;
+  float loc[3], no[3];
+  int index;
+} SnapObjectResult;
+
+typedef struct SnapObjectsData {
+  SnapObjectContext *sctx;
+  SnapData *snapdata;
+  const int *candidates;
+  SnapObjectResult *results;
+  bool use_no, use_index;
+} SnapObjectsData;
+
+static void snap_object_candidate(const SnapObjectsData *data, const int i)
+{
+  const SnapObjectItem *item = &data->sctx->objects.items[data->candidates[i]];
+  SnapObjectResult *res = &data->results[i];
+
+  res->elem = snapObject(data->sctx,
+                         data->snapdata,
+                         item->ob,
+                         (float(*)[4])item->obmat,
+                         item->is_obedit,
+                         &res->dist_px,
+                         res->loc,
+                         data->use_no ? res->no : NULL,
+                         data->use_index ? &res->index : NULL,
+                         NULL,
+                         NULL);
+}
+
+static void snap_objects_parallel_cb(void *__restrict userdata,
+                                     const int i,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SnapObjectsData *data = userdata;
+  if (data->sctx->objects.items[data->candidates[i]].use_bounds) {
+    snap_object_candidate(data, i);
   }
 }
 
@@ -2580,20 +2840,100 @@ static short snapObjectsRay(SnapObjectContext *sctx,
                             Object **r_ob,
                             float r_obmat[4][4])
 {
-  struct SnapObjUserData data = {
+  snap_objects_cache_ensure(sctx, params);
+
+  const SnapObjectItem *items = sctx->objects.items;
+  const int items_len = sctx->objects.items_len;
+
+  /* Only test objects whose bounds are near the cursor. Clip planes are tested per object and
+   * the distance has a margin, the per object bounds test is precise. */
+  BLI_bitmap *items_near = BLI_BITMAP_NEW(max_ii(1, items_len), __func__);
+  if (sctx->objects.tree) {
+    BVHTreeNearest nearest = {
+        .index = -1,
+        .dist_sq = SQUARE(*dist_px + 1.0f),
+    };
+    BLI_bvhtree_find_nearest_projected(sctx->objects.tree,
+                                       snapdata->pmat,
+                                       snapdata->win_size,
+                                       snapdata->mval,
+                                       snapdata->clip_plane,
+                                       0,
+                                       &nearest,
+                                       snap_objects_near_cb,
+                                       items_near);
+  }
+
+  int *candidates = MEM_malloc_arrayN(max_ii(1, items_len), sizeof(*candidates), __func__);
+  int candidates_len = 0;
+  for (int i = 0; i < items_len; i++) {
+    if (!items[i].use_bounds || BLI_BITMAP_TEST(items_near, i)) {
+      candidates[candidates_len++] = i;
+    }
+  }
+  MEM_freeN(items_near);
+
+  SnapObjectsData data = {
+      .sctx = sctx,
       .snapdata = snapdata,
-      .dist_px = dist_px,
-      .r_loc = r_loc,
-      .r_no = r_no,
-      .r_ob = r_ob,
-      .r_index = r_index,
-      .r_obmat = r_obmat,
-      .ret = 0,
+      .candidates = candidates,
+      .results = MEM_malloc_arrayN(max_ii(1, candidates_len), sizeof(*data.results), __func__),
+      .use_no = r_no != NULL,
+      .use_index = r_index != NULL,
   };
 
-  iter_snap_objects(sctx, params, sanp_obj_cb, &data);
+  /* Objects without bounds may modify shared data, snap to them first, one by one.
+   * Then snap to the others in parallel, each one with the same initial distance. */
+  for (int i = 0; i < candidates_len; i++) {
+    const SnapObjectItem *item = &items[candidates[i]];
+    data.results[i].dist_px = *dist_px;
+    if (item->use_bounds) {
+      snap_object_data_prepare(sctx, snapdata, item, *dist_px);
+    }
+    else {
+      snap_object_candidate(&data, i);
+    }
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, candidates_len, &data, snap_objects_parallel_cb, &settings);
 
-  return data.ret;
+  /* The nearest element wins, on equal distance the first object tested before. */
+  int best = -1;
+  for (int i = 0; i < candidates_len; i++) {
+    const SnapObjectResult *res = &data.results[i];
+    if (res->elem && (best == -1 || res->dist_px < data.results[best].dist_px)) {
+      best = i;
+    }
+  }
+
+  short retval = 0;
+  if (best != -1) {
+    const SnapObjectItem *item = &items[candidates[best]];
+    const SnapObjectResult *res = &data.results[best];
+
+    *dist_px = res->dist_px;
+    copy_v3_v3(r_loc, res->loc);
+    if (r_no) {
+      copy_v3_v3(r_no, res->no);
+    }
+    if (r_index) {
+      *r_index = res->index;
+    }
+    if (r_ob) {
+      *r_ob = item->ob;
+    }
+    if (r_obmat) {
+      copy_m4_m4(r_obmat, item->obmat);
+    }
+    retval = res->elem;
+  }
+
+  MEM_freeN(data.results);
+  MEM_freeN(candidates);
+
+  return retval;
 }
 
 /** \} */
@@ -2662,6 +3002,7 @@ static void snap_object_data_free(void *sod_v)
 
 void ED_transform_snap_object_context_destroy(SnapObjectContext *sctx)
 {
+  snap_objects_cache_free(sctx);
   BLI_ghash_free(sctx->cache.object_map, NULL, snap_object_data_free);
   BLI_memarena_free(sctx->cache.mem_arena);
 
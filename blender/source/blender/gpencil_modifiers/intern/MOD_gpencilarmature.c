@@ -90,7 +90,8 @@ static void gpencil_deform_verts(ArmatureGpencilModifierData *mmd, Object *targe
                         mmd->deformflag,
                         (float(*)[3])mmd->prevCos,
                         mmd->vgname,
-                        gps);
+                        gps,
+                        NULL);
 
   /* Apply deformed coordinates */
   pt = gps->points;
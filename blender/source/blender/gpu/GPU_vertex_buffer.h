@@ -124,6 +124,9 @@ void GPU_vertbuf_attr_get_raw_data(GPUVertBuf *, uint a_idx, GPUVertBufRaw *acce
 
 void GPU_vertbuf_use(GPUVertBuf *);
 
+/* Overwrite a range of vertices with tightly packed (format stride) data. */
+void GPU_vertbuf_update_sub(GPUVertBuf *, uint v_start, uint v_len, const void *data);
+
 /* Metrics */
 uint GPU_vertbuf_get_memory_usage(void);
 
@@ -88,12 +88,15 @@ void GPU_vertbuf_init_with_format_ex(GPUVertBuf *verts,
 /** Same as discard but does not free. */
 void GPU_vertbuf_clear(GPUVertBuf *verts)
 {
-  if (verts->vbo_id) {
-    GPU_buf_free(verts->vbo_id);
-    verts->vbo_id = 0;
 #if VRAM_USAGE
+  /* Data that was allocated but never uploaded is accounted for too. */
+  if (verts->vbo_id || verts->data) {
     vbo_memory_usage -= GPU_vertbuf_size_get(verts);
+  }
 #endif
+  if (verts->vbo_id) {
+    GPU_buf_free(verts->vbo_id);
+    verts->vbo_id = 0;
   }
   if (verts->data) {
     MEM_SAFE_FREE(verts->data);
@@ -271,6 +274,34 @@ void GPU_vertbuf_use(GPUVertBuf *verts)
   }
 }
 
+/**
+ * Update vertices [v_start, v_start + v_len) without re-uploading the whole buffer.
+ * While the data is still in RAM it is patched in place, otherwise only the range is sent
+ * to the GPU.
+ */
+void GPU_vertbuf_update_sub(GPUVertBuf *verts, uint v_start, uint v_len, const void *data)
+{
+  const uint stride = verts->format.stride;
+
+#if TRUST_NO_ONE
+  assert(v_start + v_len <= verts->vertex_len);
+  assert(verts->data != NULL || verts->vbo_id != 0);
+#endif
+
+  if (v_len == 0) {
+    return;
+  }
+  if (verts->data) {
+    memcpy(verts->data + v_start * stride, data, v_len * stride);
+    verts->dirty = true;
+  }
+  else {
+    glBindBuffer(GL_ARRAY_BUFFER, verts->vbo_id);
+    glBufferSubData(GL_ARRAY_BUFFER, v_start * stride, v_len * stride, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+}
+
 uint GPU_vertbuf_get_memory_usage(void)
 {
   return vbo_memory_usage;
@@ -372,6 +372,7 @@ void IMB_close_anim_proxies(struct anim *anim);
 int ismovie(const char *filepath);
 void IMB_anim_set_preseek(struct anim *anim, int preseek);
 int IMB_anim_get_preseek(struct anim *anim);
+void IMB_anim_set_concurrent_decoding(struct anim *anim, int num_decoders);
 
 /**
  *
@@ -440,6 +441,22 @@ struct ImBuf *IMB_onehalf(struct ImBuf *ibuf1);
  */
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+/* Filters used by IMB_scaleImBuf_filter, listed from fastest to sharpest. */
+typedef enum eIMBScaleFilter {
+  IMB_SCALE_FILTER_BOX = 0,
+  IMB_SCALE_FILTER_BILINEAR = 1,
+  IMB_SCALE_FILTER_BICUBIC = 2,
+} eIMBScaleFilter;
+
+/**
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf,
+                           unsigned int newx,
+                           unsigned int newy,
+                           eIMBScaleFilter filter);
+
 /**
  *
  * \attention Defined in scaling.c
@@ -81,10 +81,27 @@
 
 #define MAXNUMSTREAMS 50
 
+/* Decoded ffmpeg frames kept per anim, see ffmpeg_frame_cache_add(). The caches of all anims
+ * share this part of the memory cache limit. */
+#define ANIM_FRAME_CACHE_MAX 32
+#define ANIM_FRAME_CACHE_LIMIT_DIVISOR 8
+
 struct IDProperty;
 struct _AviMovie;
 struct anim_index;
 
+#ifdef WITH_FFMPEG
+typedef struct AnimFrameCacheEntry {
+  struct ImBuf *ibuf;
+  /* Frame from the decoder, not converted yet. Frames decoded on the way to a seek target are
+   * only converted into ibuf when they're fetched. */
+  struct AVFrame *frame;
+  /* pts of the frame and of the frame decoded before it (-1 when not known). */
+  int64_t pts;
+  int64_t prev_pts;
+} AnimFrameCacheEntry;
+#endif
+
 struct anim {
   int ib_flags;
   int curtype;
@@ -108,6 +125,8 @@ struct anim {
   int interlacing;
   int preseek;
   int streamindex;
+  /* number of anims decoded at the same time, see IMB_anim_set_concurrent_decoding() */
+  int num_concurrent_decoders;
 
   /* avi */
   struct _AviMovie *avi;
@@ -136,7 +155,13 @@ struct anim {
   struct ImBuf *last_frame;
   int64_t last_pts;
   int64_t next_pts;
+  int64_t prev_pts;
   AVPacket next_packet;
+
+  /* ring cache of decoded frames, so stepping backwards does not decode from the key frame */
+  AnimFrameCacheEntry frame_cache[ANIM_FRAME_CACHE_MAX];
+  int frame_cache_size;
+  int frame_cache_next;
 #endif
 
   char index_dir[768];
@@ -37,4 +37,6 @@ void IMB_unpremultiply_rect_float(float *rect_float, int channels, int w, int h)
 
 void imb_onehalf_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1);
 
+void imb_scale_box_linear(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
+
 #endif
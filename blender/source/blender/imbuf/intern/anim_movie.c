@@ -61,8 +61,10 @@
 #include "BLI_utildefines.h"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
+#include "BLI_threads.h"
 
 #include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
 
 #ifdef WITH_AVI
 #  include "AVI_avi.h"
@@ -205,6 +207,7 @@ static void free_anim_avi(struct anim *anim)
 
 #ifdef WITH_FFMPEG
 static void free_anim_ffmpeg(struct anim *anim);
+static void ffmpeg_frame_cache_init(struct anim *anim);
 #endif
 
 void IMB_free_anim(struct anim *anim)
@@ -559,6 +562,14 @@ static int startffmpeg(struct anim *anim)
 
   pCodecCtx->workaround_bugs = 1;
 
+  /* Decode several frames at the same time, long GOP footage is too slow on one thread.
+   * Anims decoded concurrently share the threads. */
+  pCodecCtx->thread_count = BLI_system_thread_count();
+  if (anim->num_concurrent_decoders > 1) {
+    pCodecCtx->thread_count = MAX2(pCodecCtx->thread_count / anim->num_concurrent_decoders, 1);
+  }
+  pCodecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
   if (avcodec_open2(pCodecCtx, pCodec, NULL) < 0) {
     avformat_close_input(&pFormatCtx);
     return -1;
@@ -625,8 +636,11 @@ static int startffmpeg(struct anim *anim)
   anim->last_frame = 0;
   anim->last_pts = -1;
   anim->next_pts = -1;
+  anim->prev_pts = -1;
   anim->next_packet.stream_index = -1;
 
+  ffmpeg_frame_cache_init(anim);
+
   anim->pFrame = av_frame_alloc();
   anim->pFrameComplete = false;
   anim->pFrameDeinterlaced = av_frame_alloc();
@@ -732,34 +746,29 @@ static int startffmpeg(struct anim *anim)
   return (0);
 }
 
-/* postprocess the image in anim->pFrame and do color conversion
+/* postprocess the decoded image in frame and do color conversion
  * and deinterlacing stuff.
  *
- * Output is anim->last_frame
+ * Output is ibuf, returns false when there was no frame to convert.
  */
 
-static void ffmpeg_postprocess(struct anim *anim)
+static bool ffmpeg_postprocess_frame(struct anim *anim, AVFrame *frame, ImBuf *ibuf)
 {
-  AVFrame *input = anim->pFrame;
-  ImBuf *ibuf = anim->last_frame;
+  AVFrame *input = frame;
   int filter_y = 0;
 
-  if (!anim->pFrameComplete) {
-    return;
-  }
-
   /* This means the data wasn't read properly,
    * this check stops crashing */
   if (input->data[0] == 0 && input->data[1] == 0 && input->data[2] == 0 && input->data[3] == 0) {
     fprintf(stderr,
             "ffmpeg_fetchibuf: "
             "data not read properly...\n");
-    return;
+    return false;
   }
 
   av_log(anim->pFormatCtx,
          AV_LOG_DEBUG,
-         "  POSTPROC: anim->pFrame planes: %p %p %p %p\n",
+         "  POSTPROC: frame planes: %p %p %p %p\n",
          input->data[0],
          input->data[1],
          input->data[2],
@@ -767,7 +776,7 @@ static void ffmpeg_postprocess(struct anim *anim)
 
   if (anim->ib_flags & IB_animdeinterlace) {
     if (avpicture_deinterlace((AVPicture *)anim->pFrameDeinterlaced,
-                              (const AVPicture *)anim->pFrame,
+                              (const AVPicture *)frame,
                               anim->pCodecCtx->pix_fmt,
                               anim->pCodecCtx->width,
                               anim->pCodecCtx->height) < 0) {
@@ -860,6 +869,204 @@ static void ffmpeg_postprocess(struct anim *anim)
   if (filter_y) {
     IMB_filtery(ibuf);
   }
+
+  return true;
+}
+
+static bool ffmpeg_postprocess(struct anim *anim, ImBuf *ibuf)
+{
+  if (!anim->pFrameComplete) {
+    return false;
+  }
+  return ffmpeg_postprocess_frame(anim, anim->pFrame, ibuf);
+}
+
+/* Ring cache of decoded frames.
+ *
+ * Going back one frame in long GOP footage means seeking to the previous key frame and
+ * decoding every frame up to the wanted one. When seeking backwards the frames just before
+ * the wanted one are kept here as well, so the following frames of backwards playback or
+ * scrubbing are found without decoding. Those frames are only copied from the decoder, they're
+ * converted when they're fetched, so a single jump back doesn't pay for converting them.
+ *
+ * The caches of all anims share a part of the memory cache limit, so many movie strips and
+ * proxies don't add up to memory which isn't accounted for. */
+
+static size_t frame_cache_memory_used = 0;
+static ThreadMutex frame_cache_memory_mutex = BLI_MUTEX_INITIALIZER;
+
+static size_t ffmpeg_frame_cache_memory_limit(void)
+{
+  return MEM_CacheLimiter_get_maximum() / ANIM_FRAME_CACHE_LIMIT_DIVISOR;
+}
+
+static bool ffmpeg_frame_cache_memory_reserve(size_t size)
+{
+  bool ok;
+
+  BLI_mutex_lock(&frame_cache_memory_mutex);
+  ok = (frame_cache_memory_used + size <= ffmpeg_frame_cache_memory_limit());
+  if (ok) {
+    frame_cache_memory_used += size;
+  }
+  BLI_mutex_unlock(&frame_cache_memory_mutex);
+
+  return ok;
+}
+
+static void ffmpeg_frame_cache_memory_release(size_t size)
+{
+  BLI_mutex_lock(&frame_cache_memory_mutex);
+  BLI_assert(frame_cache_memory_used >= size);
+  frame_cache_memory_used -= size;
+  BLI_mutex_unlock(&frame_cache_memory_mutex);
+}
+
+static void ffmpeg_frame_cache_init(struct anim *anim)
+{
+  /* Anims decoded concurrently only read ahead (sequencer prefetching),
+   * their frames aren't read twice. */
+  if (anim->num_concurrent_decoders > 1) {
+    anim->frame_cache_size = 0;
+  }
+  else {
+    anim->frame_cache_size = (int)(ffmpeg_frame_cache_memory_limit() /
+                                   MAX2(anim->framesize, 1));
+    CLAMP(anim->frame_cache_size, 0, ANIM_FRAME_CACHE_MAX);
+  }
+  anim->frame_cache_next = 0;
+}
+
+static bool ffmpeg_frame_cache_entry_is_used(const AnimFrameCacheEntry *entry)
+{
+  return entry->ibuf || entry->frame;
+}
+
+static void ffmpeg_frame_cache_entry_clear(AnimFrameCacheEntry *entry)
+{
+  if (entry->ibuf) {
+    IMB_freeImBuf(entry->ibuf);
+    entry->ibuf = NULL;
+  }
+  if (entry->frame) {
+    av_frame_free(&entry->frame);
+  }
+}
+
+static void ffmpeg_frame_cache_free(struct anim *anim)
+{
+  for (int i = 0; i < ANIM_FRAME_CACHE_MAX; i++) {
+    if (ffmpeg_frame_cache_entry_is_used(&anim->frame_cache[i])) {
+      ffmpeg_frame_cache_entry_clear(&anim->frame_cache[i]);
+      ffmpeg_frame_cache_memory_release(anim->framesize);
+    }
+  }
+  anim->frame_cache_next = 0;
+}
+
+static ImBuf *ffmpeg_frame_cache_lookup(struct anim *anim, int64_t pts_to_search)
+{
+  for (int i = 0; i < anim->frame_cache_size; i++) {
+    AnimFrameCacheEntry *entry = &anim->frame_cache[i];
+
+    if (!ffmpeg_frame_cache_entry_is_used(entry)) {
+      continue;
+    }
+    /* Same frame as ffmpeg_decode_video_frame_scan() stops at: the first one at or after the
+     * searched pts. */
+    if (entry->pts == pts_to_search ||
+        (entry->prev_pts != -1 && entry->prev_pts < pts_to_search &&
+         pts_to_search < entry->pts)) {
+      if (entry->ibuf == NULL) {
+        /* Only uses the conversion context, the decoder stays where it is. */
+        ImBuf *ibuf = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
+        ibuf->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
+
+        if (!ffmpeg_postprocess_frame(anim, entry->frame, ibuf)) {
+          IMB_freeImBuf(ibuf);
+          ffmpeg_frame_cache_entry_clear(entry);
+          ffmpeg_frame_cache_memory_release(anim->framesize);
+          return NULL;
+        }
+        av_frame_free(&entry->frame);
+        entry->ibuf = ibuf;
+      }
+      IMB_refImBuf(entry->ibuf);
+      return entry->ibuf;
+    }
+  }
+  return NULL;
+}
+
+/* Entry to store the frame at pts in, memory is reserved for entries with an ImBuf.
+ * NULL when the frame isn't cached or the memory limit is reached. */
+static AnimFrameCacheEntry *ffmpeg_frame_cache_entry_get(struct anim *anim, int64_t pts)
+{
+  AnimFrameCacheEntry *entry;
+
+  if (anim->frame_cache_size == 0 || pts == AV_NOPTS_VALUE || pts == -1) {
+    return NULL;
+  }
+
+  for (int i = 0; i < anim->frame_cache_size; i++) {
+    entry = &anim->frame_cache[i];
+    if (ffmpeg_frame_cache_entry_is_used(entry) && entry->pts == pts) {
+      return entry;
+    }
+  }
+
+  entry = &anim->frame_cache[anim->frame_cache_next];
+  anim->frame_cache_next = (anim->frame_cache_next + 1) % anim->frame_cache_size;
+
+  if (ffmpeg_frame_cache_entry_is_used(entry)) {
+    ffmpeg_frame_cache_entry_clear(entry);
+  }
+  else if (!ffmpeg_frame_cache_memory_reserve(anim->framesize)) {
+    return NULL;
+  }
+  return entry;
+}
+
+static void ffmpeg_frame_cache_entry_set(AnimFrameCacheEntry *entry,
+                                         ImBuf *ibuf,
+                                         int64_t pts,
+                                         int64_t prev_pts)
+{
+  ffmpeg_frame_cache_entry_clear(entry);
+  IMB_refImBuf(ibuf);
+  entry->ibuf = ibuf;
+  entry->pts = pts;
+  entry->prev_pts = (prev_pts == AV_NOPTS_VALUE) ? -1 : prev_pts;
+}
+
+static void ffmpeg_frame_cache_add(struct anim *anim, ImBuf *ibuf, int64_t pts, int64_t prev_pts)
+{
+  AnimFrameCacheEntry *entry = ffmpeg_frame_cache_entry_get(anim, pts);
+
+  if (entry) {
+    ffmpeg_frame_cache_entry_set(entry, ibuf, pts, prev_pts);
+  }
+}
+
+/* Copy the frame in anim->pFrame into the cache, it's converted when it's fetched. */
+static void ffmpeg_frame_cache_add_decoded(struct anim *anim)
+{
+  AnimFrameCacheEntry *entry = ffmpeg_frame_cache_entry_get(anim, anim->next_pts);
+
+  if (entry == NULL || ffmpeg_frame_cache_entry_is_used(entry)) {
+    /* Not cached, or cached already. */
+    return;
+  }
+
+  /* The decoder reuses its frame, so the data is copied. */
+  entry->frame = av_frame_alloc();
+  if (entry->frame == NULL || av_frame_ref(entry->frame, anim->pFrame) < 0) {
+    ffmpeg_frame_cache_entry_clear(entry);
+    ffmpeg_frame_cache_memory_release(anim->framesize);
+    return;
+  }
+  entry->pts = anim->next_pts;
+  entry->prev_pts = (anim->prev_pts == AV_NOPTS_VALUE) ? -1 : anim->prev_pts;
 }
 
 /* decode one video frame also considering the packet read into next_packet */
@@ -893,6 +1100,7 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
           anim->pCodecCtx, anim->pFrame, &anim->pFrameComplete, &anim->next_packet);
 
       if (anim->pFrameComplete) {
+        anim->prev_pts = anim->next_pts;
         anim->next_pts = av_get_pts_from_frame(anim->pFormatCtx, anim->pFrame);
 
         av_log(anim->pFormatCtx,
@@ -928,6 +1136,7 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
         anim->pCodecCtx, anim->pFrame, &anim->pFrameComplete, &anim->next_packet);
 
     if (anim->pFrameComplete) {
+      anim->prev_pts = anim->next_pts;
       anim->next_pts = av_get_pts_from_frame(anim->pFormatCtx, anim->pFrame);
 
       av_log(anim->pFormatCtx,
@@ -954,7 +1163,12 @@ static int ffmpeg_decode_video_frame(struct anim *anim)
   return (rval >= 0);
 }
 
-static void ffmpeg_decode_video_frame_scan(struct anim *anim, int64_t pts_to_search)
+/* Decode up to the frame at pts_to_search, frames from cache_from_pts on are added to the
+ * frame cache on the way. */
+
+static void ffmpeg_decode_video_frame_scan(struct anim *anim,
+                                           int64_t pts_to_search,
+                                           int64_t cache_from_pts)
 {
   /* there seem to exist *very* silly GOP lengths out in the wild... */
   int count = 1000;
@@ -971,6 +1185,9 @@ static void ffmpeg_decode_video_frame_scan(struct anim *anim, int64_t pts_to_sea
            "  WHILE: pts=%lld in search of %lld\n",
            (long long int)anim->next_pts,
            (long long int)pts_to_search);
+    if (anim->pFrameComplete && anim->next_pts != -1 && anim->next_pts >= cache_from_pts) {
+      ffmpeg_frame_cache_add_decoded(anim);
+    }
     if (!ffmpeg_decode_video_frame(anim)) {
       break;
     }
@@ -1042,6 +1259,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   long long st_time;
   struct anim_index *tc_index = 0;
   AVStream *v_st;
+  ImBuf *ibuf;
   int new_frame_index = 0; /* To quiet gcc barking... */
   int old_frame_index = 0; /* To quiet gcc barking... */
 
@@ -1095,11 +1313,18 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
     return anim->last_frame;
   }
 
+  /* The decoder stays where it is, so curposition is not changed either. */
+  ibuf = ffmpeg_frame_cache_lookup(anim, pts_to_search);
+  if (ibuf) {
+    av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: frame cache hit\n");
+    return ibuf;
+  }
+
   if (position > anim->curposition + 1 && anim->preseek && !tc_index &&
       position - (anim->curposition + 1) < anim->preseek) {
     av_log(anim->pFormatCtx, AV_LOG_DEBUG, "FETCH: within preseek interval (no index)\n");
 
-    ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+    ffmpeg_decode_video_frame_scan(anim, pts_to_search, pts_to_search);
   }
   else if (tc_index && IMB_indexer_can_scan(tc_index, old_frame_index, new_frame_index)) {
     av_log(anim->pFormatCtx,
@@ -1107,7 +1332,7 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
            "FETCH: within preseek interval "
            "(index tells us)\n");
 
-    ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+    ffmpeg_decode_video_frame_scan(anim, pts_to_search, pts_to_search);
   }
   else if (position != anim->curposition + 1) {
     long long pos;
@@ -1179,7 +1404,14 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
     /* memset(anim->pFrame, ...) ?? */
 
     if (ret >= 0) {
-      ffmpeg_decode_video_frame_scan(anim, pts_to_search);
+      int64_t cache_from_pts = pts_to_search;
+
+      /* Seeking backwards, keep the frames before this one for the next fetches. */
+      if (position < anim->curposition && frame_rate > 0.0) {
+        cache_from_pts -= (int64_t)(anim->frame_cache_size / (pts_time_base * frame_rate));
+      }
+
+      ffmpeg_decode_video_frame_scan(anim, pts_to_search, cache_from_pts);
     }
   }
   else if (position == 0 && anim->curposition == -1) {
@@ -1194,7 +1426,9 @@ static ImBuf *ffmpeg_fetchibuf(struct anim *anim, int position, IMB_Timecode_Typ
   anim->last_frame = IMB_allocImBuf(anim->x, anim->y, 32, IB_rect);
   anim->last_frame->rect_colorspace = colormanage_colorspace_get_named(anim->colorspace);
 
-  ffmpeg_postprocess(anim);
+  if (ffmpeg_postprocess(anim, anim->last_frame)) {
+    ffmpeg_frame_cache_add(anim, anim->last_frame, anim->next_pts, anim->prev_pts);
+  }
 
   anim->last_pts = anim->next_pts;
 
@@ -1237,6 +1471,7 @@ static void free_anim_ffmpeg(struct anim *anim)
 
     sws_freeContext(anim->img_convert_ctx);
     IMB_freeImBuf(anim->last_frame);
+    ffmpeg_frame_cache_free(anim);
     if (anim->next_packet.stream_index != -1) {
       av_free_packet(&anim->next_packet);
     }
@@ -1393,10 +1628,8 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
 #endif
 #ifdef WITH_FFMPEG
     case ANIM_FFMPEG:
+      /* Sets curposition itself, frames from the cache leave the decoder where it is. */
       ibuf = ffmpeg_fetchibuf(anim, position, tc);
-      if (ibuf) {
-        anim->curposition = position;
-      }
       filter_y = 0; /* done internally */
       break;
 #endif
@@ -1406,7 +1639,7 @@ struct ImBuf *IMB_anim_absolute(struct anim *anim,
     if (filter_y) {
       IMB_filtery(ibuf);
     }
-    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, anim->curposition + 1);
+    BLI_snprintf(ibuf->name, sizeof(ibuf->name), "%s.%04d", anim->name, position + 1);
   }
   return (ibuf);
 }
@@ -1470,3 +1703,29 @@ int IMB_anim_get_preseek(struct anim *anim)
 {
   return anim->preseek;
 }
+
+/**
+ * The anim is decoded at the same time as \a num_decoders - 1 other anims, by other threads.
+ * The decoder uses its share of the threads and no decoded frames are kept,
+ * call before reading the first frame.
+ */
+void IMB_anim_set_concurrent_decoding(struct anim *anim, int num_decoders)
+{
+  if (anim->num_concurrent_decoders == num_decoders) {
+    return;
+  }
+  anim->num_concurrent_decoders = num_decoders;
+
+  for (int i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
+    if (anim->proxy_anim[i]) {
+      IMB_anim_set_concurrent_decoding(anim->proxy_anim[i], num_decoders);
+    }
+  }
+
+#ifdef WITH_FFMPEG
+  if (anim->curtype == ANIM_FFMPEG && anim->pCodecCtx) {
+    ffmpeg_frame_cache_free(anim);
+    ffmpeg_frame_cache_init(anim);
+  }
+#endif
+}
@@ -48,10 +48,12 @@
 #include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_rect.h"
+#include "BLI_task.h"
 
 #include "BKE_appdir.h"
 #include "BKE_colortools.h"
 #include "BKE_context.h"
+#include "BKE_global.h"
 #include "BKE_image.h"
 #include "BKE_main.h"
 #include "BKE_sequencer.h"
@@ -60,6 +62,10 @@
 
 #include <ocio_capi.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /*********************** Global declarations *************************/
 
 #define DISPLAY_BUFFER_CHANNELS 4
@@ -100,6 +106,8 @@ static pthread_mutex_t processor_lock = BLI_MUTEX_INITIALIZER;
 typedef struct ColormanageProcessor {
   OCIO_ConstProcessorRcPtr *processor;
   CurveMapping *curve_mapping;
+  /* Baked approximation of processor, used instead of it when set. */
+  struct ColormanageDisplayLUT *display_lut;
   bool is_data_result;
 } ColormanageProcessor;
 
@@ -131,6 +139,32 @@ static struct global_color_picking_state {
   bool failed;
 } global_color_picking_state = {NULL};
 
+/* Display transform baked into a shaper and 3D LUT, see "Baked display LUT" section. */
+typedef struct ColormanageDisplayLUT {
+  struct ColormanageDisplayLUT *next, *prev;
+
+  /* Settings of processor the LUT was baked from. */
+  char look[MAX_COLORSPACE_NAME];
+  char view[MAX_COLORSPACE_NAME];
+  char display[MAX_COLORSPACE_NAME];
+  char input[MAX_COLORSPACE_NAME];
+  float exposure, gamma;
+
+  /* RGB of every lattice point padded to 4 floats, red changing fastest. */
+  float *table;
+
+  /* Difference to the exact processor measured when baking. */
+  float max_error, mean_error;
+  bool is_valid;
+
+  /* Number of processors using the LUT, and whether it's no longer in the cache. */
+  int users;
+  bool is_orphan;
+} ColormanageDisplayLUT;
+
+static ListBase global_display_luts = {NULL, NULL};
+static pthread_mutex_t display_lut_lock = BLI_MUTEX_INITIALIZER;
+
 /*********************** Color managed cache *************************/
 
 /* Cache Implementation Notes
@@ -581,11 +615,43 @@ static void colormanage_load_config(OCIO_ConstConfigRcPtr *config)
   invert_m3_m3(imbuf_linear_srgb_to_xyz, imbuf_xyz_to_linear_srgb);
 }
 
+static void colormanage_display_lut_free(ColormanageDisplayLUT *lut)
+{
+  MEM_freeN(lut->table);
+  MEM_freeN(lut);
+}
+
+static void colormanage_display_luts_free(void)
+{
+  BLI_mutex_lock(&display_lut_lock);
+
+  ColormanageDisplayLUT *lut = global_display_luts.first;
+  while (lut) {
+    ColormanageDisplayLUT *lut_next = lut->next;
+
+    /* LUTs still used by a processor are freed once it is released. */
+    if (lut->users == 0) {
+      colormanage_display_lut_free(lut);
+    }
+    else {
+      lut->is_orphan = true;
+    }
+
+    lut = lut_next;
+  }
+  BLI_listbase_clear(&global_display_luts);
+
+  BLI_mutex_unlock(&display_lut_lock);
+}
+
 static void colormanage_free_config(void)
 {
   ColorSpace *colorspace;
   ColorManagedDisplay *display;
 
+  /* Baked LUTs depend on config. */
+  colormanage_display_luts_free();
+
   /* free color spaces */
   colorspace = global_colorspaces.first;
   while (colorspace) {
@@ -1403,6 +1469,398 @@ bool IMB_colormanagement_space_name_is_data(const char *name)
   return (colorspace && colorspace->is_data);
 }
 
+/*********************** Baked display LUT *************************/
+
+/* Display transforms of scene linear images can be baked into a 3D LUT, which is much
+ * cheaper to evaluate per pixel than the OCIO processor.
+ *
+ * Inputs are first mapped to lattice coordinates by a shaper, which is the float bit pattern
+ * of the value. This is piecewise linear in log2 space, exactly invertible and has lattice
+ * points aligned to powers of two, DISPLAY_LUT_OCTAVE_POINTS of them per octave. Values are
+ * then interpolated from the 4 lattice points of the enclosing tetrahedron. */
+
+#define DISPLAY_LUT_SIZE 65
+#define DISPLAY_LUT_OCTAVE_POINTS 4
+/* Range of scene linear values covered by the LUT, offset by DISPLAY_LUT_MIN so zero is
+ * included. Values outside of it are clamped. */
+#define DISPLAY_LUT_MIN (1.0f / 256.0f)
+#define DISPLAY_LUT_MAX 256.0f
+/* Exponent bits of DISPLAY_LUT_MIN. */
+#define DISPLAY_LUT_MIN_BITS (127 - 8)
+
+/* Number of LUTs kept around for different view and display settings. */
+#define DISPLAY_LUT_MAX_CACHED 4
+/* Largest difference to the exact processor in display space for the LUT to be used. */
+#define DISPLAY_LUT_MAX_ERROR (1.0f / 255.0f)
+/* Number of probe points per axis used to measure the error. */
+#define DISPLAY_LUT_PROBE_SIZE 16
+
+BLI_INLINE float display_lut_shaper_scale(void)
+{
+  /* One octave covers 1 << 23 mantissa steps. */
+  return (float)DISPLAY_LUT_OCTAVE_POINTS / (float)(1 << 23);
+}
+
+static float display_lut_shaper_inverse(float s)
+{
+  const int bits = (DISPLAY_LUT_MIN_BITS << 23) + (int)(s / display_lut_shaper_scale() + 0.5f);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value - DISPLAY_LUT_MIN;
+}
+
+BLI_INLINE void display_lut_apply_pixel(const float *table, float pixel[3])
+{
+  const int stride_r = 4;
+  const int stride_g = 4 * DISPLAY_LUT_SIZE;
+  const int stride_b = 4 * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE;
+  int index[3];
+  float frac[3];
+
+#ifdef __SSE2__
+  __m128 value = _mm_set_ps(0.0f, pixel[2], pixel[1], pixel[0]);
+  value = _mm_add_ps(value, _mm_set1_ps(DISPLAY_LUT_MIN));
+  value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(DISPLAY_LUT_MIN)),
+                     _mm_set1_ps(DISPLAY_LUT_MAX));
+
+  const __m128i bits = _mm_sub_epi32(_mm_castps_si128(value),
+                                     _mm_set1_epi32(DISPLAY_LUT_MIN_BITS << 23));
+  const __m128 s = _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(display_lut_shaper_scale()));
+  const __m128i s_index = _mm_cvttps_epi32(_mm_min_ps(s, _mm_set1_ps(DISPLAY_LUT_SIZE - 2)));
+  float s_index_frac[4];
+  int s_index_int[4];
+
+  _mm_storeu_ps(s_index_frac, _mm_sub_ps(s, _mm_cvtepi32_ps(s_index)));
+  _mm_storeu_si128((__m128i *)s_index_int, s_index);
+  copy_v3_v3(frac, s_index_frac);
+  copy_v3_v3_int(index, s_index_int);
+#else
+  for (int i = 0; i < 3; i++) {
+    const float value = clamp_f(pixel[i] + DISPLAY_LUT_MIN, DISPLAY_LUT_MIN, DISPLAY_LUT_MAX);
+    int bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const float s = (bits - (DISPLAY_LUT_MIN_BITS << 23)) * display_lut_shaper_scale();
+    index[i] = (int)min_ff(max_ff(s, 0.0f), DISPLAY_LUT_SIZE - 2);
+    frac[i] = s - index[i];
+  }
+#endif
+
+  /* Pick tetrahedron by order of fractions, walking from first to last lattice point of the
+   * cube along the axis with the largest fraction first. */
+  int offset1, offset2;
+  float weight0, weight1, weight2;
+
+  if (frac[0] > frac[1]) {
+    if (frac[1] > frac[2]) {
+      offset1 = stride_r;
+      offset2 = stride_r + stride_g;
+      weight0 = frac[0];
+      weight1 = frac[1];
+      weight2 = frac[2];
+    }
+    else if (frac[0] > frac[2]) {
+      offset1 = stride_r;
+      offset2 = stride_r + stride_b;
+      weight0 = frac[0];
+      weight1 = frac[2];
+      weight2 = frac[1];
+    }
+    else {
+      offset1 = stride_b;
+      offset2 = stride_b + stride_r;
+      weight0 = frac[2];
+      weight1 = frac[0];
+      weight2 = frac[1];
+    }
+  }
+  else {
+    if (frac[2] > frac[1]) {
+      offset1 = stride_b;
+      offset2 = stride_b + stride_g;
+      weight0 = frac[2];
+      weight1 = frac[1];
+      weight2 = frac[0];
+    }
+    else if (frac[2] > frac[0]) {
+      offset1 = stride_g;
+      offset2 = stride_g + stride_b;
+      weight0 = frac[1];
+      weight1 = frac[2];
+      weight2 = frac[0];
+    }
+    else {
+      offset1 = stride_g;
+      offset2 = stride_g + stride_r;
+      weight0 = frac[1];
+      weight1 = frac[0];
+      weight2 = frac[2];
+    }
+  }
+
+  const float *c0 = table + index[0] * stride_r + index[1] * stride_g + index[2] * stride_b;
+  const float *c1 = c0 + offset1;
+  const float *c2 = c0 + offset2;
+  const float *c3 = c0 + stride_r + stride_g + stride_b;
+
+#ifdef __SSE2__
+  const __m128 v0 = _mm_load_ps(c0);
+  const __m128 v1 = _mm_load_ps(c1);
+  const __m128 v2 = _mm_load_ps(c2);
+  const __m128 v3 = _mm_load_ps(c3);
+  __m128 result = _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), _mm_set1_ps(weight0)));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_sub_ps(v2, v1), _mm_set1_ps(weight1)));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_sub_ps(v3, v2), _mm_set1_ps(weight2)));
+
+  float result_v4[4];
+  _mm_storeu_ps(result_v4, result);
+  copy_v3_v3(pixel, result_v4);
+#else
+  for (int i = 0; i < 3; i++) {
+    pixel[i] = c0[i] + (c1[i] - c0[i]) * weight0 + (c2[i] - c1[i]) * weight1 +
+               (c3[i] - c2[i]) * weight2;
+  }
+#endif
+}
+
+static void display_lut_apply(const ColormanageDisplayLUT *lut,
+                              float *buffer,
+                              int width,
+                              int height,
+                              int channels,
+                              bool predivide)
+{
+  const size_t i_last = ((size_t)width) * height;
+  float *pixel = buffer;
+
+  predivide = predivide && (channels == 4);
+
+  for (size_t i = 0; i < i_last; i++, pixel += channels) {
+    if (predivide && pixel[3] != 1.0f && pixel[3] != 0.0f) {
+      const float alpha = pixel[3];
+      mul_v3_fl(pixel, 1.0f / alpha);
+      display_lut_apply_pixel(lut->table, pixel);
+      mul_v3_fl(pixel, alpha);
+    }
+    else {
+      display_lut_apply_pixel(lut->table, pixel);
+    }
+  }
+}
+
+typedef struct DisplayLUTBakeData {
+  OCIO_ConstProcessorRcPtr *processor;
+  float *table;
+} DisplayLUTBakeData;
+
+static void display_lut_bake_slice_cb(void *__restrict userdata,
+                                      const int b,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  DisplayLUTBakeData *data = userdata;
+  const int slice_size = DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE;
+  float *slice = data->table + 4 * (size_t)slice_size * b;
+  float *lattice_point = slice;
+
+  for (int g = 0; g < DISPLAY_LUT_SIZE; g++) {
+    for (int r = 0; r < DISPLAY_LUT_SIZE; r++, lattice_point += 4) {
+      lattice_point[0] = display_lut_shaper_inverse(r);
+      lattice_point[1] = display_lut_shaper_inverse(g);
+      lattice_point[2] = display_lut_shaper_inverse(b);
+      lattice_point[3] = 1.0f;
+    }
+  }
+
+  OCIO_PackedImageDesc *img = OCIO_createOCIO_PackedImageDesc(
+      slice, slice_size, 1, 4, sizeof(float), 4 * sizeof(float), 4 * sizeof(float) * slice_size);
+  OCIO_processorApply(data->processor, img);
+  OCIO_PackedImageDescRelease(img);
+}
+
+/* Compare LUT against exact processor in display range, in between lattice points. */
+static void display_lut_measure_error(ColormanageDisplayLUT *lut,
+                                      OCIO_ConstProcessorRcPtr *processor)
+{
+  const int probe_size = DISPLAY_LUT_PROBE_SIZE;
+  const int tot_probe = probe_size * probe_size * probe_size;
+  const float probe_step = (float)(DISPLAY_LUT_SIZE - 1) / probe_size;
+  float *exact = MEM_mallocN(sizeof(float[4]) * tot_probe, __func__);
+  float *baked = MEM_mallocN(sizeof(float[4]) * tot_probe, __func__);
+  float *probe = exact;
+
+  for (int b = 0; b < probe_size; b++) {
+    for (int g = 0; g < probe_size; g++) {
+      for (int r = 0; r < probe_size; r++, probe += 4) {
+        /* Offset avoids probing lattice points, where the LUT is exact. */
+        probe[0] = display_lut_shaper_inverse((r + 0.37f) * probe_step);
+        probe[1] = display_lut_shaper_inverse((g + 0.61f) * probe_step);
+        probe[2] = display_lut_shaper_inverse((b + 0.23f) * probe_step);
+        probe[3] = 1.0f;
+      }
+    }
+  }
+  memcpy(baked, exact, sizeof(float[4]) * tot_probe);
+
+  OCIO_PackedImageDesc *img = OCIO_createOCIO_PackedImageDesc(
+      exact, tot_probe, 1, 4, sizeof(float), 4 * sizeof(float), 4 * sizeof(float) * tot_probe);
+  OCIO_processorApply(processor, img);
+  OCIO_PackedImageDescRelease(img);
+
+  display_lut_apply(lut, baked, tot_probe, 1, 4, false);
+
+  double error_sum = 0.0;
+  lut->max_error = 0.0f;
+
+  for (int i = 0; i < tot_probe; i++) {
+    for (int channel = 0; channel < 3; channel++) {
+      const float error = fabsf(clamp_f(exact[4 * i + channel], 0.0f, 1.0f) -
+                                clamp_f(baked[4 * i + channel], 0.0f, 1.0f));
+      lut->max_error = max_ff(lut->max_error, error);
+      error_sum += error;
+    }
+  }
+
+  lut->mean_error = (float)(error_sum / (3 * tot_probe));
+  lut->is_valid = (lut->max_error <= DISPLAY_LUT_MAX_ERROR);
+
+  MEM_freeN(exact);
+  MEM_freeN(baked);
+}
+
+static ColormanageDisplayLUT *display_lut_bake(const ColorManagedViewSettings *view_settings,
+                                               const ColorManagedDisplaySettings *display_settings,
+                                               const char *from_colorspace,
+                                               OCIO_ConstProcessorRcPtr *processor)
+{
+  ColormanageDisplayLUT *lut = MEM_callocN(sizeof(ColormanageDisplayLUT), __func__);
+  const size_t table_size = sizeof(float[4]) * DISPLAY_LUT_SIZE * DISPLAY_LUT_SIZE *
+                            DISPLAY_LUT_SIZE;
+
+  STRNCPY(lut->look, view_settings->look);
+  STRNCPY(lut->view, view_settings->view_transform);
+  STRNCPY(lut->display, display_settings->display_device);
+  STRNCPY(lut->input, from_colorspace);
+  lut->exposure = view_settings->exposure;
+  lut->gamma = view_settings->gamma;
+
+  /* Aligned for SSE loads of lattice points. */
+  lut->table = MEM_mallocN_aligned(table_size, 16, "display LUT table");
+
+  DisplayLUTBakeData data = {processor, lut->table};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(0, DISPLAY_LUT_SIZE, &data, display_lut_bake_slice_cb, &settings);
+
+  display_lut_measure_error(lut, processor);
+
+  if (G.debug & G_DEBUG) {
+    printf("Color management: baked display LUT for \"%s\" view on \"%s\" display, "
+           "max error %.2f/255, mean error %.3f/255%s\n",
+           lut->view,
+           lut->display,
+           lut->max_error * 255.0f,
+           lut->mean_error * 255.0f,
+           lut->is_valid ? "" : ", using exact transform instead");
+  }
+
+  return lut;
+}
+
+static bool display_lut_matches(const ColormanageDisplayLUT *lut,
+                                const ColorManagedViewSettings *view_settings,
+                                const ColorManagedDisplaySettings *display_settings,
+                                const char *from_colorspace)
+{
+  return STREQ(lut->look, view_settings->look) &&
+         STREQ(lut->view, view_settings->view_transform) &&
+         STREQ(lut->display, display_settings->display_device) &&
+         STREQ(lut->input, from_colorspace) && lut->exposure == view_settings->exposure &&
+         lut->gamma == view_settings->gamma;
+}
+
+/* Get baked LUT for display processor, baking it if needed.
+ * Returns NULL when LUT is not accurate enough for given transform. */
+static ColormanageDisplayLUT *display_lut_acquire(
+    const ColorManagedViewSettings *view_settings,
+    const ColorManagedDisplaySettings *display_settings,
+    const char *from_colorspace,
+    OCIO_ConstProcessorRcPtr *processor)
+{
+  ColormanageDisplayLUT *lut;
+
+  BLI_mutex_lock(&display_lut_lock);
+
+  for (lut = global_display_luts.first; lut; lut = lut->next) {
+    if (display_lut_matches(lut, view_settings, display_settings, from_colorspace)) {
+      break;
+    }
+  }
+
+  if (lut) {
+    /* Most recently used LUTs are kept in front. */
+    BLI_remlink(&global_display_luts, lut);
+  }
+  else {
+    lut = display_lut_bake(view_settings, display_settings, from_colorspace, processor);
+  }
+  BLI_addhead(&global_display_luts, lut);
+
+  /* Remove least recently used LUTs which are not in use. */
+  ColormanageDisplayLUT *lut_iter = global_display_luts.last;
+  int tot_lut = BLI_listbase_count(&global_display_luts);
+
+  while (lut_iter && tot_lut > DISPLAY_LUT_MAX_CACHED) {
+    ColormanageDisplayLUT *lut_prev = lut_iter->prev;
+    if (lut_iter->users == 0) {
+      BLI_remlink(&global_display_luts, lut_iter);
+      colormanage_display_lut_free(lut_iter);
+      tot_lut--;
+    }
+    lut_iter = lut_prev;
+  }
+
+  if (lut->is_valid) {
+    lut->users++;
+  }
+  else {
+    lut = NULL;
+  }
+
+  BLI_mutex_unlock(&display_lut_lock);
+
+  return lut;
+}
+
+static void display_lut_release(ColormanageDisplayLUT *lut)
+{
+  BLI_mutex_lock(&display_lut_lock);
+
+  lut->users--;
+  if (lut->users == 0 && lut->is_orphan) {
+    colormanage_display_lut_free(lut);
+  }
+
+  BLI_mutex_unlock(&display_lut_lock);
+}
+
+/* Use baked LUT for display processor if enabled in view settings. This is only used for
+ * display buffers in editors, images written to files always use the exact transform. */
+static void colormanage_processor_display_lut_ensure(
+    ColormanageProcessor *cm_processor,
+    const ColorManagedViewSettings *view_settings,
+    const ColorManagedDisplaySettings *display_settings)
+{
+  if (cm_processor == NULL || cm_processor->processor == NULL || view_settings == NULL) {
+    return;
+  }
+  if ((view_settings->flag & COLORMANAGE_VIEW_USE_BAKED_LUT) == 0) {
+    return;
+  }
+
+  cm_processor->display_lut = display_lut_acquire(
+      view_settings, display_settings, global_role_scene_linear, cm_processor->processor);
+}
+
 /*********************** Threaded display buffer transform routines *************************/
 
 typedef struct DisplayBufferThread {
@@ -1732,7 +2190,8 @@ static void colormanage_display_buffer_process_ex(
     float *display_buffer,
     unsigned char *display_buffer_byte,
     const ColorManagedViewSettings *view_settings,
-    const ColorManagedDisplaySettings *display_settings)
+    const ColorManagedDisplaySettings *display_settings,
+    const bool use_display_lut)
 {
   ColormanageProcessor *cm_processor = NULL;
   bool skip_transform = false;
@@ -1748,6 +2207,10 @@ static void colormanage_display_buffer_process_ex(
 
   if (skip_transform == false) {
     cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+
+    if (use_display_lut) {
+      colormanage_processor_display_lut_ensure(cm_processor, view_settings, display_settings);
+    }
   }
 
   display_buffer_apply_threaded(ibuf,
@@ -1768,7 +2231,7 @@ static void colormanage_display_buffer_process(ImBuf *ibuf,
                                                const ColorManagedDisplaySettings *display_settings)
 {
   colormanage_display_buffer_process_ex(
-      ibuf, NULL, display_buffer, view_settings, display_settings);
+      ibuf, NULL, display_buffer, view_settings, display_settings, true);
 }
 
 /*********************** Threaded processor transform routines *************************/
@@ -2429,8 +2892,12 @@ static void colormanagement_imbuf_make_display_space(
     imb_addrectImBuf(ibuf);
   }
 
-  colormanage_display_buffer_process_ex(
-      ibuf, ibuf->rect_float, (unsigned char *)ibuf->rect, view_settings, display_settings);
+  colormanage_display_buffer_process_ex(ibuf,
+                                        ibuf->rect_float,
+                                        (unsigned char *)ibuf->rect,
+                                        view_settings,
+                                        display_settings,
+                                        false);
 }
 
 void IMB_colormanagement_imbuf_make_display_space(
@@ -3579,6 +4046,7 @@ static void imb_partial_display_buffer_update_ex(
 
     if (!skip_transform) {
       cm_processor = IMB_colormanagement_display_processor_new(view_settings, display_settings);
+      colormanage_processor_display_lut_ensure(cm_processor, view_settings, display_settings);
     }
 
     if (do_threads) {
@@ -3826,7 +4294,10 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
     }
   }
 
-  if (cm_processor->processor && channels >= 3) {
+  if (cm_processor->display_lut && channels >= 3) {
+    display_lut_apply(cm_processor->display_lut, buffer, width, height, channels, predivide);
+  }
+  else if (cm_processor->processor && channels >= 3) {
     OCIO_PackedImageDesc *img;
 
     /* apply OCIO processor */
@@ -3875,6 +4346,9 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
   if (cm_processor->processor) {
     OCIO_processorRelease(cm_processor->processor);
   }
+  if (cm_processor->display_lut) {
+    display_lut_release(cm_processor->display_lut);
+  }
 
   MEM_freeN(cm_processor);
 }
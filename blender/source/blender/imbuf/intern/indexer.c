@@ -30,6 +30,8 @@
 #include "BLI_string.h"
 #include "BLI_fileops.h"
 #include "BLI_ghash.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "IMB_indexer.h"
 #include "IMB_anim.h"
@@ -686,6 +688,9 @@ static void free_proxy_output_ffmpeg(struct proxy_output_ctx *ctx, int rollback)
 typedef struct FFmpegIndexBuilderContext {
   int anim_type;
 
+  struct anim *anim;
+  int quality;
+
   AVFormatContext *iFormatCtx;
   AVCodecContext *iCodecCtx;
   AVCodec *iCodec;
@@ -711,6 +716,14 @@ typedef struct FFmpegIndexBuilderContext {
   double pts_time_base;
   int frameno, frameno_gapless;
   int start_pts_set;
+
+  /* outputs are incomplete, they are removed like when the build is stopped */
+  bool build_failed;
+
+  /* The proxy sizes of a decoded frame are scaled and encoded in parallel, from a copy of the
+   * frame, while the next frame is decoded. */
+  TaskPool *proxy_pool;
+  AVFrame *proxy_frame;
 } FFmpegIndexBuilderContext;
 
 static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim,
@@ -724,6 +737,8 @@ static IndexBuildContext *index_ffmpeg_create_context(struct anim *anim,
   int num_indexers = IMB_TC_MAX_SLOT;
   int i, streamcount;
 
+  context->anim = anim;
+  context->quality = quality;
   context->tcs_in_use = tcs_in_use;
   context->proxy_sizes_in_use = proxy_sizes_in_use;
   context->num_proxy_sizes = IMB_PROXY_MAX_SLOT;
@@ -818,6 +833,10 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, int
 {
   int i;
 
+  if (context->build_failed) {
+    stop = 1;
+  }
+
   for (i = 0; i < context->num_indexers; i++) {
     if (context->tcs_in_use & tc_types[i]) {
       IMB_index_builder_finish(context->indexer[i], stop);
@@ -836,18 +855,14 @@ static void index_rebuild_ffmpeg_finish(FFmpegIndexBuilderContext *context, int
   MEM_freeN(context);
 }
 
-static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *context,
-                                                    AVPacket *curr_packet,
-                                                    AVFrame *in_frame)
+static void index_rebuild_ffmpeg_add_index_entry(FFmpegIndexBuilderContext *context,
+                                                 unsigned char *buffer,
+                                                 int data_size,
+                                                 unsigned long long pts,
+                                                 unsigned long long s_pos,
+                                                 unsigned long long s_dts)
 {
   int i;
-  unsigned long long s_pos = context->seek_pos;
-  unsigned long long s_dts = context->seek_pos_dts;
-  unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
-
-  for (i = 0; i < context->num_proxy_sizes; i++) {
-    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
-  }
 
   if (!context->start_pts_set) {
     context->start_pts = pts;
@@ -857,18 +872,6 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
   context->frameno = floor(
       (pts - context->start_pts) * context->pts_time_base * context->frame_rate + 0.5);
 
-  /* decoding starts *always* on I-Frames,
-   * so: P-Frames won't work, even if all the
-   * information is in place, when we seek
-   * to the I-Frame presented *after* the P-Frame,
-   * but located before the P-Frame within
-   * the stream */
-
-  if (pts < context->seek_pos_pts) {
-    s_pos = context->last_seek_pos;
-    s_dts = context->last_seek_pos_dts;
-  }
-
   for (i = 0; i < context->num_indexers; i++) {
     if (context->tcs_in_use & tc_types[i]) {
       int tc_frameno = context->frameno;
@@ -877,32 +880,106 @@ static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *c
         tc_frameno = context->frameno_gapless;
       }
 
-      IMB_index_builder_proc_frame(context->indexer[i],
-                                   curr_packet->data,
-                                   curr_packet->size,
-                                   tc_frameno,
-                                   s_pos,
-                                   s_dts,
-                                   pts);
+      IMB_index_builder_proc_frame(
+          context->indexer[i], buffer, data_size, tc_frameno, s_pos, s_dts, pts);
     }
   }
 
   context->frameno_gapless++;
 }
 
+static void index_rebuild_ffmpeg_proxy_task(TaskPool *__restrict pool,
+                                            void *taskdata,
+                                            int UNUSED(threadid))
+{
+  FFmpegIndexBuilderContext *context = BLI_task_pool_userdata(pool);
+
+  add_to_proxy_output_ffmpeg((struct proxy_output_ctx *)taskdata, context->proxy_frame);
+}
+
+static void index_rebuild_ffmpeg_proc_proxies(FFmpegIndexBuilderContext *context,
+                                              AVFrame *in_frame)
+{
+  int i;
+
+  if (context->proxy_pool) {
+    /* the copy of the previous frame is still used until its proxies are encoded */
+    BLI_task_pool_work_and_wait(context->proxy_pool);
+    av_frame_unref(context->proxy_frame);
+
+    /* the decoder reuses its frame, so the frame is copied */
+    if (av_frame_ref(context->proxy_frame, in_frame) >= 0) {
+      for (i = 0; i < context->num_proxy_sizes; i++) {
+        if (context->proxy_ctx[i]) {
+          BLI_task_pool_push(context->proxy_pool,
+                             index_rebuild_ffmpeg_proxy_task,
+                             context->proxy_ctx[i],
+                             false,
+                             TASK_PRIORITY_HIGH);
+        }
+      }
+      return;
+    }
+  }
+
+  for (i = 0; i < context->num_proxy_sizes; i++) {
+    add_to_proxy_output_ffmpeg(context->proxy_ctx[i], in_frame);
+  }
+}
+
+static void index_rebuild_ffmpeg_proc_decoded_frame(FFmpegIndexBuilderContext *context,
+                                                    AVPacket *curr_packet,
+                                                    AVFrame *in_frame)
+{
+  unsigned long long s_pos = context->seek_pos;
+  unsigned long long s_dts = context->seek_pos_dts;
+  unsigned long long pts = av_get_pts_from_frame(context->iFormatCtx, in_frame);
+
+  index_rebuild_ffmpeg_proc_proxies(context, in_frame);
+
+  /* decoding starts *always* on I-Frames,
+   * so: P-Frames won't work, even if all the
+   * information is in place, when we seek
+   * to the I-Frame presented *after* the P-Frame,
+   * but located before the P-Frame within
+   * the stream */
+
+  if (pts < context->seek_pos_pts) {
+    s_pos = context->last_seek_pos;
+    s_dts = context->last_seek_pos_dts;
+  }
+
+  index_rebuild_ffmpeg_add_index_entry(
+      context, curr_packet->data, curr_packet->size, pts, s_pos, s_dts);
+}
+
 static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
                                 short *stop,
                                 short *do_update,
                                 float *progress)
 {
+  TaskScheduler *scheduler = BLI_task_scheduler_get();
   AVFrame *in_frame = 0;
   AVPacket next_packet;
   uint64_t stream_size;
+  int i;
 
   memset(&next_packet, 0, sizeof(AVPacket));
 
   in_frame = av_frame_alloc();
 
+  /* The frame is decoded once for all proxy sizes. The time codes are added on this thread in
+   * decoding order, so they're the same as without threads. */
+  if (BLI_task_scheduler_num_threads(scheduler) > 1) {
+    for (i = 0; i < context->num_proxy_sizes; i++) {
+      if (context->proxy_ctx[i]) {
+        context->proxy_pool = BLI_task_pool_create(scheduler, context);
+        context->proxy_frame = av_frame_alloc();
+        break;
+      }
+    }
+  }
+
   stream_size = avio_size(context->iFormatCtx->pb);
 
   context->frame_rate = av_q2d(av_guess_frame_rate(context->iFormatCtx, context->iStream, NULL));
@@ -963,11 +1040,833 @@ static int index_rebuild_ffmpeg(FFmpegIndexBuilderContext *context,
     } while (frame_finished);
   }
 
+  if (context->proxy_pool) {
+    /* the proxy outputs are flushed when finishing */
+    BLI_task_pool_work_and_wait(context->proxy_pool);
+    BLI_task_pool_free(context->proxy_pool);
+    av_frame_free(&context->proxy_frame);
+    context->proxy_pool = NULL;
+  }
+
   av_free(in_frame);
 
   return 1;
 }
 
+/* ----------------------------------------------------------------------
+ * - ffmpeg segment rebuilder
+ *
+ * The movie is split into segments starting at key frames, which are decoded in parallel.
+ * Each decoded frame is scaled and encoded for all proxy sizes at once. The proxy packets and
+ * the time code entries of a segment are written to files in the index directory, and joined
+ * into the proxies and indices in order when all segments are done.
+ *
+ * Finished segments are kept when building is stopped, so the next build continues from there.
+ * ---------------------------------------------------------------------- */
+
+/* Not enabled by default yet: the time codes and frames haven't been compared with the
+ * sequential build on real long and open GOP movies, including stopped and resumed builds. */
+// #define USE_SEGMENT_BUILD
+
+#ifdef USE_SEGMENT_BUILD
+
+static const char segment_magic[] = "BlenMSeg";
+
+#define INDEX_SEGMENT_VERSION 1
+
+/* Minimum number of video packets in a segment, a segment always ends at a key frame. */
+#define INDEX_SEGMENT_MIN_PACKETS 250
+
+typedef struct IndexSegment {
+  /* Key frame the segment starts with. */
+  int64_t start_pos;
+  int64_t start_dts;
+  int64_t start_pts;
+  /* Key frame before the segment, for the seek positions of the first frames. */
+  int64_t prev_pos;
+  int64_t prev_dts;
+  int64_t prev_pts;
+  int num_packets;
+  char _pad[4];
+} IndexSegment;
+
+typedef struct IndexSegmentHeader {
+  char magic[8];
+  int version;
+  int proxy_sizes_in_use;
+  int quality;
+  int num_segments;
+  int64_t file_size;
+} IndexSegmentHeader;
+
+/* Time code entry of a decoded frame. */
+typedef struct IndexSegmentFrame {
+  unsigned long long pts;
+  unsigned long long seek_pos;
+  unsigned long long seek_pos_dts;
+} IndexSegmentFrame;
+
+typedef struct IndexSegmentOutput {
+  AVCodecContext *c;
+  struct SwsContext *sws_ctx;
+  AVFrame *frame;
+  FILE *file;
+  int cfra;
+} IndexSegmentOutput;
+
+typedef struct IndexSegmentDecoder {
+  AVFormatContext *format_ctx;
+  AVCodecContext *codec_ctx;
+  AVFrame *frame;
+  IndexSegmentOutput outputs[IMB_PROXY_MAX_SLOT];
+  FILE *tc_file;
+
+  unsigned long long seek_pos;
+  unsigned long long seek_pos_dts;
+  unsigned long long seek_pos_pts;
+  unsigned long long last_seek_pos;
+  unsigned long long last_seek_pos_dts;
+} IndexSegmentDecoder;
+
+typedef struct IndexSegmentBuild {
+  FFmpegIndexBuilderContext *context;
+  IndexSegment *segments;
+  int num_segments;
+  char segment_dir[FILE_MAX];
+
+  short *stop;
+  short *do_update;
+  float *progress;
+
+  /* Protected by the user mutex of the task pool. */
+  int num_packets;
+  int num_packets_done;
+  bool error;
+} IndexSegmentBuild;
+
+static void get_segment_dir(struct anim *anim, char *segment_dir)
+{
+  char index_dir[FILE_MAXDIR];
+  char segment_name[256];
+  char stream_suffix[20];
+
+  stream_suffix[0] = 0;
+
+  if (anim->streamindex > 0) {
+    BLI_snprintf(stream_suffix, sizeof(stream_suffix), "_st%d", anim->streamindex);
+  }
+
+  BLI_snprintf(segment_name, sizeof(segment_name), "segments%s%s", stream_suffix, anim->suffix);
+
+  get_index_dir(anim, index_dir, sizeof(index_dir));
+
+  BLI_join_dirfile(segment_dir, FILE_MAX, index_dir, segment_name);
+}
+
+/* proxy_index -1 gives the time code file of the segment */
+static void get_segment_filename(
+    const char *segment_dir, int segment_index, int proxy_index, bool temp, char *fname)
+{
+  char name[64];
+
+  if (proxy_index == -1) {
+    BLI_snprintf(name, sizeof(name), "seg%05d_tc%s", segment_index, temp ? temp_ext : "");
+  }
+  else {
+    BLI_snprintf(name,
+                 sizeof(name),
+                 "seg%05d_proxy_%d%s",
+                 segment_index,
+                 (int)(proxy_fac[proxy_index] * 100),
+                 temp ? temp_ext : "");
+  }
+
+  BLI_join_dirfile(fname, FILE_MAX, segment_dir, name);
+}
+
+/* Read the packets of the movie without decoding them, to find the key frames to start the
+ * segments at. Returns NULL when the movie can't be decoded in segments. */
+static IndexSegment *index_ffmpeg_find_segments(FFmpegIndexBuilderContext *context,
+                                                int *r_num_segments,
+                                                int *r_num_packets)
+{
+  AVFormatContext *format_ctx = NULL;
+  AVPacket packet;
+  IndexSegment *segments = NULL;
+  int num_segments = 0, segments_len = 0, num_packets = 0;
+  int64_t prev_pos = 0, prev_dts = 0, prev_pts = 0;
+  bool valid = true;
+
+  if (avformat_open_input(&format_ctx, context->anim->name, NULL, NULL) != 0) {
+    return NULL;
+  }
+
+  if (avformat_find_stream_info(format_ctx, NULL) < 0) {
+    avformat_close_input(&format_ctx);
+    return NULL;
+  }
+
+  memset(&packet, 0, sizeof(AVPacket));
+
+  while (valid && av_read_frame(format_ctx, &packet) >= 0) {
+    if (packet.stream_index == context->videoStream) {
+      if (packet.flags & AV_PKT_FLAG_KEY) {
+        if (packet.pos < 0 || packet.dts == AV_NOPTS_VALUE || packet.pts == AV_NOPTS_VALUE) {
+          valid = false;
+        }
+        else if (num_segments == 0 ||
+                 segments[num_segments - 1].num_packets >= INDEX_SEGMENT_MIN_PACKETS) {
+          IndexSegment *segment;
+
+          /* frames of a segment are found by their presentation time */
+          if (num_segments > 0 && packet.pts <= segments[num_segments - 1].start_pts) {
+            valid = false;
+          }
+
+          if (num_segments == segments_len) {
+            segments_len = MAX2(segments_len * 2, 64);
+            segments = MEM_reallocN(segments, sizeof(IndexSegment) * segments_len);
+          }
+
+          segment = &segments[num_segments++];
+          memset(segment, 0, sizeof(IndexSegment));
+          segment->start_pos = packet.pos;
+          segment->start_dts = packet.dts;
+          segment->start_pts = packet.pts;
+          segment->prev_pos = prev_pos;
+          segment->prev_dts = prev_dts;
+          segment->prev_pts = prev_pts;
+        }
+
+        prev_pos = packet.pos;
+        prev_dts = packet.dts;
+        prev_pts = packet.pts;
+      }
+      else if (num_segments == 0) {
+        /* frames before the first key frame */
+        valid = false;
+      }
+
+      if (num_segments > 0) {
+        segments[num_segments - 1].num_packets++;
+      }
+      num_packets++;
+    }
+    av_free_packet(&packet);
+  }
+
+  avformat_close_input(&format_ctx);
+
+  if (!valid || num_segments < 2) {
+    MEM_SAFE_FREE(segments);
+    return NULL;
+  }
+
+  *r_num_segments = num_segments;
+  *r_num_packets = num_packets;
+  return segments;
+}
+
+static void index_segment_header_init(IndexSegmentBuild *build, IndexSegmentHeader *header)
+{
+  FFmpegIndexBuilderContext *context = build->context;
+  int i;
+
+  memset(header, 0, sizeof(IndexSegmentHeader));
+  memcpy(header->magic, segment_magic, sizeof(header->magic));
+  header->version = INDEX_SEGMENT_VERSION;
+  header->quality = context->quality;
+  header->num_segments = build->num_segments;
+  header->file_size = avio_size(context->iFormatCtx->pb);
+
+  for (i = 0; i < context->num_proxy_sizes; i++) {
+    if (context->proxy_ctx[i]) {
+      header->proxy_sizes_in_use |= proxy_sizes[i];
+    }
+  }
+}
+
+/* Are the segments in the segment directory from a build with the same settings? */
+static bool index_segment_header_matches(IndexSegmentBuild *build,
+                                         const IndexSegmentHeader *header)
+{
+  char fname[FILE_MAX];
+  IndexSegmentHeader file_header;
+  IndexSegment *file_segments;
+  bool matches = false;
+  FILE *fp;
+
+  BLI_join_dirfile(fname, sizeof(fname), build->segment_dir, "segments");
+  fp = BLI_fopen(fname, "rb");
+  if (!fp) {
+    return false;
+  }
+
+  if (fread(&file_header, sizeof(file_header), 1, fp) == 1 &&
+      memcmp(&file_header, header, sizeof(file_header)) == 0) {
+    file_segments = MEM_mallocN(sizeof(IndexSegment) * build->num_segments, __func__);
+    if (fread(file_segments, sizeof(IndexSegment), build->num_segments, fp) ==
+        (size_t)build->num_segments) {
+      matches = memcmp(file_segments,
+                       build->segments,
+                       sizeof(IndexSegment) * build->num_segments) == 0;
+    }
+    MEM_freeN(file_segments);
+  }
+
+  fclose(fp);
+  return matches;
+}
+
+static bool index_segment_header_write(IndexSegmentBuild *build, const IndexSegmentHeader *header)
+{
+  char fname[FILE_MAX];
+  bool ok;
+  FILE *fp;
+
+  BLI_join_dirfile(fname, sizeof(fname), build->segment_dir, "segments");
+  fp = BLI_fopen(fname, "wb");
+  if (!fp) {
+    return false;
+  }
+
+  ok = fwrite(header, sizeof(IndexSegmentHeader), 1, fp) == 1 &&
+       fwrite(build->segments, sizeof(IndexSegment), build->num_segments, fp) ==
+           (size_t)build->num_segments;
+
+  fclose(fp);
+  return ok;
+}
+
+static bool index_segment_output_open(IndexSegmentOutput *output,
+                                      struct proxy_output_ctx *proxy,
+                                      AVCodecContext *in_codec_ctx,
+                                      const char *fname)
+{
+  output->c = avcodec_alloc_context3(proxy->codec);
+  output->c->codec_type = AVMEDIA_TYPE_VIDEO;
+  output->c->codec_id = proxy->c->codec_id;
+  output->c->width = proxy->c->width;
+  output->c->height = proxy->c->height;
+  output->c->pix_fmt = proxy->c->pix_fmt;
+  output->c->sample_aspect_ratio = proxy->c->sample_aspect_ratio;
+  output->c->time_base = proxy->c->time_base;
+  output->c->qmin = proxy->c->qmin;
+  output->c->qmax = proxy->c->qmax;
+
+  if (avcodec_open2(output->c, proxy->codec, NULL) < 0) {
+    return false;
+  }
+
+  if (proxy->sws_ctx) {
+    output->frame = av_frame_alloc();
+    avpicture_fill((AVPicture *)output->frame,
+                   MEM_mallocN(avpicture_get_size(output->c->pix_fmt,
+                                                  round_up(output->c->width, 16),
+                                                  output->c->height),
+                               "alloc proxy output frame"),
+                   output->c->pix_fmt,
+                   round_up(output->c->width, 16),
+                   output->c->height);
+
+    output->sws_ctx = sws_getContext(in_codec_ctx->width,
+                                     proxy->orig_height,
+                                     in_codec_ctx->pix_fmt,
+                                     output->c->width,
+                                     output->c->height,
+                                     output->c->pix_fmt,
+                                     SWS_FAST_BILINEAR,
+                                     NULL,
+                                     NULL,
+                                     NULL);
+    if (!output->sws_ctx) {
+      return false;
+    }
+  }
+
+  output->file = BLI_fopen(fname, "wb");
+  return output->file != NULL;
+}
+
+static void index_segment_output_close(IndexSegmentOutput *output)
+{
+  if (output->c) {
+    avcodec_close(output->c);
+    av_free(output->c);
+  }
+  if (output->sws_ctx) {
+    sws_freeContext(output->sws_ctx);
+  }
+  if (output->frame) {
+    MEM_freeN(output->frame->data[0]);
+    av_free(output->frame);
+  }
+  if (output->file) {
+    fclose(output->file);
+  }
+  memset(output, 0, sizeof(IndexSegmentOutput));
+}
+
+/* Scale and encode a frame, the packet is stored as its size followed by the data. */
+static bool index_segment_output_add(IndexSegmentOutput *output, AVFrame *frame, int height)
+{
+  AVPacket packet = {0};
+  int got_output;
+  bool ok;
+
+  av_init_packet(&packet);
+
+  if (output->sws_ctx) {
+    sws_scale(output->sws_ctx,
+              (const uint8_t *const *)frame->data,
+              frame->linesize,
+              0,
+              height,
+              output->frame->data,
+              output->frame->linesize);
+    frame = output->frame;
+  }
+
+  frame->pts = output->cfra++;
+
+  if (avcodec_encode_video2(output->c, &packet, frame, &got_output) < 0 || !got_output) {
+    return false;
+  }
+
+  ok = fwrite(&packet.size, sizeof(packet.size), 1, output->file) == 1 &&
+       fwrite(packet.data, 1, packet.size, output->file) == (size_t)packet.size;
+
+  av_free_packet(&packet);
+  return ok;
+}
+
+static bool index_segment_decoder_open(IndexSegmentBuild *build,
+                                       IndexSegmentDecoder *decoder,
+                                       int segment_index,
+                                       ThreadMutex *mutex)
+{
+  FFmpegIndexBuilderContext *context = build->context;
+  const IndexSegment *segment = &build->segments[segment_index];
+  AVCodec *codec;
+  char fname[FILE_MAX];
+  bool ok = true;
+  int i;
+
+  if (avformat_open_input(&decoder->format_ctx, context->anim->name, NULL, NULL) != 0) {
+    return false;
+  }
+
+  /* opening and closing codecs is not thread safe with all ffmpeg versions,
+   * finding the stream info opens codecs too */
+  BLI_mutex_lock(mutex);
+  ok = avformat_find_stream_info(decoder->format_ctx, NULL) >= 0;
+  BLI_mutex_unlock(mutex);
+
+  if (!ok || decoder->format_ctx->nb_streams <= (unsigned int)context->videoStream) {
+    return false;
+  }
+
+  decoder->codec_ctx = decoder->format_ctx->streams[context->videoStream]->codec;
+  codec = avcodec_find_decoder(decoder->codec_ctx->codec_id);
+  if (codec == NULL) {
+    decoder->codec_ctx = NULL;
+    return false;
+  }
+
+  decoder->codec_ctx->workaround_bugs = 1;
+
+  BLI_mutex_lock(mutex);
+  if (avcodec_open2(decoder->codec_ctx, codec, NULL) < 0) {
+    decoder->codec_ctx = NULL;
+    ok = false;
+  }
+  for (i = 0; ok && i < context->num_proxy_sizes; i++) {
+    if (context->proxy_ctx[i]) {
+      get_segment_filename(build->segment_dir, segment_index, i, true, fname);
+      ok = index_segment_output_open(
+          &decoder->outputs[i], context->proxy_ctx[i], decoder->codec_ctx, fname);
+    }
+  }
+  BLI_mutex_unlock(mutex);
+
+  if (!ok) {
+    return false;
+  }
+
+  get_segment_filename(build->segment_dir, segment_index, -1, true, fname);
+  decoder->tc_file = BLI_fopen(fname, "wb");
+  if (!decoder->tc_file) {
+    return false;
+  }
+
+  decoder->frame = av_frame_alloc();
+
+  /* same state as the sequential build has when it reaches the first key frame */
+  decoder->seek_pos = segment->prev_pos;
+  decoder->seek_pos_dts = segment->prev_dts;
+  decoder->seek_pos_pts = segment->prev_pts;
+
+  if (segment_index > 0 &&
+      av_seek_frame(
+          decoder->format_ctx, context->videoStream, segment->start_dts, AVSEEK_FLAG_BACKWARD) <
+          0) {
+    return false;
+  }
+
+  return true;
+}
+
+static void index_segment_decoder_close(IndexSegmentDecoder *decoder, ThreadMutex *mutex)
+{
+  int i;
+
+  BLI_mutex_lock(mutex);
+  if (decoder->codec_ctx) {
+    avcodec_close(decoder->codec_ctx);
+  }
+  for (i = 0; i < IMB_PROXY_MAX_SLOT; i++) {
+    index_segment_output_close(&decoder->outputs[i]);
+  }
+  BLI_mutex_unlock(mutex);
+
+  if (decoder->format_ctx) {
+    avformat_close_input(&decoder->format_ctx);
+  }
+  if (decoder->frame) {
+    av_free(decoder->frame);
+  }
+  if (decoder->tc_file) {
+    fclose(decoder->tc_file);
+  }
+}
+
+static bool index_segment_proc_decoded_frame(FFmpegIndexBuilderContext *context,
+                                             IndexSegmentDecoder *decoder,
+                                             int64_t pts)
+{
+  IndexSegmentFrame entry;
+  int i;
+
+  entry.pts = pts;
+  entry.seek_pos = decoder->seek_pos;
+  entry.seek_pos_dts = decoder->seek_pos_dts;
+
+  /* see index_rebuild_ffmpeg_proc_decoded_frame */
+  if (entry.pts < decoder->seek_pos_pts) {
+    entry.seek_pos = decoder->last_seek_pos;
+    entry.seek_pos_dts = decoder->last_seek_pos_dts;
+  }
+
+  for (i = 0; i < context->num_proxy_sizes; i++) {
+    if (decoder->outputs[i].c &&
+        !index_segment_output_add(
+            &decoder->outputs[i], decoder->frame, context->proxy_ctx[i]->orig_height)) {
+      return false;
+    }
+  }
+
+  return fwrite(&entry, sizeof(entry), 1, decoder->tc_file) == 1;
+}
+
+static void index_segment_add_progress(IndexSegmentBuild *build,
+                                       ThreadMutex *mutex,
+                                       int num_packets)
+{
+  BLI_mutex_lock(mutex);
+  build->num_packets_done += num_packets;
+  *build->progress = (float)build->num_packets_done / (float)build->num_packets;
+  *build->do_update = true;
+  BLI_mutex_unlock(mutex);
+}
+
+static void index_segment_build_task(TaskPool *__restrict pool,
+                                     void *taskdata,
+                                     int UNUSED(threadid))
+{
+  IndexSegmentBuild *build = BLI_task_pool_userdata(pool);
+  ThreadMutex *mutex = BLI_task_pool_user_mutex(pool);
+  FFmpegIndexBuilderContext *context = build->context;
+  const int segment_index = POINTER_AS_INT(taskdata);
+  const IndexSegment *segment = &build->segments[segment_index];
+  const IndexSegment *next_segment = (segment_index + 1 < build->num_segments) ? segment + 1 :
+                                                                                  NULL;
+  IndexSegmentDecoder decoder;
+  AVPacket packet;
+  bool started = false, finished = false, ok;
+  int num_packets = 0, i;
+
+  if (*build->stop || build->error) {
+    return;
+  }
+
+  memset(&decoder, 0, sizeof(decoder));
+  memset(&packet, 0, sizeof(AVPacket));
+
+  ok = index_segment_decoder_open(build, &decoder, segment_index, mutex);
+
+  while (ok && !finished && av_read_frame(decoder.format_ctx, &packet) >= 0) {
+    int frame_finished = 0;
+
+    if (*build->stop) {
+      ok = false;
+    }
+    else if (packet.stream_index == context->videoStream) {
+      /* seeking stops at a key frame before the segment */
+      if (!started) {
+        if (packet.pos == segment->start_pos) {
+          started = true;
+        }
+        else if (packet.dts != AV_NOPTS_VALUE && packet.dts > segment->start_dts) {
+          ok = false;
+        }
+      }
+
+      if (started) {
+        if (packet.flags & AV_PKT_FLAG_KEY) {
+          decoder.last_seek_pos = decoder.seek_pos;
+          decoder.last_seek_pos_dts = decoder.seek_pos_dts;
+          decoder.seek_pos = packet.pos;
+          decoder.seek_pos_dts = packet.dts;
+          decoder.seek_pos_pts = packet.pts;
+        }
+
+        avcodec_decode_video2(decoder.codec_ctx, decoder.frame, &frame_finished, &packet);
+
+        if (++num_packets % 16 == 0) {
+          index_segment_add_progress(build, mutex, 16);
+        }
+      }
+    }
+
+    if (frame_finished) {
+      int64_t pts = av_get_pts_from_frame(decoder.format_ctx, decoder.frame);
+
+      /* frames before the key frame belong to the previous segment, which decodes them from
+       * the previous key frame. The segment ends with the first frame of the next segment. */
+      if (next_segment && pts >= next_segment->start_pts) {
+        finished = true;
+      }
+      else if (segment_index == 0 || pts >= segment->start_pts) {
+        ok = index_segment_proc_decoded_frame(context, &decoder, pts);
+      }
+    }
+    av_free_packet(&packet);
+  }
+
+  /* process pictures still stuck in decoder engine after EOF */
+  if (ok && started && !finished) {
+    int frame_finished;
+
+    av_free_packet(&packet);
+
+    do {
+      frame_finished = 0;
+
+      avcodec_decode_video2(decoder.codec_ctx, decoder.frame, &frame_finished, &packet);
+
+      if (frame_finished) {
+        int64_t pts = av_get_pts_from_frame(decoder.format_ctx, decoder.frame);
+
+        if (next_segment && pts >= next_segment->start_pts) {
+          break;
+        }
+        if (segment_index == 0 || pts >= segment->start_pts) {
+          ok = index_segment_proc_decoded_frame(context, &decoder, pts);
+        }
+      }
+    } while (ok && frame_finished);
+  }
+
+  ok = ok && started;
+
+  index_segment_decoder_close(&decoder, mutex);
+
+  if (ok) {
+    char fname[FILE_MAX], fname_tmp[FILE_MAX];
+
+    /* the time code file is renamed last, it marks the segment as done */
+    for (i = IMB_PROXY_MAX_SLOT - 1; i >= -1; i--) {
+      if (i == -1 || context->proxy_ctx[i]) {
+        get_segment_filename(build->segment_dir, segment_index, i, true, fname_tmp);
+        get_segment_filename(build->segment_dir, segment_index, i, false, fname);
+        BLI_rename(fname_tmp, fname);
+      }
+    }
+
+    fprintf(stderr, "Proxy segment %d of %d done\n", segment_index + 1, build->num_segments);
+  }
+  else if (!*build->stop) {
+    BLI_mutex_lock(mutex);
+    build->error = true;
+    BLI_mutex_unlock(mutex);
+  }
+
+  index_segment_add_progress(build, mutex, segment->num_packets - (num_packets / 16) * 16);
+}
+
+static bool index_segment_join_proxy(struct proxy_output_ctx *ctx, const char *fname)
+{
+  FILE *fp = BLI_fopen(fname, "rb");
+  bool ok = (fp != NULL);
+  int size;
+
+  while (ok && fread(&size, sizeof(size), 1, fp) == 1) {
+    AVPacket packet;
+
+    if (size <= 0 || av_new_packet(&packet, size) < 0) {
+      ok = false;
+      break;
+    }
+
+    if (fread(packet.data, 1, size, fp) == (size_t)size) {
+      packet.pts = av_rescale_q(ctx->cfra++, ctx->c->time_base, ctx->st->time_base);
+      packet.dts = packet.pts;
+      packet.flags |= AV_PKT_FLAG_KEY;
+      packet.stream_index = ctx->st->index;
+
+      if (av_interleaved_write_frame(ctx->of, &packet) != 0) {
+        fprintf(stderr, "Error writing proxy frame %d into '%s'\n", ctx->cfra - 1, fname);
+        ok = false;
+      }
+    }
+    else {
+      ok = false;
+    }
+
+    av_free_packet(&packet);
+  }
+
+  if (fp) {
+    fclose(fp);
+  }
+  return ok;
+}
+
+static bool index_segment_join_index(FFmpegIndexBuilderContext *context, const char *fname)
+{
+  FILE *fp = BLI_fopen(fname, "rb");
+  IndexSegmentFrame entry;
+
+  if (!fp) {
+    return false;
+  }
+
+  while (fread(&entry, sizeof(entry), 1, fp) == 1) {
+    index_rebuild_ffmpeg_add_index_entry(
+        context, NULL, 0, entry.pts, entry.seek_pos, entry.seek_pos_dts);
+  }
+
+  fclose(fp);
+  return true;
+}
+
+/* Returns false when the movie has to be indexed sequentially instead. */
+static bool index_rebuild_ffmpeg_segments(FFmpegIndexBuilderContext *context,
+                                          short *stop,
+                                          short *do_update,
+                                          float *progress)
+{
+  IndexSegmentBuild build;
+  IndexSegmentHeader header;
+  TaskScheduler *scheduler = BLI_task_scheduler_get();
+  TaskPool *pool;
+  char fname[FILE_MAX];
+  int i, j;
+
+  if (BLI_task_scheduler_num_threads(scheduler) < 2) {
+    return false;
+  }
+
+  memset(&build, 0, sizeof(build));
+  build.context = context;
+  build.stop = stop;
+  build.do_update = do_update;
+  build.progress = progress;
+
+  build.segments = index_ffmpeg_find_segments(context, &build.num_segments, &build.num_packets);
+  if (build.segments == NULL) {
+    return false;
+  }
+
+  /* continue a stopped build with the same settings */
+  get_segment_dir(context->anim, build.segment_dir);
+  index_segment_header_init(&build, &header);
+
+  if (!index_segment_header_matches(&build, &header)) {
+    BLI_delete(build.segment_dir, true, true);
+    BLI_dir_create_recursive(build.segment_dir);
+
+    if (!index_segment_header_write(&build, &header)) {
+      MEM_freeN(build.segments);
+      return false;
+    }
+  }
+
+  pool = BLI_task_pool_create(scheduler, &build);
+
+  for (i = 0; i < build.num_segments; i++) {
+    get_segment_filename(build.segment_dir, i, -1, false, fname);
+    if (BLI_exists(fname)) {
+      build.num_packets_done += build.segments[i].num_packets;
+    }
+    else {
+      BLI_task_pool_push(
+          pool, index_segment_build_task, POINTER_FROM_INT(i), false, TASK_PRIORITY_LOW);
+    }
+  }
+
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+
+  if (*stop) {
+    MEM_freeN(build.segments);
+    return true;
+  }
+
+  if (build.error) {
+    fprintf(stderr, "Proxy: building in segments failed, building sequentially\n");
+    BLI_delete(build.segment_dir, true, true);
+    MEM_freeN(build.segments);
+    return false;
+  }
+
+  /* join the segments in order */
+  context->frame_rate = av_q2d(av_guess_frame_rate(context->iFormatCtx, context->iStream, NULL));
+  context->pts_time_base = av_q2d(context->iStream->time_base);
+
+  for (i = 0; i < build.num_segments; i++) {
+    bool ok;
+
+    get_segment_filename(build.segment_dir, i, -1, false, fname);
+    ok = index_segment_join_index(context, fname);
+
+    for (j = 0; ok && j < context->num_proxy_sizes; j++) {
+      if (context->proxy_ctx[j]) {
+        get_segment_filename(build.segment_dir, i, j, false, fname);
+        ok = index_segment_join_proxy(context->proxy_ctx[j], fname);
+      }
+    }
+
+    if (!ok) {
+      /* The outputs are written up to this segment already, so they're discarded. The segment
+       * is built again when resuming, the ones before it are kept. */
+      fprintf(stderr, "Proxy: couldn't join segment %d\n", i + 1);
+      get_segment_filename(build.segment_dir, i, -1, false, fname);
+      BLI_delete(fname, false, false);
+      context->build_failed = true;
+      MEM_freeN(build.segments);
+      return true;
+    }
+  }
+
+  BLI_delete(build.segment_dir, true, true);
+  MEM_freeN(build.segments);
+
+  return true;
+}
+
+#endif /* USE_SEGMENT_BUILD */
+
 #endif
 
 /* ----------------------------------------------------------------------
@@ -1228,6 +2127,12 @@ void IMB_anim_index_rebuild(struct IndexBuildContext *context,
   switch (context->anim_type) {
 #ifdef WITH_FFMPEG
     case ANIM_FFMPEG:
+#  ifdef USE_SEGMENT_BUILD
+      if (index_rebuild_ffmpeg_segments(
+              (FFmpegIndexBuilderContext *)context, stop, do_update, progress)) {
+        break;
+      }
+#  endif
       index_rebuild_ffmpeg((FFmpegIndexBuilderContext *)context, stop, do_update, progress);
       break;
 #endif
@@ -1309,6 +2214,9 @@ struct anim *IMB_anim_open_proxy(struct anim *anim, IMB_Proxy_Size preview_size)
 
   /* proxies are generated in the same color space as animation itself */
   anim->proxy_anim[i] = IMB_open_anim(fname, 0, 0, anim->colorspace);
+  if (anim->proxy_anim[i]) {
+    IMB_anim_set_concurrent_decoding(anim->proxy_anim[i], anim->num_concurrent_decoders);
+  }
 
   anim->proxies_tried |= preview_size;
 
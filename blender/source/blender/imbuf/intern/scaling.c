@@ -22,9 +22,14 @@
  * \ingroup imbuf
  */
 
+#include <string.h>
+
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_math_color.h"
 #include "BLI_math_interp.h"
+#include "BLI_math_vector.h"
+#include "BLI_task.h"
 #include "MEM_guardedalloc.h"
 
 #include "imbuf.h"
@@ -35,6 +40,10 @@
 
 #include "BLI_sys_types.h"  // for intptr_t support
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static void imb_half_x_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 {
   uchar *p1, *_p1, *dest;
@@ -1613,6 +1622,494 @@ static void scalefast_Z_ImBuf(ImBuf *ibuf, int newx, int newy)
   }
 }
 
+/* ******** separable filtered scaling ******** */
+
+/* Images are scaled in two passes, horizontal and vertical, each resampling one axis with
+ * precomputed filter weights. The filter is stretched when scaling down, so all input pixels
+ * contribute to the result. Passes run in parallel over lines, one RGBA pixel is processed as
+ * one SSE2 vector when available. */
+
+typedef struct ScaleFilterWeights {
+  /* Number of output pixels. */
+  int size;
+  /* Maximum number of input pixels contributing to one output pixel. */
+  int taps;
+  /* First input pixel and number of input pixels for every output pixel. */
+  int *first;
+  int *count;
+  /* `taps` normalized weights for every output pixel. */
+  float *weights;
+} ScaleFilterWeights;
+
+static float scale_filter_radius(eIMBScaleFilter filter)
+{
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return 0.5f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      return 1.0f;
+    case IMB_SCALE_FILTER_BICUBIC:
+      return 2.0f;
+  }
+  BLI_assert(0);
+  return 1.0f;
+}
+
+static float scale_filter_eval(eIMBScaleFilter filter, float x)
+{
+  switch (filter) {
+    case IMB_SCALE_FILTER_BOX:
+      return (x > -0.5f && x <= 0.5f) ? 1.0f : 0.0f;
+    case IMB_SCALE_FILTER_BILINEAR:
+      x = fabsf(x);
+      return (x < 1.0f) ? 1.0f - x : 0.0f;
+    case IMB_SCALE_FILTER_BICUBIC: {
+      /* Catmull-Rom spline (a = -0.5). */
+      const float a = -0.5f;
+      x = fabsf(x);
+      if (x < 1.0f) {
+        return ((a + 2.0f) * x - (a + 3.0f)) * x * x + 1.0f;
+      }
+      if (x < 2.0f) {
+        return (((x - 5.0f) * x + 8.0f) * x - 4.0f) * a;
+      }
+      return 0.0f;
+    }
+  }
+  BLI_assert(0);
+  return 0.0f;
+}
+
+static void scale_filter_weights_init(ScaleFilterWeights *fw,
+                                      eIMBScaleFilter filter,
+                                      int in_size,
+                                      int out_size)
+{
+  const float scale = (float)in_size / (float)out_size;
+  const float filter_scale = max_ff(scale, 1.0f);
+  const float support = scale_filter_radius(filter) * filter_scale;
+  /* Box filter for scaling down uses area coverage, so partially covered input pixels
+   * are weighted correctly. */
+  const bool use_area = (filter == IMB_SCALE_FILTER_BOX && scale > 1.0f);
+  const float bias = use_area ? 1.0f : 0.5f;
+
+  fw->size = out_size;
+  fw->taps = (int)ceilf(support) * 2 + 2;
+  fw->first = MEM_mallocN(sizeof(int) * out_size, __func__);
+  fw->count = MEM_mallocN(sizeof(int) * out_size, __func__);
+  fw->weights = MEM_callocN(sizeof(float) * out_size * fw->taps, __func__);
+
+  for (int i = 0; i < out_size; i++) {
+    const float center = (i + 0.5f) * scale;
+    const int first = max_ii((int)(center - support + 1.0f - bias), 0);
+    const int last = min_ii((int)(center + support + bias), in_size);
+    const int count = min_ii(last - first, fw->taps);
+    float *weights = &fw->weights[i * fw->taps];
+    float total = 0.0f;
+
+    for (int j = 0; j < count; j++) {
+      if (use_area) {
+        weights[j] = max_ff(min_ff(first + j + 1.0f, center + support) -
+                                max_ff(first + j, center - support),
+                            0.0f);
+      }
+      else {
+        weights[j] = scale_filter_eval(filter, (first + j - center + 0.5f) / filter_scale);
+      }
+      total += weights[j];
+    }
+
+    if (total != 0.0f) {
+      for (int j = 0; j < count; j++) {
+        weights[j] /= total;
+      }
+    }
+    else {
+      /* Can only happen for box filter between pixel centers, use nearest pixel. */
+      weights[0] = 1.0f;
+    }
+
+    fw->first[i] = first;
+    fw->count[i] = max_ii(count, 1);
+  }
+}
+
+static void scale_filter_weights_free(ScaleFilterWeights *fw)
+{
+  MEM_freeN(fw->first);
+  MEM_freeN(fw->count);
+  MEM_freeN(fw->weights);
+}
+
+#ifdef __SSE2__
+
+typedef __m128 ScalePixel;
+
+BLI_INLINE ScalePixel scale_pixel_zero(void)
+{
+  return _mm_setzero_ps();
+}
+
+BLI_INLINE ScalePixel scale_pixel_load_float(const float *p)
+{
+  return _mm_loadu_ps(p);
+}
+
+BLI_INLINE ScalePixel scale_pixel_load_byte(const uchar *p)
+{
+  int color;
+  memcpy(&color, p, sizeof(color));
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i color_16 = _mm_unpacklo_epi8(_mm_cvtsi32_si128(color), zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(color_16, zero));
+}
+
+BLI_INLINE ScalePixel scale_pixel_madd(const ScalePixel acc, const ScalePixel p, const float w)
+{
+  return _mm_add_ps(acc, _mm_mul_ps(p, _mm_set1_ps(w)));
+}
+
+BLI_INLINE void scale_pixel_store_float(float *p, const ScalePixel v)
+{
+  _mm_storeu_ps(p, v);
+}
+
+BLI_INLINE void scale_pixel_store_byte(uchar *p, const ScalePixel v)
+{
+  /* Round to nearest, packing clamps to 0..255 range. */
+  const __m128i color_32 = _mm_cvttps_epi32(
+      _mm_min_ps(_mm_add_ps(v, _mm_set1_ps(0.5f)), _mm_set1_ps(255.0f)));
+  const __m128i color_16 = _mm_packs_epi32(color_32, color_32);
+  const int color = _mm_cvtsi128_si32(_mm_packus_epi16(color_16, color_16));
+  memcpy(p, &color, sizeof(color));
+}
+
+#else /* __SSE2__ */
+
+typedef struct ScalePixel {
+  float v[4];
+} ScalePixel;
+
+BLI_INLINE ScalePixel scale_pixel_zero(void)
+{
+  ScalePixel r = {{0.0f, 0.0f, 0.0f, 0.0f}};
+  return r;
+}
+
+BLI_INLINE ScalePixel scale_pixel_load_float(const float *p)
+{
+  ScalePixel r = {{p[0], p[1], p[2], p[3]}};
+  return r;
+}
+
+BLI_INLINE ScalePixel scale_pixel_load_byte(const uchar *p)
+{
+  ScalePixel r = {{p[0], p[1], p[2], p[3]}};
+  return r;
+}
+
+BLI_INLINE ScalePixel scale_pixel_madd(ScalePixel acc, const ScalePixel p, const float w)
+{
+  madd_v4_v4fl(acc.v, p.v, w);
+  return acc;
+}
+
+BLI_INLINE void scale_pixel_store_float(float *p, const ScalePixel v)
+{
+  copy_v4_v4(p, v.v);
+}
+
+BLI_INLINE void scale_pixel_store_byte(uchar *p, const ScalePixel v)
+{
+  for (int i = 0; i < 4; i++) {
+    p[i] = (uchar)clamp_f(v.v[i] + 0.5f, 0.0f, 255.0f);
+  }
+}
+
+#endif /* __SSE2__ */
+
+typedef struct ScalePassData {
+  const ScaleFilterWeights *fw;
+  /* Only one of byte and float buffer is set for input and for output. */
+  const uchar *in_byte;
+  const float *in_float;
+  uchar *out_byte;
+  float *out_float;
+  /* Width of input and output buffer, in pixels. */
+  int in_width;
+  int out_width;
+} ScalePassData;
+
+/* Number of pixels accumulated at once in the vertical pass. */
+#define SCALE_BLOCK_SIZE 64
+
+BLI_INLINE void scale_pass_store(const ScalePassData *data,
+                                 size_t index,
+                                 const ScalePixel *pixels,
+                                 int len)
+{
+  if (data->out_byte) {
+    uchar *out = data->out_byte + 4 * index;
+    for (int x = 0; x < len; x++) {
+      scale_pixel_store_byte(out + 4 * x, pixels[x]);
+    }
+  }
+  else {
+    float *out = data->out_float + 4 * index;
+    for (int x = 0; x < len; x++) {
+      scale_pixel_store_float(out + 4 * x, pixels[x]);
+    }
+  }
+}
+
+static void scale_pass_horizontal_cb(void *__restrict userdata,
+                                     const int y,
+                                     const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ScalePassData *data = userdata;
+  const ScaleFilterWeights *fw = data->fw;
+  const size_t in_row = (size_t)y * data->in_width;
+  const size_t out_row = (size_t)y * data->out_width;
+  ScalePixel block[SCALE_BLOCK_SIZE];
+
+  for (int x_start = 0; x_start < fw->size; x_start += SCALE_BLOCK_SIZE) {
+    const int len = min_ii(fw->size - x_start, SCALE_BLOCK_SIZE);
+
+    for (int x = 0; x < len; x++) {
+      const float *weights = &fw->weights[(x_start + x) * fw->taps];
+      const size_t first = in_row + fw->first[x_start + x];
+      const int count = fw->count[x_start + x];
+      ScalePixel acc = scale_pixel_zero();
+
+      if (data->in_byte) {
+        const uchar *in = data->in_byte + 4 * first;
+        for (int i = 0; i < count; i++) {
+          acc = scale_pixel_madd(acc, scale_pixel_load_byte(in + 4 * i), weights[i]);
+        }
+      }
+      else {
+        const float *in = data->in_float + 4 * first;
+        for (int i = 0; i < count; i++) {
+          acc = scale_pixel_madd(acc, scale_pixel_load_float(in + 4 * i), weights[i]);
+        }
+      }
+      block[x] = acc;
+    }
+
+    scale_pass_store(data, out_row + x_start, block, len);
+  }
+}
+
+static void scale_pass_vertical_cb(void *__restrict userdata,
+                                   const int y,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ScalePassData *data = userdata;
+  const ScaleFilterWeights *fw = data->fw;
+  const float *weights = &fw->weights[y * fw->taps];
+  const size_t first = (size_t)fw->first[y] * data->in_width;
+  const size_t out_row = (size_t)y * data->out_width;
+  ScalePixel block[SCALE_BLOCK_SIZE];
+
+  /* Accumulate a block of pixels one input line at a time, so every tap
+   * reads a contiguous span of memory. */
+  for (int x_start = 0; x_start < data->out_width; x_start += SCALE_BLOCK_SIZE) {
+    const int len = min_ii(data->out_width - x_start, SCALE_BLOCK_SIZE);
+
+    for (int x = 0; x < len; x++) {
+      block[x] = scale_pixel_zero();
+    }
+
+    for (int i = 0; i < fw->count[y]; i++) {
+      const size_t index = first + (size_t)i * data->in_width + x_start;
+      const float weight = weights[i];
+
+      if (data->in_byte) {
+        const uchar *in = data->in_byte + 4 * index;
+        for (int x = 0; x < len; x++) {
+          block[x] = scale_pixel_madd(block[x], scale_pixel_load_byte(in + 4 * x), weight);
+        }
+      }
+      else {
+        const float *in = data->in_float + 4 * index;
+        for (int x = 0; x < len; x++) {
+          block[x] = scale_pixel_madd(block[x], scale_pixel_load_float(in + 4 * x), weight);
+        }
+      }
+    }
+
+    scale_pass_store(data, out_row + x_start, block, len);
+  }
+}
+
+/* Resample one 4 channel buffer, either byte or float, from in_x * in_y to out_x * out_y. */
+static void scale_filtered_buffer(const uchar *in_byte,
+                                  const float *in_float,
+                                  uchar *out_byte,
+                                  float *out_float,
+                                  int in_x,
+                                  int in_y,
+                                  int out_x,
+                                  int out_y,
+                                  eIMBScaleFilter filter_x,
+                                  eIMBScaleFilter filter_y)
+{
+  const bool do_x = (in_x != out_x);
+  const bool do_y = (in_y != out_y);
+  ScaleFilterWeights fw_x, fw_y;
+  float *temp = NULL;
+  ScalePassData data = {NULL};
+  TaskParallelSettings settings;
+
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = ((size_t)out_x * out_y > 64 * 64);
+
+  if (do_x) {
+    scale_filter_weights_init(&fw_x, filter_x, in_x, out_x);
+
+    data.fw = &fw_x;
+    data.in_byte = in_byte;
+    data.in_float = in_float;
+    data.in_width = in_x;
+    data.out_width = out_x;
+    if (do_y) {
+      /* Intermediate result is kept in float to avoid rounding twice. */
+      temp = MEM_mallocN(sizeof(float[4]) * out_x * in_y, __func__);
+      data.out_float = temp;
+    }
+    else {
+      data.out_byte = out_byte;
+      data.out_float = out_float;
+    }
+
+    BLI_task_parallel_range(0, in_y, &data, scale_pass_horizontal_cb, &settings);
+    scale_filter_weights_free(&fw_x);
+  }
+
+  if (do_y) {
+    scale_filter_weights_init(&fw_y, filter_y, in_y, out_y);
+
+    data.fw = &fw_y;
+    data.in_byte = temp ? NULL : in_byte;
+    data.in_float = temp ? temp : in_float;
+    data.out_byte = out_byte;
+    data.out_float = out_float;
+    data.in_width = out_x;
+    data.out_width = out_x;
+
+    BLI_task_parallel_range(0, out_y, &data, scale_pass_vertical_cb, &settings);
+    scale_filter_weights_free(&fw_y);
+  }
+
+  if (temp) {
+    MEM_freeN(temp);
+  }
+}
+
+static bool scale_filtered_supported(const ImBuf *ibuf)
+{
+  /* Only 4 channel float buffers are supported. */
+  return (ibuf->rect_float == NULL || ibuf->channels == 4);
+}
+
+static void scale_filtered(ImBuf *ibuf,
+                           unsigned int newx,
+                           unsigned int newy,
+                           eIMBScaleFilter filter_x,
+                           eIMBScaleFilter filter_y)
+{
+  uchar *newrect = NULL;
+  float *newrectf = NULL;
+
+  if (ibuf->rect) {
+    newrect = MEM_mallocN(sizeof(uchar[4]) * newx * newy, "scale_filtered");
+    scale_filtered_buffer((uchar *)ibuf->rect,
+                          NULL,
+                          newrect,
+                          NULL,
+                          ibuf->x,
+                          ibuf->y,
+                          newx,
+                          newy,
+                          filter_x,
+                          filter_y);
+  }
+  if (ibuf->rect_float) {
+    newrectf = MEM_mallocN(sizeof(float[4]) * newx * newy, "scale_filtered_float");
+    scale_filtered_buffer(
+        NULL, ibuf->rect_float, NULL, newrectf, ibuf->x, ibuf->y, newx, newy, filter_x, filter_y);
+  }
+
+  if (newrect) {
+    imb_freerectImBuf(ibuf);
+    ibuf->mall |= IB_rect;
+    ibuf->rect = (unsigned int *)newrect;
+  }
+  if (newrectf) {
+    imb_freerectfloatImBuf(ibuf);
+    ibuf->mall |= IB_rectfloat;
+    ibuf->rect_float = newrectf;
+  }
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+}
+
+/**
+ * Scale with the box filter when scaling down and linear interpolation when scaling up,
+ * one axis at a time. Used before separable filtered scaling and still used for float
+ * buffers with other than 4 channels, the Z-buffer is not scaled.
+ */
+void imb_scale_box_linear(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
+{
+  if (newx && (newx < ibuf->x)) {
+    scaledownx(ibuf, newx);
+  }
+  if (newy && (newy < ibuf->y)) {
+    scaledowny(ibuf, newy);
+  }
+  if (newx && (newx > ibuf->x)) {
+    scaleupx(ibuf, newx);
+  }
+  if (newy && (newy > ibuf->y)) {
+    scaleupy(ibuf, newy);
+  }
+}
+
+/**
+ * Scale \a ibuf using given filter, the filter is widened when scaling down
+ * so every input pixel contributes to the result.
+ * A zero \a newx or \a newy keeps that dimension unchanged.
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scaleImBuf_filter(struct ImBuf *ibuf,
+                           unsigned int newx,
+                           unsigned int newy,
+                           eIMBScaleFilter filter)
+{
+  if (ibuf == NULL) {
+    return false;
+  }
+  if (ibuf->rect == NULL && ibuf->rect_float == NULL) {
+    return false;
+  }
+  if (!scale_filtered_supported(ibuf)) {
+    return IMB_scaleImBuf(ibuf, newx, newy);
+  }
+
+  newx = newx ? newx : ibuf->x;
+  newy = newy ? newy : ibuf->y;
+  if (newx == ibuf->x && newy == ibuf->y) {
+    return false;
+  }
+
+  scalefast_Z_ImBuf(ibuf, newx, newy);
+  scale_filtered(ibuf, newx, newy, filter, filter);
+
+  return true;
+}
+
 /**
  * Return true if \a ibuf is modified.
  */
@@ -1639,19 +2136,22 @@ bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
     return true;
   }
 
-  if (newx && (newx < ibuf->x)) {
-    scaledownx(ibuf, newx);
-  }
-  if (newy && (newy < ibuf->y)) {
-    scaledowny(ibuf, newy);
-  }
-  if (newx && (newx > ibuf->x)) {
-    scaleupx(ibuf, newx);
-  }
-  if (newy && (newy > ibuf->y)) {
-    scaleupy(ibuf, newy);
+  /* Separable filtered scaling, box filter averages all pixels when scaling down,
+   * bilinear filter is used when scaling up. */
+  if (scale_filtered_supported(ibuf)) {
+    newx = newx ? newx : ibuf->x;
+    newy = newy ? newy : ibuf->y;
+    scale_filtered(ibuf,
+                   newx,
+                   newy,
+                   (newx < ibuf->x) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR,
+                   (newy < ibuf->y) ? IMB_SCALE_FILTER_BOX : IMB_SCALE_FILTER_BILINEAR);
+    return true;
   }
 
+  /* Only handles other channel counts. */
+  imb_scale_box_linear(ibuf, newx, newy);
+
   return true;
 }
 
@@ -414,6 +414,7 @@ static ImBuf *thumb_create_ex(const char *file_path,
   char tdir[FILE_MAX];
   char temp[FILE_MAX];
   char mtime[40] = "0";  /* in case we can't stat the file */
+  char fsize[40] = "0";
   char cwidth[40] = "0"; /* in case images have no data */
   char cheight[40] = "0";
   short tsize = 128;
@@ -479,6 +480,7 @@ static ImBuf *thumb_create_ex(const char *file_path,
         if (img != NULL) {
           if (BLI_stat(file_path, &info) != -1) {
             BLI_snprintf(mtime, sizeof(mtime), "%ld", (long int)info.st_mtime);
+            BLI_snprintf(fsize, sizeof(fsize), "%lld", (long long int)info.st_size);
           }
           BLI_snprintf(cwidth, sizeof(cwidth), "%d", img->x);
           BLI_snprintf(cheight, sizeof(cheight), "%d", img->y);
@@ -500,6 +502,7 @@ static ImBuf *thumb_create_ex(const char *file_path,
         }
         if (BLI_stat(file_path, &info) != -1) {
           BLI_snprintf(mtime, sizeof(mtime), "%ld", (long int)info.st_mtime);
+          BLI_snprintf(fsize, sizeof(fsize), "%lld", (long long int)info.st_size);
         }
       }
       if (!img) {
@@ -534,6 +537,7 @@ static ImBuf *thumb_create_ex(const char *file_path,
     IMB_metadata_set_field(img->metadata, "Thumb::URI", uri);
     IMB_metadata_set_field(img->metadata, "Description", desc);
     IMB_metadata_set_field(img->metadata, "Thumb::MTime", mtime);
+    IMB_metadata_set_field(img->metadata, "Thumb::Size", fsize);
     if (use_hash) {
       IMB_metadata_set_field(img->metadata, "X-Blender::Hash", hash);
     }
@@ -693,6 +697,7 @@ ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source
         bool regenerate = false;
 
         char mtime[40];
+        char fsize[40];
         char thumb_hash[33];
         char thumb_hash_curr[33];
 
@@ -706,6 +711,13 @@ ImBuf *IMB_thumb_manage(const char *org_path, ThumbSize size, ThumbSource source
           regenerate = true;
         }
 
+        /* The size is optional (not written by older versions),
+         * it catches files replaced within the precision of the modification time. */
+        if (!regenerate &&
+            IMB_metadata_get_field(img->metadata, "Thumb::Size", fsize, sizeof(fsize))) {
+          regenerate = (st.st_size != atoll(fsize));
+        }
+
         if (use_hash && !regenerate) {
           if (IMB_metadata_get_field(
                   img->metadata, "X-Blender::Hash", thumb_hash_curr, sizeof(thumb_hash_curr))) {
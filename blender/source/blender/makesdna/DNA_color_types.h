@@ -209,6 +209,7 @@ typedef struct ColorManagedColorspaceSettings {
 /* ColorManagedViewSettings->flag */
 enum {
   COLORMANAGE_VIEW_USE_CURVES = (1 << 0),
+  COLORMANAGE_VIEW_USE_BAKED_LUT = (1 << 1),
 };
 
 #endif
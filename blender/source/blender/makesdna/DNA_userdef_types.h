@@ -711,7 +711,8 @@ typedef struct UserDef {
   short gp_manhattendist, gp_euclideandist, gp_eraser;
   /** #eGP_UserdefSettings. */
   short gp_settings;
-  char _pad13[4];
+  /** Compositor memory buffer cache limit (in megabytes). */
+  int compositor_cache_limit;
   struct SolidLight light_param[4];
   float light_ambient[3];
   char _pad3[4];
@@ -724,7 +725,8 @@ typedef struct UserDef {
   int prefetchframes;
   /** Control the rotation step of the view when PAD2, PAD4, PAD6&PAD8 is use. */
   float pad_rot_angle;
-  char _pad12[4];
+  /** Sequencer disk cache size limit (in gigabytes). */
+  int sequencer_disk_cache_size_limit;
   /** Rotating view icon size. */
   short rvisize;
   /** Rotating view icon brightness. */
@@ -1242,6 +1242,15 @@ static void rna_def_colormanage(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Use Curves", "Use RGB curved for pre-display transformation");
   RNA_def_property_update(prop, NC_WINDOW, "rna_ColorManagement_update");
 
+  prop = RNA_def_property(srna, "use_baked_lut", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", COLORMANAGE_VIEW_USE_BAKED_LUT);
+  RNA_def_property_ui_text(prop,
+                           "Use Baked LUT",
+                           "Display images in editors using the view transform baked into a "
+                           "lookup table, faster but approximate. Rendered and saved images "
+                           "always use the exact transform");
+  RNA_def_property_update(prop, NC_WINDOW, "rna_ColorManagement_update");
+
   /* ** Colorspace **  */
   srna = RNA_def_struct(brna, "ColorManagedInputColorspaceSettings", NULL);
   RNA_def_struct_path_func(srna, "rna_ColorManagedInputColorspaceSettings_path");
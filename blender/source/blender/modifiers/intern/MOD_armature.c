@@ -65,6 +65,17 @@ static void copyData(const ModifierData *md, ModifierData *target, const int fla
   tamd->prevCos = NULL;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  armature_deform_cache_free(runtime_data);
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 static void requiredDataMask(Object *UNUSED(ob),
                              ModifierData *UNUSED(md),
                              CustomData_MeshMasks *r_cddata_masks)
@@ -143,7 +154,8 @@ static void deformVerts(ModifierData *md,
                         amd->deformflag,
                         (float(*)[3])amd->prevCos,
                         amd->defgrp_name,
-                        NULL);
+                        NULL,
+                        (struct ArmatureDeformCache **)&md->runtime);
 
   /* free cache */
   if (amd->prevCos) {
@@ -173,7 +185,8 @@ static void deformVertsEM(ModifierData *md,
                         amd->deformflag,
                         (float(*)[3])amd->prevCos,
                         amd->defgrp_name,
-                        NULL);
+                        NULL,
+                        (struct ArmatureDeformCache **)&md->runtime);
 
   /* free cache */
   if (amd->prevCos) {
@@ -206,7 +219,8 @@ static void deformMatricesEM(ModifierData *md,
                         amd->deformflag,
                         NULL,
                         amd->defgrp_name,
-                        NULL);
+                        NULL,
+                        (struct ArmatureDeformCache **)&md->runtime);
 
   if (mesh_src != mesh) {
     BKE_id_free(NULL, mesh_src);
@@ -232,7 +246,8 @@ static void deformMatrices(ModifierData *md,
                         amd->deformflag,
                         NULL,
                         amd->defgrp_name,
-                        NULL);
+                        NULL,
+                        (struct ArmatureDeformCache **)&md->runtime);
 
   if (mesh_src != mesh) {
     BKE_id_free(NULL, mesh_src);
@@ -257,7 +272,7 @@ ModifierTypeInfo modifierType_Armature = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ updateDepsgraph,
     /* dependsOnTime */ NULL,
@@ -265,5 +280,5 @@ ModifierTypeInfo modifierType_Armature = {
     /* foreachObjectLink */ foreachObjectLink,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
 };
@@ -28,6 +28,7 @@
 #include "BLI_utildefines.h"
 
 #include "BLI_math.h"
+#include "BLI_task.h"
 
 #include "DNA_curve_types.h"
 #include "DNA_mesh_types.h"
@@ -105,45 +106,171 @@ static void updateDepsgraph(ModifierData *md, const ModifierUpdateDepsgraphConte
   }
 }
 
-BLI_INLINE float sum_v3(const float v[3])
+/* -------------------------------------------------------------------- */
+/** \name Doubles Detection
+ *
+ * Target vertices are stored in a spatial hash, with cells at least as large as the merge
+ * distance, so a search only has to visit the few cells overlapping the search box.
+ * \{ */
+
+typedef struct DoublesGridElem {
+  int vertex_num; /* The original index of the vertex */
+  float co[3];    /* Its coordinates, stored here to avoid indirect lookups while searching */
+} DoublesGridElem;
+
+typedef struct DoublesGrid {
+  /** Bounds of the stored vertices, searches are clamped to them. */
+  float min[3], max[3];
+  float cell_size_inv;
+  uint buckets_mask;
+  /** Elements of bucket `i` are `elems[offsets[i]]` up to `elems[offsets[i + 1]]`. */
+  int *offsets;
+  DoublesGridElem *elems;
+} DoublesGrid;
+
+/* Limit the cells per axis, so cell coordinates always fit in an int. */
+#define DOUBLES_GRID_CELLS_MAX (1 << 20)
+
+BLI_INLINE int doubles_grid_cell(const DoublesGrid *grid, const float co, const int axis)
 {
-  return v[0] + v[1] + v[2];
+  return (int)((co - grid->min[axis]) * grid->cell_size_inv);
 }
 
-/* Structure used for sorting vertices, when processing doubles */
-typedef struct SortVertsElem {
-  int vertex_num; /* The original index of the vertex, prior to sorting */
-  float co[3];    /* Its coordinates */
-  float sum_co;   /* sum_v3(co), just so we don't do the sum many times.  */
-} SortVertsElem;
+BLI_INLINE uint doubles_grid_bucket(const DoublesGrid *grid, const int x, const int y, const int z)
+{
+  return (((uint)x * 73856093u) ^ ((uint)y * 19349663u) ^ ((uint)z * 83492791u)) &
+         grid->buckets_mask;
+}
 
-static int svert_sum_cmp(const void *e1, const void *e2)
+static void doubles_grid_build(DoublesGrid *grid,
+                               const MVert *mverts,
+                               const int verts_start,
+                               const int verts_num,
+                               const float dist)
 {
-  const SortVertsElem *sv1 = e1;
-  const SortVertsElem *sv2 = e2;
+  const MVert *mv;
+  float cell_size;
+  uint buckets_num = 1;
+  uint *elem_buckets;
+  int i;
+
+  INIT_MINMAX(grid->min, grid->max);
+  for (i = 0, mv = mverts + verts_start; i < verts_num; i++, mv++) {
+    minmax_v3v3_v3(grid->min, grid->max, mv->co);
+  }
+
+  cell_size = max_ff(dist, max_fff(grid->max[0] - grid->min[0],
+                                   grid->max[1] - grid->min[1],
+                                   grid->max[2] - grid->min[2]) /
+                               (float)DOUBLES_GRID_CELLS_MAX);
+  grid->cell_size_inv = (cell_size > 0.0f) ? 1.0f / cell_size : 0.0f;
+  if (!isfinite(grid->cell_size_inv)) {
+    grid->cell_size_inv = 0.0f;
+  }
+
+  while (buckets_num < (uint)verts_num) {
+    buckets_num <<= 1;
+  }
+  grid->buckets_mask = buckets_num - 1;
+
+  grid->offsets = MEM_calloc_arrayN(buckets_num + 1, sizeof(*grid->offsets), __func__);
+  grid->elems = MEM_malloc_arrayN(verts_num, sizeof(*grid->elems), __func__);
+  elem_buckets = MEM_malloc_arrayN(verts_num, sizeof(*elem_buckets), __func__);
 
-  if (sv1->sum_co > sv2->sum_co) {
-    return 1;
+  for (i = 0, mv = mverts + verts_start; i < verts_num; i++, mv++) {
+    elem_buckets[i] = doubles_grid_bucket(grid,
+                                          doubles_grid_cell(grid, mv->co[0], 0),
+                                          doubles_grid_cell(grid, mv->co[1], 1),
+                                          doubles_grid_cell(grid, mv->co[2], 2));
+    grid->offsets[elem_buckets[i] + 1]++;
   }
-  else if (sv1->sum_co < sv2->sum_co) {
-    return -1;
+  for (i = 0; i < (int)buckets_num; i++) {
+    grid->offsets[i + 1] += grid->offsets[i];
   }
-  else {
-    return 0;
+  /* Fill each bucket back to front, this keeps its vertices in index order
+   * and leaves `offsets[i + 1]` at the start of bucket `i`. */
+  for (i = verts_num; i--;) {
+    DoublesGridElem *elem = &grid->elems[--grid->offsets[elem_buckets[i] + 1]];
+    elem->vertex_num = verts_start + i;
+    copy_v3_v3(elem->co, mverts[verts_start + i].co);
   }
+  memmove(grid->offsets, grid->offsets + 1, sizeof(*grid->offsets) * buckets_num);
+  grid->offsets[buckets_num] = verts_num;
+
+  MEM_freeN(elem_buckets);
 }
 
-static void svert_from_mvert(SortVertsElem *sv,
-                             const MVert *mv,
-                             const int i_begin,
-                             const int i_end)
+static void doubles_grid_free(DoublesGrid *grid)
 {
-  int i;
-  for (i = i_begin; i < i_end; i++, sv++, mv++) {
-    sv->vertex_num = i;
-    copy_v3_v3(sv->co, mv->co);
-    sv->sum_co = sum_v3(mv->co);
+  MEM_freeN(grid->offsets);
+  MEM_freeN(grid->elems);
+}
+
+/**
+ * \return The index of the closest stored vertex within \a dist of \a co
+ * (the lowest index on ties), or -1 if there is none.
+ */
+static int doubles_grid_find_nearest(const DoublesGrid *grid, const float co[3], const float dist)
+{
+  int cell_min[3], cell_max[3];
+  int best_vertex = -1;
+  float best_dist_sq = dist * dist;
+  int x, y, z, axis;
+
+  for (axis = 0; axis < 3; axis++) {
+    const float lo = max_ff(co[axis] - dist, grid->min[axis]);
+    const float hi = min_ff(co[axis] + dist, grid->max[axis]);
+    if (!(lo <= hi)) {
+      return -1;
+    }
+    cell_min[axis] = doubles_grid_cell(grid, lo, axis);
+    cell_max[axis] = doubles_grid_cell(grid, hi, axis);
+  }
+
+  for (z = cell_min[2]; z <= cell_max[2]; z++) {
+    for (y = cell_min[1]; y <= cell_max[1]; y++) {
+      for (x = cell_min[0]; x <= cell_max[0]; x++) {
+        const uint bucket = doubles_grid_bucket(grid, x, y, z);
+        const DoublesGridElem *elem = &grid->elems[grid->offsets[bucket]];
+        const DoublesGridElem *elem_end = &grid->elems[grid->offsets[bucket + 1]];
+        for (; elem != elem_end; elem++) {
+          const float dist_sq = len_squared_v3v3(co, elem->co);
+          /* Unsigned compare so any vertex wins a tie against -1 (none found yet). */
+          if ((dist_sq < best_dist_sq) ||
+              ((dist_sq == best_dist_sq) && ((uint)elem->vertex_num < (uint)best_vertex))) {
+            best_dist_sq = dist_sq;
+            best_vertex = elem->vertex_num;
+          }
+        }
+      }
+    }
+  }
+  return best_vertex;
+}
+
+typedef struct MapDoublesData {
+  const DoublesGrid *grid;
+  const MVert *mverts;
+  const int *doubles_map;
+  int *nearest;
+  int source_start;
+  float dist;
+} MapDoublesData;
+
+static void dm_mvert_map_doubles_nearest_cb(void *__restrict userdata,
+                                            const int i,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MapDoublesData *data = userdata;
+  const int vertex_num = data->source_start + i;
+
+  /* If source has already been assigned to a target (in an earlier call, with other chunks) */
+  if (data->doubles_map[vertex_num] != -1) {
+    data->nearest[i] = -1;
+    return;
   }
+  data->nearest[i] = doubles_grid_find_nearest(
+      data->grid, data->mverts[vertex_num].co, data->dist);
 }
 
 /**
@@ -161,112 +288,64 @@ static void dm_mvert_map_doubles(int *doubles_map,
                                  const int source_num_verts,
                                  const float dist)
 {
-  const float dist3 = ((float)M_SQRT3 + 0.00005f) * dist; /* Just above sqrt(3) */
-  int i_source, i_target, i_target_low_bound, target_end, source_end;
-  SortVertsElem *sorted_verts_target, *sorted_verts_source;
-  SortVertsElem *sve_source, *sve_target, *sve_target_low_bound;
-  bool target_scan_completed;
-
-  target_end = target_start + target_num_verts;
-  source_end = source_start + source_num_verts;
-
-  /* build array of MVerts to be tested for merging */
-  sorted_verts_target = MEM_malloc_arrayN(target_num_verts, sizeof(SortVertsElem), __func__);
-  sorted_verts_source = MEM_malloc_arrayN(source_num_verts, sizeof(SortVertsElem), __func__);
-
-  /* Copy target vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_target, mverts + target_start, target_start, target_end);
-
-  /* Copy source vertices index and cos into SortVertsElem array */
-  svert_from_mvert(sorted_verts_source, mverts + source_start, source_start, source_end);
-
-  /* sort arrays according to sum of vertex coordinates (sumco) */
-  qsort(sorted_verts_target, target_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
-  qsort(sorted_verts_source, source_num_verts, sizeof(SortVertsElem), svert_sum_cmp);
-
-  sve_target_low_bound = sorted_verts_target;
-  i_target_low_bound = 0;
-  target_scan_completed = false;
-
-  /* Scan source vertices, in SortVertsElem sorted array, */
-  /* all the while maintaining the lower bound of possible doubles in target vertices */
-  for (i_source = 0, sve_source = sorted_verts_source; i_source < source_num_verts;
-       i_source++, sve_source++) {
-    int best_target_vertex = -1;
-    float best_dist_sq = dist * dist;
-    float sve_source_sumco;
-
-    /* If source has already been assigned to a target (in an earlier call, with other chunks) */
-    if (doubles_map[sve_source->vertex_num] != -1) {
+  DoublesGrid grid;
+  int *nearest;
+  int i_source;
+
+  if (target_num_verts == 0 || source_num_verts == 0) {
+    return;
+  }
+
+  doubles_grid_build(&grid, mverts, target_start, target_num_verts, dist);
+  nearest = MEM_malloc_arrayN(source_num_verts, sizeof(*nearest), __func__);
+
+  /* Search the closest target of each source vertex in parallel,
+   * only reading coordinates and mappings of earlier calls. */
+  MapDoublesData data = {
+      .grid = &grid,
+      .mverts = mverts,
+      .doubles_map = doubles_map,
+      .nearest = nearest,
+      .source_start = source_start,
+      .dist = dist,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, source_num_verts, &data, dm_mvert_map_doubles_nearest_cb, &settings);
+
+  /* Then follow existing mappings in order, since those may involve the source vertices too. */
+  for (i_source = 0; i_source < source_num_verts; i_source++) {
+    const int vertex_num = source_start + i_source;
+    int best_target_vertex = nearest[i_source];
+
+    if (doubles_map[vertex_num] != -1) {
       continue;
     }
 
-    /* If target fully scanned already, then all remaining source vertices cannot have a double */
-    if (target_scan_completed) {
-      doubles_map[sve_source->vertex_num] = -1;
-      continue;
-    }
-
-    sve_source_sumco = sum_v3(sve_source->co);
-
-    /* Skip all target vertices that are more than dist3 lower in terms of sumco */
-    /* and advance the overall lower bound, applicable to all remaining vertices as well. */
-    while ((i_target_low_bound < target_num_verts) &&
-           (sve_target_low_bound->sum_co < sve_source_sumco - dist3)) {
-      i_target_low_bound++;
-      sve_target_low_bound++;
-    }
-    /* If end of target list reached, then no more possible doubles */
-    if (i_target_low_bound >= target_num_verts) {
-      doubles_map[sve_source->vertex_num] = -1;
-      target_scan_completed = true;
-      continue;
-    }
-    /* Test target candidates starting at the low bound of possible doubles,
-     * ordered in terms of sumco. */
-    i_target = i_target_low_bound;
-    sve_target = sve_target_low_bound;
-
-    /* i_target will scan vertices in the
-     * [v_source_sumco - dist3;  v_source_sumco + dist3] range */
-
-    while ((i_target < target_num_verts) && (sve_target->sum_co <= sve_source_sumco + dist3)) {
-      /* Testing distance for candidate double in target */
-      /* v_target is within dist3 of v_source in terms of sumco;  check real distance */
-      float dist_sq;
-      if ((dist_sq = len_squared_v3v3(sve_source->co, sve_target->co)) <= best_dist_sq) {
-        /* Potential double found */
-        best_dist_sq = dist_sq;
-        best_target_vertex = sve_target->vertex_num;
-
-        /* If target is already mapped, we only follow that mapping if final target remains
-         * close enough from current vert (otherwise no mapping at all).
-         * Note that if we later find another target closer than this one, then we check it.
-         * But if other potential targets are farther,
-         * then there will be no mapping at all for this source. */
-        while (best_target_vertex != -1 &&
-               !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
-          if (compare_len_v3v3(mverts[sve_source->vertex_num].co,
-                               mverts[doubles_map[best_target_vertex]].co,
-                               dist)) {
-            best_target_vertex = doubles_map[best_target_vertex];
-          }
-          else {
-            best_target_vertex = -1;
-          }
-        }
+    /* If target is already mapped, we only follow that mapping if final target remains
+     * close enough from current vert (otherwise no mapping at all). */
+    while (best_target_vertex != -1 &&
+           !ELEM(doubles_map[best_target_vertex], -1, best_target_vertex)) {
+      if (compare_len_v3v3(
+              mverts[vertex_num].co, mverts[doubles_map[best_target_vertex]].co, dist)) {
+        best_target_vertex = doubles_map[best_target_vertex];
+      }
+      else {
+        best_target_vertex = -1;
       }
-      i_target++;
-      sve_target++;
     }
-    /* End of candidate scan: if none found then no doubles */
-    doubles_map[sve_source->vertex_num] = best_target_vertex;
+    doubles_map[vertex_num] = best_target_vertex;
   }
 
-  MEM_freeN(sorted_verts_source);
-  MEM_freeN(sorted_verts_target);
+  MEM_freeN(nearest);
+  doubles_grid_free(&grid);
 }
 
+#undef DOUBLES_GRID_CELLS_MAX
+
+/** \} */
+
 static void mesh_merge_transform(Mesh *result,
                                  Mesh *cap_mesh,
                                  const float cap_offset[4][4],
@@ -349,17 +428,105 @@ static void mesh_merge_transform(Mesh *result,
   }
 }
 
+typedef struct ArrayChunkData {
+  const Mesh *mesh;
+  Mesh *result;
+  /** Cumulative offset of each copy. */
+  const float (*chunk_offsets)[4][4];
+  /** UV layers of the result, only set when they have to be offset. */
+  MLoopUV **mloopuv_layers;
+  int mloopuv_layers_len;
+  const float *uv_offset;
+  bool use_recalc_normals;
+} ArrayChunkData;
+
+/**
+ * Copy the source mesh into array copy \a c, applying its offset.
+ * Every copy writes its own range of the preallocated result arrays.
+ */
+static void array_chunk_copy_cb(void *__restrict userdata,
+                                const int c,
+                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const ArrayChunkData *data = userdata;
+  const Mesh *mesh = data->mesh;
+  Mesh *result = data->result;
+  const int chunk_nverts = mesh->totvert;
+  const int chunk_nedges = mesh->totedge;
+  const int chunk_nloops = mesh->totloop;
+  const int chunk_npolys = mesh->totpoly;
+  const float(*current_offset)[4] = data->chunk_offsets[c];
+  MVert *mv;
+  MEdge *me;
+  MLoop *ml;
+  MPoly *mp;
+  int i;
+
+  /* copy customdata to new geometry */
+  CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
+  CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
+  CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
+  CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
+
+  /* apply offset to all new verts */
+  mv = result->mvert + c * chunk_nverts;
+  for (i = 0; i < chunk_nverts; i++, mv++) {
+    mul_m4_v3(current_offset, mv->co);
+
+    /* We have to correct normals too, if we do not tag them as dirty! */
+    if (!data->use_recalc_normals) {
+      float no[3];
+      normal_short_to_float_v3(no, mv->no);
+      mul_mat3_m4_v3(current_offset, no);
+      normalize_v3(no);
+      normal_float_to_short_v3(mv->no, no);
+    }
+  }
+
+  /* adjust edge vertex indices */
+  me = result->medge + c * chunk_nedges;
+  for (i = 0; i < chunk_nedges; i++, me++) {
+    me->v1 += c * chunk_nverts;
+    me->v2 += c * chunk_nverts;
+  }
+
+  mp = result->mpoly + c * chunk_npolys;
+  for (i = 0; i < chunk_npolys; i++, mp++) {
+    mp->loopstart += c * chunk_nloops;
+  }
+
+  /* adjust loop vertex and edge indices */
+  ml = result->mloop + c * chunk_nloops;
+  for (i = 0; i < chunk_nloops; i++, ml++) {
+    ml->v += c * chunk_nverts;
+    ml->e += c * chunk_nedges;
+  }
+
+  /* handle UVs */
+  if (data->mloopuv_layers_len != 0) {
+    const float uv_offset[2] = {
+        data->uv_offset[0] * (float)c,
+        data->uv_offset[1] * (float)c,
+    };
+    for (i = 0; i < data->mloopuv_layers_len; i++) {
+      MLoopUV *dmloopuv = data->mloopuv_layers[i] + c * chunk_nloops;
+      int l_index = chunk_nloops;
+      for (; l_index-- != 0; dmloopuv++) {
+        dmloopuv->uv[0] += uv_offset[0];
+        dmloopuv->uv[1] += uv_offset[1];
+      }
+    }
+  }
+}
+
 static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
                                    const ModifierEvalContext *ctx,
                                    Mesh *mesh)
 {
   const float eps = 1e-6f;
   const MVert *src_mvert;
-  MVert *mv, *mv_prev, *result_dm_verts;
+  MVert *result_dm_verts;
 
-  MEdge *me;
-  MLoop *ml;
-  MPoly *mp;
   int i, j, c, count;
   float length = amd->length;
   /* offset matrix */
@@ -368,6 +535,7 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   bool offset_has_scale;
   float current_offset[4][4];
   float final_offset[4][4];
+  float(*chunk_offsets)[4][4];
   int *full_doubles_map = NULL;
   int tot_doubles;
 
@@ -533,113 +701,87 @@ static Mesh *arrayModifier_doArray(ArrayModifierData *amd,
   first_chunk_start = 0;
   first_chunk_nverts = chunk_nverts;
 
-  unit_m4(current_offset);
+  /* Cumulative offsets of all copies, computed up-front so copies can be made in parallel. */
+  chunk_offsets = MEM_malloc_arrayN(count, sizeof(*chunk_offsets), "mod array offsets");
+  unit_m4(chunk_offsets[0]);
   for (c = 1; c < count; c++) {
-    /* copy customdata to new geometry */
-    CustomData_copy_data(&mesh->vdata, &result->vdata, 0, c * chunk_nverts, chunk_nverts);
-    CustomData_copy_data(&mesh->edata, &result->edata, 0, c * chunk_nedges, chunk_nedges);
-    CustomData_copy_data(&mesh->ldata, &result->ldata, 0, c * chunk_nloops, chunk_nloops);
-    CustomData_copy_data(&mesh->pdata, &result->pdata, 0, c * chunk_npolys, chunk_npolys);
-
-    mv_prev = result_dm_verts;
-    mv = mv_prev + c * chunk_nverts;
-
-    /* recalculate cumulative offset here */
-    mul_m4_m4m4(current_offset, current_offset, offset);
-
-    /* apply offset to all new verts */
-    for (i = 0; i < chunk_nverts; i++, mv++, mv_prev++) {
-      mul_m4_v3(current_offset, mv->co);
-
-      /* We have to correct normals too, if we do not tag them as dirty! */
-      if (!use_recalc_normals) {
-        float no[3];
-        normal_short_to_float_v3(no, mv->no);
-        mul_mat3_m4_v3(current_offset, no);
-        normalize_v3(no);
-        normal_float_to_short_v3(mv->no, no);
+    mul_m4_m4m4(chunk_offsets[c], chunk_offsets[c - 1], offset);
+  }
+  copy_m4_m4(current_offset, chunk_offsets[count - 1]);
+
+  if (count > 1) {
+    ArrayChunkData data = {
+        .mesh = mesh,
+        .result = result,
+        .chunk_offsets = (const float(*)[4][4])chunk_offsets,
+        .uv_offset = amd->uv_offset,
+        .use_recalc_normals = use_recalc_normals,
+    };
+
+    /* handle UVs */
+    if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
+      data.mloopuv_layers_len = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
+      data.mloopuv_layers = MEM_malloc_arrayN(
+          data.mloopuv_layers_len, sizeof(*data.mloopuv_layers), __func__);
+      for (i = 0; i < data.mloopuv_layers_len; i++) {
+        data.mloopuv_layers[i] = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
       }
     }
 
-    /* adjust edge vertex indices */
-    me = result->medge + c * chunk_nedges;
-    for (i = 0; i < chunk_nedges; i++, me++) {
-      me->v1 += c * chunk_nverts;
-      me->v2 += c * chunk_nverts;
-    }
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 1;
+    settings.use_threading = ((size_t)(count - 1) * (size_t)(chunk_nverts + chunk_nloops) >
+                              10000);
+    BLI_task_parallel_range(1, count, &data, array_chunk_copy_cb, &settings);
 
-    mp = result->mpoly + c * chunk_npolys;
-    for (i = 0; i < chunk_npolys; i++, mp++) {
-      mp->loopstart += c * chunk_nloops;
-    }
-
-    /* adjust loop vertex and edge indices */
-    ml = result->mloop + c * chunk_nloops;
-    for (i = 0; i < chunk_nloops; i++, ml++) {
-      ml->v += c * chunk_nverts;
-      ml->e += c * chunk_nedges;
+    if (data.mloopuv_layers) {
+      MEM_freeN(data.mloopuv_layers);
     }
+  }
 
-    /* Handle merge between chunk n and n-1 */
-    if (use_merge && (c >= 1)) {
-      if (!offset_has_scale && (c >= 2)) {
-        /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
-         * ... that is except if scaling makes the distance grow */
-        int k;
-        int this_chunk_index = c * chunk_nverts;
-        int prev_chunk_index = (c - 1) * chunk_nverts;
-        for (k = 0; k < chunk_nverts; k++, this_chunk_index++, prev_chunk_index++) {
-          int target = full_doubles_map[prev_chunk_index];
-          if (target != -1) {
-            target += chunk_nverts; /* translate mapping */
-            while (target != -1 && !ELEM(full_doubles_map[target], -1, target)) {
-              /* If target is already mapped, we only follow that mapping if final target remains
-               * close enough from current vert (otherwise no mapping at all). */
-              if (compare_len_v3v3(result_dm_verts[this_chunk_index].co,
-                                   result_dm_verts[full_doubles_map[target]].co,
-                                   amd->merge_dist)) {
-                target = full_doubles_map[target];
-              }
-              else {
-                target = -1;
-              }
+  /* Handle merge between chunk n and n-1,
+   * in order since mappings of a chunk are followed by the next one. */
+  for (c = 1; use_merge && c < count; c++) {
+    if (!offset_has_scale && (c >= 2)) {
+      /* Mapping chunk 3 to chunk 2 is a translation of mapping 2 to 1
+       * ... that is except if scaling makes the distance grow */
+      int k;
+      int this_chunk_index = c * chunk_nverts;
+      int prev_chunk_index = (c - 1) * chunk_nverts;
+      for (k = 0; k < chunk_nverts; k++, this_chunk_index++, prev_chunk_index++) {
+        int target = full_doubles_map[prev_chunk_index];
+        if (target != -1) {
+          target += chunk_nverts; /* translate mapping */
+          while (target != -1 && !ELEM(full_doubles_map[target], -1, target)) {
+            /* If target is already mapped, we only follow that mapping if final target remains
+             * close enough from current vert (otherwise no mapping at all). */
+            if (compare_len_v3v3(result_dm_verts[this_chunk_index].co,
+                                 result_dm_verts[full_doubles_map[target]].co,
+                                 amd->merge_dist)) {
+              target = full_doubles_map[target];
+            }
+            else {
+              target = -1;
             }
           }
-          full_doubles_map[this_chunk_index] = target;
         }
-      }
-      else {
-        dm_mvert_map_doubles(full_doubles_map,
-                             result_dm_verts,
-                             (c - 1) * chunk_nverts,
-                             chunk_nverts,
-                             c * chunk_nverts,
-                             chunk_nverts,
-                             amd->merge_dist);
+        full_doubles_map[this_chunk_index] = target;
       }
     }
-  }
-
-  /* handle UVs */
-  if (chunk_nloops > 0 && is_zero_v2(amd->uv_offset) == false) {
-    const int totuv = CustomData_number_of_layers(&result->ldata, CD_MLOOPUV);
-    for (i = 0; i < totuv; i++) {
-      MLoopUV *dmloopuv = CustomData_get_layer_n(&result->ldata, CD_MLOOPUV, i);
-      dmloopuv += chunk_nloops;
-      for (c = 1; c < count; c++) {
-        const float uv_offset[2] = {
-            amd->uv_offset[0] * (float)c,
-            amd->uv_offset[1] * (float)c,
-        };
-        int l_index = chunk_nloops;
-        for (; l_index-- != 0; dmloopuv++) {
-          dmloopuv->uv[0] += uv_offset[0];
-          dmloopuv->uv[1] += uv_offset[1];
-        }
-      }
+    else {
+      dm_mvert_map_doubles(full_doubles_map,
+                           result_dm_verts,
+                           (c - 1) * chunk_nverts,
+                           chunk_nverts,
+                           c * chunk_nverts,
+                           chunk_nverts,
+                           amd->merge_dist);
     }
   }
 
+  MEM_freeN(chunk_offsets);
+
   last_chunk_start = (count - 1) * chunk_nverts;
   last_chunk_nverts = chunk_nverts;
 
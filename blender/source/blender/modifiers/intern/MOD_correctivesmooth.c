@@ -40,6 +40,7 @@
 #include "BKE_library.h"
 
 #include "MOD_modifiertypes.h"
+#include "MOD_smooth_util.h"
 #include "MOD_util.h"
 
 #include "BLI_strict_flags.h"
@@ -96,10 +97,17 @@ static void freeBind(CorrectiveSmoothModifierData *csmd)
   csmd->bind_coords_num = 0;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  MOD_smooth_adjacency_free(runtime_data);
+}
+
 static void freeData(ModifierData *md)
 {
   CorrectiveSmoothModifierData *csmd = (CorrectiveSmoothModifierData *)md;
   freeBind(csmd);
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
 }
 
 static void requiredDataMask(Object *UNUSED(ob),
@@ -169,180 +177,11 @@ static void mesh_get_boundaries(Mesh *mesh, float *smooth_weights)
 }
 
 /* -------------------------------------------------------------------- */
-/* Simple Weighted Smoothing
+/* Smoothing
  *
- * (average of surrounding verts)
+ * 'Simple' moves towards the average of surrounding verts,
+ * 'Length Weight' weights the average by edge length, see: MOD_smooth_util.c
  */
-static void smooth_iter__simple(CorrectiveSmoothModifierData *csmd,
-                                Mesh *mesh,
-                                float (*vertexCos)[3],
-                                uint numVerts,
-                                const float *smooth_weights,
-                                uint iterations)
-{
-  const float lambda = csmd->lambda;
-  uint i;
-
-  const uint numEdges = (uint)mesh->totedge;
-  const MEdge *edges = mesh->medge;
-  float *vertex_edge_count_div;
-
-  struct SmoothingData_Simple {
-    float delta[3];
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  vertex_edge_count_div = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count_div[edges[i].v1] += 1.0f;
-    vertex_edge_count_div[edges[i].v2] += 1.0f;
-  }
-
-  /* a little confusing, but we can include 'lambda' and smoothing weight
-   * here to avoid multiplying for every iteration */
-  if (smooth_weights == NULL) {
-    for (i = 0; i < numVerts; i++) {
-      vertex_edge_count_div[i] = lambda * (vertex_edge_count_div[i] ?
-                                               (1.0f / vertex_edge_count_div[i]) :
-                                               1.0f);
-    }
-  }
-  else {
-    for (i = 0; i < numVerts; i++) {
-      vertex_edge_count_div[i] = smooth_weights[i] * lambda *
-                                 (vertex_edge_count_div[i] ? (1.0f / vertex_edge_count_div[i]) :
-                                                             1.0f);
-    }
-  }
-
-  /* -------------------------------------------------------------------- */
-  /* Main Smoothing Loop */
-
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Simple *sd_v1;
-      struct SmoothingData_Simple *sd_v2;
-      float edge_dir[3];
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-    }
-
-    for (i = 0; i < numVerts; i++) {
-      struct SmoothingData_Simple *sd = &smooth_data[i];
-      madd_v3_v3fl(vertexCos[i], sd->delta, vertex_edge_count_div[i]);
-      /* zero for the next iteration (saves memset on entire array) */
-      memset(sd, 0, sizeof(*sd));
-    }
-  }
-
-  MEM_freeN(vertex_edge_count_div);
-  MEM_freeN(smooth_data);
-}
-
-/* -------------------------------------------------------------------- */
-/* Edge-Length Weighted Smoothing
- */
-static void smooth_iter__length_weight(CorrectiveSmoothModifierData *csmd,
-                                       Mesh *mesh,
-                                       float (*vertexCos)[3],
-                                       uint numVerts,
-                                       const float *smooth_weights,
-                                       uint iterations)
-{
-  const float eps = FLT_EPSILON * 10.0f;
-  const uint numEdges = (uint)mesh->totedge;
-  /* note: the way this smoothing method works, its approx half as strong as the simple-smooth,
-   * and 2.0 rarely spikes, double the value for consistent behavior. */
-  const float lambda = csmd->lambda * 2.0f;
-  const MEdge *edges = mesh->medge;
-  float *vertex_edge_count;
-  uint i;
-
-  struct SmoothingData_Weighted {
-    float delta[3];
-    float edge_length_sum;
-  } *smooth_data = MEM_calloc_arrayN(numVerts, sizeof(*smooth_data), __func__);
-
-  /* calculate as floats to avoid int->float conversion in #smooth_iter */
-  vertex_edge_count = MEM_calloc_arrayN(numVerts, sizeof(float), __func__);
-  for (i = 0; i < numEdges; i++) {
-    vertex_edge_count[edges[i].v1] += 1.0f;
-    vertex_edge_count[edges[i].v2] += 1.0f;
-  }
-
-  /* -------------------------------------------------------------------- */
-  /* Main Smoothing Loop */
-
-  while (iterations--) {
-    for (i = 0; i < numEdges; i++) {
-      struct SmoothingData_Weighted *sd_v1;
-      struct SmoothingData_Weighted *sd_v2;
-      float edge_dir[3];
-      float edge_dist;
-
-      sub_v3_v3v3(edge_dir, vertexCos[edges[i].v2], vertexCos[edges[i].v1]);
-      edge_dist = len_v3(edge_dir);
-
-      /* weight by distance */
-      mul_v3_fl(edge_dir, edge_dist);
-
-      sd_v1 = &smooth_data[edges[i].v1];
-      sd_v2 = &smooth_data[edges[i].v2];
-
-      add_v3_v3(sd_v1->delta, edge_dir);
-      sub_v3_v3(sd_v2->delta, edge_dir);
-
-      sd_v1->edge_length_sum += edge_dist;
-      sd_v2->edge_length_sum += edge_dist;
-    }
-
-    if (smooth_weights == NULL) {
-      /* fast-path */
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
-         * (mean average). */
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-#if 0
-          /* first calculate the new location */
-          mul_v3_fl(sd->delta, 1.0f / div);
-          /* then interpolate */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda);
-#else
-          /* do this in one step */
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda / div);
-#endif
-        }
-        /* zero for the next iteration (saves memset on entire array) */
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-    else {
-      for (i = 0; i < numVerts; i++) {
-        struct SmoothingData_Weighted *sd = &smooth_data[i];
-        const float div = sd->edge_length_sum * vertex_edge_count[i];
-        if (div > eps) {
-          const float lambda_w = lambda * smooth_weights[i];
-          madd_v3_v3fl(vertexCos[i], sd->delta, lambda_w / div);
-        }
-
-        memset(sd, 0, sizeof(*sd));
-      }
-    }
-  }
-
-  MEM_freeN(vertex_edge_count);
-  MEM_freeN(smooth_data);
-}
-
 static void smooth_iter(CorrectiveSmoothModifierData *csmd,
                         Mesh *mesh,
                         float (*vertexCos)[3],
@@ -350,16 +189,29 @@ static void smooth_iter(CorrectiveSmoothModifierData *csmd,
                         const float *smooth_weights,
                         uint iterations)
 {
+  /* The adjacency is cached on the modifier and only rebuilt when the topology changes. */
+  SmoothAdjacency *adj = MOD_smooth_adjacency_ensure(
+      &csmd->modifier, mesh->medge, mesh->totedge, (int)numVerts);
+  SmoothParams params = {0};
+
+  params.weights = smooth_weights;
+
   switch (csmd->smooth_type) {
     case MOD_CORRECTIVESMOOTH_SMOOTH_LENGTH_WEIGHT:
-      smooth_iter__length_weight(csmd, mesh, vertexCos, numVerts, smooth_weights, iterations);
+      params.kernel = MOD_SMOOTH_KERNEL_LENGTH_WEIGHT;
+      /* note: the way this smoothing method works, its approx half as strong as the
+       * simple-smooth, and 2.0 rarely spikes, double the value for consistent behavior. */
+      params.lambda = csmd->lambda * 2.0f;
       break;
 
     /* case MOD_CORRECTIVESMOOTH_SMOOTH_SIMPLE: */
     default:
-      smooth_iter__simple(csmd, mesh, vertexCos, numVerts, smooth_weights, iterations);
+      params.kernel = MOD_SMOOTH_KERNEL_SIMPLE;
+      params.lambda = csmd->lambda;
       break;
   }
+
+  MOD_smooth_iterate(adj, &params, vertexCos, (int)iterations);
 }
 
 static void smooth_verts(CorrectiveSmoothModifierData *csmd,
@@ -787,5 +639,5 @@ ModifierTypeInfo modifierType_CorrectiveSmooth = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
 };
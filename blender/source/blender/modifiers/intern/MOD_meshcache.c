@@ -59,6 +59,17 @@ static void initData(ModifierData *md)
   mcmd->up_axis = 2;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  MOD_meshcache_file_release(runtime_data);
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 static bool dependsOnTime(ModifierData *md)
 {
   MeshCacheModifierData *mcmd = (MeshCacheModifierData *)md;
@@ -142,18 +153,21 @@ static void meshcache_do(MeshCacheModifierData *mcmd,
   /* -------------------------------------------------------------------- */
   /* Read the File (or error out when the file is bad) */
 
-  /* would be nice if we could avoid doing this _every_ frame */
   BLI_strncpy(filepath, mcmd->filepath, sizeof(filepath));
   BLI_path_abs(filepath, ID_BLEND_PATH_FROM_GLOBAL((ID *)ob));
 
-  switch (mcmd->type) {
+  /* The file stays mapped between evaluations (and is shared with other modifiers). */
+  MeshCacheFile *mcf = MOD_meshcache_file_ensure(
+      (MeshCacheFile **)&mcmd->modifier.runtime, filepath, &err_str);
+
+  switch (mcf ? mcmd->type : -1) {
     case MOD_MESHCACHE_TYPE_MDD:
       ok = MOD_meshcache_read_mdd_times(
-          filepath, vertexCos, numVerts, mcmd->interp, time, fps, mcmd->time_mode, &err_str);
+          mcf, vertexCos, numVerts, mcmd->interp, time, fps, mcmd->time_mode, &err_str);
       break;
     case MOD_MESHCACHE_TYPE_PC2:
       ok = MOD_meshcache_read_pc2_times(
-          filepath, vertexCos, numVerts, mcmd->interp, time, fps, mcmd->time_mode, &err_str);
+          mcf, vertexCos, numVerts, mcmd->interp, time, fps, mcmd->time_mode, &err_str);
       break;
     default:
       ok = false;
@@ -305,7 +319,7 @@ ModifierTypeInfo modifierType_MeshCache = {
 
     /* initData */ initData,
     /* requiredDataMask */ NULL,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ NULL,
     /* dependsOnTime */ dependsOnTime,
@@ -313,5 +327,5 @@ ModifierTypeInfo modifierType_MeshCache = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
 };
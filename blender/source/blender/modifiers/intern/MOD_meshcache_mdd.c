@@ -18,39 +18,42 @@
  * \ingroup modifiers
  */
 
-#include <stdio.h>
 #include <string.h>
-#include <errno.h>
 
 #include "BLI_utildefines.h"
 
-#include "BLI_fileops.h"
 #include "BLI_math.h"
 #ifdef __LITTLE_ENDIAN__
 #  include "BLI_endian_switch.h"
 #endif
-#ifdef WIN32
-#  include "BLI_winstuff.h"
-#endif
 
 #include "DNA_modifier_types.h"
 
 #include "MOD_meshcache_util.h" /* own include */
 
+/* MDD files are big endian. */
+#ifdef __LITTLE_ENDIAN__
+#  define MDD_USE_ENDIAN_SWITCH true
+#else
+#  define MDD_USE_ENDIAN_SWITCH false
+#endif
+
 typedef struct MDDHead {
   int frame_tot;
   int verts_tot;
 } MDDHead; /* frames, verts */
 
-static bool meshcache_read_mdd_head(FILE *fp,
+static bool meshcache_read_mdd_head(const MeshCacheFile *mcf,
                                     const int verts_tot,
                                     MDDHead *mdd_head,
                                     const char **err_str)
 {
-  if (!fread(mdd_head, sizeof(*mdd_head), 1, fp)) {
+  const void *data = MOD_meshcache_file_data(mcf, 0, sizeof(*mdd_head));
+  if (data == NULL) {
     *err_str = "Missing header";
     return false;
   }
+  memcpy(mdd_head, data, sizeof(*mdd_head));
 
 #ifdef __LITTLE_ENDIAN__
   BLI_endian_switch_int32_array((int *)mdd_head, 2);
@@ -65,36 +68,11 @@ static bool meshcache_read_mdd_head(FILE *fp,
     *err_str = "Invalid frame total";
     return false;
   }
-  /* intentionally dont seek back */
-
-  return true;
-}
-
-/**
- * Gets the index frange and factor
- */
-static bool meshcache_read_mdd_range(FILE *fp,
-                                     const int verts_tot,
-                                     const float frame,
-                                     const char interp,
-                                     int r_index_range[2],
-                                     float *r_factor,
-                                     const char **err_str)
-{
-  MDDHead mdd_head;
-
-  /* first check interpolation and get the vert locations */
-
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-    return false;
-  }
-
-  MOD_meshcache_calc_range(frame, interp, mdd_head.frame_tot, r_index_range, r_factor);
 
   return true;
 }
 
-static bool meshcache_read_mdd_range_from_time(FILE *fp,
+static bool meshcache_read_mdd_range_from_time(const MeshCacheFile *mcf,
                                                const int verts_tot,
                                                const float time,
                                                const float UNUSED(fps),
@@ -106,12 +84,19 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   float f_time, f_time_prev = FLT_MAX;
   float frame;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
+  if (meshcache_read_mdd_head(mcf, verts_tot, &mdd_head, err_str) == false) {
+    return false;
+  }
+
+  const float *times = MOD_meshcache_file_data(
+      mcf, sizeof(mdd_head), sizeof(float) * (size_t)mdd_head.frame_tot);
+  if (times == NULL) {
+    *err_str = "Missing frame times";
     return false;
   }
 
   for (i = 0; i < mdd_head.frame_tot; i++) {
-    fread(&f_time, sizeof(float), 1, fp);
+    memcpy(&f_time, &times[i], sizeof(float));
 #ifdef __LITTLE_ENDIAN__
     BLI_endian_switch_float(&f_time);
 #endif
@@ -142,121 +127,47 @@ static bool meshcache_read_mdd_range_from_time(FILE *fp,
   return true;
 }
 
-bool MOD_meshcache_read_mdd_index(FILE *fp,
+bool MOD_meshcache_read_mdd_frame(MeshCacheFile *mcf,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
-                                  const int index,
-                                  const float factor,
+                                  const char interp,
+                                  const float frame,
                                   const char **err_str)
 {
   MDDHead mdd_head;
+  int index_range[2];
+  float factor;
 
-  if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
+  if (meshcache_read_mdd_head(mcf, verts_tot, &mdd_head, err_str) == false) {
     return false;
   }
 
-  if (fseek(fp, mdd_head.frame_tot * sizeof(int), SEEK_CUR) != 0) {
-    *err_str = "Header seek failed";
-    return false;
-  }
+  MOD_meshcache_calc_range(frame, interp, mdd_head.frame_tot, index_range, &factor);
 
-  if (fseek(fp, sizeof(float) * 3 * index * mdd_head.verts_tot, SEEK_CUR) != 0) {
-    *err_str = "Failed to seek frame";
-    return false;
-  }
+  /* Frames follow the header and the time of each frame. */
+  const size_t frames_offset = sizeof(mdd_head) + sizeof(float) * (size_t)mdd_head.frame_tot;
+  const size_t frame_size = sizeof(float[3]) * (size_t)mdd_head.verts_tot;
+  const bool use_interp = (index_range[0] != index_range[1]);
 
-  if (factor >= 1.0f) {
-#if 1
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      fread(vco, sizeof(float) * 3, 1, fp);
-
-#  ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(vco + 0);
-      BLI_endian_switch_float(vco + 1);
-      BLI_endian_switch_float(vco + 2);
-#  endif /* __LITTLE_ENDIAN__ */
-    }
-#else
-    /* no blending */
-    if (!fread(vertexCos, sizeof(float) * 3, mdd_head.verts_tot, f)) {
-      *err_str = errno ? strerror(errno) : "Failed to read frame";
-      return false;
-    }
-#  ifdef __LITTLE_ENDIAN__
-    BLI_endian_switch_float_array(vertexCos[0], mdd_head.verts_tot * 3);
-#  endif
-#endif
-  }
-  else {
-    const float ifactor = 1.0f - factor;
-    float *vco = *vertexCos;
-    uint i;
-    for (i = mdd_head.verts_tot; i != 0; i--, vco += 3) {
-      float tvec[3];
-      fread(tvec, sizeof(float) * 3, 1, fp);
+  const size_t offset_a = frames_offset + frame_size * (size_t)index_range[0];
+  const size_t offset_b = frames_offset + frame_size * (size_t)index_range[1];
+  const void *co_a = MOD_meshcache_file_data(mcf, offset_a, frame_size);
+  const void *co_b = use_interp ? MOD_meshcache_file_data(mcf, offset_b, frame_size) : NULL;
 
-#ifdef __LITTLE_ENDIAN__
-      BLI_endian_switch_float(tvec + 0);
-      BLI_endian_switch_float(tvec + 1);
-      BLI_endian_switch_float(tvec + 2);
-#endif
-
-      vco[0] = (vco[0] * ifactor) + (tvec[0] * factor);
-      vco[1] = (vco[1] * ifactor) + (tvec[1] * factor);
-      vco[2] = (vco[2] * ifactor) + (tvec[2] * factor);
-    }
+  if ((co_a == NULL) || (use_interp && (co_b == NULL))) {
+    *err_str = "Failed to read frame";
+    return false;
   }
 
-  return true;
-}
+  /* read both and interpolate, reading directly from the mapped file */
+  MOD_meshcache_coords_read(vertexCos, verts_tot, co_a, co_b, factor, MDD_USE_ENDIAN_SWITCH);
 
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
-                                  float (*vertexCos)[3],
-                                  const int verts_tot,
-                                  const char interp,
-                                  const float frame,
-                                  const char **err_str)
-{
-  int index_range[2];
-  float factor;
+  MOD_meshcache_file_prefetch(mcf, frames_offset, frame_size, mdd_head.frame_tot, index_range[0]);
 
-  if (meshcache_read_mdd_range(fp,
-                               verts_tot,
-                               frame,
-                               interp,
-                               index_range,
-                               &factor, /* read into these values */
-                               err_str) == false) {
-    return false;
-  }
-
-  if (index_range[0] == index_range[1]) {
-    /* read single */
-    if ((fseek(fp, 0, SEEK_SET) == 0) &&
-        MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str)) {
-      return true;
-    }
-    else {
-      return false;
-    }
-  }
-  else {
-    /* read both and interpolate */
-    if ((fseek(fp, 0, SEEK_SET) == 0) &&
-        MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[0], 1.0f, err_str) &&
-        (fseek(fp, 0, SEEK_SET) == 0) &&
-        MOD_meshcache_read_mdd_index(fp, vertexCos, verts_tot, index_range[1], factor, err_str)) {
-      return true;
-    }
-    else {
-      return false;
-    }
-  }
+  return true;
 }
 
-bool MOD_meshcache_read_mdd_times(const char *filepath,
+bool MOD_meshcache_read_mdd_times(MeshCacheFile *mcf,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -267,14 +178,6 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
 {
   float frame;
 
-  FILE *fp = BLI_fopen(filepath, "rb");
-  bool ok;
-
-  if (fp == NULL) {
-    *err_str = errno ? strerror(errno) : "Unknown error opening file";
-    return false;
-  }
-
   switch (time_mode) {
     case MOD_MESHCACHE_TIME_FRAME: {
       frame = time;
@@ -282,29 +185,23 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
     }
     case MOD_MESHCACHE_TIME_SECONDS: {
       /* we need to find the closest time */
-      if (meshcache_read_mdd_range_from_time(fp, verts_tot, time, fps, &frame, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_range_from_time(mcf, verts_tot, time, fps, &frame, err_str) ==
+          false) {
         return false;
       }
-      rewind(fp);
       break;
     }
     case MOD_MESHCACHE_TIME_FACTOR:
     default: {
       MDDHead mdd_head;
-      if (meshcache_read_mdd_head(fp, verts_tot, &mdd_head, err_str) == false) {
-        fclose(fp);
+      if (meshcache_read_mdd_head(mcf, verts_tot, &mdd_head, err_str) == false) {
         return false;
       }
 
       frame = CLAMPIS(time, 0.0f, 1.0f) * (float)mdd_head.frame_tot;
-      rewind(fp);
       break;
     }
   }
 
-  ok = MOD_meshcache_read_mdd_frame(fp, vertexCos, verts_tot, interp, frame, err_str);
-
-  fclose(fp);
-  return ok;
+  return MOD_meshcache_read_mdd_frame(mcf, vertexCos, verts_tot, interp, frame, err_str);
 }
@@ -18,14 +18,39 @@
  * \ingroup modifiers
  */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#ifdef WIN32
+#  include <io.h>
+#  include "mmap_win.h"
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 
+#include "BLI_endian_switch.h"
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "DNA_modifier_types.h"
 
 #include "MOD_meshcache_util.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 void MOD_meshcache_calc_range(const float frame,
                               const char interp,
                               const int frame_tot,
@@ -62,3 +87,388 @@ void MOD_meshcache_calc_range(const float frame,
     }
   }
 }
+
+/* -------------------------------------------------------------------- */
+/** \name Mapped Cache Files
+ *
+ * Cache files are memory mapped once and shared between all modifiers reading them,
+ * each modifier keeps a user in its runtime data, see #MOD_meshcache_file_ensure.
+ * Frames are read directly from the mapping, while a background task touches
+ * the frames ahead in the playback direction so they're paged in before they're needed.
+ * \{ */
+
+/* Number of frames read ahead, limited by #MESHCACHE_PREFETCH_SIZE_MAX. */
+#define MESHCACHE_PREFETCH_FRAMES 16
+#define MESHCACHE_PREFETCH_SIZE_MAX (256 << 20)
+/* Touch one byte per page when prefetching. */
+#define MESHCACHE_PREFETCH_STRIDE 4096
+/* Check the file is unchanged on disk after touching this many bytes. */
+#define MESHCACHE_PREFETCH_CHECK_SIZE (1 << 20)
+
+struct MeshCacheFile {
+  struct MeshCacheFile *next, *prev;
+
+  char filepath[FILE_MAX];
+  /* Used to detect the file being written to, while mapped. */
+  size_t size;
+  int64_t mtime;
+
+  int file;
+  const unsigned char *data;
+  int users;
+  /* The file changed on disk, no longer in #g_meshcache_files, freed by the last user. */
+  bool is_stale;
+
+  /* Prefetching (protected by #g_meshcache_files.mutex). */
+  TaskPool *prefetch_pool;
+  int prefetch_index_last;
+  /* Frames already requested: [start, end). */
+  int prefetch_range[2];
+};
+
+typedef struct MeshCachePrefetchTask {
+  size_t offset;
+  size_t size;
+} MeshCachePrefetchTask;
+
+static struct {
+  ListBase files;
+  ThreadMutex mutex;
+} g_meshcache_files = {{NULL, NULL}, BLI_MUTEX_INITIALIZER};
+
+static MeshCacheFile *meshcache_file_open(const char *filepath,
+                                          const BLI_stat_t *st,
+                                          const char **err_str)
+{
+  const int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+  if (file == -1) {
+    *err_str = errno ? strerror(errno) : "Unknown error opening file";
+    return NULL;
+  }
+
+  const size_t size = (size_t)st->st_size;
+  const unsigned char *data = NULL;
+  if (size != 0) {
+    data = mmap(NULL, size, PROT_READ, MAP_SHARED, file, 0);
+    if (data == (const unsigned char *)-1) {
+      *err_str = errno ? strerror(errno) : "Failed to map file";
+      close(file);
+      return NULL;
+    }
+  }
+
+  MeshCacheFile *mcf = MEM_callocN(sizeof(*mcf), __func__);
+  BLI_strncpy(mcf->filepath, filepath, sizeof(mcf->filepath));
+  mcf->size = size;
+  mcf->mtime = (int64_t)st->st_mtime;
+  mcf->file = file;
+  mcf->data = data;
+  mcf->prefetch_index_last = -1;
+  return mcf;
+}
+
+static void meshcache_file_close(MeshCacheFile *mcf)
+{
+  /* Prefetch tasks read from the mapping, finish them first. */
+  if (mcf->prefetch_pool) {
+    BLI_task_pool_cancel(mcf->prefetch_pool);
+    BLI_task_pool_free(mcf->prefetch_pool);
+  }
+  if (mcf->data) {
+    munmap((void *)mcf->data, mcf->size);
+  }
+  close(mcf->file);
+  MEM_freeN(mcf);
+}
+
+static void meshcache_file_release_locked(MeshCacheFile *mcf)
+{
+  BLI_assert(mcf->users > 0);
+  if (--mcf->users == 0) {
+    if (!mcf->is_stale) {
+      BLI_remlink(&g_meshcache_files.files, mcf);
+    }
+    meshcache_file_close(mcf);
+  }
+}
+
+/**
+ * Ensure \a mcf_p holds a user of the mapped \a filepath, re-using an existing mapping
+ * (possibly opened by another modifier) as long as the file is unchanged on disk.
+ *
+ * \return The mapped file or NULL on failure, with \a err_str set.
+ */
+MeshCacheFile *MOD_meshcache_file_ensure(MeshCacheFile **mcf_p,
+                                         const char *filepath,
+                                         const char **err_str)
+{
+  MeshCacheFile *mcf = *mcf_p;
+  BLI_stat_t st;
+
+  if (BLI_stat(filepath, &st) == -1) {
+    *err_str = errno ? strerror(errno) : "Unknown error opening file";
+    MOD_meshcache_file_release(mcf);
+    *mcf_p = NULL;
+    return NULL;
+  }
+
+  if (mcf && STREQ(mcf->filepath, filepath) && (mcf->size == (size_t)st.st_size) &&
+      (mcf->mtime == (int64_t)st.st_mtime)) {
+    return mcf;
+  }
+
+  BLI_mutex_lock(&g_meshcache_files.mutex);
+
+  if (mcf) {
+    meshcache_file_release_locked(mcf);
+    mcf = NULL;
+  }
+
+  LISTBASE_FOREACH_MUTABLE (MeshCacheFile *, mcf_iter, &g_meshcache_files.files) {
+    if (STREQ(mcf_iter->filepath, filepath)) {
+      if ((mcf_iter->size == (size_t)st.st_size) && (mcf_iter->mtime == (int64_t)st.st_mtime)) {
+        mcf = mcf_iter;
+      }
+      else {
+        /* Written to since it was mapped, keep it for its current users only. */
+        BLI_remlink(&g_meshcache_files.files, mcf_iter);
+        mcf_iter->is_stale = true;
+      }
+    }
+  }
+
+  if (mcf == NULL) {
+    mcf = meshcache_file_open(filepath, &st, err_str);
+    if (mcf) {
+      BLI_addtail(&g_meshcache_files.files, mcf);
+    }
+  }
+  if (mcf) {
+    mcf->users++;
+  }
+
+  BLI_mutex_unlock(&g_meshcache_files.mutex);
+
+  *mcf_p = mcf;
+  return mcf;
+}
+
+void MOD_meshcache_file_release(MeshCacheFile *mcf)
+{
+  if (mcf == NULL) {
+    return;
+  }
+  BLI_mutex_lock(&g_meshcache_files.mutex);
+  meshcache_file_release_locked(mcf);
+  BLI_mutex_unlock(&g_meshcache_files.mutex);
+}
+
+/**
+ * Reading the mapping beyond the end of a file truncated since it was mapped raises SIGBUS,
+ * so the file is checked to be unchanged before reading.
+ */
+static bool meshcache_file_is_unchanged(const MeshCacheFile *mcf)
+{
+  BLI_stat_t st;
+  if (BLI_fstat(mcf->file, &st) == -1) {
+    return false;
+  }
+  return (mcf->size == (size_t)st.st_size) && (mcf->mtime == (int64_t)st.st_mtime);
+}
+
+/**
+ * \return The mapped memory from \a offset when \a size bytes are available, otherwise NULL.
+ * NULL is returned as well when the file changed on disk,
+ * the next #MOD_meshcache_file_ensure maps it again.
+ */
+const void *MOD_meshcache_file_data(const MeshCacheFile *mcf, size_t offset, size_t size)
+{
+  if ((offset > mcf->size) || (size > mcf->size - offset)) {
+    return NULL;
+  }
+  if (!meshcache_file_is_unchanged(mcf)) {
+    return NULL;
+  }
+  return mcf->data + offset;
+}
+
+static void meshcache_prefetch_task(TaskPool *__restrict pool,
+                                    void *taskdata,
+                                    int UNUSED(threadid))
+{
+  const MeshCacheFile *mcf = BLI_task_pool_userdata(pool);
+  const MeshCachePrefetchTask *task = taskdata;
+  const volatile unsigned char *data = mcf->data + task->offset;
+
+  for (size_t i = 0; i < task->size; i += MESHCACHE_PREFETCH_STRIDE) {
+    if (BLI_task_pool_canceled(pool)) {
+      break;
+    }
+    if (((i % MESHCACHE_PREFETCH_CHECK_SIZE) == 0) && !meshcache_file_is_unchanged(mcf)) {
+      break;
+    }
+    /* Only reading causes the page to be loaded. */
+    (void)data[i];
+  }
+}
+
+/**
+ * Read ahead of frame \a index in the direction of playback (from previous calls),
+ * so following frames are already in memory.
+ *
+ * \param frames_offset: Offset of the first frame in the file.
+ * \param frame_size: Size of each frame in bytes.
+ */
+void MOD_meshcache_file_prefetch(MeshCacheFile *mcf,
+                                 const size_t frames_offset,
+                                 const size_t frame_size,
+                                 const int frame_tot,
+                                 const int index)
+{
+  const int frames_num = max_ii(
+      (int)min_zz(MESHCACHE_PREFETCH_SIZE_MAX / max_zz(frame_size, 1), MESHCACHE_PREFETCH_FRAMES),
+      1);
+
+  BLI_mutex_lock(&g_meshcache_files.mutex);
+
+  const int index_last = mcf->prefetch_index_last;
+  mcf->prefetch_index_last = index;
+
+  if ((index_last == -1) || (index_last == index)) {
+    /* The first read or a redraw, the direction is unknown. */
+    BLI_mutex_unlock(&g_meshcache_files.mutex);
+    return;
+  }
+
+  int range[2];
+  if (index > index_last) {
+    range[0] = index + 1;
+    range[1] = min_ii(index + 1 + frames_num, frame_tot);
+  }
+  else {
+    range[0] = max_ii(index - frames_num, 0);
+    range[1] = index;
+  }
+
+  /* Frames requested by previous calls don't need to be requested again,
+   * when playing this is only the single frame at the end of the range. */
+  int range_new[2] = {range[0], range[1]};
+  const int *range_prev = mcf->prefetch_range;
+  if ((range_prev[0] <= range_new[0]) && (range_prev[1] > range_new[0])) {
+    range_new[0] = range_prev[1];
+  }
+  if ((range_prev[1] >= range_new[1]) && (range_prev[0] < range_new[1])) {
+    range_new[1] = range_prev[0];
+  }
+  copy_v2_v2_int(mcf->prefetch_range, range);
+
+  if (range_new[0] < range_new[1]) {
+    MeshCachePrefetchTask *task = MEM_mallocN(sizeof(*task), __func__);
+    task->offset = frames_offset + (size_t)range_new[0] * frame_size;
+    task->size = (size_t)(range_new[1] - range_new[0]) * frame_size;
+
+    if (MOD_meshcache_file_data(mcf, task->offset, task->size)) {
+      if (mcf->prefetch_pool == NULL) {
+        mcf->prefetch_pool = BLI_task_pool_create_background(BLI_task_scheduler_get(), mcf);
+      }
+      BLI_task_pool_push(
+          mcf->prefetch_pool, meshcache_prefetch_task, task, true, TASK_PRIORITY_LOW);
+    }
+    else {
+      MEM_freeN(task);
+    }
+  }
+
+  BLI_mutex_unlock(&g_meshcache_files.mutex);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reading Coordinates
+ * \{ */
+
+/**
+ * Copy \a verts_tot coordinates from the file data in \a co_a,
+ * or interpolate between \a co_a and \a co_b by \a factor when \a co_b is given.
+ *
+ * \param use_endian_switch: The file byte order differs from ours.
+ * \note The file data doesn't need to be aligned.
+ */
+void MOD_meshcache_coords_read(float (*vertexCos)[3],
+                               const int verts_tot,
+                               const void *co_a,
+                               const void *co_b,
+                               const float factor,
+                               const bool use_endian_switch)
+{
+  const int values_tot = verts_tot * 3;
+  const float ifactor = 1.0f - factor;
+  float *vco = vertexCos[0];
+  int i = 0;
+
+  if (co_b && (factor >= 1.0f)) {
+    co_a = co_b;
+    co_b = NULL;
+  }
+
+  if ((co_b == NULL) && (use_endian_switch == false)) {
+    memcpy(vco, co_a, sizeof(float) * (size_t)values_tot);
+    return;
+  }
+
+#ifdef __SSE2__
+  {
+    const __m128 ifactor_v = _mm_set1_ps(ifactor);
+    const __m128 factor_v = _mm_set1_ps(factor);
+    const __m128i mask_byte_1 = _mm_set1_epi32(0x0000ff00);
+    const __m128i mask_byte_2 = _mm_set1_epi32(0x00ff0000);
+
+#  define ENDIAN_SWITCH_V4(v) \
+    _mm_or_si128(_mm_or_si128(_mm_slli_epi32(v, 24), _mm_srli_epi32(v, 24)), \
+                 _mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 8), mask_byte_2), \
+                              _mm_and_si128(_mm_srli_epi32(v, 8), mask_byte_1)))
+
+    for (; i + 4 <= values_tot; i += 4) {
+      __m128i a = _mm_loadu_si128((const __m128i *)((const float *)co_a + i));
+      if (use_endian_switch) {
+        a = ENDIAN_SWITCH_V4(a);
+      }
+      if (co_b) {
+        __m128i b = _mm_loadu_si128((const __m128i *)((const float *)co_b + i));
+        if (use_endian_switch) {
+          b = ENDIAN_SWITCH_V4(b);
+        }
+        _mm_storeu_ps(vco + i,
+                      _mm_add_ps(_mm_mul_ps(_mm_castsi128_ps(a), ifactor_v),
+                                 _mm_mul_ps(_mm_castsi128_ps(b), factor_v)));
+      }
+      else {
+        _mm_storeu_si128((__m128i *)(vco + i), a);
+      }
+    }
+
+#  undef ENDIAN_SWITCH_V4
+  }
+#endif /* __SSE2__ */
+
+  for (; i < values_tot; i++) {
+    float a, b;
+    memcpy(&a, (const float *)co_a + i, sizeof(float));
+    if (use_endian_switch) {
+      BLI_endian_switch_float(&a);
+    }
+    if (co_b) {
+      memcpy(&b, (const float *)co_b + i, sizeof(float));
+      if (use_endian_switch) {
+        BLI_endian_switch_float(&b);
+      }
+      vco[i] = (a * ifactor) + (b * factor);
+    }
+    else {
+      vco[i] = a;
+    }
+  }
+}
+
+/** \} */
@@ -21,20 +21,16 @@
 #ifndef __MOD_MESHCACHE_UTIL_H__
 #define __MOD_MESHCACHE_UTIL_H__
 
+typedef struct MeshCacheFile MeshCacheFile;
+
 /* MOD_meshcache_mdd.c */
-bool MOD_meshcache_read_mdd_index(FILE *fp,
-                                  float (*vertexCos)[3],
-                                  const int vertex_tot,
-                                  const int index,
-                                  const float factor,
-                                  const char **err_str);
-bool MOD_meshcache_read_mdd_frame(FILE *fp,
+bool MOD_meshcache_read_mdd_frame(MeshCacheFile *mcf,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str);
-bool MOD_meshcache_read_mdd_times(const char *filepath,
+bool MOD_meshcache_read_mdd_times(MeshCacheFile *mcf,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -44,19 +40,13 @@ bool MOD_meshcache_read_mdd_times(const char *filepath,
                                   const char **err_str);
 
 /* MOD_meshcache_pc2.c */
-bool MOD_meshcache_read_pc2_index(FILE *fp,
-                                  float (*vertexCos)[3],
-                                  const int verts_tot,
-                                  const int index,
-                                  const float factor,
-                                  const char **err_str);
-bool MOD_meshcache_read_pc2_frame(FILE *fp,
+bool MOD_meshcache_read_pc2_frame(MeshCacheFile *mcf,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
                                   const float frame,
                                   const char **err_str);
-bool MOD_meshcache_read_pc2_times(const char *filepath,
+bool MOD_meshcache_read_pc2_times(MeshCacheFile *mcf,
                                   float (*vertexCos)[3],
                                   const int verts_tot,
                                   const char interp,
@@ -72,6 +62,24 @@ void MOD_meshcache_calc_range(const float frame,
                               int r_index_range[2],
                               float *r_factor);
 
+MeshCacheFile *MOD_meshcache_file_ensure(MeshCacheFile **mcf_p,
+                                         const char *filepath,
+                                         const char **err_str);
+void MOD_meshcache_file_release(MeshCacheFile *mcf);
+const void *MOD_meshcache_file_data(const MeshCacheFile *mcf, size_t offset, size_t size);
+void MOD_meshcache_file_prefetch(MeshCacheFile *mcf,
+                                 const size_t frames_offset,
+                                 const size_t frame_size,
+                                 const int frame_tot,
+                                 const int index);
+
+void MOD_meshcache_coords_read(float (*vertexCos)[3],
+                               const int verts_tot,
+                               const void *co_a,
+                               const void *co_b,
+                               const float factor,
+                               const bool use_endian_switch);
+
 #define FRAME_SNAP_EPS 0.0001f
 
 #endif /* __MOD_MESHCACHE_UTIL_H__ */
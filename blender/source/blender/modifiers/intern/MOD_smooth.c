@@ -37,6 +37,7 @@
 #include "BKE_deform.h"
 
 #include "MOD_modifiertypes.h"
+#include "MOD_smooth_util.h"
 #include "MOD_util.h"
 
 static void initData(ModifierData *md)
@@ -65,6 +66,17 @@ static bool isDisabled(const struct Scene *UNUSED(scene),
   return false;
 }
 
+static void freeRuntimeData(void *runtime_data)
+{
+  MOD_smooth_adjacency_free(runtime_data);
+}
+
+static void freeData(ModifierData *md)
+{
+  freeRuntimeData(md->runtime);
+  md->runtime = NULL;
+}
+
 static void requiredDataMask(Object *UNUSED(ob),
                              ModifierData *md,
                              CustomData_MeshMasks *r_cddata_masks)
@@ -84,101 +96,35 @@ static void smoothModifier_do(
     return;
   }
 
-  float(*accumulated_vecs)[3] = MEM_calloc_arrayN(
-      (size_t)numVerts, sizeof(*accumulated_vecs), __func__);
-  if (!accumulated_vecs) {
-    return;
-  }
-
-  uint *num_accumulated_vecs = MEM_calloc_arrayN(
-      (size_t)numVerts, sizeof(*num_accumulated_vecs), __func__);
-  if (!num_accumulated_vecs) {
-    if (accumulated_vecs) {
-      MEM_freeN(accumulated_vecs);
-    }
-    return;
-  }
-
-  const float fac_new = smd->fac;
-  const float fac_orig = 1.0f - fac_new;
-
-  MEdge *medges = mesh->medge;
-  const int num_edges = mesh->totedge;
+  /* The adjacency is cached on the modifier and only rebuilt when the topology changes. */
+  SmoothAdjacency *adj = MOD_smooth_adjacency_ensure(
+      &smd->modifier, mesh->medge, mesh->totedge, numVerts);
 
   MDeformVert *dvert;
   int defgrp_index;
   MOD_get_vgroup(ob, mesh, smd->defgrp_name, &dvert, &defgrp_index);
 
-  for (int j = 0; j < smd->repeat; j++) {
-    if (j != 0) {
-      memset(accumulated_vecs, 0, sizeof(*accumulated_vecs) * (size_t)numVerts);
-      memset(num_accumulated_vecs, 0, sizeof(*num_accumulated_vecs) * (size_t)numVerts);
-    }
-
-    for (int i = 0; i < num_edges; i++) {
-      float fvec[3];
-      const uint idx1 = medges[i].v1;
-      const uint idx2 = medges[i].v2;
-
-      mid_v3_v3v3(fvec, vertexCos[idx1], vertexCos[idx2]);
-
-      num_accumulated_vecs[idx1]++;
-      add_v3_v3(accumulated_vecs[idx1], fvec);
-
-      num_accumulated_vecs[idx2]++;
-      add_v3_v3(accumulated_vecs[idx2], fvec);
-    }
-
-    const short flag = smd->flag;
-    if (dvert) {
-      MDeformVert *dv = dvert;
-      for (int i = 0; i < numVerts; i++, dv++) {
-        float *vco_orig = vertexCos[i];
-        if (num_accumulated_vecs[0] > 0) {
-          mul_v3_fl(accumulated_vecs[i], 1.0f / (float)num_accumulated_vecs[i]);
-        }
-        float *vco_new = accumulated_vecs[i];
-
-        const float f_new = defvert_find_weight(dv, defgrp_index) * fac_new;
-        if (f_new <= 0.0f) {
-          continue;
-        }
-        const float f_orig = 1.0f - f_new;
-
-        if (flag & MOD_SMOOTH_X) {
-          vco_orig[0] = f_orig * vco_orig[0] + f_new * vco_new[0];
-        }
-        if (flag & MOD_SMOOTH_Y) {
-          vco_orig[1] = f_orig * vco_orig[1] + f_new * vco_new[1];
-        }
-        if (flag & MOD_SMOOTH_Z) {
-          vco_orig[2] = f_orig * vco_orig[2] + f_new * vco_new[2];
-        }
-      }
-    }
-    else { /* no vertex group */
-      for (int i = 0; i < numVerts; i++) {
-        float *vco_orig = vertexCos[i];
-        if (num_accumulated_vecs[0] > 0) {
-          mul_v3_fl(accumulated_vecs[i], 1.0f / (float)num_accumulated_vecs[i]);
-        }
-        float *vco_new = accumulated_vecs[i];
-
-        if (flag & MOD_SMOOTH_X) {
-          vco_orig[0] = fac_orig * vco_orig[0] + fac_new * vco_new[0];
-        }
-        if (flag & MOD_SMOOTH_Y) {
-          vco_orig[1] = fac_orig * vco_orig[1] + fac_new * vco_new[1];
-        }
-        if (flag & MOD_SMOOTH_Z) {
-          vco_orig[2] = fac_orig * vco_orig[2] + fac_new * vco_new[2];
-        }
-      }
+  float *weights = NULL;
+  if (dvert) {
+    weights = MEM_malloc_arrayN((size_t)numVerts, sizeof(*weights), __func__);
+    for (int i = 0; i < numVerts; i++) {
+      weights[i] = defvert_find_weight(&dvert[i], defgrp_index);
     }
   }
 
-  MEM_freeN(accumulated_vecs);
-  MEM_freeN(num_accumulated_vecs);
+  const SmoothParams params = {
+      .kernel = MOD_SMOOTH_KERNEL_MIDPOINT,
+      .lambda = smd->fac,
+      .weights = weights,
+      .use_axis = {(smd->flag & MOD_SMOOTH_X) != 0,
+                   (smd->flag & MOD_SMOOTH_Y) != 0,
+                   (smd->flag & MOD_SMOOTH_Z) != 0},
+  };
+  MOD_smooth_iterate(adj, &params, vertexCos, smd->repeat);
+
+  if (weights) {
+    MEM_freeN(weights);
+  }
 }
 
 static void deformVerts(ModifierData *md,
@@ -238,7 +184,7 @@ ModifierTypeInfo modifierType_Smooth = {
 
     /* initData */ initData,
     /* requiredDataMask */ requiredDataMask,
-    /* freeData */ NULL,
+    /* freeData */ freeData,
     /* isDisabled */ isDisabled,
     /* updateDepsgraph */ NULL,
     /* dependsOnTime */ NULL,
@@ -246,5 +192,5 @@ ModifierTypeInfo modifierType_Smooth = {
     /* foreachObjectLink */ NULL,
     /* foreachIDLink */ NULL,
     /* foreachTexLink */ NULL,
-    /* freeRuntimeData */ NULL,
+    /* freeRuntimeData */ freeRuntimeData,
 };
@@ -0,0 +1,394 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup modifiers
+ *
+ * Iterative vertex smoothing shared by the smoothing modifiers.
+ *
+ * Instead of scattering edge contributions into both vertices of every edge
+ * (which can't be threaded), each vertex gathers from its neighbors using a
+ * cached adjacency, reading from one coordinate buffer and writing to another.
+ * Neighbors are visited in edge order, so the result is the same as the edge loop.
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+
+#include "BLI_hash_mm2a.h"
+#include "BLI_math.h"
+#include "BLI_task.h"
+
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+
+#include "MOD_smooth_util.h"
+
+#include "BLI_strict_flags.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* Vertices handled by a single task. */
+#define SMOOTH_BLOCK_SIZE 1024
+
+/* -------------------------------------------------------------------- */
+/** \name Vertex Adjacency
+ * \{ */
+
+static uint smooth_edges_hash(const MEdge *medge, const int edges_num)
+{
+  BLI_HashMurmur2A mm2;
+  BLI_hash_mm2a_init(&mm2, 0);
+  for (int i = 0; i < edges_num; i++) {
+    BLI_hash_mm2a_add_int(&mm2, (int)medge[i].v1);
+    BLI_hash_mm2a_add_int(&mm2, (int)medge[i].v2);
+  }
+  return BLI_hash_mm2a_end(&mm2);
+}
+
+static SmoothAdjacency *smooth_adjacency_create(const MEdge *medge,
+                                                const int edges_num,
+                                                const int verts_num,
+                                                const uint edges_hash)
+{
+  SmoothAdjacency *adj = MEM_mallocN(sizeof(*adj), __func__);
+  adj->verts_num = verts_num;
+  adj->edges_num = edges_num;
+  adj->edges_hash = edges_hash;
+  adj->offsets = MEM_calloc_arrayN((size_t)verts_num + 1, sizeof(*adj->offsets), __func__);
+  adj->verts = MEM_malloc_arrayN((size_t)edges_num * 2, sizeof(*adj->verts), __func__);
+
+  int *offsets = adj->offsets;
+  for (int i = 0; i < edges_num; i++) {
+    BLI_assert(medge[i].v1 < (uint)verts_num && medge[i].v2 < (uint)verts_num);
+    offsets[medge[i].v1 + 1]++;
+    offsets[medge[i].v2 + 1]++;
+  }
+  for (int i = 0; i < verts_num; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  int *fill = MEM_malloc_arrayN((size_t)verts_num, sizeof(*fill), __func__);
+  memcpy(fill, offsets, sizeof(*fill) * (size_t)verts_num);
+  for (int i = 0; i < edges_num; i++) {
+    const uint v1 = medge[i].v1, v2 = medge[i].v2;
+    adj->verts[fill[v1]++] = (int)v2;
+    adj->verts[fill[v2]++] = (int)v1;
+  }
+  MEM_freeN(fill);
+
+  return adj;
+}
+
+/**
+ * Return the adjacency for these edges, stored in the modifiers runtime data.
+ * It's only rebuilt when the topology changes, the caller must free it with
+ * #MOD_smooth_adjacency_free when the modifier is freed.
+ */
+SmoothAdjacency *MOD_smooth_adjacency_ensure(ModifierData *md,
+                                             const MEdge *medge,
+                                             const int edges_num,
+                                             const int verts_num)
+{
+  SmoothAdjacency *adj = md->runtime;
+  const uint edges_hash = smooth_edges_hash(medge, edges_num);
+
+  if (adj != NULL) {
+    if ((adj->verts_num == verts_num) && (adj->edges_num == edges_num) &&
+        (adj->edges_hash == edges_hash)) {
+      return adj;
+    }
+    MOD_smooth_adjacency_free(adj);
+  }
+
+  adj = smooth_adjacency_create(medge, edges_num, verts_num, edges_hash);
+  md->runtime = adj;
+  return adj;
+}
+
+void MOD_smooth_adjacency_free(SmoothAdjacency *adj)
+{
+  if (adj == NULL) {
+    return;
+  }
+  MEM_freeN(adj->offsets);
+  MEM_freeN(adj->verts);
+  MEM_freeN(adj);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Smoothing Kernels
+ *
+ * Coordinates are padded to 4 floats (the last one being zero),
+ * so they can be loaded into a single SIMD register.
+ * \{ */
+
+typedef struct SmoothIterData {
+  const SmoothAdjacency *adj;
+  const SmoothParams *params;
+  /** Per vertex factor, see #smooth_vert_factors_calc. */
+  const float *vert_factor;
+  const float (*co_src)[4];
+  float (*co_dst)[4];
+} SmoothIterData;
+
+static void smooth_block__simple(const SmoothIterData *data, const int start, const int end)
+{
+  const int *offsets = data->adj->offsets;
+  const int *adj_verts = data->adj->verts;
+  const float(*co_src)[4] = data->co_src;
+  float(*co_dst)[4] = data->co_dst;
+
+  for (int i = start; i < end; i++) {
+#ifdef __SSE2__
+    const __m128 co = _mm_load_ps(co_src[i]);
+    __m128 delta = _mm_setzero_ps();
+    for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+      delta = _mm_add_ps(delta, _mm_sub_ps(_mm_load_ps(co_src[adj_verts[k]]), co));
+    }
+    _mm_store_ps(co_dst[i], _mm_add_ps(co, _mm_mul_ps(delta, _mm_set1_ps(data->vert_factor[i]))));
+#else
+    float delta[3] = {0.0f, 0.0f, 0.0f};
+    for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+      float edge_dir[3];
+      sub_v3_v3v3(edge_dir, co_src[adj_verts[k]], co_src[i]);
+      add_v3_v3(delta, edge_dir);
+    }
+    madd_v3_v3v3fl(co_dst[i], co_src[i], delta, data->vert_factor[i]);
+#endif
+  }
+}
+
+static void smooth_block__length_weight(const SmoothIterData *data,
+                                        const int start,
+                                        const int end)
+{
+  const float eps = FLT_EPSILON * 10.0f;
+  const int *offsets = data->adj->offsets;
+  const int *adj_verts = data->adj->verts;
+  const float(*co_src)[4] = data->co_src;
+  float(*co_dst)[4] = data->co_dst;
+
+  for (int i = start; i < end; i++) {
+    float edge_length_sum = 0.0f;
+#ifdef __SSE2__
+    const __m128 co = _mm_load_ps(co_src[i]);
+    __m128 delta = _mm_setzero_ps();
+    for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+      const __m128 edge_dir = _mm_sub_ps(_mm_load_ps(co_src[adj_verts[k]]), co);
+      float edge_dir_sq[4];
+      _mm_storeu_ps(edge_dir_sq, _mm_mul_ps(edge_dir, edge_dir));
+      const float edge_dist = sqrtf(edge_dir_sq[0] + edge_dir_sq[1] + edge_dir_sq[2]);
+
+      /* weight by distance */
+      delta = _mm_add_ps(delta, _mm_mul_ps(edge_dir, _mm_set1_ps(edge_dist)));
+      edge_length_sum += edge_dist;
+    }
+#else
+    float delta[3] = {0.0f, 0.0f, 0.0f};
+    for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+      float edge_dir[3];
+      sub_v3_v3v3(edge_dir, co_src[adj_verts[k]], co_src[i]);
+      const float edge_dist = len_v3(edge_dir);
+
+      /* weight by distance */
+      madd_v3_v3fl(delta, edge_dir, edge_dist);
+      edge_length_sum += edge_dist;
+    }
+#endif
+
+    /* Divide by sum of all neighbor distances (weighted) and amount of neighbors,
+     * (mean average). */
+    const float div = edge_length_sum * (float)(offsets[i + 1] - offsets[i]);
+    if (div > eps) {
+#ifdef __SSE2__
+      _mm_store_ps(co_dst[i],
+                   _mm_add_ps(co, _mm_mul_ps(delta, _mm_set1_ps(data->vert_factor[i] / div))));
+#else
+      madd_v3_v3v3fl(co_dst[i], co_src[i], delta, data->vert_factor[i] / div);
+#endif
+    }
+    else {
+      copy_v4_v4(co_dst[i], co_src[i]);
+    }
+  }
+}
+
+static void smooth_block__midpoint(const SmoothIterData *data, const int start, const int end)
+{
+  const int *offsets = data->adj->offsets;
+  const int *adj_verts = data->adj->verts;
+  const bool *use_axis = data->params->use_axis;
+  const float(*co_src)[4] = data->co_src;
+  float(*co_dst)[4] = data->co_dst;
+
+#ifdef __SSE2__
+  const __m128 axis_mask = _mm_castsi128_ps(
+      _mm_set_epi32(0, use_axis[2] ? -1 : 0, use_axis[1] ? -1 : 0, use_axis[0] ? -1 : 0));
+  const __m128 half = _mm_set1_ps(0.5f);
+#endif
+
+  for (int i = start; i < end; i++) {
+    const int neighbors_num = offsets[i + 1] - offsets[i];
+    const float f_new = data->vert_factor[i];
+
+    /* Loose vertices and vertices outside the vertex group are left as they are,
+     * without a vertex group negative factors are used. */
+    if ((neighbors_num == 0) || (data->params->weights && (f_new <= 0.0f))) {
+      copy_v4_v4(co_dst[i], co_src[i]);
+      continue;
+    }
+    const float f_orig = 1.0f - f_new;
+
+#ifdef __SSE2__
+    const __m128 co = _mm_load_ps(co_src[i]);
+    __m128 co_new = _mm_setzero_ps();
+    for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+      co_new = _mm_add_ps(co_new,
+                          _mm_mul_ps(half, _mm_add_ps(co, _mm_load_ps(co_src[adj_verts[k]]))));
+    }
+    co_new = _mm_mul_ps(co_new, _mm_set1_ps(1.0f / (float)neighbors_num));
+
+    const __m128 co_blend = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(f_orig), co),
+                                       _mm_mul_ps(_mm_set1_ps(f_new), co_new));
+    _mm_store_ps(co_dst[i],
+                 _mm_or_ps(_mm_and_ps(axis_mask, co_blend), _mm_andnot_ps(axis_mask, co)));
+#else
+    float co_new[3] = {0.0f, 0.0f, 0.0f};
+    for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+      float mid[3];
+      mid_v3_v3v3(mid, co_src[i], co_src[adj_verts[k]]);
+      add_v3_v3(co_new, mid);
+    }
+    mul_v3_fl(co_new, 1.0f / (float)neighbors_num);
+
+    for (int axis = 0; axis < 4; axis++) {
+      co_dst[i][axis] = (axis < 3 && use_axis[axis]) ?
+                            f_orig * co_src[i][axis] + f_new * co_new[axis] :
+                            co_src[i][axis];
+    }
+#endif
+  }
+}
+
+static void smooth_iter_block_cb(void *__restrict userdata,
+                                 const int block,
+                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const SmoothIterData *data = userdata;
+  const int start = block * SMOOTH_BLOCK_SIZE;
+  const int end = min_ii(start + SMOOTH_BLOCK_SIZE, data->adj->verts_num);
+
+  switch (data->params->kernel) {
+    case MOD_SMOOTH_KERNEL_LENGTH_WEIGHT:
+      smooth_block__length_weight(data, start, end);
+      break;
+    case MOD_SMOOTH_KERNEL_MIDPOINT:
+      smooth_block__midpoint(data, start, end);
+      break;
+    /* case MOD_SMOOTH_KERNEL_SIMPLE: */
+    default:
+      smooth_block__simple(data, start, end);
+      break;
+  }
+}
+
+/**
+ * Fold the constant part of each kernel into a single value per vertex,
+ * to avoid calculating it for every iteration.
+ */
+static void smooth_vert_factors_calc(const SmoothAdjacency *adj,
+                                     const SmoothParams *params,
+                                     float *r_vert_factor)
+{
+  const float *weights = params->weights;
+
+  for (int i = 0; i < adj->verts_num; i++) {
+    r_vert_factor[i] = weights ? weights[i] * params->lambda : params->lambda;
+
+    if (params->kernel == MOD_SMOOTH_KERNEL_SIMPLE) {
+      const float neighbors_num = (float)(adj->offsets[i + 1] - adj->offsets[i]);
+      r_vert_factor[i] *= neighbors_num ? (1.0f / neighbors_num) : 1.0f;
+    }
+  }
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Smoothing Iterations
+ * \{ */
+
+/**
+ * Smooth \a vertexCos in place, running \a iterations passes of the kernel in \a params.
+ */
+void MOD_smooth_iterate(const SmoothAdjacency *adj,
+                        const SmoothParams *params,
+                        float (*vertexCos)[3],
+                        int iterations)
+{
+  const int verts_num = adj->verts_num;
+  if ((iterations <= 0) || (verts_num == 0)) {
+    return;
+  }
+
+  float *vert_factor = MEM_malloc_arrayN((size_t)verts_num, sizeof(*vert_factor), __func__);
+  smooth_vert_factors_calc(adj, params, vert_factor);
+
+  /* Double buffered, each iteration reads from one and writes into the other. */
+  float(*co_src)[4] = MEM_mallocN_aligned(sizeof(*co_src) * (size_t)verts_num, 16, __func__);
+  float(*co_dst)[4] = MEM_mallocN_aligned(sizeof(*co_dst) * (size_t)verts_num, 16, __func__);
+  for (int i = 0; i < verts_num; i++) {
+    copy_v3_v3(co_src[i], vertexCos[i]);
+    co_src[i][3] = co_dst[i][3] = 0.0f;
+  }
+
+  SmoothIterData data = {
+      .adj = adj,
+      .params = params,
+      .vert_factor = vert_factor,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (verts_num > 10000);
+
+  const int blocks_num = (verts_num + SMOOTH_BLOCK_SIZE - 1) / SMOOTH_BLOCK_SIZE;
+  while (iterations--) {
+    data.co_src = (const float(*)[4])co_src;
+    data.co_dst = co_dst;
+    BLI_task_parallel_range(0, blocks_num, &data, smooth_iter_block_cb, &settings);
+
+    float(*co_swap)[4] = co_src;
+    co_src = co_dst;
+    co_dst = co_swap;
+  }
+
+  for (int i = 0; i < verts_num; i++) {
+    copy_v3_v3(vertexCos[i], co_src[i]);
+  }
+
+  MEM_freeN(co_src);
+  MEM_freeN(co_dst);
+  MEM_freeN(vert_factor);
+}
+
+/** \} */
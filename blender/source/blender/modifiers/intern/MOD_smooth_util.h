@@ -0,0 +1,75 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup modifiers
+ *
+ * Iterative vertex smoothing shared by the smoothing modifiers.
+ */
+
+#ifndef __MOD_SMOOTH_UTIL_H__
+#define __MOD_SMOOTH_UTIL_H__
+
+struct MEdge;
+struct ModifierData;
+
+/**
+ * Vertex adjacency in compressed sparse row layout, built from the edges.
+ *
+ * The neighbors of vertex `i` are `verts[offsets[i]]` up to (not including)
+ * `verts[offsets[i + 1]]`, in the order of the edges using the vertex
+ * (duplicate edges are kept, so results match an edge loop exactly).
+ */
+typedef struct SmoothAdjacency {
+  int verts_num;
+  int edges_num;
+  /** Hash of the edge vertex indices, to detect topology changes. */
+  unsigned int edges_hash;
+
+  int *offsets;
+  int *verts;
+} SmoothAdjacency;
+
+enum {
+  /** Move towards the average of the neighbors (corrective smooth 'Simple'). */
+  MOD_SMOOTH_KERNEL_SIMPLE = 0,
+  /** Average weighted by edge length (corrective smooth 'Length Weight'). */
+  MOD_SMOOTH_KERNEL_LENGTH_WEIGHT = 1,
+  /** Blend with the average of the edge mid-points, per axis (smooth modifier). */
+  MOD_SMOOTH_KERNEL_MIDPOINT = 2,
+};
+
+typedef struct SmoothParams {
+  int kernel;
+  float lambda;
+  /** Optional per vertex influence (vertex group), may be NULL. */
+  const float *weights;
+  /** Axes to smooth, only used by #MOD_SMOOTH_KERNEL_MIDPOINT. */
+  bool use_axis[3];
+} SmoothParams;
+
+SmoothAdjacency *MOD_smooth_adjacency_ensure(struct ModifierData *md,
+                                             const struct MEdge *medge,
+                                             const int edges_num,
+                                             const int verts_num);
+void MOD_smooth_adjacency_free(SmoothAdjacency *adj);
+
+void MOD_smooth_iterate(const SmoothAdjacency *adj,
+                        const SmoothParams *params,
+                        float (*vertexCos)[3],
+                        int iterations);
+
+#endif /* __MOD_SMOOTH_UTIL_H__ */
@@ -123,6 +123,8 @@
 
 #include "DEG_depsgraph.h"
 
+#include "COM_compositor.h"
+
 #include "WM_api.h"
 #include "WM_types.h"
 #include "WM_message.h"
@@ -555,6 +557,11 @@ static void wm_file_read_post(bContext *C,
   if (use_data) {
     WM_operatortype_last_properties_clear_all();
 
+#ifdef WITH_COMPOSITOR
+    /* Cached buffers are keyed by settings of the previous file. */
+    COM_clearCaches();
+#endif
+
     /* After load post, so for example the driver namespace can be filled
      * before evaluating the depsgraph. */
     wm_event_do_depsgraph(C, true);
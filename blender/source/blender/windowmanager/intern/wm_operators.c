@@ -59,6 +59,7 @@
 #include "BLI_utildefines.h"
 
 #include "BKE_brush.h"
+#include "BKE_bvhutils.h"
 #include "BKE_colortools.h"
 #include "BKE_context.h"
 #include "BKE_global.h"
@@ -69,6 +70,7 @@
 #include "BKE_library_query.h"
 #include "BKE_main.h"
 #include "BKE_material.h"
+#include "BKE_mesh.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h" /* BKE_ST_MAXNAME */
@@ -78,6 +80,8 @@
 
 #include "BLF_api.h"
 
+#include "DRW_engine.h"
+
 #include "GPU_immediate.h"
 #include "GPU_immediate_util.h"
 #include "GPU_matrix.h"
@@ -3182,6 +3186,9 @@ static void WM_OT_redraw_timer(wmOperatorType *ot)
 static int memory_statistics_exec(bContext *UNUSED(C), wmOperator *UNUSED(op))
 {
   MEM_printmemlist_stats();
+  BKE_bvhcache_shared_stats_print();
+  BKE_mesh_normals_topology_stats_print();
+  DRW_mesh_batch_cache_stats_print();
   return OPERATOR_FINISHED;
 }
 
@@ -0,0 +1,259 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+#include "DNA_sequence_types.h"
+#include "MEM_guardedalloc.h"
+#include "PIL_time.h"
+
+#include "intern/seqeffects_kernels.h"
+}
+
+/* Throughput of the effect kernels on a 4K frame, scalar against SSE2 versions. */
+
+#define NUM_RUN_AVERAGED 5
+
+#define IMAGE_X 3840
+#define IMAGE_Y 2160
+#define IMAGE_LEN (IMAGE_X * IMAGE_Y * 4)
+
+typedef void (*EffectByteFn)(float facf0,
+                             float facf1,
+                             int x,
+                             int y,
+                             unsigned char *rect1,
+                             unsigned char *rect2,
+                             unsigned char *out);
+typedef void (*EffectFloatFn)(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+
+typedef struct EffectBuffers {
+  unsigned char *rect1_byte, *rect2_byte, *out_byte;
+  float *rect1_float, *rect2_float, *out_float;
+} EffectBuffers;
+
+static void effect_buffers_init(EffectBuffers *buffers)
+{
+  buffers->rect1_byte = (unsigned char *)MEM_mallocN(IMAGE_LEN, __func__);
+  buffers->rect2_byte = (unsigned char *)MEM_mallocN(IMAGE_LEN, __func__);
+  buffers->out_byte = (unsigned char *)MEM_mallocN(IMAGE_LEN, __func__);
+  buffers->rect1_float = (float *)MEM_mallocN(sizeof(float) * IMAGE_LEN, __func__);
+  buffers->rect2_float = (float *)MEM_mallocN(sizeof(float) * IMAGE_LEN, __func__);
+  buffers->out_float = (float *)MEM_mallocN(sizeof(float) * IMAGE_LEN, __func__);
+
+  RNG *rng = BLI_rng_new(1234);
+  for (int i = 0; i < IMAGE_LEN; i += 4) {
+    for (int j = 0; j < 4; j++) {
+      buffers->rect1_byte[i + j] = (unsigned char)(BLI_rng_get_uint(rng) & 0xff);
+      buffers->rect2_byte[i + j] = (unsigned char)(BLI_rng_get_uint(rng) & 0xff);
+    }
+    const float alpha1 = BLI_rng_get_float(rng), alpha2 = BLI_rng_get_float(rng);
+    for (int j = 0; j < 3; j++) {
+      buffers->rect1_float[i + j] = BLI_rng_get_float(rng) * alpha1;
+      buffers->rect2_float[i + j] = BLI_rng_get_float(rng) * alpha2;
+    }
+    buffers->rect1_float[i + 3] = alpha1;
+    buffers->rect2_float[i + 3] = alpha2;
+  }
+  BLI_rng_free(rng);
+}
+
+static void effect_buffers_free(EffectBuffers *buffers)
+{
+  MEM_freeN(buffers->rect1_byte);
+  MEM_freeN(buffers->rect2_byte);
+  MEM_freeN(buffers->out_byte);
+  MEM_freeN(buffers->rect1_float);
+  MEM_freeN(buffers->rect2_float);
+  MEM_freeN(buffers->out_float);
+}
+
+static void print_timing(const char *id, const double time)
+{
+  printf("%-14s: %8.2f ms, %7.1f Mpixel/s\n",
+         id,
+         time * 1000.0,
+         (double)(IMAGE_X * IMAGE_Y) / time / 1e6);
+}
+
+static double effect_byte_time(EffectBuffers *buffers, EffectByteFn effect)
+{
+  double time = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    const double time_start = PIL_check_seconds_timer();
+    effect(0.4f,
+           0.6f,
+           IMAGE_X,
+           IMAGE_Y,
+           buffers->rect1_byte,
+           buffers->rect2_byte,
+           buffers->out_byte);
+    time += PIL_check_seconds_timer() - time_start;
+  }
+  return time / NUM_RUN_AVERAGED;
+}
+
+static double effect_float_time(EffectBuffers *buffers, EffectFloatFn effect)
+{
+  double time = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    const double time_start = PIL_check_seconds_timer();
+    effect(0.4f,
+           0.6f,
+           IMAGE_X,
+           IMAGE_Y,
+           buffers->rect1_float,
+           buffers->rect2_float,
+           buffers->out_float);
+    time += PIL_check_seconds_timer() - time_start;
+  }
+  return time / NUM_RUN_AVERAGED;
+}
+
+static void effect_byte_performance(const char *id,
+                                    EffectByteFn effect_scalar,
+                                    EffectByteFn effect_sse2)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  EffectBuffers buffers;
+  effect_buffers_init(&buffers);
+
+  print_timing("scalar", effect_byte_time(&buffers, effect_scalar));
+#ifdef __SSE2__
+  print_timing("SSE2", effect_byte_time(&buffers, effect_sse2));
+#else
+  UNUSED_VARS(effect_sse2);
+#endif
+
+  effect_buffers_free(&buffers);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+static void effect_float_performance(const char *id,
+                                     EffectFloatFn effect_scalar,
+                                     EffectFloatFn effect_sse2)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  EffectBuffers buffers;
+  effect_buffers_init(&buffers);
+
+  print_timing("scalar", effect_float_time(&buffers, effect_scalar));
+#ifdef __SSE2__
+  print_timing("SSE2", effect_float_time(&buffers, effect_sse2));
+#else
+  UNUSED_VARS(effect_sse2);
+#endif
+
+  effect_buffers_free(&buffers);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+#ifdef __SSE2__
+#  define EFFECT_SSE2(name) name##_sse2
+#else
+#  define EFFECT_SSE2(name) NULL
+#endif
+
+TEST(sequencer_effects, AlphaOverByte_4K)
+{
+  effect_byte_performance("AlphaOverByte_4K",
+                          seq_effect_alphaover_byte_scalar,
+                          EFFECT_SSE2(seq_effect_alphaover_byte));
+}
+TEST(sequencer_effects, AlphaOverFloat_4K)
+{
+  effect_float_performance("AlphaOverFloat_4K",
+                           seq_effect_alphaover_float_scalar,
+                           EFFECT_SSE2(seq_effect_alphaover_float));
+}
+TEST(sequencer_effects, CrossByte_4K)
+{
+  effect_byte_performance(
+      "CrossByte_4K", seq_effect_cross_byte_scalar, EFFECT_SSE2(seq_effect_cross_byte));
+}
+TEST(sequencer_effects, CrossFloat_4K)
+{
+  effect_float_performance(
+      "CrossFloat_4K", seq_effect_cross_float_scalar, EFFECT_SSE2(seq_effect_cross_float));
+}
+TEST(sequencer_effects, AddByte_4K)
+{
+  effect_byte_performance(
+      "AddByte_4K", seq_effect_add_byte_scalar, EFFECT_SSE2(seq_effect_add_byte));
+}
+TEST(sequencer_effects, AddFloat_4K)
+{
+  effect_float_performance(
+      "AddFloat_4K", seq_effect_add_float_scalar, EFFECT_SSE2(seq_effect_add_float));
+}
+TEST(sequencer_effects, MulByte_4K)
+{
+  effect_byte_performance(
+      "MulByte_4K", seq_effect_mul_byte_scalar, EFFECT_SSE2(seq_effect_mul_byte));
+}
+TEST(sequencer_effects, MulFloat_4K)
+{
+  effect_float_performance(
+      "MulFloat_4K", seq_effect_mul_float_scalar, EFFECT_SSE2(seq_effect_mul_float));
+}
+
+static void effect_blend_float_performance(const char *id, const int btype)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  EffectBuffers buffers;
+  effect_buffers_init(&buffers);
+
+  double time = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    const double time_start = PIL_check_seconds_timer();
+    seq_effect_blend_float_scalar(0.4f,
+                                  0.6f,
+                                  IMAGE_X,
+                                  IMAGE_Y,
+                                  buffers.rect1_float,
+                                  buffers.rect2_float,
+                                  btype,
+                                  buffers.out_float);
+    time += PIL_check_seconds_timer() - time_start;
+  }
+  print_timing("scalar", time / NUM_RUN_AVERAGED);
+
+#ifdef __SSE2__
+  time = 0.0;
+  for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+    const double time_start = PIL_check_seconds_timer();
+    seq_effect_blend_float_sse2(0.4f,
+                                0.6f,
+                                IMAGE_X,
+                                IMAGE_Y,
+                                buffers.rect1_float,
+                                buffers.rect2_float,
+                                btype,
+                                buffers.out_float);
+    time += PIL_check_seconds_timer() - time_start;
+  }
+  print_timing("SSE2", time / NUM_RUN_AVERAGED);
+#endif
+
+  effect_buffers_free(&buffers);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(sequencer_effects, BlendScreenFloat_4K)
+{
+  effect_blend_float_performance("BlendScreenFloat_4K", SEQ_TYPE_SCREEN);
+}
+TEST(sequencer_effects, BlendLightenFloat_4K)
+{
+  effect_blend_float_performance("BlendLightenFloat_4K", SEQ_TYPE_LIGHTEN);
+}
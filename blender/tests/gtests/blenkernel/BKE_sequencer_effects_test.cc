@@ -0,0 +1,223 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string.h>
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+#include "DNA_sequence_types.h"
+#include "MEM_guardedalloc.h"
+
+#include "intern/seqeffects_kernels.h"
+}
+
+#ifdef __SSE2__
+
+/* Checks the SSE2 kernels give the same bits as the scalar ones on 4K frames. */
+
+#define IMAGE_X 3840
+#define IMAGE_Y 2160
+#define IMAGE_LEN (IMAGE_X * IMAGE_Y * 4)
+
+typedef void (*EffectByteFn)(float facf0,
+                             float facf1,
+                             int x,
+                             int y,
+                             unsigned char *rect1,
+                             unsigned char *rect2,
+                             unsigned char *out);
+typedef void (*EffectFloatFn)(
+    float facf0, float facf1, int x, int y, float *rect1, float *rect2, float *out);
+
+/* Field factors, including the extremes and out of range values from animation curves. */
+static const float effect_factors[][2] = {
+    {0.0f, 0.0f},
+    {0.35f, 0.7f},
+    {1.0f, 1.0f},
+    {-0.25f, 1.5f},
+};
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+/* Random straight alpha colors, with many fully transparent and opaque pixels. */
+static void rng_rect_byte(RNG *rng, unsigned char *rect)
+{
+  for (int i = 0; i < IMAGE_LEN; i += 4) {
+    for (int j = 0; j < 4; j++) {
+      rect[i + j] = (unsigned char)(BLI_rng_get_uint(rng) & 0xff);
+    }
+    switch (BLI_rng_get_uint(rng) % 4) {
+      case 0:
+        rect[i + 3] = 0;
+        break;
+      case 1:
+        rect[i + 3] = 255;
+        break;
+    }
+  }
+}
+
+/* Random premultiplied colors, including over-exposed and negative values. */
+static void rng_rect_float(RNG *rng, float *rect)
+{
+  for (int i = 0; i < IMAGE_LEN; i += 4) {
+    float alpha;
+    switch (BLI_rng_get_uint(rng) % 4) {
+      case 0:
+        alpha = 0.0f;
+        break;
+      case 1:
+        alpha = 1.0f;
+        break;
+      default:
+        alpha = BLI_rng_get_float(rng);
+        break;
+    }
+    for (int j = 0; j < 3; j++) {
+      rect[i + j] = (BLI_rng_get_float(rng) * 1.5f - 0.25f) * alpha;
+    }
+    rect[i + 3] = alpha;
+  }
+}
+
+static void effect_byte_compare(EffectByteFn effect_scalar, EffectByteFn effect_sse2)
+{
+  const size_t size = sizeof(unsigned char) * IMAGE_LEN;
+  unsigned char *rect1 = (unsigned char *)MEM_mallocN(size, __func__);
+  unsigned char *rect2 = (unsigned char *)MEM_mallocN(size, __func__);
+  unsigned char *out_scalar = (unsigned char *)MEM_mallocN(size, __func__);
+  unsigned char *out_sse2 = (unsigned char *)MEM_mallocN(size, __func__);
+
+  RNG *rng = BLI_rng_new(1234);
+  rng_rect_byte(rng, rect1);
+  rng_rect_byte(rng, rect2);
+  BLI_rng_free(rng);
+
+  for (int i = 0; i < ARRAY_SIZE(effect_factors); i++) {
+    const float facf0 = effect_factors[i][0], facf1 = effect_factors[i][1];
+
+    effect_scalar(facf0, facf1, IMAGE_X, IMAGE_Y, rect1, rect2, out_scalar);
+    effect_sse2(facf0, facf1, IMAGE_X, IMAGE_Y, rect1, rect2, out_sse2);
+    EXPECT_EQ(0, memcmp(out_scalar, out_sse2, size)) << "factors " << facf0 << ", " << facf1;
+  }
+
+  MEM_freeN(rect1);
+  MEM_freeN(rect2);
+  MEM_freeN(out_scalar);
+  MEM_freeN(out_sse2);
+}
+
+static void effect_float_compare(EffectFloatFn effect_scalar, EffectFloatFn effect_sse2)
+{
+  const size_t size = sizeof(float) * IMAGE_LEN;
+  float *rect1 = (float *)MEM_mallocN(size, __func__);
+  float *rect2 = (float *)MEM_mallocN(size, __func__);
+  float *out_scalar = (float *)MEM_mallocN(size, __func__);
+  float *out_sse2 = (float *)MEM_mallocN(size, __func__);
+
+  RNG *rng = BLI_rng_new(1234);
+  rng_rect_float(rng, rect1);
+  rng_rect_float(rng, rect2);
+  BLI_rng_free(rng);
+
+  for (int i = 0; i < ARRAY_SIZE(effect_factors); i++) {
+    const float facf0 = effect_factors[i][0], facf1 = effect_factors[i][1];
+
+    effect_scalar(facf0, facf1, IMAGE_X, IMAGE_Y, rect1, rect2, out_scalar);
+    effect_sse2(facf0, facf1, IMAGE_X, IMAGE_Y, rect1, rect2, out_sse2);
+    EXPECT_EQ(0, memcmp(out_scalar, out_sse2, size)) << "factors " << facf0 << ", " << facf1;
+  }
+
+  MEM_freeN(rect1);
+  MEM_freeN(rect2);
+  MEM_freeN(out_scalar);
+  MEM_freeN(out_sse2);
+}
+
+static void effect_blend_float_compare(const int btype)
+{
+  const size_t size = sizeof(float) * IMAGE_LEN;
+  float *rect1 = (float *)MEM_mallocN(size, __func__);
+  float *rect2 = (float *)MEM_mallocN(size, __func__);
+  float *out_scalar = (float *)MEM_mallocN(size, __func__);
+  float *out_sse2 = (float *)MEM_mallocN(size, __func__);
+
+  RNG *rng = BLI_rng_new(1234);
+  rng_rect_float(rng, rect1);
+  rng_rect_float(rng, rect2);
+  BLI_rng_free(rng);
+
+  for (int i = 0; i < ARRAY_SIZE(effect_factors); i++) {
+    const float facf0 = effect_factors[i][0], facf1 = effect_factors[i][1];
+
+    seq_effect_blend_float_scalar(facf0, facf1, IMAGE_X, IMAGE_Y, rect1, rect2, btype, out_scalar);
+    EXPECT_TRUE(seq_effect_blend_float_sse2(
+        facf0, facf1, IMAGE_X, IMAGE_Y, rect1, rect2, btype, out_sse2));
+    EXPECT_EQ(0, memcmp(out_scalar, out_sse2, size)) << "factors " << facf0 << ", " << facf1;
+  }
+
+  MEM_freeN(rect1);
+  MEM_freeN(rect2);
+  MEM_freeN(out_scalar);
+  MEM_freeN(out_sse2);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(sequencer_effects, AlphaOverByte)
+{
+  effect_byte_compare(seq_effect_alphaover_byte_scalar, seq_effect_alphaover_byte_sse2);
+}
+TEST(sequencer_effects, AlphaOverFloat)
+{
+  effect_float_compare(seq_effect_alphaover_float_scalar, seq_effect_alphaover_float_sse2);
+}
+TEST(sequencer_effects, CrossByte)
+{
+  effect_byte_compare(seq_effect_cross_byte_scalar, seq_effect_cross_byte_sse2);
+}
+TEST(sequencer_effects, CrossFloat)
+{
+  effect_float_compare(seq_effect_cross_float_scalar, seq_effect_cross_float_sse2);
+}
+TEST(sequencer_effects, AddByte)
+{
+  effect_byte_compare(seq_effect_add_byte_scalar, seq_effect_add_byte_sse2);
+}
+TEST(sequencer_effects, AddFloat)
+{
+  effect_float_compare(seq_effect_add_float_scalar, seq_effect_add_float_sse2);
+}
+TEST(sequencer_effects, MulByte)
+{
+  effect_byte_compare(seq_effect_mul_byte_scalar, seq_effect_mul_byte_sse2);
+}
+TEST(sequencer_effects, MulFloat)
+{
+  effect_float_compare(seq_effect_mul_float_scalar, seq_effect_mul_float_sse2);
+}
+
+TEST(sequencer_effects, BlendFloat)
+{
+  effect_blend_float_compare(SEQ_TYPE_ADD);
+  effect_blend_float_compare(SEQ_TYPE_SUB);
+  effect_blend_float_compare(SEQ_TYPE_MUL);
+  effect_blend_float_compare(SEQ_TYPE_DARKEN);
+  effect_blend_float_compare(SEQ_TYPE_LIGHTEN);
+  effect_blend_float_compare(SEQ_TYPE_SCREEN);
+}
+
+TEST(sequencer_effects, BlendFloatUnsupported)
+{
+  /* Modes without SSE2 version must be left to the scalar code. */
+  float rect[4] = {0.5f, 0.5f, 0.5f, 1.0f}, out[4] = {0.0f};
+  EXPECT_FALSE(seq_effect_blend_float_sse2(1.0f, 1.0f, 1, 1, rect, rect, SEQ_TYPE_OVERLAY, out));
+  EXPECT_EQ(0.0f, out[0]);
+}
+
+#endif /* __SSE2__ */
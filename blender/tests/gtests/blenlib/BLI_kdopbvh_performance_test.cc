@@ -0,0 +1,195 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_kdopbvh.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
+#include "PIL_time.h"
+}
+
+#include "stubs/bf_intern_eigen_stubs.h"
+
+/* Compares rays per second of single ray-casts against ray packets,
+ * using coherent camera rays on a displaced grid (similar to baking or snapping). */
+
+#define NUM_RUN_AVERAGED 5
+
+/* Grid resolution (the mesh has twice as many triangles as quads). */
+#define GRID_RES 300
+/* Rays are cast in tiles of pixels (packets of 16 rays are 4x4 tiles). */
+#define IMAGE_RES 512
+
+typedef struct RayCastMesh {
+  float (*verts)[3];
+  int (*tris)[3];
+  int tris_len;
+} RayCastMesh;
+
+static void mesh_raycast_callback(void *userdata,
+                                  int index,
+                                  const BVHTreeRay *ray,
+                                  BVHTreeRayHit *hit)
+{
+  const RayCastMesh *mesh = (const RayCastMesh *)userdata;
+  const int *tri = mesh->tris[index];
+  float dist;
+
+  if (isect_ray_tri_watertight_v3(ray->origin,
+                                  ray->isect_precalc,
+                                  mesh->verts[tri[0]],
+                                  mesh->verts[tri[1]],
+                                  mesh->verts[tri[2]],
+                                  &dist,
+                                  NULL) &&
+      (dist < hit->dist)) {
+    hit->index = index;
+    hit->dist = dist;
+    madd_v3_v3v3fl(hit->co, ray->origin, ray->direction, dist);
+  }
+}
+
+static void mesh_grid_create(RayCastMesh *mesh, struct RNG *rng)
+{
+  const int verts_len = (GRID_RES + 1) * (GRID_RES + 1);
+  mesh->tris_len = GRID_RES * GRID_RES * 2;
+  mesh->verts = (float(*)[3])MEM_mallocN(sizeof(*mesh->verts) * verts_len, __func__);
+  mesh->tris = (int(*)[3])MEM_mallocN(sizeof(*mesh->tris) * mesh->tris_len, __func__);
+
+  for (int y = 0, i = 0; y <= GRID_RES; y++) {
+    for (int x = 0; x <= GRID_RES; x++, i++) {
+      mesh->verts[i][0] = ((float)x / GRID_RES) * 2.0f - 1.0f;
+      mesh->verts[i][1] = ((float)y / GRID_RES) * 2.0f - 1.0f;
+      mesh->verts[i][2] = BLI_rng_get_float(rng) * 0.05f;
+    }
+  }
+  for (int y = 0, i = 0; y < GRID_RES; y++) {
+    for (int x = 0; x < GRID_RES; x++, i += 2) {
+      const int v = y * (GRID_RES + 1) + x;
+      ARRAY_SET_ITEMS(mesh->tris[i], v, v + 1, v + GRID_RES + 2);
+      ARRAY_SET_ITEMS(mesh->tris[i + 1], v, v + GRID_RES + 2, v + GRID_RES + 1);
+    }
+  }
+}
+
+static void camera_ray_get(int x, int y, float r_co[3], float r_dir[3])
+{
+  ARRAY_SET_ITEMS(r_co, 0.0f, -0.5f, 2.0f);
+  ARRAY_SET_ITEMS(r_dir,
+                  ((float)x / IMAGE_RES) * 2.0f - 1.0f,
+                  ((float)y / IMAGE_RES) * 2.0f - 1.0f + 0.5f,
+                  -1.5f);
+  normalize_v3(r_dir);
+}
+
+static void raycast_performance_run(const char *id,
+                                    BVHTree *tree,
+                                    const BVHTreeFlat *flat,
+                                    RayCastMesh *mesh,
+                                    int tile_x_size,
+                                    int tile_y_size)
+{
+  const int packet_len = tile_x_size * tile_y_size;
+  double averaged_timing = 0.0;
+  int hits_len = 0;
+
+  for (int run = 0; run < NUM_RUN_AVERAGED; run++) {
+    const double init_time = PIL_check_seconds_timer();
+    hits_len = 0;
+
+    for (int tile_y = 0; tile_y < IMAGE_RES; tile_y += tile_y_size) {
+      for (int tile_x = 0; tile_x < IMAGE_RES; tile_x += tile_x_size) {
+        float co[BVH_RAYCAST_PACKET_MAX][3], dir[BVH_RAYCAST_PACKET_MAX][3];
+        BVHTreeRayHit hits[BVH_RAYCAST_PACKET_MAX];
+
+        for (int i = 0; i < packet_len; i++) {
+          camera_ray_get(tile_x + (i % tile_x_size), tile_y + (i / tile_x_size), co[i], dir[i]);
+          hits[i].index = -1;
+          hits[i].dist = BVH_RAYCAST_DIST_MAX;
+        }
+
+        if (flat) {
+          hits_len += BLI_bvhtree_flat_ray_cast_packet_ex(flat,
+                                                          co,
+                                                          dir,
+                                                          packet_len,
+                                                          0.0f,
+                                                          hits,
+                                                          mesh_raycast_callback,
+                                                          mesh,
+                                                          BVH_RAYCAST_DEFAULT);
+        }
+        else if (packet_len == 1) {
+          if (BLI_bvhtree_ray_cast(
+                  tree, co[0], dir[0], 0.0f, &hits[0], mesh_raycast_callback, mesh) != -1) {
+            hits_len++;
+          }
+        }
+        else {
+          hits_len += BLI_bvhtree_ray_cast_packet(
+              tree, co, dir, packet_len, 0.0f, hits, mesh_raycast_callback, mesh);
+        }
+      }
+    }
+    averaged_timing += PIL_check_seconds_timer() - init_time;
+  }
+
+  averaged_timing /= NUM_RUN_AVERAGED;
+  printf("\t%s: %d hits, %fs on average over %d runs (%.2f Mrays/s)\n",
+         id,
+         hits_len,
+         averaged_timing,
+         NUM_RUN_AVERAGED,
+         (double)(IMAGE_RES * IMAGE_RES) / averaged_timing / 1e6);
+}
+
+static void raycast_performance_test(const char *id, char tree_type)
+{
+  printf("\n========== STARTING %s ==========\n", id);
+
+  struct RNG *rng = BLI_rng_new(1234);
+  RayCastMesh mesh;
+  mesh_grid_create(&mesh, rng);
+
+  BVHTree *tree = BLI_bvhtree_new(mesh.tris_len, 0.0f, tree_type, 6);
+  for (int i = 0; i < mesh.tris_len; i++) {
+    float co[3][3];
+    for (int j = 0; j < 3; j++) {
+      copy_v3_v3(co[j], mesh.verts[mesh.tris[i][j]]);
+    }
+    BLI_bvhtree_insert(tree, i, co[0], 3);
+  }
+  BLI_bvhtree_balance(tree);
+  BVHTreeFlat *flat = BLI_bvhtree_flat_new(tree);
+
+  raycast_performance_run("Single ray", tree, NULL, &mesh, 1, 1);
+  raycast_performance_run("Packet of 4", tree, NULL, &mesh, 2, 2);
+  raycast_performance_run("Packet of 8", tree, NULL, &mesh, 4, 2);
+  raycast_performance_run("Packet of 16", tree, NULL, &mesh, 4, 4);
+  raycast_performance_run("Flat, single ray", tree, flat, &mesh, 1, 1);
+  raycast_performance_run("Flat, packet of 4", tree, flat, &mesh, 2, 2);
+  raycast_performance_run("Flat, packet of 8", tree, flat, &mesh, 4, 2);
+  raycast_performance_run("Flat, packet of 16", tree, flat, &mesh, 4, 4);
+
+  BLI_bvhtree_flat_free(flat);
+  BLI_bvhtree_free(tree);
+  MEM_freeN(mesh.verts);
+  MEM_freeN(mesh.tris);
+  BLI_rng_free(rng);
+
+  printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, RayCastPacketBinaryTree)
+{
+  raycast_performance_test("Ray-cast packets - binary tree", 2);
+}
+
+TEST(kdopbvh, RayCastPacketQuadTree)
+{
+  raycast_performance_test("Ray-cast packets - quad tree", 4);
+}
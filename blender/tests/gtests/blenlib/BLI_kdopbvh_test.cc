@@ -135,3 +135,141 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+/* -------------------------------------------------------------------- */
+/* Ray-Cast Packets */
+
+static void raycast_rays_init(
+    float (*co)[3], float (*dir)[3], int rays_len, struct RNG *rng, float spread)
+{
+  float co_base[3], dir_base[3];
+  BLI_rng_get_float_unit_v3(rng, dir_base);
+  mul_v3_v3fl(co_base, dir_base, -2.0f);
+
+  for (int i = 0; i < rays_len; i++) {
+    for (int j = 0; j < 3; j++) {
+      co[i][j] = co_base[j] + (BLI_rng_get_float(rng) * 2.0f - 1.0f) * spread;
+      dir[i][j] = dir_base[j] + (BLI_rng_get_float(rng) * 2.0f - 1.0f) * spread;
+    }
+    normalize_v3(dir[i]);
+  }
+}
+
+static void raycast_packet_test(int points_len,
+                                char tree_type,
+                                char axis,
+                                float radius,
+                                int packet_len,
+                                bool use_flat,
+                                int random_seed,
+                                bool use_update = false)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.01f, tree_type, axis);
+
+  for (int i = 0; i < points_len; i++) {
+    float co[3];
+    rng_v3_round(co, 3, rng, 1 << 20, 1.0f);
+    BLI_bvhtree_insert(tree, i, co, 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  BVHTreeFlat *flat = use_flat ? BLI_bvhtree_flat_new(tree) : NULL;
+
+  if (use_update) {
+    /* Scale all points, the flat tree has to be refit. */
+    for (int i = 0; i < points_len; i++) {
+      float co[3];
+      rng_v3_round(co, 3, rng, 1 << 20, 0.5f);
+      BLI_bvhtree_update_node(tree, i, co, NULL, 1);
+    }
+    BLI_bvhtree_update_tree(tree);
+    if (flat) {
+      BLI_bvhtree_flat_update(flat);
+    }
+  }
+
+  for (int packet = 0; packet < 100; packet++) {
+    float co[BVH_RAYCAST_PACKET_MAX][3], dir[BVH_RAYCAST_PACKET_MAX][3];
+    BVHTreeRayHit hits[BVH_RAYCAST_PACKET_MAX];
+    int hits_len = 0;
+
+    raycast_rays_init(co, dir, packet_len, rng, 0.1f);
+
+    for (int i = 0; i < packet_len; i++) {
+      hits[i].index = -1;
+      hits[i].dist = BVH_RAYCAST_DIST_MAX;
+    }
+
+    int packet_hits_len;
+    if (use_flat) {
+      packet_hits_len = BLI_bvhtree_flat_ray_cast_packet_ex(
+          flat, co, dir, packet_len, radius, hits, NULL, NULL, 0);
+    }
+    else {
+      packet_hits_len = BLI_bvhtree_ray_cast_packet(
+          tree, co, dir, packet_len, radius, hits, NULL, NULL);
+    }
+
+    for (int i = 0; i < packet_len; i++) {
+      BVHTreeRayHit hit;
+      hit.index = -1;
+      hit.dist = BVH_RAYCAST_DIST_MAX;
+      BLI_bvhtree_ray_cast(tree, co[i], dir[i], radius, &hit, NULL, NULL);
+
+      EXPECT_EQ(hit.index, hits[i].index);
+      if (hit.index != -1) {
+        EXPECT_NEAR(hit.dist, hits[i].dist, 1e-5f);
+        hits_len++;
+      }
+    }
+    EXPECT_EQ(hits_len, packet_hits_len);
+  }
+
+  if (flat) {
+    BLI_bvhtree_flat_free(flat);
+  }
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+}
+
+TEST(kdopbvh, RayCastPacket_4)
+{
+  raycast_packet_test(1000, 2, 6, 0.0f, 4, false, 1234);
+}
+TEST(kdopbvh, RayCastPacket_7)
+{
+  raycast_packet_test(1000, 4, 8, 0.0f, 7, false, 123);
+}
+TEST(kdopbvh, RayCastPacket_16)
+{
+  raycast_packet_test(1000, 4, 26, 0.0f, 16, false, 12);
+}
+TEST(kdopbvh, RayCastPacketRadius_16)
+{
+  raycast_packet_test(1000, 8, 6, 0.05f, 16, false, 12);
+}
+TEST(kdopbvh, RayCastPacketFlat_1)
+{
+  raycast_packet_test(1, 2, 6, 0.0f, 1, true, 1234);
+}
+TEST(kdopbvh, RayCastPacketFlat_4)
+{
+  raycast_packet_test(1000, 2, 6, 0.0f, 4, true, 1234);
+}
+TEST(kdopbvh, RayCastPacketFlat_8)
+{
+  raycast_packet_test(1000, 4, 8, 0.0f, 8, true, 123);
+}
+TEST(kdopbvh, RayCastPacketFlat_16)
+{
+  raycast_packet_test(1000, 32, 6, 0.0f, 16, true, 12);
+}
+TEST(kdopbvh, RayCastPacketFlatRadius_16)
+{
+  raycast_packet_test(1000, 3, 6, 0.05f, 16, true, 12);
+}
+TEST(kdopbvh, RayCastPacketFlatUpdate_16)
+{
+  raycast_packet_test(1000, 4, 6, 0.0f, 16, true, 12, true);
+}
@@ -0,0 +1,206 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_kdtree.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
+}
+
+/* Compare against brute force, using enough points for the tree to be balanced in parallel. */
+
+#define POINTS_LEN 50000
+#define QUERY_LEN 2000
+#define NEAREST_N 8
+
+static KDTree_3d *kdtree_random_create(float (*points)[3], int points_len, struct RNG *rng)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i]);
+    mul_v3_fl(points[i], BLI_rng_get_float(rng));
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static int find_nearest_brute_force(const float (*points)[3], int points_len, const float co[3])
+{
+  int index = -1;
+  float dist_best_sq = FLT_MAX;
+  for (int i = 0; i < points_len; i++) {
+    const float dist_sq = len_squared_v3v3(points[i], co);
+    if (dist_sq < dist_best_sq) {
+      dist_best_sq = dist_sq;
+      index = i;
+    }
+  }
+  return index;
+}
+
+TEST(kdtree, FindNearest)
+{
+  BLI_threadapi_init();
+  struct RNG *rng = BLI_rng_new(1234);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(*points) * POINTS_LEN, __func__);
+  KDTree_3d *tree = kdtree_random_create(points, POINTS_LEN, rng);
+
+  for (int i = 0; i < QUERY_LEN; i++) {
+    float co[3];
+    KDTreeNearest_3d nearest;
+    BLI_rng_get_float_unit_v3(rng, co);
+    EXPECT_EQ(find_nearest_brute_force(points, POINTS_LEN, co),
+              BLI_kdtree_3d_find_nearest(tree, co, &nearest));
+    EXPECT_FLOAT_EQ(len_v3v3(points[nearest.index], co), nearest.dist);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  BLI_rng_free(rng);
+  BLI_threadapi_exit();
+}
+
+/* Points on a planar grid (many equal coordinates), queried from far outside. */
+TEST(kdtree, FindNearestPlanar)
+{
+  const int grid_len = 100;
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(*points) * grid_len * grid_len, __func__);
+  KDTree_3d *tree = BLI_kdtree_3d_new(grid_len * grid_len);
+  int points_len = 0;
+  for (int y = 0; y < grid_len; y++) {
+    for (int x = 0; x < grid_len; x++) {
+      float *co = points[points_len];
+      co[0] = (float)x / grid_len - 0.5f;
+      co[1] = (float)y / grid_len - 0.5f;
+      co[2] = 0.0f;
+      if (len_squared_v3(co) < 0.1f) {
+        BLI_kdtree_3d_insert(tree, points_len++, co);
+      }
+    }
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  struct RNG *rng = BLI_rng_new(1234);
+  for (int i = 0; i < QUERY_LEN; i++) {
+    float co[3];
+    KDTreeNearest_3d nearest;
+    BLI_rng_get_float_unit_v3(rng, co);
+    co[2] *= 0.1f;
+    const int index = find_nearest_brute_force(points, points_len, co);
+    EXPECT_NE(-1, BLI_kdtree_3d_find_nearest(tree, co, &nearest));
+    EXPECT_FLOAT_EQ(len_v3v3(points[index], co), nearest.dist);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  BLI_rng_free(rng);
+}
+
+TEST(kdtree, Empty)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(0);
+  BLI_kdtree_3d_balance(tree);
+  const float co[3] = {0.0f, 0.0f, 0.0f};
+  KDTreeNearest_3d nearest;
+  EXPECT_EQ(-1, BLI_kdtree_3d_find_nearest(tree, co, NULL));
+  BLI_kdtree_3d_find_nearest_batch(tree, &co, 1, &nearest);
+  EXPECT_EQ(-1, nearest.index);
+  BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, Batch)
+{
+  BLI_threadapi_init();
+  struct RNG *rng = BLI_rng_new(4321);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(*points) * POINTS_LEN, __func__);
+  float(*co)[3] = (float(*)[3])MEM_mallocN(sizeof(*co) * QUERY_LEN, __func__);
+  KDTree_3d *tree = kdtree_random_create(points, POINTS_LEN, rng);
+
+  for (int i = 0; i < QUERY_LEN; i++) {
+    BLI_rng_get_float_unit_v3(rng, co[i]);
+    mul_v3_fl(co[i], 0.5f);
+  }
+
+  /* Nearest. */
+  KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_mallocN(
+      sizeof(*nearest) * QUERY_LEN * NEAREST_N, __func__);
+  BLI_kdtree_3d_find_nearest_batch(tree, co, QUERY_LEN, nearest);
+  for (int i = 0; i < QUERY_LEN; i++) {
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, co[i], NULL), nearest[i].index);
+  }
+
+  /* Nearest N. */
+  int *nearest_len = (int *)MEM_mallocN(sizeof(*nearest_len) * QUERY_LEN, __func__);
+  BLI_kdtree_3d_find_nearest_n_batch(tree, co, QUERY_LEN, nearest, NEAREST_N, nearest_len);
+  for (int i = 0; i < QUERY_LEN; i++) {
+    KDTreeNearest_3d nearest_n[NEAREST_N];
+    EXPECT_EQ(NEAREST_N, nearest_len[i]);
+    EXPECT_EQ(nearest_len[i], BLI_kdtree_3d_find_nearest_n(tree, co[i], nearest_n, NEAREST_N));
+    for (int j = 0; j < nearest_len[i]; j++) {
+      EXPECT_EQ(nearest_n[j].index, nearest[i * NEAREST_N + j].index);
+    }
+  }
+
+  /* Range search. */
+  const float range = 0.05f;
+  KDTreeNearest_3d *range_nearest;
+  uint *range_offset = (uint *)MEM_mallocN(sizeof(*range_offset) * (QUERY_LEN + 1), __func__);
+  const int range_len = BLI_kdtree_3d_range_search_batch(
+      tree, co, QUERY_LEN, range, &range_nearest, range_offset);
+  EXPECT_EQ(range_len, range_offset[QUERY_LEN]);
+  EXPECT_GT(range_len, 0);
+  for (int i = 0; i < QUERY_LEN; i++) {
+    KDTreeNearest_3d *range_nearest_single;
+    const int found = BLI_kdtree_3d_range_search(tree, co[i], &range_nearest_single, range);
+    EXPECT_EQ(found, range_offset[i + 1] - range_offset[i]);
+    for (int j = 0; j < found; j++) {
+      EXPECT_FLOAT_EQ(range_nearest_single[j].dist, range_nearest[range_offset[i] + j].dist);
+    }
+    if (range_nearest_single) {
+      MEM_freeN(range_nearest_single);
+    }
+  }
+
+  MEM_freeN(range_nearest);
+  MEM_freeN(range_offset);
+  MEM_freeN(nearest_len);
+  MEM_freeN(nearest);
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(co);
+  MEM_freeN(points);
+  BLI_rng_free(rng);
+  BLI_threadapi_exit();
+}
+
+TEST(kdtree, Duplicates)
+{
+  /* Pairs of points at the same location, every second point is merged into the first. */
+  const int pairs_len = 1000;
+  KDTree_3d *tree = BLI_kdtree_3d_new(pairs_len * 2);
+  for (int i = 0; i < pairs_len; i++) {
+    const float co[3] = {(float)i, (float)(i % 7), 0.0f};
+    BLI_kdtree_3d_insert(tree, i * 2, co);
+    BLI_kdtree_3d_insert(tree, i * 2 + 1, co);
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  int *duplicates = (int *)MEM_mallocN(sizeof(*duplicates) * pairs_len * 2, __func__);
+  for (int use_index_order = 0; use_index_order < 2; use_index_order++) {
+    copy_vn_i(duplicates, pairs_len * 2, -1);
+    EXPECT_EQ(pairs_len,
+              BLI_kdtree_3d_calc_duplicates_fast(tree, 0.1f, use_index_order, duplicates));
+    for (int i = 0; i < pairs_len; i++) {
+      const int a = duplicates[i * 2], b = duplicates[i * 2 + 1];
+      EXPECT_TRUE(((a == i * 2) && (b == i * 2)) || ((a == i * 2 + 1) && (b == i * 2 + 1)));
+    }
+  }
+
+  MEM_freeN(duplicates);
+  BLI_kdtree_3d_free(tree);
+}
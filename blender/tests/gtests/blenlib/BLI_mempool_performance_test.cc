@@ -0,0 +1,126 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+/* Contention of many threads allocating from the same pool,
+ * comparing a pool protected by a lock against threaded allocation. */
+
+#define NUM_RUN_AVERAGED 3
+/* Must be a multiple of the batch size used by #mempool_perf_task_func. */
+#define NUM_ITEMS_PER_TASK (1 << 14)
+#define NUM_TASKS_PER_THREAD 4
+
+typedef struct MempoolPerfData {
+  BLI_mempool *pool;
+  SpinLock lock;
+  bool use_threads_api;
+} MempoolPerfData;
+
+static void mempool_perf_task_func(TaskPool *__restrict task_pool,
+                                   void *UNUSED(taskdata),
+                                   int threadid)
+{
+  MempoolPerfData *data = (MempoolPerfData *)BLI_task_pool_userdata(task_pool);
+  void *elems[64];
+
+  /* Allocate in small batches, freeing every other element (as operators creating geometry
+   * and removing temporary elements would). */
+  for (int i = 0; i < NUM_ITEMS_PER_TASK; i += ARRAY_SIZE(elems)) {
+    for (int j = 0; j < ARRAY_SIZE(elems); j++) {
+      if (data->use_threads_api) {
+        elems[j] = BLI_mempool_alloc_thread(data->pool, (uint)threadid);
+      }
+      else {
+        BLI_spin_lock(&data->lock);
+        elems[j] = BLI_mempool_alloc(data->pool);
+        BLI_spin_unlock(&data->lock);
+      }
+    }
+    for (int j = 0; j < ARRAY_SIZE(elems); j += 2) {
+      if (data->use_threads_api) {
+        BLI_mempool_free_thread(data->pool, (uint)threadid, elems[j]);
+      }
+      else {
+        BLI_spin_lock(&data->lock);
+        BLI_mempool_free(data->pool, elems[j]);
+        BLI_spin_unlock(&data->lock);
+      }
+    }
+  }
+}
+
+static double mempool_perf_run(TaskScheduler *scheduler,
+                               const int num_threads,
+                               const bool use_threads_api)
+{
+  MempoolPerfData data;
+  double averaged_timing = 0.0;
+
+  data.use_threads_api = use_threads_api;
+  BLI_spin_init(&data.lock);
+
+  for (int run = 0; run < NUM_RUN_AVERAGED; run++) {
+    data.pool = BLI_mempool_create(sizeof(float[4]), 0, 512, BLI_MEMPOOL_ALLOW_ITER);
+
+    const double init_time = PIL_check_seconds_timer();
+    if (use_threads_api) {
+      BLI_mempool_threads_begin(data.pool, (uint)num_threads + 1, 0);
+    }
+
+    TaskPool *task_pool = BLI_task_pool_create(scheduler, &data);
+    for (int i = 0; i < num_threads * NUM_TASKS_PER_THREAD; i++) {
+      BLI_task_pool_push(task_pool, mempool_perf_task_func, NULL, false, TASK_PRIORITY_HIGH);
+    }
+    BLI_task_pool_work_and_wait(task_pool);
+    BLI_task_pool_free(task_pool);
+
+    if (use_threads_api) {
+      BLI_mempool_threads_end(data.pool);
+    }
+    averaged_timing += PIL_check_seconds_timer() - init_time;
+
+    EXPECT_EQ(num_threads * NUM_TASKS_PER_THREAD * (NUM_ITEMS_PER_TASK / 2),
+              BLI_mempool_len(data.pool));
+    BLI_mempool_destroy(data.pool);
+  }
+
+  BLI_spin_end(&data.lock);
+
+  return averaged_timing / NUM_RUN_AVERAGED;
+}
+
+TEST(mempool, ThreadContention)
+{
+  printf("\n========== STARTING Mempool thread contention ==========\n");
+  BLI_threadapi_init();
+
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+    const double timing_locked = mempool_perf_run(scheduler, num_threads, false);
+    const double timing_threaded = mempool_perf_run(scheduler, num_threads, true);
+    const double items = (double)(num_threads * NUM_TASKS_PER_THREAD * NUM_ITEMS_PER_TASK);
+
+    printf("\t%2d threads: locked %fs (%.2f Mallocs/s), threaded %fs (%.2f Mallocs/s)\n",
+           num_threads,
+           timing_locked,
+           items / timing_locked / 1e6,
+           timing_threaded,
+           items / timing_threaded / 1e6);
+    BLI_task_scheduler_free(scheduler);
+  }
+
+  BLI_threadapi_exit();
+  printf("========== ENDED Mempool thread contention ==========\n\n");
+}
@@ -0,0 +1,132 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+
+#include "MEM_guardedalloc.h"
+};
+
+#define NUM_ITEMS 10000
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+typedef struct MempoolTestData {
+  BLI_mempool *pool;
+  int **elems;
+} MempoolTestData;
+
+static void mempool_alloc_thread_func(void *__restrict userdata,
+                                      const int index,
+                                      const TaskParallelTLS *__restrict tls)
+{
+  MempoolTestData *data = (MempoolTestData *)userdata;
+  int *elem = (int *)BLI_mempool_alloc_thread(data->pool, (uint)tls->thread_id);
+  *elem = index;
+  data->elems[index] = elem;
+}
+
+static void mempool_free_thread_func(void *__restrict userdata,
+                                     const int index,
+                                     const TaskParallelTLS *__restrict tls)
+{
+  MempoolTestData *data = (MempoolTestData *)userdata;
+  /* Free from a different thread than the one allocating (most likely). */
+  if (index % 3 == 0) {
+    BLI_mempool_free_thread(data->pool, (uint)tls->thread_id, data->elems[index]);
+    data->elems[index] = NULL;
+  }
+}
+
+static void mempool_threaded_test(const uint totelem_reserve)
+{
+  int *elems[NUM_ITEMS];
+  MempoolTestData data = {NULL, elems};
+
+  BLI_threadapi_init();
+  data.pool = BLI_mempool_create(sizeof(int), 0, 32, BLI_MEMPOOL_ALLOW_ITER);
+
+  /* Elements allocated before the threaded section. */
+  for (int i = 0; i < 100; i++) {
+    int *elem = (int *)BLI_mempool_alloc(data.pool);
+    *elem = -1;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 16;
+
+  const int threads_len = BLI_task_scheduler_num_threads(BLI_task_scheduler_get()) + 1;
+  BLI_mempool_threads_begin(data.pool, (uint)threads_len, totelem_reserve);
+  BLI_task_parallel_range(0, NUM_ITEMS, &data, mempool_alloc_thread_func, &settings);
+  BLI_task_parallel_range(0, NUM_ITEMS, &data, mempool_free_thread_func, &settings);
+  BLI_mempool_threads_end(data.pool);
+
+  const int elems_len = 100 + NUM_ITEMS - ((NUM_ITEMS + 2) / 3);
+  EXPECT_EQ(elems_len, BLI_mempool_len(data.pool));
+
+  /* Iteration sees each element once. */
+  bool *found = (bool *)MEM_callocN(sizeof(*found) * NUM_ITEMS, __func__);
+  BLI_mempool_iter iter;
+  int *elem;
+  int i = 0;
+  BLI_mempool_iternew(data.pool, &iter);
+  while ((elem = (int *)BLI_mempool_iterstep(&iter))) {
+    if (*elem != -1) {
+      EXPECT_EQ(elems[*elem], elem);
+      EXPECT_FALSE(found[*elem]);
+      found[*elem] = true;
+    }
+    EXPECT_EQ(elem, BLI_mempool_findelem(data.pool, (uint)i));
+    i++;
+  }
+  EXPECT_EQ(elems_len, i);
+  MEM_freeN(found);
+
+  /* Freed elements are reused by the regular API. */
+  for (int j = 0; j < NUM_ITEMS; j++) {
+    if (elems[j]) {
+      BLI_mempool_free(data.pool, elems[j]);
+    }
+  }
+  for (int j = 0; j < NUM_ITEMS; j++) {
+    elem = (int *)BLI_mempool_alloc(data.pool);
+    *elem = j;
+  }
+  EXPECT_EQ(100 + NUM_ITEMS, BLI_mempool_len(data.pool));
+
+  BLI_mempool_destroy(data.pool);
+  BLI_threadapi_exit();
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(mempool, Alloc)
+{
+  BLI_mempool *pool = BLI_mempool_create(sizeof(int), 0, 32, BLI_MEMPOOL_ALLOW_ITER);
+  for (int i = 0; i < NUM_ITEMS; i++) {
+    int *elem = (int *)BLI_mempool_alloc(pool);
+    *elem = i;
+  }
+  EXPECT_EQ(NUM_ITEMS, BLI_mempool_len(pool));
+  for (int i = 0; i < NUM_ITEMS; i += 100) {
+    EXPECT_EQ(i, *(int *)BLI_mempool_findelem(pool, (uint)i));
+  }
+  BLI_mempool_destroy(pool);
+}
+
+TEST(mempool, ThreadedAlloc)
+{
+  mempool_threaded_test(0);
+}
+
+TEST(mempool, ThreadedAllocReserve)
+{
+  mempool_threaded_test(NUM_ITEMS);
+}
@@ -0,0 +1,101 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string>
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_fileops.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "MEM_CacheLimiterC-Api.h"
+#include "PIL_time.h"
+}
+
+#include "IMB_anim_test_movie.h"
+
+/* Time stepping through a generated long GOP movie, with and without the frame cache of the
+ * anim. Without the cache every step backwards seeks to the key frame and decodes from there.
+ * The single jump backwards shows what keeping the frames before the jump costs. */
+
+#define MOVIE_X 1920
+#define MOVIE_Y 1080
+#define MOVIE_FRAMES 300
+#define MOVIE_GOP 250
+
+/* Frames stepped through, starting at the end of the long GOP. */
+#define STEP_FIRST 200
+#define STEP_LEN 40
+
+static double anim_fetch_range(struct anim *anim, int first, int last)
+{
+  const int step = (first <= last) ? 1 : -1;
+  const double time_start = PIL_check_seconds_timer();
+
+  for (int position = first; position != last + step; position += step) {
+    ImBuf *ibuf = IMB_anim_absolute(anim, position, IMB_TC_NONE, IMB_PROXY_NONE);
+    EXPECT_NE((ImBuf *)NULL, ibuf) << "frame " << position;
+    if (ibuf) {
+      IMB_freeImBuf(ibuf);
+    }
+  }
+  return PIL_check_seconds_timer() - time_start;
+}
+
+static void anim_performance(const char *name, const bool use_frame_cache)
+{
+  const std::string filepath = ::testing::internal::TempDir() + "blender_anim_test.mp4";
+  struct anim *anim;
+  double time;
+
+  printf("\n========== STARTING %s ==========\n", name);
+
+  BLI_threadapi_init();
+  IMB_init();
+  IMB_ffmpeg_init();
+  /* Same as the default memory cache limit of the preferences. */
+  MEM_CacheLimiter_set_maximum((size_t)4096 * 1024 * 1024);
+
+  ASSERT_TRUE(anim_test_movie_write(filepath.c_str(), MOVIE_X, MOVIE_Y, MOVIE_FRAMES, MOVIE_GOP));
+
+  anim = IMB_open_anim(filepath.c_str(), IB_rect, 0, NULL);
+  ASSERT_NE((struct anim *)NULL, anim);
+  if (!use_frame_cache) {
+    /* Anims decoded concurrently keep no frame cache. */
+    IMB_anim_set_concurrent_decoding(anim, 2);
+  }
+
+  time = anim_fetch_range(anim, STEP_FIRST, STEP_FIRST + STEP_LEN - 1);
+  printf("%-24s: %8.2f ms per frame\n", "forward", time * 1000.0 / STEP_LEN);
+
+  time = anim_fetch_range(anim, STEP_FIRST + STEP_LEN - 1, STEP_FIRST);
+  printf("%-24s: %8.2f ms per frame\n", "backward", time * 1000.0 / STEP_LEN);
+
+  /* Far enough from the frames fetched so far to miss the cache. */
+  time = anim_fetch_range(anim, MOVIE_FRAMES - 1, MOVIE_FRAMES - 1);
+  time = anim_fetch_range(anim, STEP_FIRST - STEP_LEN, STEP_FIRST - STEP_LEN);
+  printf("%-24s: %8.2f ms\n", "single jump backward", time * 1000.0);
+
+  time = anim_fetch_range(anim, STEP_FIRST - STEP_LEN - 1, STEP_FIRST - 2 * STEP_LEN);
+  printf("%-24s: %8.2f ms per frame\n", "backward after jump", time * 1000.0 / STEP_LEN);
+
+  IMB_close_anim(anim);
+  BLI_delete(filepath.c_str(), false, false);
+
+  IMB_exit();
+  BLI_threadapi_exit();
+
+  printf("========== ENDED ==========\n\n");
+}
+
+TEST(imbuf_anim, LongGOP_FrameCache)
+{
+  anim_performance("long GOP, frame cache", true);
+}
+TEST(imbuf_anim, LongGOP_NoFrameCache)
+{
+  anim_performance("long GOP, no frame cache", false);
+}
@@ -0,0 +1,131 @@
+/* Apache License, Version 2.0 */
+
+#include "ffmpeg_compat.h"
+
+#include "IMB_anim_test_movie.h"
+
+static void test_movie_frame_fill(AVFrame *frame, int width, int height, int cfra)
+{
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      frame->data[0][y * frame->linesize[0] + x] = (unsigned char)(x + y + cfra * 3);
+    }
+  }
+  for (int y = 0; y < height / 2; y++) {
+    for (int x = 0; x < width / 2; x++) {
+      frame->data[1][y * frame->linesize[1] + x] = (unsigned char)(128 + y + cfra * 2);
+      frame->data[2][y * frame->linesize[2] + x] = (unsigned char)(64 + x + cfra * 5);
+    }
+  }
+}
+
+/* Encode one frame, NULL flushes the encoder. Returns 1 when a packet was written, 0 when
+ * there was none and -1 on errors. */
+static int test_movie_encode(AVFormatContext *of, AVStream *st, AVFrame *frame)
+{
+  AVCodecContext *c = st->codec;
+  AVPacket packet = {0};
+  int got_output, ret;
+
+  av_init_packet(&packet);
+
+  if (avcodec_encode_video2(c, &packet, frame, &got_output) < 0) {
+    return -1;
+  }
+  if (!got_output) {
+    return 0;
+  }
+
+  if (packet.pts != AV_NOPTS_VALUE) {
+    packet.pts = av_rescale_q(packet.pts, c->time_base, st->time_base);
+  }
+  if (packet.dts != AV_NOPTS_VALUE) {
+    packet.dts = av_rescale_q(packet.dts, c->time_base, st->time_base);
+  }
+  packet.stream_index = st->index;
+
+  ret = av_interleaved_write_frame(of, &packet);
+  return (ret == 0) ? 1 : -1;
+}
+
+bool anim_test_movie_write(
+    const char *filepath, int width, int height, int frames_len, int gop_size)
+{
+  AVFormatContext *of;
+  AVStream *st;
+  AVCodecContext *c;
+  AVCodec *codec;
+  AVFrame *frame;
+  bool ok = true;
+
+  of = avformat_alloc_context();
+  if (of == NULL) {
+    return false;
+  }
+  of->oformat = av_guess_format(NULL, filepath, NULL);
+  codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+  st = avformat_new_stream(of, NULL);
+  if (of->oformat == NULL || codec == NULL || st == NULL) {
+    avformat_free_context(of);
+    return false;
+  }
+
+  c = st->codec;
+  c->codec_id = AV_CODEC_ID_MPEG4;
+  c->codec_type = AVMEDIA_TYPE_VIDEO;
+  c->width = width;
+  c->height = height;
+  c->time_base.num = 1;
+  c->time_base.den = 25;
+  c->pix_fmt = AV_PIX_FMT_YUV420P;
+  c->gop_size = gop_size;
+  c->max_b_frames = 2;
+  c->bit_rate = 8000000;
+  st->time_base = c->time_base;
+
+  if (of->oformat->flags & AVFMT_GLOBALHEADER) {
+    c->flags |= CODEC_FLAG_GLOBAL_HEADER;
+  }
+
+  if (avcodec_open2(c, codec, NULL) < 0) {
+    avformat_free_context(of);
+    return false;
+  }
+  if (avio_open(&of->pb, filepath, AVIO_FLAG_WRITE) < 0) {
+    avcodec_close(c);
+    avformat_free_context(of);
+    return false;
+  }
+
+  frame = av_frame_alloc();
+  frame->format = c->pix_fmt;
+  frame->width = width;
+  frame->height = height;
+
+  ok = (av_frame_get_buffer(frame, 32) >= 0) && (avformat_write_header(of, NULL) >= 0);
+
+  for (int cfra = 0; ok && cfra < frames_len; cfra++) {
+    /* The encoder keeps references to frames it delays for B-frames. */
+    if (av_frame_make_writable(frame) < 0) {
+      ok = false;
+      break;
+    }
+    test_movie_frame_fill(frame, width, height, cfra);
+    frame->pts = cfra;
+    ok = test_movie_encode(of, st, frame) >= 0;
+  }
+
+  if (ok) {
+    int ret;
+    while ((ret = test_movie_encode(of, st, NULL)) > 0) {
+    }
+    ok = (ret == 0) && (av_write_trailer(of) == 0);
+  }
+
+  av_frame_free(&frame);
+  avcodec_close(c);
+  avio_close(of->pb);
+  avformat_free_context(of);
+
+  return ok;
+}
@@ -0,0 +1,21 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __IMB_ANIM_TEST_MOVIE_H__
+#define __IMB_ANIM_TEST_MOVIE_H__
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Write an MPEG-4 movie with a key frame every gop_size frames and B-frames, so going back
+ * one frame has to decode from a key frame far away. The frames show a moving gradient. */
+bool anim_test_movie_write(
+    const char *filepath, int width, int height, int frames_len, int gop_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IMB_ANIM_TEST_MOVIE_H__ */
@@ -0,0 +1,110 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_threads.h"
+#include "PIL_time.h"
+#include "intern/IMB_filter.h"
+}
+
+#include "IMB_scaling_test_util.h"
+
+/* Time and quality of the previous box/linear scaling against separable filtered scaling.
+ * Quality is the PSNR against the analytic image rendered at the new resolution. */
+
+#define NUM_RUN_AVERAGED 3
+
+typedef enum eScaleMethod {
+  SCALE_METHOD_BOX_LINEAR = 0,
+  SCALE_METHOD_DEFAULT,
+  SCALE_METHOD_BICUBIC,
+} eScaleMethod;
+
+static const char *scale_method_names[] = {"box/linear (old)", "default", "bicubic"};
+
+static void scale_method_apply(ImBuf *ibuf, int newx, int newy, eScaleMethod method)
+{
+  switch (method) {
+    case SCALE_METHOD_BOX_LINEAR:
+      imb_scale_box_linear(ibuf, newx, newy);
+      break;
+    case SCALE_METHOD_DEFAULT:
+      IMB_scaleImBuf(ibuf, newx, newy);
+      break;
+    case SCALE_METHOD_BICUBIC:
+      IMB_scaleImBuf_filter(ibuf, newx, newy, IMB_SCALE_FILTER_BICUBIC);
+      break;
+  }
+}
+
+static void scale_performance(int src_x, int src_y, int dst_x, int dst_y, const bool use_float)
+{
+  printf("\n========== STARTING %dx%d -> %dx%d %s ==========\n",
+         src_x,
+         src_y,
+         dst_x,
+         dst_y,
+         use_float ? "float" : "byte");
+
+  float *src = scale_test_reference(src_x, src_y);
+  float *ref = scale_test_reference(dst_x, dst_y);
+
+  BLI_threadapi_init();
+  IMB_init();
+
+  for (int method = 0; method < ARRAY_SIZE(scale_method_names); method++) {
+    double time = 0.0, psnr = 0.0;
+    for (int i = 0; i < NUM_RUN_AVERAGED; i++) {
+      ImBuf *ibuf = scale_test_imbuf(src_x, src_y, use_float, src);
+
+      const double time_start = PIL_check_seconds_timer();
+      scale_method_apply(ibuf, dst_x, dst_y, (eScaleMethod)method);
+      time += PIL_check_seconds_timer() - time_start;
+
+      psnr = scale_test_psnr(ibuf, ref);
+      IMB_freeImBuf(ibuf);
+    }
+    printf("%-18s: %8.2f ms, %6.2f dB\n",
+           scale_method_names[method],
+           time * 1000.0 / NUM_RUN_AVERAGED,
+           psnr);
+  }
+
+  IMB_exit();
+  BLI_threadapi_exit();
+
+  MEM_freeN(src);
+  MEM_freeN(ref);
+
+  printf("========== ENDED ==========\n\n");
+}
+
+TEST(imbuf_scaling, Down_4K_HD_Byte)
+{
+  scale_performance(3840, 2160, 1920, 1080, false);
+}
+TEST(imbuf_scaling, Down_4K_HD_Float)
+{
+  scale_performance(3840, 2160, 1920, 1080, true);
+}
+TEST(imbuf_scaling, Down_4K_720p_Byte)
+{
+  scale_performance(3840, 2160, 1280, 720, false);
+}
+TEST(imbuf_scaling, Up_HD_4K_Byte)
+{
+  scale_performance(1920, 1080, 3840, 2160, false);
+}
+TEST(imbuf_scaling, Up_HD_4K_Float)
+{
+  scale_performance(1920, 1080, 3840, 2160, true);
+}
+TEST(imbuf_scaling, Mixed_Byte)
+{
+  scale_performance(1000, 700, 1373, 511, false);
+}
+TEST(imbuf_scaling, Thumbnail_Byte)
+{
+  scale_performance(3840, 2160, 256, 144, false);
+}
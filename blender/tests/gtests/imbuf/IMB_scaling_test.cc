@@ -0,0 +1,137 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_threads.h"
+#include "intern/IMB_filter.h"
+}
+
+#include "IMB_scaling_test_util.h"
+
+/* Compares separable filtered scaling against the previous box/linear scaling. */
+
+typedef struct ScaleTestCase {
+  int src_x, src_y;
+  int dst_x, dst_y;
+} ScaleTestCase;
+
+static const ScaleTestCase scale_test_cases[] = {
+    {1000, 700, 500, 350},
+    {1000, 700, 333, 700},
+    {640, 360, 1280, 720},
+    {1000, 700, 1373, 511},
+};
+
+static void scale_test_compare(const ScaleTestCase *tc, const bool use_float)
+{
+  float *src = scale_test_reference(tc->src_x, tc->src_y);
+  float *ref = scale_test_reference(tc->dst_x, tc->dst_y);
+
+  ImBuf *ibuf_old = scale_test_imbuf(tc->src_x, tc->src_y, use_float, src);
+  ImBuf *ibuf_new = scale_test_imbuf(tc->src_x, tc->src_y, use_float, src);
+
+  imb_scale_box_linear(ibuf_old, tc->dst_x, tc->dst_y);
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf_new, tc->dst_x, tc->dst_y));
+
+  EXPECT_EQ(tc->dst_x, ibuf_new->x);
+  EXPECT_EQ(tc->dst_y, ibuf_new->y);
+
+  const double psnr_old = scale_test_psnr(ibuf_old, ref);
+  const double psnr_new = scale_test_psnr(ibuf_new, ref);
+  /* Not worse than before, allowing for differences in rounding of byte buffers. */
+  EXPECT_GE(psnr_new, psnr_old - 0.05)
+      << tc->src_x << "x" << tc->src_y << " -> " << tc->dst_x << "x" << tc->dst_y
+      << (use_float ? " float" : " byte");
+
+  IMB_freeImBuf(ibuf_old);
+  IMB_freeImBuf(ibuf_new);
+  MEM_freeN(src);
+  MEM_freeN(ref);
+}
+
+TEST(imbuf_scaling, QualityByte)
+{
+  BLI_threadapi_init();
+  IMB_init();
+  for (int i = 0; i < ARRAY_SIZE(scale_test_cases); i++) {
+    scale_test_compare(&scale_test_cases[i], false);
+  }
+  IMB_exit();
+  BLI_threadapi_exit();
+}
+
+TEST(imbuf_scaling, QualityFloat)
+{
+  BLI_threadapi_init();
+  IMB_init();
+  for (int i = 0; i < ARRAY_SIZE(scale_test_cases); i++) {
+    scale_test_compare(&scale_test_cases[i], true);
+  }
+  IMB_exit();
+  BLI_threadapi_exit();
+}
+
+TEST(imbuf_scaling, Filters)
+{
+  const eIMBScaleFilter filters[] = {
+      IMB_SCALE_FILTER_BOX, IMB_SCALE_FILTER_BILINEAR, IMB_SCALE_FILTER_BICUBIC};
+  float *src = scale_test_reference(400, 300);
+  float *ref_down = scale_test_reference(150, 100);
+  float *ref_up = scale_test_reference(700, 500);
+
+  BLI_threadapi_init();
+  IMB_init();
+  for (int i = 0; i < ARRAY_SIZE(filters); i++) {
+    /* Every filter must give a reasonable approximation, both ways. */
+    ImBuf *ibuf = scale_test_imbuf(400, 300, false, src);
+    EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, 150, 100, filters[i]));
+    EXPECT_GT(scale_test_psnr(ibuf, ref_down), 30.0) << "filter " << filters[i];
+    IMB_freeImBuf(ibuf);
+
+    ibuf = scale_test_imbuf(400, 300, true, src);
+    EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, 700, 500, filters[i]));
+    EXPECT_GT(scale_test_psnr(ibuf, ref_up), 30.0) << "filter " << filters[i];
+    IMB_freeImBuf(ibuf);
+
+    /* Zero size keeps the dimension. */
+    ibuf = scale_test_imbuf(400, 300, false, src);
+    EXPECT_TRUE(IMB_scaleImBuf_filter(ibuf, 0, 100, filters[i]));
+    EXPECT_EQ(400, ibuf->x);
+    EXPECT_EQ(100, ibuf->y);
+    EXPECT_FALSE(IMB_scaleImBuf_filter(ibuf, 400, 100, filters[i]));
+    IMB_freeImBuf(ibuf);
+  }
+  IMB_exit();
+  BLI_threadapi_exit();
+
+  MEM_freeN(src);
+  MEM_freeN(ref_down);
+  MEM_freeN(ref_up);
+}
+
+TEST(imbuf_scaling, BicubicUp)
+{
+  /* Bicubic is used instead of the default bilinear filter when scaling up renders. */
+  float *src = scale_test_reference(640, 360);
+  float *ref = scale_test_reference(1280, 720);
+
+  BLI_threadapi_init();
+  IMB_init();
+  for (int use_float = 0; use_float < 2; use_float++) {
+    ImBuf *ibuf_bilinear = scale_test_imbuf(640, 360, use_float, src);
+    ImBuf *ibuf_bicubic = scale_test_imbuf(640, 360, use_float, src);
+
+    IMB_scaleImBuf(ibuf_bilinear, 1280, 720);
+    IMB_scaleImBuf_filter(ibuf_bicubic, 1280, 720, IMB_SCALE_FILTER_BICUBIC);
+    EXPECT_GT(scale_test_psnr(ibuf_bicubic, ref), scale_test_psnr(ibuf_bilinear, ref));
+
+    IMB_freeImBuf(ibuf_bilinear);
+    IMB_freeImBuf(ibuf_bicubic);
+  }
+  IMB_exit();
+  BLI_threadapi_exit();
+
+  MEM_freeN(src);
+  MEM_freeN(ref);
+}
@@ -0,0 +1,91 @@
+/* Apache License, Version 2.0 */
+
+#ifndef __IMB_SCALING_TEST_UTIL_H__
+#define __IMB_SCALING_TEST_UTIL_H__
+
+/* Quality measure for image scaling: images are rendered from an analytic function,
+ * the scaled image is compared against the function rendered at the new resolution. */
+
+#include <math.h>
+#include <string.h>
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "MEM_guardedalloc.h"
+}
+
+/* Samples per pixel axis, each pixel is the average of the function over its area. */
+#define SCALE_TEST_SUPERSAMPLE 4
+
+/* Smooth gradient, fine sine detail and a hard edge. */
+static void scale_test_func(double x, double y, double r_color[4])
+{
+  const double d = sqrt((x - 0.5) * (x - 0.5) + (y - 0.5) * (y - 0.5));
+  r_color[0] = 0.5 + 0.5 * sin(40.0 * x) * cos(30.0 * y);
+  r_color[1] = x;
+  r_color[2] = (d < 0.3) ? 0.9 : 0.1;
+  r_color[3] = 1.0;
+}
+
+static float *scale_test_reference(int width, int height)
+{
+  const int ss = SCALE_TEST_SUPERSAMPLE;
+  float *ref = (float *)MEM_mallocN(sizeof(float[4]) * width * height, __func__);
+
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      double accum[4] = {0.0, 0.0, 0.0, 0.0}, color[4];
+      for (int j = 0; j < ss; j++) {
+        for (int i = 0; i < ss; i++) {
+          scale_test_func((x + (i + 0.5) / ss) / width, (y + (j + 0.5) / ss) / height, color);
+          for (int k = 0; k < 4; k++) {
+            accum[k] += color[k];
+          }
+        }
+      }
+      for (int k = 0; k < 4; k++) {
+        ref[4 * ((size_t)y * width + x) + k] = (float)(accum[k] / (ss * ss));
+      }
+    }
+  }
+  return ref;
+}
+
+static ImBuf *scale_test_imbuf(int width, int height, bool use_float, const float *ref)
+{
+  const size_t len = (size_t)4 * width * height;
+  ImBuf *ibuf = IMB_allocImBuf(width, height, 32, use_float ? IB_rectfloat : IB_rect);
+
+  if (use_float) {
+    memcpy(ibuf->rect_float, ref, sizeof(float) * len);
+  }
+  else {
+    unsigned char *rect = (unsigned char *)ibuf->rect;
+    for (size_t i = 0; i < len; i++) {
+      rect[i] = (unsigned char)(ref[i] * 255.0f + 0.5f);
+    }
+  }
+  return ibuf;
+}
+
+/* Peak signal to noise ratio of the color channels in dB, higher is better. */
+static double scale_test_psnr(const ImBuf *ibuf, const float *ref)
+{
+  const size_t len = (size_t)ibuf->x * ibuf->y;
+  double error_sq = 0.0;
+
+  for (size_t i = 0; i < len; i++) {
+    for (int k = 0; k < 3; k++) {
+      const double value = ibuf->rect_float ?
+                               ibuf->rect_float[4 * i + k] :
+                               ((unsigned char *)ibuf->rect)[4 * i + k] / 255.0;
+      const double diff = value - ref[4 * i + k];
+      error_sq += diff * diff;
+    }
+  }
+  return 10.0 * log10(1.0 / (error_sq / (3 * len)));
+}
+
+#endif /* __IMB_SCALING_TEST_UTIL_H__ */
@@ -0,0 +1,124 @@
+# Apache License, Version 2.0
+
+# Times compositing blur and defocus node trees on a generated image.
+#
+# ./blender.bin --background --factory-startup --python tests/python/bl_compositor_performance.py
+#
+# Optional arguments after "--":
+#   --size X Y    image and render size (default 1920 1080)
+#   --runs N      times each tree is composited, the best time is printed (default 3)
+#   --threads N   compositor threads, 0 for all system threads (default 0)
+
+import bpy
+import hashlib
+import os
+import sys
+import tempfile
+import time
+
+
+def parse_args():
+    import argparse
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--size", type=int, nargs=2, default=(1920, 1080))
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("--threads", type=int, default=0)
+    return parser.parse_args(argv)
+
+
+def scene_setup(size, threads):
+    scene = bpy.context.scene
+    render = scene.render
+    render.resolution_x, render.resolution_y = size
+    render.resolution_percentage = 100
+    render.use_compositing = True
+    render.use_sequencer = False
+    if threads:
+        render.threads_mode = 'FIXED'
+        render.threads = threads
+
+    # Keep the render time and date out of the saved file, so checksums only depend on pixels.
+    for prop in render.bl_rna.properties:
+        if prop.identifier.startswith("use_stamp_"):
+            setattr(render, prop.identifier, False)
+
+    # Without a render layers node only the compositor runs.
+    scene.use_nodes = True
+    image = bpy.data.images.new("Input", size[0], size[1], float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+    return scene, image
+
+
+def tree_setup(scene, image, name):
+    tree = scene.node_tree
+    tree.nodes.clear()
+
+    image_node = tree.nodes.new("CompositorNodeImage")
+    image_node.image = image
+    socket = image_node.outputs["Image"]
+
+    if name in {"blur", "blur defocus"}:
+        blur = tree.nodes.new("CompositorNodeBlur")
+        blur.filter_type = 'GAUSS'
+        blur.size_x = blur.size_y = 40
+        tree.links.new(socket, blur.inputs["Image"])
+        socket = blur.outputs["Image"]
+
+    if name in {"bokeh blur"}:
+        blur = tree.nodes.new("CompositorNodeBlur")
+        blur.use_bokeh = True
+        blur.size_x = blur.size_y = 25
+        tree.links.new(socket, blur.inputs["Image"])
+        socket = blur.outputs["Image"]
+
+    if name in {"defocus", "blur defocus"}:
+        # The red channel of the grid drives the blur radius.
+        separate = tree.nodes.new("CompositorNodeSepRGBA")
+        tree.links.new(image_node.outputs["Image"], separate.inputs["Image"])
+        defocus = tree.nodes.new("CompositorNodeDefocus")
+        defocus.use_zbuffer = True
+        defocus.blur_max = 20.0
+        tree.links.new(socket, defocus.inputs["Image"])
+        tree.links.new(separate.outputs["R"], defocus.inputs["Z"])
+        socket = defocus.outputs["Image"]
+
+    composite = tree.nodes.new("CompositorNodeComposite")
+    tree.links.new(socket, composite.inputs["Image"])
+
+
+def render_checksum(filepath):
+    # Hash of the composited image, to compare results between builds.
+    bpy.data.images["Render Result"].save_render(filepath)
+    with open(filepath, "rb") as fh:
+        return hashlib.md5(fh.read()).hexdigest()
+
+
+def time_tree(scene, image, name, runs, filepath):
+    tree_setup(scene, image, name)
+    times = []
+    for _ in range(runs):
+        time_start = time.perf_counter()
+        bpy.ops.render.render()
+        times.append(time.perf_counter() - time_start)
+    print("%-16s: %9.2f ms (average %9.2f ms) %s" %
+          (name, min(times) * 1000.0, sum(times) / len(times) * 1000.0,
+           render_checksum(filepath)))
+
+
+def main():
+    args = parse_args()
+
+    scene, image = scene_setup(args.size, args.threads)
+    print("\n========== STARTING compositor, %dx%d ==========" % tuple(args.size))
+
+    filepath = os.path.join(tempfile.gettempdir(), "bl_compositor_performance.png")
+    for name in ("blur", "bokeh blur", "defocus", "blur defocus"):
+        time_tree(scene, image, name, args.runs, filepath)
+    os.remove(filepath)
+
+    print("========== ENDED compositor ==========\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,98 @@
+# Apache License, Version 2.0
+
+# Times edit-mesh transform of a large grid with proportional editing.
+#
+# ./blender.bin --background --factory-startup --python tests/python/bl_transform_performance.py
+#
+# Optional arguments after "--":
+#   --subdivisions N   grid vertices per side (default 1000, one million vertices)
+#   --runs N           times each operator runs, the best time is printed (default 3)
+
+import bpy
+import bmesh
+import math
+import sys
+import time
+
+
+def parse_args():
+    import argparse
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--subdivisions", type=int, default=1000)
+    parser.add_argument("--runs", type=int, default=3)
+    return parser.parse_args(argv)
+
+
+def grid_setup(subdivisions):
+    for ob in list(bpy.data.objects):
+        bpy.data.objects.remove(ob)
+
+    bpy.ops.mesh.primitive_grid_add(
+        x_subdivisions=subdivisions, y_subdivisions=subdivisions, size=2.0)
+    ob = bpy.context.active_object
+    bpy.ops.object.mode_set(mode='EDIT')
+
+    # Select a disk in the center, proportional editing affects the area around it.
+    bm = bmesh.from_edit_mesh(ob.data)
+    for v in bm.verts:
+        v.select = (v.co.x * v.co.x + v.co.y * v.co.y) < (0.3 * 0.3)
+    bm.select_flush(True)
+    bmesh.update_edit_mesh(ob.data)
+
+    return ob, len(bm.verts), sum(1 for v in bm.verts if v.select)
+
+
+def checksum(ob):
+    # Sum of coordinates, to compare results between builds.
+    bpy.ops.object.mode_set(mode='OBJECT')
+    total = sum(c for v in ob.data.vertices for c in v.co)
+    bpy.ops.object.mode_set(mode='EDIT')
+    return total
+
+
+def time_operator(name, op, runs, **kwargs):
+    times = []
+    for _ in range(runs):
+        time_start = time.perf_counter()
+        result = op(**kwargs)
+        times.append(time.perf_counter() - time_start)
+        assert result == {'FINISHED'}, result
+    print("%-32s: %9.2f ms (average %9.2f ms)" %
+          (name, min(times) * 1000.0, sum(times) / len(times) * 1000.0))
+
+
+def main():
+    args = parse_args()
+
+    # Undo pushes copy the whole mesh, exclude them from the timings.
+    bpy.context.preferences.edit.undo_steps = 0
+
+    ob, verts_len, selected_len = grid_setup(args.subdivisions)
+    print("\n========== STARTING transform, %d vertices, %d selected ==========" %
+          (verts_len, selected_len))
+
+    proportional = dict(
+        use_proportional_edit=True,
+        proportional_edit_falloff='SMOOTH',
+        proportional_size=0.6,
+    )
+
+    time_operator("translate", bpy.ops.transform.translate, args.runs,
+                  value=(0.0, 0.0, 0.1))
+    time_operator("translate proportional", bpy.ops.transform.translate, args.runs,
+                  value=(0.0, 0.0, 0.1), **proportional)
+    time_operator("rotate proportional", bpy.ops.transform.rotate, args.runs,
+                  value=math.radians(10.0), orient_axis='Z', **proportional)
+    time_operator("resize proportional", bpy.ops.transform.resize, args.runs,
+                  value=(1.1, 1.1, 1.1), **proportional)
+    time_operator("translate proportional sphere", bpy.ops.transform.translate, args.runs,
+                  value=(0.0, 0.0, 0.1), use_proportional_edit=True,
+                  proportional_edit_falloff='SPHERE', proportional_size=1.5)
+
+    print("checksum: %.6f" % checksum(ob))
+    print("========== ENDED transform ==========\n")
+
+
+if __name__ == "__main__":
+    main()